@@ -249,6 +249,17 @@ K4A_EXPORT k4a_result_t k4a_set_allocator(k4a_memory_allocate_cb_t allocate, k4a
  * \remarks
  * When done with the device, close the handle with k4a_device_close()
  *
+ * \remarks
+ * When the environment variable \p K4A_VIRTUAL_DEVICE is set to the path of a recording, that recording is opened as
+ * the only device instead of the connected ones. Its streams are replayed in a loop at the recorded rate, and its
+ * calibration, serial number and firmware versions are reported as the device's.
+ *
+ * \remarks
+ * When the environment variable \p K4A_CALIBRATION_CACHE_DIR is set to an existing directory, the calibration read
+ * from a device is stored there by serial number and firmware version. Later opens of the same device read it from
+ * that directory instead of transferring it again. Only devices that provide their calibration as a JSON file, the
+ * Femto Mega and Femto Bolt, are cached. These are the only devices k4a_device_open() supports.
+ *
  * \xmlonly
  * <requirements>
  *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
@@ -344,6 +355,86 @@ K4A_EXPORT k4a_wait_result_t k4a_device_get_capture(k4a_device_t device_handle,
                                                     k4a_capture_t *capture_handle,
                                                     int32_t timeout_in_ms);
 
+/** Sets a callback that receives the captures from the device as they arrive.
+ *
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param capture_cb
+ * The callback to call for each capture, or NULL to go back to buffering captures for k4a_device_get_capture().
+ *
+ * \param capture_cb_context
+ * Context passed to \p capture_cb.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the callback was set, ::K4A_RESULT_FAILED otherwise.
+ *
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * While a callback is set, each capture is passed to \p capture_cb on the thread that receives it from the device,
+ * without being buffered, and k4a_device_get_capture() won't return any captures. This saves the thread switch
+ * between the device and a thread waiting in k4a_device_get_capture().
+ *
+ * \remarks
+ * The callback owns the capture it is given and must call k4a_capture_release() when it is done with it. See
+ * ::k4a_capture_ready_cb_t.
+ *
+ * \remarks
+ * The callback can be set or cleared at any time. Once this function returns, the previous callback is not called
+ * anymore, so its context can be freed. This function must not be called from the callback, and neither must
+ * k4a_device_stop_cameras() or k4a_device_close().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_device_set_capture_callback(k4a_device_t device_handle,
+                                                        k4a_capture_ready_cb_t *capture_cb,
+                                                        void *capture_cb_context);
+
+/** Gets the delivery statistics of the device streams.
+ *
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param stats
+ * Location to write the statistics to.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the statistics were written to \p stats, ::K4A_RESULT_FAILED otherwise.
+ *
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * Use this to detect an application falling behind the device. A capture that isn't read with
+ * k4a_device_get_capture() before the capture queue fills up is dropped, and so is an IMU sample not read with
+ * k4a_device_get_imu_sample() in time. The drops are counted in \p stats.
+ *
+ * \remarks
+ * The color, depth and IR images travel together in a capture, so the camera streams share a capture queue. Their
+ * \p queue_high_water and latency percentiles are the same, and a dropped capture counts as a dropped frame for each
+ * stream it holds an image of. The latency is measured from the device delivering a capture to k4a_device_get_capture()
+ * returning it. Captures delivered through k4a_device_set_capture_callback() aren't queued and don't add to it. The
+ * IMU stream doesn't measure latency and reports 0.
+ *
+ * \remarks
+ * The camera statistics start over with k4a_device_start_cameras(), the IMU statistics with k4a_device_start_imu().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_result_t k4a_device_get_stream_stats(k4a_device_t device_handle, k4a_device_stream_stats_t *stats);
+
 /** Reads an IMU sample.
  *
  * \param device_handle
@@ -402,6 +493,59 @@ K4A_EXPORT k4a_wait_result_t k4a_device_get_imu_sample(k4a_device_t device_handl
                                                        k4a_imu_sample_t *imu_sample,
                                                        int32_t timeout_in_ms);
 
+/** Reads all of the available IMU samples.
+ *
+ * \param device_handle
+ * Handle obtained by k4a_device_open().
+ *
+ * \param imu_samples
+ * Location to write the IMU samples to, oldest first.
+ *
+ * \param max_count
+ * The number of samples \p imu_samples can hold.
+ *
+ * \param timeout_in_ms
+ * Specifies the time in milliseconds the function should block waiting for the first sample. If set to 0, the function
+ * will return without blocking. Passing a value of #K4A_WAIT_INFINITE will block indefinitely until data is available,
+ * the device is disconnected, or another error occurs.
+ *
+ * \param sample_count
+ * Location to write the number of samples read to.
+ *
+ * \returns
+ * ::K4A_WAIT_RESULT_SUCCEEDED if at least one sample is returned. If a sample is not available before the timeout
+ * elapses, the function will return ::K4A_WAIT_RESULT_TIMEOUT. All other failures will return
+ * ::K4A_WAIT_RESULT_FAILED.
+ *
+ * \relates k4a_device_t
+ *
+ * \remarks
+ * Waits like k4a_device_get_imu_sample() for the first sample, then returns every buffered sample up to \p max_count
+ * in one call. The buffer is locked once for all of them, rather than once per sample, so an application can read the
+ * IMU once per camera capture instead of once per sample.
+ *
+ * \remarks
+ * The samples are the same ones k4a_device_get_imu_sample() returns. Samples not returned because \p imu_samples is
+ * full stay buffered for the next call.
+ *
+ * \remarks
+ * This function needs to be called while the device is in a running state;
+ * after k4a_device_start_imu() is called and before k4a_device_stop_imu() is called.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4a.h (include k4a/k4a.h)</requirement>
+ *   <requirement name="Library">k4a.lib</requirement>
+ *   <requirement name="DLL">k4a.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_EXPORT k4a_wait_result_t k4a_device_get_imu_samples(k4a_device_t device_handle,
+                                                        k4a_imu_sample_t *imu_samples,
+                                                        size_t max_count,
+                                                        int32_t timeout_in_ms,
+                                                        size_t *sample_count);
+
 /** Create an empty capture object.
  *
  * \param capture_handle
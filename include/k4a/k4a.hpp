@@ -1247,6 +1247,36 @@ public:
         return get_capture(cap, std::chrono::milliseconds(K4A_WAIT_INFINITE));
     }
 
+    /** Sets a callback that receives the captures as they arrive, or clears it if capture_cb is nullptr.
+     * Throws error on failure.
+     *
+     * \sa k4a_device_set_capture_callback
+     */
+    void set_capture_callback(k4a_capture_ready_cb_t *capture_cb, void *capture_cb_context)
+    {
+        k4a_result_t result = k4a_device_set_capture_callback(m_handle, capture_cb, capture_cb_context);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to set capture callback!");
+        }
+    }
+
+    /** Gets the delivery statistics of the device streams.
+     * Throws error on failure.
+     *
+     * \sa k4a_device_get_stream_stats
+     */
+    k4a_device_stream_stats_t get_stream_stats() const
+    {
+        k4a_device_stream_stats_t stats;
+        k4a_result_t result = k4a_device_get_stream_stats(m_handle, &stats);
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to get stream statistics!");
+        }
+        return stats;
+    }
+
     /** Reads an IMU sample.  Returns true if a sample was read, false if the read timed out.
      * Throws error on failure.
      *
@@ -1278,6 +1308,32 @@ public:
         return get_imu_sample(imu_sample, std::chrono::milliseconds(K4A_WAIT_INFINITE));
     }
 
+    /** Reads all of the available IMU samples into imu_samples, up to max_count. Returns the number of samples read,
+     * 0 if the read timed out. Throws error on failure.
+     *
+     * \sa k4a_device_get_imu_samples
+     */
+    size_t get_imu_samples(k4a_imu_sample_t *imu_samples, size_t max_count, std::chrono::milliseconds timeout)
+    {
+        int32_t timeout_ms = internal::clamp_cast<int32_t>(timeout.count());
+        size_t sample_count = 0;
+        k4a_wait_result_t result = k4a_device_get_imu_samples(m_handle,
+                                                              imu_samples,
+                                                              max_count,
+                                                              timeout_ms,
+                                                              &sample_count);
+        if (result == K4A_WAIT_RESULT_FAILED)
+        {
+            throw error("Failed to get IMU samples from device!");
+        }
+        else if (result == K4A_WAIT_RESULT_TIMEOUT)
+        {
+            return 0;
+        }
+
+        return sample_count;
+    }
+
     /** Starts the K4A device's cameras
      * Throws error on failure.
      *
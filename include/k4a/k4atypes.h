@@ -947,6 +947,31 @@ typedef void(k4a_memory_destroy_cb_t)(void *buffer, void *context);
  */
 typedef uint8_t *(k4a_memory_allocate_cb_t)(int size, void **context);
 
+/** Callback function for a capture being delivered by the device.
+ *
+ * \param capture_handle
+ * The capture that was just received from the device.
+ *
+ * \param context
+ * The context that was supplied by the caller as \p capture_cb_context to \ref k4a_device_set_capture_callback().
+ *
+ * \remarks
+ * The callback owns a reference to \p capture_handle and must call \ref k4a_capture_release() when it is done with the
+ * capture, either in the callback or later from another thread.
+ *
+ * \remarks
+ * This callback is called on the thread that receives the captures from the device. The next capture isn't delivered
+ * until the callback returns, so the callback should hand long running work off to another thread.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ *
+ */
+typedef void(k4a_capture_ready_cb_t)(k4a_capture_t capture_handle, void *context);
+
 /**
  *
  * @}
@@ -1262,6 +1287,46 @@ typedef struct _k4a_imu_sample_t
     uint64_t gyro_timestamp_usec; /**< Timestamp of the gyroscope in microseconds */
 } k4a_imu_sample_t;
 
+/** Statistics of a single stream of a device.
+ *
+ * \remarks
+ * Filled in by \ref k4a_device_get_stream_stats(). The counts cover the time since the stream was last started.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_stream_stats_t
+{
+    uint64_t delivered_count;   /**< Number of frames received from the device. */
+    uint64_t dropped_count;     /**< Number of frames dropped because they weren't read before the queue filled up. */
+    uint32_t queue_high_water;  /**< Largest number of captures or samples waiting to be read at once. */
+    float interval_mean_usec;   /**< Mean interval between the device timestamps of consecutive frames. */
+    float interval_jitter_usec; /**< Standard deviation of the interval between consecutive frames. */
+    uint32_t latency_p50_usec;  /**< Median time from the frame arriving to it being read by the application. */
+    uint32_t latency_p90_usec;  /**< 90th percentile of the time from arrival to being read. */
+    uint32_t latency_p99_usec;  /**< 99th percentile of the time from arrival to being read. */
+    uint32_t latency_max_usec;  /**< Longest time from arrival to being read. */
+} k4a_stream_stats_t;
+
+/** Statistics of the streams of a device.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">k4atypes.h (include k4a/k4a.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_device_stream_stats_t
+{
+    k4a_stream_stats_t color; /**< Color camera stream. */
+    k4a_stream_stats_t depth; /**< Depth camera stream. */
+    k4a_stream_stats_t ir;    /**< IR camera stream. */
+    k4a_stream_stats_t imu;   /**< IMU stream. */
+} k4a_device_stream_stats_t;
+
 /**
  *
  * @}
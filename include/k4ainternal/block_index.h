@@ -0,0 +1,79 @@
+/** \file block_index.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure Record SDK.
+ * Sidecar index of every block in a recording.
+ */
+
+#ifndef BLOCK_INDEX_H
+#define BLOCK_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace libebml
+{
+class IOCallback;
+}
+
+namespace k4arecord
+{
+// The index for "recording.mkv" is stored next to it as "recording.mkv.k4aidx".
+#define BLOCK_INDEX_FILE_SUFFIX ".k4aidx"
+
+// Bytes hashed at each end of the recording by get_recording_hash().
+#define BLOCK_INDEX_HASH_WINDOW (1024 * 1024)
+
+#pragma pack(push, 1)
+// One entry per SimpleBlock or BlockGroup in the recording, in file order. The struct padding and size must be exact.
+struct block_index_entry_t
+{
+    uint64_t timestamp_ns;   // Block timestamp relative to the start of the recording.
+    uint64_t cluster_offset; // Segment relative offset of the cluster containing the block.
+    uint64_t block_offset;   // Segment relative offset of the block element.
+    uint32_t block_size;     // Size of the block element, including its header.
+    uint16_t track_number;
+    uint16_t reserved;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(block_index_entry_t) == 32, "block_index_entry_t size does not match the on-disk format.");
+
+/**
+ * Index file layout (little-endian):
+ *
+ *   char     magic[8] = "K4AIDX2"
+ *   uint64_t recording_size  Size of the recording file the index was generated for.
+ *   uint64_t recording_hash  get_recording_hash() of the recording the index was generated for.
+ *   uint64_t entry_count
+ *   uint64_t checksum        FNV-1a of the entries.
+ *   block_index_entry_t entries[entry_count]
+ *
+ * read_block_index() returns false if the file is missing, truncated, fails the checksum, or was generated for a
+ * recording of a different size or hash. The recording is always the source of truth, a rejected index is simply
+ * rebuilt.
+ */
+std::string get_block_index_path(const char *recording_path);
+bool write_block_index(const std::string &index_path,
+                       uint64_t recording_size,
+                       uint64_t recording_hash,
+                       const std::vector<block_index_entry_t> &entries);
+bool read_block_index(const std::string &index_path,
+                      uint64_t recording_size,
+                      uint64_t recording_hash,
+                      std::vector<block_index_entry_t> *entries);
+
+/**
+ * Hashes the first and last BLOCK_INDEX_HASH_WINDOW bytes of a recording. This covers the segment info, including the
+ * SegmentUID if the recording has one, and the first and last clusters, so a recording that was rewritten with the
+ * same size does not match its old index. The file position is left undefined.
+ *
+ * Throws std::ios_base::failure if the recording can't be read.
+ */
+uint64_t get_recording_hash(libebml::IOCallback &file, uint64_t recording_size);
+
+} // namespace k4arecord
+
+#endif /* BLOCK_INDEX_H */
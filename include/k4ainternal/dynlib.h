@@ -56,6 +56,25 @@ K4A_DECLARE_HANDLE(dynlib_t);
  */
 k4a_result_t dynlib_create(const char *name, uint32_t version, dynlib_t *dynlib_handle);
 
+/** Loads a dynamic library (shared library) by its full file name.
+ *
+ * \param file_name [IN]
+ * File name of the dynamic library, including any prefix, suffix and version. For example "k4arecord.dll" on
+ * Windows or "libk4arecord.so.1.4" on Linux.
+ *
+ * \param dynlib_handle [OUT]
+ * A handle to store dynlib in. Only valid if function returns
+ * K4A_RESULT_SUCCEEDED
+ *
+ * \remarks
+ * Use this for libraries that do not follow the plugin naming scheme of \ref dynlib_create. The library is searched
+ * for the same way as in \ref dynlib_create.
+ *
+ * \return K4A_RESULT_SUCCEEDED if the library was loaded, K4A_RESULT_FAILED
+ * otherwise
+ */
+k4a_result_t dynlib_create_from_file_name(const char *file_name, dynlib_t *dynlib_handle);
+
 /** Finds the address of an exported symbol in a loaded dynamic library
  *
  * \param dynlib_handle [IN]
@@ -89,6 +89,33 @@ used with CPP and destroy being used with C, or vise-vesa, the types get c or cp
         DESTROY((PUB_HANDLE_TYPE(_public_handle_name_) *)handle);                                                      \
     }
 
+/* K4A_DECLARE_POOLED_CONTEXT declares the same functions as K4A_DECLARE_CONTEXT, plus functions to keep released
+handles in a pool for reuse. A recycled handle is invalid, so get_context fails for a handle that is used after it was
+released, until reuse hands it out again. */
+#define K4A_DECLARE_POOLED_CONTEXT(_public_handle_name_, _internal_context_type_)                                      \
+    K4A_DECLARE_CONTEXT(_public_handle_name_, _internal_context_type_)                                                 \
+                                                                                                                       \
+    /* Define "void handle_t_recycle(handle_t handle)" function */                                                     \
+    static inline void _public_handle_name_##_recycle(_public_handle_name_ handle)                                     \
+    {                                                                                                                  \
+        if (_public_handle_name_##_get_context(handle) != NULL)                                                        \
+        {                                                                                                              \
+            ((PUB_HANDLE_TYPE(_public_handle_name_) *)handle)->handleType = NULL;                                      \
+        }                                                                                                              \
+    }                                                                                                                  \
+                                                                                                                       \
+    /* Define "context_t* handle_t_reuse(handle_t handle)" function */                                                 \
+    static inline _internal_context_type_ *_public_handle_name_##_reuse(_public_handle_name_ handle)                   \
+    {                                                                                                                  \
+        if ((handle == NULL) || ((PUB_HANDLE_TYPE(_public_handle_name_) *)handle)->handleType != NULL)                 \
+        {                                                                                                              \
+            IF_LOGGER(LOG_ERROR("Invalid recycled " #_public_handle_name_ " %p", handle);)                             \
+            return NULL;                                                                                               \
+        }                                                                                                              \
+        ((PUB_HANDLE_TYPE(_public_handle_name_) *)handle)->handleType = PRIV_HANDLE_TYPE(_public_handle_name_);        \
+        return &(((PUB_HANDLE_TYPE(_public_handle_name_) *)handle)->context);                                          \
+    }
+
 /*
  * Example:
 
@@ -154,6 +154,87 @@ private:
     std::thread::id m_owner;
 };
 
+/**
+ * Write-only EBML IO handler that forwards to user-provided k4a_record_io_callbacks_t.
+ * The write position is tracked here since the recording is the only writer of the output. If no seek callback is
+ * provided, any seek away from the current position throws.
+ */
+class CustomIOCallback : public libebml::IOCallback
+{
+public:
+    CustomIOCallback(const k4a_record_io_callbacks_t &callbacks);
+    ~CustomIOCallback() override;
+
+    uint32 read(void *buffer, size_t size) override;
+    void setFilePointer(int64 offset, libebml::seek_mode mode = libebml::seek_beginning) override;
+    size_t write(const void *buffer, size_t size) override;
+    uint64 getFilePointer() override;
+    void close() override;
+    bool isSeekable() const;
+
+private:
+    k4a_record_io_callbacks_t m_callbacks;
+    uint64 m_position = 0;
+    uint64 m_size = 0;
+    bool m_closed = false;
+};
+
+/**
+ * EBML IO handler that forwards to another handler, writing the size field of element heads as the EBML unknown size.
+ * libebml always renders the size it computed, so the head of an element whose final size can't be written later is
+ * rendered through this handler. The element still records its position and head size as usual.
+ */
+class UnknownSizeHeadIOCallback : public libebml::IOCallback
+{
+public:
+    UnknownSizeHeadIOCallback(libebml::IOCallback &output, size_t id_length);
+
+    uint32 read(void *buffer, size_t size) override;
+    void setFilePointer(int64 offset, libebml::seek_mode mode = libebml::seek_beginning) override;
+    size_t write(const void *buffer, size_t size) override;
+    uint64 getFilePointer() override;
+    void close() override;
+
+private:
+    libebml::IOCallback &m_output;
+    size_t m_id_length;
+};
+
+/**
+ * Read-only EBML IO handler backed by a memory mapping of the whole file.
+ * Reads copy straight out of the mapping without any system calls, and frame data can be referenced in place with
+ * view(). Each handler has its own file position. Threads that read the same file at the same time each use their own
+ * reader, created from the handler that mapped the file, instead of sharing a lock.
+ */
+class MappedFileIOCallback : public libebml::IOCallback
+{
+public:
+    MappedFileIOCallback(const char *path);
+
+    // Creates a reader of the same mapping, with its own file position starting at the beginning of the file.
+    explicit MappedFileIOCallback(const MappedFileIOCallback &file);
+    ~MappedFileIOCallback() override;
+
+    uint32 read(void *buffer, size_t size) override;
+    void setFilePointer(int64 offset, libebml::seek_mode mode = libebml::seek_beginning) override;
+    size_t write(const void *buffer, size_t size) override;
+    uint64 getFilePointer() override;
+    void close() override;
+
+    // Returns a reference to size bytes of the file at offset, or nullptr if the range is outside of the file.
+    // The file is mapped read-only, writing through the reference faults. The mapping stays valid until every
+    // reference has been released, even after the handler is destroyed.
+    std::shared_ptr<const uint8_t> view(uint64 offset, uint64 size) const;
+
+    // Hints to the OS that a range of the file will be read soon so it can be paged in ahead of time.
+    void willNeed(uint64 offset, uint64 size) const;
+
+private:
+    std::shared_ptr<const uint8_t> m_data;
+    uint64 m_size = 0;
+    uint64 m_position = 0;
+};
+
 // Struct matches https://docs.microsoft.com/en-us/windows/desktop/wmdm/-bitmapinfoheader
 struct BITMAPINFOHEADER
 {
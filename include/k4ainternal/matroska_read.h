@@ -9,10 +9,32 @@
 #define RECORD_READ_H
 
 #include <k4ainternal/matroska_common.h>
+#include <k4ainternal/block_index.h>
+#include <atomic>
 #include <functional>
 #include <mutex>
-#include <future>
+#include <condition_variable>
+#include <thread>
 #include <map>
+#include <set>
+#include <deque>
+#include <list>
+#include <turbojpeg.h>
+
+// The maximum number of clusters that can be read ahead by the prefetch thread.
+#define MAX_CLUSTER_READ_AHEAD_COUNT 64
+
+// The number of MJPEG color frames decoded ahead of the read position when color conversion is enabled.
+// Each decoded frame is a full BGRA image, so this is kept small.
+#define COLOR_DECODE_AHEAD_COUNT 4
+// The maximum number of worker threads decoding MJPEG color frames.
+#define MAX_COLOR_DECODE_THREADS 4
+
+// The number of depth and IR image buffers kept for reuse after their images are released.
+#define IMAGE_BUFFER_POOL_SIZE 8
+
+// The default memory limit of the parsed cluster cache, see k4a_playback_set_cache_size().
+#define DEFAULT_CLUSTER_CACHE_SIZE (64 * 1024 * 1024)
 
 namespace k4arecord
 {
@@ -40,8 +62,12 @@ typedef struct _cluster_info_t
 // Once it is known that no gap is present between indexed clusters, next_known is set to true.
 typedef std::unique_ptr<cluster_info_t, std::function<void(cluster_info_t *)>> cluster_cache_t;
 
-// A pointer to a cluster that is still being loaded from disk.
-typedef std::shared_future<std::shared_ptr<libmatroska::KaxCluster>> future_cluster_t;
+// A block from the recording's block index, see load_block_index().
+typedef struct _indexed_block_t
+{
+    uint64_t timestamp_ns = 0; // The timestamp of the block as written in the file.
+    cluster_info_t *cluster_info = NULL;
+} indexed_block_t;
 
 typedef struct _loaded_cluster_t
 {
@@ -49,12 +75,40 @@ typedef struct _loaded_cluster_t
     std::shared_ptr<libmatroska::KaxCluster> cluster;
 
 #if CLUSTER_READ_AHEAD_COUNT
-    // Pointers to previous and next clusters to keep them preloaded in memory.
-    future_cluster_t previous_clusters[CLUSTER_READ_AHEAD_COUNT];
-    future_cluster_t next_clusters[CLUSTER_READ_AHEAD_COUNT];
+    // Pointers to the clusters that were already read, so they stay in memory if the read direction changes.
+    // Clusters ahead of the read position are kept in memory by the prefetch thread.
+    std::shared_ptr<libmatroska::KaxCluster> previous_clusters[CLUSTER_READ_AHEAD_COUNT];
+    std::shared_ptr<libmatroska::KaxCluster> next_clusters[CLUSTER_READ_AHEAD_COUNT];
 #endif
 } loaded_cluster_t;
 
+// A parsed cluster kept in memory by the cluster cache, see cache_cluster().
+typedef struct _cached_cluster_t
+{
+    cluster_info_t *cluster_info = NULL;
+    std::shared_ptr<libmatroska::KaxCluster> cluster;
+    uint64_t size = 0; // The number of bytes counted against the cache capacity.
+} cached_cluster_t;
+
+// A color frame being decoded ahead of the read position, see color_decode_thread().
+typedef struct _decoded_frame_t
+{
+    std::shared_ptr<libmatroska::KaxCluster> cluster; // Keeps the block data in memory until it is decoded.
+    libmatroska::KaxInternalBlock *block = NULL;
+    std::vector<uint8_t> *buffer = NULL; // The decoded BGRA image, NULL until done or if decoding failed.
+    bool queued = true;                  // Set to false once a worker thread starts decoding.
+    bool done = false;
+    bool claimed = false; // The reader is waiting for this frame, it should not be evicted.
+} decoded_frame_t;
+
+// Depth and IR image buffers are returned here when their image is released. The pool is shared with the images using
+// it, so images can outlive the playback handle. Only buffers of the requested size are reused.
+typedef struct _image_buffer_pool_t
+{
+    std::mutex lock;
+    std::vector<std::vector<uint8_t> *> buffers;
+} image_buffer_pool_t;
+
 typedef struct _block_info_t
 {
     struct _track_reader_t *reader = NULL;
@@ -78,6 +132,7 @@ typedef struct _track_reader_t
     std::vector<uint8_t> codec_private;
 
     std::shared_ptr<block_info_t> current_block;
+    uint64_t seek_timestamp_ns = 0; // Reading starts from here while current_block is NULL.
     uint64_t frame_period_ns = 0;
     uint64_t sync_delay_ns = 0;
 
@@ -88,14 +143,25 @@ typedef struct _track_reader_t
     uint32_t height = 0;
     uint32_t stride = 0;
     k4a_image_format_t format = K4A_IMAGE_FORMAT_CUSTOM;
+    bool rvl_compressed = false; // Blocks need to be decoded with rvl_decode_image()
+
+    // Every block in this track sorted by timestamp, empty if the recording has no block index.
+    std::vector<indexed_block_t> block_index;
+
+    bool enabled = true; // Blocks of disabled tracks are skipped when reading clusters, see set_track_enabled().
 } track_reader_t;
 
 typedef struct _k4a_playback_context_t
 {
-    const char *file_path;
+    std::string file_path;
     std::unique_ptr<IOCallback> ebml_file;
-    std::mutex io_lock; // Locks access to ebml_file
-    bool file_closing;
+    std::mutex io_lock; // Locks access to ebml_file and disabled_tracks, unless file_mapped is set
+    std::atomic<bool> file_closing;
+
+    // ebml_file is a MappedFileIOCallback. Clusters are loaded through a reader of their own without io_lock, and
+    // disabled_tracks is locked with cache_lock instead. ebml_file itself is only read under cache_lock.
+    bool file_mapped;
+    std::set<uint64_t> disabled_tracks; // Track numbers of the disabled tracks.
 
     uint64_t timecode_scale;
     k4a_record_configuration_t record_config;
@@ -119,6 +185,42 @@ typedef struct _k4a_playback_context_t
 
     cluster_cache_t cluster_cache;
     std::recursive_mutex cache_lock; // Locks modification of cluster_cache
+    // Every entry of cluster_cache in file order if the block index was loaded, otherwise empty.
+    std::vector<cluster_info_t *> cluster_index;
+
+    // Recently used clusters are kept in memory up to cluster_cache_capacity bytes, see cache_cluster().
+    std::mutex cluster_lru_lock;             // Locks access to the cluster_lru fields and the cache stats
+    std::list<cached_cluster_t> cluster_lru; // Most recently used first
+    std::map<cluster_info_t *, std::list<cached_cluster_t>::iterator> cluster_lru_index;
+    uint64_t cluster_lru_bytes = 0;
+    uint64_t cluster_cache_capacity = DEFAULT_CLUSTER_CACHE_SIZE;
+
+    // Clusters are read ahead of the read position by a background thread, see prefetch_thread().
+    std::thread prefetch_thread;
+    std::mutex prefetch_lock; // Locks access to the prefetch fields below
+    std::unique_ptr<std::condition_variable> prefetch_notify;
+    cluster_info_t *prefetch_position = NULL; // The furthest cluster read in the current direction.
+    bool prefetch_next = true;                // The direction of the last cluster read.
+    uint64_t prefetch_generation = 0;         // Incremented each time prefetch_position changes.
+    bool prefetch_stopping = false;
+    size_t read_ahead_count = CLUSTER_READ_AHEAD_COUNT;
+    k4a_playback_read_ahead_direction_t read_ahead_direction = K4A_PLAYBACK_READ_AHEAD_FOLLOW;
+
+    // MJPEG color frames in the prefetched clusters are decoded by worker threads, see color_decode_thread().
+    std::vector<std::thread> decode_threads;
+    std::mutex decode_lock; // Locks access to the decode fields below
+    std::unique_ptr<std::condition_variable> decode_notify;   // Signals new frames in decode_queue
+    std::unique_ptr<std::condition_variable> decode_complete; // Signals frames that finished decoding
+    std::map<uint64_t, decoded_frame_t> decoded_frames;       // Keyed by the file offset of the block
+    std::deque<uint64_t> decode_queue;
+    uint64_t decode_read_offset = 0; // File offset of the last color block converted for the user.
+    bool decode_ahead_enabled = false;
+    bool decode_stopping = false;
+
+    std::mutex decoder_pool_lock;
+    std::vector<tjhandle> decoder_pool; // Idle turbojpeg decompressors, reused instead of creating one per frame.
+
+    std::shared_ptr<image_buffer_pool_t> image_buffer_pool;
 
     track_reader_t *color_track = nullptr;
     track_reader_t *depth_track = nullptr;
@@ -137,7 +239,8 @@ typedef struct _k4a_playback_context_t
     uint64_t last_file_timestamp_ns; // Relative to start of file.
 
     // Stats
-    uint64_t seek_count, load_count, cache_hits;
+    std::atomic<uint64_t> seek_count;
+    uint64_t load_count, cache_hits, cache_evictions;
 } k4a_playback_context_t;
 
 K4A_DECLARE_CONTEXT(k4a_playback_t, k4a_playback_context_t);
@@ -146,10 +249,40 @@ typedef struct _k4a_playback_data_block_context_t
 {
     uint64_t device_timestamp_usec;
     std::vector<uint8_t> data_block;
+
+    // If the recording is memory mapped, the block is referenced in place in the read-only mapping instead of copied
+    // to data_block.
+    std::shared_ptr<const uint8_t> mapped_block;
+    size_t mapped_block_size;
 } k4a_playback_data_block_context_t;
 
 K4A_DECLARE_CONTEXT(k4a_playback_data_block_t, k4a_playback_data_block_context_t);
 
+// A recording in a playback group, see k4a_playback_group_open().
+typedef struct _playback_group_member_t
+{
+    k4a_playback_t handle = NULL;
+    uint64_t subordinate_delay_usec = 0; // subordinate_delay_off_master_usec from the record configuration.
+
+    k4a_capture_t capture = NULL;     // The next capture from this recording, NULL once the end is reached.
+    uint64_t sync_timestamp_usec = 0; // Timestamp of the capture with the subordinate delay removed.
+} playback_group_member_t;
+
+typedef struct _k4a_playback_group_context_t
+{
+    std::vector<playback_group_member_t> members;
+
+    // Indices of the members with a pending capture, kept as a min-heap ordered by sync timestamp.
+    std::vector<size_t> capture_heap;
+
+    // Set when reading the next capture of a member failed. That member is missing from the heap, so all later reads
+    // fail instead of returning captures from the remaining members only.
+    bool read_failed = false;
+} k4a_playback_group_context_t;
+
+K4A_DECLARE_CONTEXT(k4a_playback_group_t, k4a_playback_group_context_t);
+
+std::unique_ptr<EbmlElement> next_child(k4a_playback_context_t *context, EbmlStream &stream, EbmlElement *parent);
 std::unique_ptr<EbmlElement> next_child(k4a_playback_context_t *context, EbmlElement *parent);
 k4a_result_t skip_element(k4a_playback_context_t *context, EbmlElement *element);
 
@@ -157,6 +290,8 @@ void match_ebml_id(k4a_playback_context_t *context, EbmlId &id, uint64_t offset)
 bool seek_info_ready(k4a_playback_context_t *context);
 k4a_result_t parse_mkv(k4a_playback_context_t *context);
 k4a_result_t populate_cluster_cache(k4a_playback_context_t *context);
+bool scan_block_index(k4a_playback_context_t *context, std::vector<block_index_entry_t> *entries);
+bool load_block_index(k4a_playback_context_t *context, const std::vector<block_index_entry_t> &entries);
 k4a_result_t parse_recording_config(k4a_playback_context_t *context);
 k4a_result_t read_bitmap_info_header(track_reader_t *track);
 void reset_seek_pointers(k4a_playback_context_t *context, uint64_t seek_timestamp_ns);
@@ -170,18 +305,36 @@ std::string get_tag_string(libmatroska::KaxTag *tag);
 libmatroska::KaxAttached *get_attachment_by_name(k4a_playback_context_t *context, const char *file_name);
 libmatroska::KaxAttached *get_attachment_by_tag(k4a_playback_context_t *context, const char *tag_name);
 
+k4a_result_t seek_offset(k4a_playback_context_t *context, EbmlStream &stream, uint64_t offset);
 k4a_result_t seek_offset(k4a_playback_context_t *context, uint64_t offset);
 void populate_cluster_info(k4a_playback_context_t *context,
                            std::shared_ptr<libmatroska::KaxCluster> &cluster,
                            cluster_info_t *cluster_info);
 cluster_info_t *find_cluster(k4a_playback_context_t *context, uint64_t timestamp_ns);
 cluster_info_t *next_cluster(k4a_playback_context_t *context, cluster_info_t *current, bool next);
+k4a_result_t set_track_enabled(k4a_playback_context_t *context, track_reader_t *track_reader, bool enabled);
+k4a_result_t find_cluster_range(k4a_playback_context_t *context,
+                                size_t range_index,
+                                size_t range_count,
+                                cluster_info_t **first_cluster,
+                                cluster_info_t **last_cluster);
+k4a_result_t open_cluster_range(k4a_playback_context_t *source,
+                                k4a_playback_context_t *context,
+                                cluster_info_t *first_cluster,
+                                cluster_info_t *last_cluster);
 std::shared_ptr<libmatroska::KaxCluster> load_cluster_internal(k4a_playback_context_t *context,
                                                                cluster_info_t *cluster_info);
+k4a_result_t set_cluster_cache_size(k4a_playback_context_t *context, uint64_t size_bytes);
+void clear_cluster_cache(k4a_playback_context_t *context);
 std::shared_ptr<loaded_cluster_t> load_cluster(k4a_playback_context_t *context, cluster_info_t *cluster_info);
 std::shared_ptr<loaded_cluster_t> load_next_cluster(k4a_playback_context_t *context,
                                                     loaded_cluster_t *current_cluster,
                                                     bool next);
+k4a_result_t start_prefetch_thread(k4a_playback_context_t *context);
+void stop_prefetch_thread(k4a_playback_context_t *context);
+void request_prefetch(k4a_playback_context_t *context, cluster_info_t *position, bool next, bool reset);
+k4a_result_t set_color_decode_ahead(k4a_playback_context_t *context, bool enabled);
+void stop_color_decode_threads(k4a_playback_context_t *context);
 
 uint64_t estimate_block_timestamp_ns(std::shared_ptr<block_info_t> &block);
 std::shared_ptr<block_info_t> find_block(k4a_playback_context_t *context,
@@ -196,13 +349,24 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
 k4a_result_t new_capture(k4a_playback_context_t *context, block_info_t *block, k4a_capture_t *capture_handle);
 k4a_stream_result_t get_capture(k4a_playback_context_t *context, k4a_capture_t *capture_handle, bool next);
 k4a_stream_result_t get_imu_sample(k4a_playback_context_t *context, k4a_imu_sample_t *imu_sample, bool next);
+k4a_stream_result_t get_next_imu_samples(k4a_playback_context_t *context,
+                                         k4a_imu_sample_t *samples,
+                                         size_t max_count,
+                                         size_t *sample_count);
+k4a_result_t get_imu_samples(k4a_playback_context_t *context,
+                             uint64_t start_timestamp_ns,
+                             uint64_t end_timestamp_ns,
+                             k4a_imu_sample_t *samples,
+                             size_t sample_capacity,
+                             size_t *sample_count);
 k4a_stream_result_t get_data_block(k4a_playback_context_t *context,
                                    track_reader_t *track_reader,
                                    k4a_playback_data_block_t *data_block_handle,
                                    bool next);
 
 // Template helper functions
-template<typename T> T *read_element(k4a_playback_context_t *context, EbmlElement *element)
+// The helpers read through context->stream, unless they are given the stream of another reader of the recording.
+template<typename T> T *read_element(k4a_playback_context_t *context, EbmlStream &stream, EbmlElement *element)
 {
     try
     {
@@ -210,14 +374,14 @@ template<typename T> T *read_element(k4a_playback_context_t *context, EbmlElemen
         EbmlElement *dummy = nullptr;
 
         T *typed_element = static_cast<T *>(element);
-        typed_element->Read(*context->stream, T::ClassInfos.Context, upper_level, dummy, true);
+        typed_element->Read(stream, T::ClassInfos.Context, upper_level, dummy, true);
         return typed_element;
     }
     catch (std::ios_base::failure &e)
     {
         LOG_ERROR("Failed to read element %s in recording '%s': %s",
                   T::ClassInfos.GetName(),
-                  context->file_path,
+                  context->file_path.c_str(),
                   e.what());
         return nullptr;
     }
@@ -230,7 +394,8 @@ template<typename T> T *read_element(k4a_playback_context_t *context, EbmlElemen
  *
  * Example usage: find_next<KaxSegment>(context, true);
  */
-template<typename T> std::unique_ptr<T> find_next(k4a_playback_context_t *context, bool search = false)
+template<typename T>
+std::unique_ptr<T> find_next(k4a_playback_context_t *context, EbmlStream &stream, bool search = false)
 {
     try
     {
@@ -246,13 +411,13 @@ template<typename T> std::unique_ptr<T> find_next(k4a_playback_context_t *contex
                     delete element;
                     return nullptr;
                 }
-                element->SkipData(*context->stream, element->Generic().Context);
+                element->SkipData(stream, element->Generic().Context);
                 delete element;
                 element = nullptr;
             }
             if (!element)
             {
-                element = context->stream->FindNextID(T::ClassInfos, UINT64_MAX);
+                element = stream.FindNextID(T::ClassInfos, UINT64_MAX);
             }
             if (!search)
             {
@@ -282,11 +447,24 @@ template<typename T> std::unique_ptr<T> find_next(k4a_playback_context_t *contex
     }
     catch (std::ios_base::failure &e)
     {
-        LOG_ERROR("Failed to find %s in recording '%s': %s", T::ClassInfos.GetName(), context->file_path, e.what());
+        LOG_ERROR("Failed to find %s in recording '%s': %s",
+                  T::ClassInfos.GetName(),
+                  context->file_path.c_str(),
+                  e.what());
         return nullptr;
     }
 }
 
+template<typename T> T *read_element(k4a_playback_context_t *context, EbmlElement *element)
+{
+    return read_element<T>(context, *context->stream, element);
+}
+
+template<typename T> std::unique_ptr<T> find_next(k4a_playback_context_t *context, bool search = false)
+{
+    return find_next<T>(context, *context->stream, search);
+}
+
 template<typename T>
 k4a_result_t read_offset(k4a_playback_context_t *context, std::unique_ptr<T> &element_out, uint64_t offset)
 {
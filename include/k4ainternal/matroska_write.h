@@ -9,10 +9,12 @@
 #define RECORD_WRITE_H
 
 #include <k4ainternal/matroska_common.h>
+#include <k4ainternal/block_index.h>
 #include <set>
 #include <condition_variable>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 namespace k4arecord
 {
@@ -30,6 +32,12 @@ typedef struct _track_header_t
      * See k4a_record_subtitle_settings_t::high_freq_data in types.h for more information on timestamp behavior.
      */
     bool high_freq_data = false;
+
+    // If true, 16-bit image data is compressed with rvl_encode_image() before being written.
+    bool rvl_compressed = false;
+
+    // If non-zero, BGRA images are compressed to MJPEG at this quality on the color encoder threads.
+    int jpeg_quality = 0;
 } track_header_t;
 
 typedef struct _track_data_t
@@ -46,11 +54,27 @@ typedef struct _cluster_t
     std::vector<std::pair<uint64_t, track_data_t>> data;
 } cluster_t;
 
+typedef struct _color_encode_job_t
+{
+    track_header_t *track;
+    uint64_t timestamp_ns;
+    k4a_image_t image; // Reference released by the encoder thread once the job is written.
+} color_encode_job_t;
+
+// Upper bound for the number of color encoder threads, the actual count also depends on the number of cores.
+#define MAX_COLOR_ENCODER_THREADS 4
+
 typedef struct _k4a_record_context_t
 {
     const char *file_path;
     std::unique_ptr<IOCallback> ebml_file;
 
+    /**
+     * True if ebml_file can only be appended to. The segment size and seek metadata can't be updated in place, so the
+     * cues, tags and seek head are written once at the end of the recording by write_append_only_trailer().
+     */
+    bool append_only;
+
     uint64_t timecode_scale;
     uint32_t camera_fps;
 
@@ -87,8 +111,16 @@ typedef struct _k4a_record_context_t
     track_header_t *depth_track = nullptr;
     track_header_t *ir_track = nullptr;
     track_header_t *imu_track = nullptr;
+    libmatroska::KaxTag *color_mode_tag = nullptr;
     std::unordered_map<std::string, track_header_t> tracks;
 
+    /**
+     * Every block written by write_cluster(), saved next to the recording by k4a_record_close() so that playback can
+     * seek without parsing clusters. Only collected when block_index_path is set, i.e. when recording to a file path.
+     */
+    std::string block_index_path;
+    std::vector<block_index_entry_t> block_index;
+
     std::list<cluster_t *> pending_clusters;
     std::mutex pending_cluster_lock; // Locks last_written_timestamp, most_recent_timestamp, and pending_clusters
 
@@ -98,6 +130,21 @@ typedef struct _k4a_record_context_t
     std::unique_ptr<std::condition_variable> writer_notify;
     std::mutex writer_lock;
 
+    /**
+     * Optional color encoder stage, started by start_color_encoder_threads() if the color track has a jpeg_quality.
+     * k4a_record_write_capture() queues color images, and the encoder threads compress them and pass the result to
+     * write_track_data(). The queue is bounded so that callers block instead of holding an unlimited number of images.
+     */
+    std::vector<std::thread> encoder_threads;
+    std::list<color_encode_job_t> encoder_queue;
+    size_t encoder_jobs_active; // Jobs removed from encoder_queue that have not been written yet.
+    size_t encoder_failures;    // Failed jobs that have not been reported to the caller yet.
+    bool encoder_stopping;
+    std::mutex encoder_lock; // Locks encoder_queue, encoder_jobs_active, encoder_failures, and encoder_stopping
+    // std::condition_variable constructor may throw, so wrap these in a pointer.
+    std::unique_ptr<std::condition_variable> encoder_notify; // A job was queued or the encoders are stopping.
+    std::unique_ptr<std::condition_variable> encoder_done;   // A job was finished.
+
     bool header_written, first_cluster_written;
 } k4a_record_context_t;
 
@@ -132,6 +179,12 @@ k4a_result_t write_track_data(k4a_record_context_t *context,
                               uint64_t timestamp_ns,
                               libmatroska::DataBuffer *buffer);
 
+k4a_result_t write_track_data_batch(k4a_record_context_t *context,
+                                    track_header_t *track,
+                                    const uint64_t *timestamps_ns,
+                                    libmatroska::DataBuffer **buffers,
+                                    size_t count);
+
 cluster_t *get_cluster_for_timestamp(k4a_record_context_t *context, uint64_t timestamp_ns);
 
 k4a_result_t write_cluster(k4a_record_context_t *context, cluster_t *cluster, uint64_t *time_end_ns = NULL);
@@ -140,6 +193,19 @@ k4a_result_t start_matroska_writer_thread(k4a_record_context_t *context);
 
 void stop_matroska_writer_thread(k4a_record_context_t *context);
 
+k4a_result_t write_append_only_trailer(k4a_record_context_t *context);
+
+k4a_result_t start_color_encoder_threads(k4a_record_context_t *context);
+
+void stop_color_encoder_threads(k4a_record_context_t *context);
+
+k4a_result_t queue_color_encode(k4a_record_context_t *context,
+                                track_header_t *track,
+                                uint64_t timestamp_ns,
+                                k4a_image_t image);
+
+k4a_result_t wait_for_color_encoder(k4a_record_context_t *context);
+
 libmatroska::KaxTag *add_tag(k4a_record_context_t *context,
                              const char *name,
                              const char *value,
@@ -0,0 +1,50 @@
+/** \file rvl_codec.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure Record SDK.
+ * Lossless 16-bit image codec for depth and IR tracks.
+ */
+
+#ifndef RVL_CODEC_H
+#define RVL_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace k4arecord
+{
+// Matroska CodecID used for depth and IR tracks compressed with rvl_encode_image().
+// The track CodecPrivate still contains the BITMAPINFOHEADER of the uncompressed b16g image.
+#define K4A_RVL_CODEC_ID "V_K4A/RVL"
+
+// Number of independently coded bands an image is split into. Bands are encoded and decoded in parallel.
+#define RVL_BAND_COUNT 4
+
+/**
+ * Run-length / variable-length coding of 16-bit images, based on "Fast Lossless Depth Image Compression" (Wilson,
+ * 2017). Runs of zero pixels are stored as a count, and non-zero pixels are stored as zig-zag encoded deltas from the
+ * previous non-zero pixel. All values are written as 3-bit variable length nibbles.
+ *
+ * rvl_compress() returns the number of bytes written, or 0 if the output buffer is too small.
+ * rvl_decompress() returns false if the input is truncated or does not decode to exactly pixel_count pixels.
+ */
+size_t rvl_max_compressed_size(size_t pixel_count);
+size_t rvl_compress(const uint16_t *input, size_t pixel_count, uint8_t *output, size_t output_size);
+bool rvl_decompress(const uint8_t *input, size_t input_size, uint16_t *output, size_t pixel_count);
+
+/**
+ * Image level encoding used for recording blocks:
+ *
+ *   uint32_t band_count (little-endian)
+ *   uint32_t band_size[band_count] (little-endian)
+ *   uint8_t band_data[band_count][band_size]
+ *
+ * Band i covers pixels [pixel_count * i / band_count, pixel_count * (i + 1) / band_count).
+ */
+bool rvl_encode_image(const uint16_t *pixels, size_t pixel_count, std::vector<uint8_t> &output);
+bool rvl_decode_image(const uint8_t *input, size_t input_size, uint16_t *pixels, size_t pixel_count);
+
+} // namespace k4arecord
+
+#endif /* RVL_CODEC_H */
@@ -47,6 +47,56 @@ extern "C" {
  */
 K4ARECORD_EXPORT k4a_result_t k4a_playback_open(const char *path, k4a_playback_t *playback_handle);
 
+/** Opens one part of a recording as an independent playback handle, so a recording can be processed in parallel.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param range_index
+ * The index of the range to open, from 0 to \p range_count - 1.
+ *
+ * \param range_count
+ * The number of ranges to split the recording into.
+ *
+ * \param range_handle
+ * If successful, this contains a pointer to the playback handle for the range. Caller must call k4a_playback_close()
+ * when finished with the range.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the range was opened. ::K4A_RESULT_FAILED if the recording has fewer data clusters than
+ * \p range_count, or if an error occurred.
+ *
+ * \remarks
+ * The recording is split at cluster boundaries into \p range_count ranges with roughly the same amount of data. Every
+ * data block in the recording belongs to exactly one range, so a capture with images stored in different clusters may
+ * be returned with some of its images by each of the neighboring ranges.
+ *
+ * \remarks
+ * The range handle shares the parsed recording header, calibration and cluster index of \p playback_handle instead of
+ * reading them from the file again, and it has its own file handle and read position. Each range handle can be used
+ * from a different thread, and \p playback_handle can be closed before the ranges are.
+ *
+ * \remarks
+ * A range handle behaves like a recording containing only the range. Reading past the end of the range returns
+ * ::K4A_STREAM_RESULT_EOF, and seeking outside of the range moves to its first or last cluster. Timestamps, the
+ * recording length, and the color conversion and enabled tracks at the time the range was opened are the same as in
+ * \p playback_handle.
+ *
+ * \relates k4a_playback_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_open_range(k4a_playback_t playback_handle,
+                                                      size_t range_index,
+                                                      size_t range_count,
+                                                      k4a_playback_t *range_handle);
+
 /** Get the raw calibration blob for the Azure Kinect device used during recording.
  *
  * \param playback_handle
@@ -393,6 +443,12 @@ K4ARECORD_EXPORT k4a_buffer_result_t k4a_playback_get_tag(k4a_playback_t playbac
  * stored in the file may significantly increase the latency of \p k4a_playback_get_next_capture() and
  * \p k4a_playback_get_previous_capture().
  *
+ * \remarks
+ * For recordings stored as ::K4A_IMAGE_FORMAT_COLOR_MJPG, the next few color frames in the clusters being read ahead
+ * (see k4a_playback_set_read_ahead()) are decoded on background threads, which hides most of this latency during
+ * continuous playback. Frames that are not decoded in time, such as the first frame after a seek, are still decoded in
+ * the user-thread.
+ *
  * \relates k4a_playback_t
  *
  * \xmlonly
@@ -406,6 +462,143 @@ K4ARECORD_EXPORT k4a_buffer_result_t k4a_playback_get_tag(k4a_playback_t playbac
 K4ARECORD_EXPORT k4a_result_t k4a_playback_set_color_conversion(k4a_playback_t playback_handle,
                                                                 k4a_image_format_t target_format);
 
+/** Configure how many data clusters are read ahead of the current playback position.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param cluster_count
+ * The number of clusters to keep loaded ahead of the current position, up to 64. Setting this to 0 disables read-ahead.
+ *
+ * \param direction
+ * The direction in which clusters are read ahead.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the read-ahead settings were applied. ::K4A_RESULT_FAILED otherwise.
+ *
+ * \remarks
+ * Clusters are read from disk and parsed on a background thread, so that \p k4a_playback_get_next_capture() and
+ * \p k4a_playback_get_previous_capture() do not wait on file IO while reading sequentially. By default 2 clusters are
+ * read ahead in the direction of the last read.
+ *
+ * \remarks
+ * Each cluster holds up to 32ms of recording data. Larger values hide slower storage at the cost of memory usage.
+ *
+ * \relates k4a_playback_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_set_read_ahead(k4a_playback_t playback_handle,
+                                                          size_t cluster_count,
+                                                          k4a_playback_read_ahead_direction_t direction);
+
+/** Enable or disable reading a track from the recording.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param track_name
+ * The name of a built-in track ("COLOR", "DEPTH", "IR", "IMU") or a custom track.
+ *
+ * \param enabled
+ * Set to false to stop reading the track, or true to read it again.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the track was updated. ::K4A_RESULT_FAILED if the track does not exist.
+ *
+ * \remarks
+ * All tracks are enabled by default. The blocks of disabled tracks are stepped over when clusters are read from disk,
+ * so their data is never loaded into memory. Captures returned by \p k4a_playback_get_next_capture() and
+ * \p k4a_playback_get_previous_capture() will not contain images from disabled tracks, reading IMU samples while the
+ * "IMU" track is disabled returns ::K4A_STREAM_RESULT_EOF, and reading data blocks from a disabled custom track fails.
+ *
+ * \remarks
+ * Changing the enabled tracks discards the clusters already in memory, but does not change the playback position of
+ * the other tracks. A "COLOR", "DEPTH" or "IR" track that is enabled again continues from the last capture returned, so
+ * its images are included starting with the following capture. The "IMU" and custom tracks are not read while they
+ * are disabled, and continue from the position they had when they were disabled. Calling
+ * \p k4a_playback_seek_timestamp() moves every track, including disabled ones.
+ *
+ * \relates k4a_playback_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_set_track_enabled(k4a_playback_t playback_handle,
+                                                             const char *track_name,
+                                                             bool enabled);
+
+/** Set the memory limit of the playback cluster cache.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param size_bytes
+ * The maximum number of bytes of parsed cluster data kept in memory. Set to 0 to disable the cache.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if the limit was applied. ::K4A_RESULT_FAILED otherwise.
+ *
+ * \remarks
+ * Recently read clusters are kept in memory so that seeking back to them, or reading them again after changing the
+ * read direction, does not read them from disk again. When the cache grows past \p size_bytes, the least recently used
+ * clusters are evicted. The default limit is 64MB.
+ *
+ * \remarks
+ * Clusters are also kept in memory while they are being read ahead or hold the current playback position, so the
+ * memory used by a playback handle may be larger than \p size_bytes.
+ *
+ * \relates k4a_playback_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_set_cache_size(k4a_playback_t playback_handle, uint64_t size_bytes);
+
+/** Get the cluster cache statistics of a playback handle.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param stats
+ * Location to write the cache statistics.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if \p stats was filled in. ::K4A_RESULT_FAILED otherwise.
+ *
+ * \remarks
+ * Cluster reads by the read-ahead thread are included in the hit and miss counts. A read counts as a hit if the cluster
+ * was still in memory, even if it had already been evicted from the cache.
+ *
+ * \relates k4a_playback_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_get_cache_stats(k4a_playback_t playback_handle,
+                                                           k4a_playback_cache_stats_t *stats);
+
 /** Reads an attachment file from a recording.
  *
  * \param playback_handle
@@ -472,6 +665,11 @@ K4ARECORD_EXPORT k4a_buffer_result_t k4a_playback_get_attachment(k4a_playback_t
  * frames were dropped in the original recording. When calling k4a_capture_get_color_image(),
  * k4a_capture_get_depth_image(), or k4a_capture_get_ir_image(), the image should be checked for NULL.
  *
+ * \remarks
+ * To avoid copying each frame, color images that are not converted (see k4a_playback_set_color_conversion()) reference
+ * the data read from the recording. Their buffers are read-only. Writing to them also modifies the same frame when it
+ * is read again from this playback handle.
+ *
  * \xmlonly
  * <requirements>
  *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
@@ -564,6 +762,45 @@ K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_previous_capture(k4a_playb
 K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_next_imu_sample(k4a_playback_t playback_handle,
                                                                       k4a_imu_sample_t *imu_sample);
 
+/** Read the next IMU samples in the recording sequence.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param imu_samples
+ * The location to write the IMU samples to.
+ *
+ * \param max_count
+ * The number of samples \p imu_samples can hold.
+ *
+ * \param sample_count
+ * The location to write the number of samples read to.
+ *
+ * \returns
+ * ::K4A_STREAM_RESULT_SUCCEEDED if at least one sample is returned, or ::K4A_STREAM_RESULT_EOF if the end of the
+ * recording is reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
+ *
+ * \relates k4a_playback_t
+ *
+ * \remarks
+ * Returns the same samples as calling k4a_playback_get_next_imu_sample() up to \p max_count times, stopping early at
+ * the end of the recording, and moves the playback position past the last sample returned. This is the playback
+ * counterpart of k4a_device_get_imu_samples(), so the same code can read the IMU samples of a capture in one call from
+ * either source.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_next_imu_samples(k4a_playback_t playback_handle,
+                                                                       k4a_imu_sample_t *imu_samples,
+                                                                       size_t max_count,
+                                                                       size_t *sample_count);
+
 /** Read the previous IMU sample in the recording sequence.
  *
  * \param playback_handle
@@ -601,6 +838,53 @@ K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_next_imu_sample(k4a_playba
 K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_get_previous_imu_sample(k4a_playback_t playback_handle,
                                                                           k4a_imu_sample_t *imu_sample);
 
+/** Read all of the IMU samples in a range of timestamps.
+ *
+ * \param playback_handle
+ * Handle obtained by k4a_playback_open().
+ *
+ * \param start_timestamp_usec
+ * The first device timestamp in the range, in microseconds.
+ *
+ * \param end_timestamp_usec
+ * The device timestamp at the end of the range, in microseconds. Samples with this timestamp are not included.
+ *
+ * \param samples
+ * Location to write the IMU samples to. This may be NULL if the caller wants to query for the number of samples.
+ *
+ * \param sample_count
+ * On input, the number of samples that \p samples can hold. On output, the number of IMU samples in the range.
+ *
+ * \returns
+ * ::K4A_BUFFER_RESULT_SUCCEEDED if every sample in the range was written to \p samples. If \p samples is too small,
+ * ::K4A_BUFFER_RESULT_TOO_SMALL is returned and \p sample_count is set to the number of samples needed. All other
+ * failures, including recordings without an IMU track, return ::K4A_BUFFER_RESULT_FAILED.
+ *
+ * \remarks
+ * A sample is in the range if its \p acc_timestamp_usec is greater than or equal to \p start_timestamp_usec and less
+ * than \p end_timestamp_usec. Pass 0 and UINT64_MAX to read the whole IMU stream.
+ *
+ * \remarks
+ * The samples are copied in a single pass over the blocks of the IMU track, which is much faster than calling
+ * k4a_playback_get_next_imu_sample() for each sample. The playback position used by
+ * k4a_playback_get_next_imu_sample() and k4a_playback_get_previous_imu_sample() is not changed.
+ *
+ * \relates k4a_playback_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_buffer_result_t k4a_playback_get_imu_samples(k4a_playback_t playback_handle,
+                                                                  uint64_t start_timestamp_usec,
+                                                                  uint64_t end_timestamp_usec,
+                                                                  k4a_imu_sample_t *samples,
+                                                                  size_t *sample_count);
+
 /** Read the next data block for a particular track.
  *
  * \param playback_handle
@@ -751,6 +1035,10 @@ K4ARECORD_EXPORT size_t k4a_playback_data_block_get_buffer_size(k4a_playback_dat
  * \remarks
  * Use this buffer to access the data written to a custom recording track.
  *
+ * \remarks
+ * The buffer is read-only. It may point directly into a read-only memory mapping of the recording, and writing to it
+ * can crash the application.
+ *
  * \returns
  * Returns a pointer to the data block buffer, or NULL if the data block is invalid.
  *
@@ -906,6 +1194,127 @@ K4ARECORD_DEPRECATED_EXPORT uint64_t k4a_playback_get_last_timestamp_usec(k4a_pl
  */
 K4ARECORD_EXPORT void k4a_playback_close(k4a_playback_t playback_handle);
 
+/** Opens a set of recordings to be played back together in timestamp order.
+ *
+ * \param paths
+ * Filesystem paths of the recordings, such as the recordings from each device of a multi-camera rig.
+ *
+ * \param path_count
+ * The number of entries in \p paths.
+ *
+ * \param group_handle
+ * If successful, this contains a pointer to the playback group handle. Caller must call k4a_playback_group_close()
+ * when finished with the recordings.
+ *
+ * \returns
+ * ::K4A_RESULT_SUCCEEDED if every recording was opened. ::K4A_RESULT_FAILED otherwise.
+ *
+ * \remarks
+ * Captures are returned by k4a_playback_group_get_next_capture() ordered by the device timestamp of their first image,
+ * minus the subordinate_delay_off_master_usec from the recording's ::k4a_record_configuration_t. Captures triggered by
+ * the same sync pulse of a master / subordinate rig are returned next to each other.
+ *
+ * \remarks
+ * Each recording is read ahead in the forward direction on its own background thread, see
+ * k4a_playback_set_read_ahead().
+ *
+ * \relates k4a_playback_group_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_playback_group_open(const char *const *paths,
+                                                      size_t path_count,
+                                                      k4a_playback_group_t *group_handle);
+
+/** Get the playback handle of one of the recordings in a playback group.
+ *
+ * \param group_handle
+ * Handle obtained by k4a_playback_group_open().
+ *
+ * \param index
+ * The index of the recording, in the order the paths were passed to k4a_playback_group_open().
+ *
+ * \returns
+ * The playback handle of the recording, or NULL if \p index is out of range.
+ *
+ * \remarks
+ * The handle remains owned by the group and must not be closed. It can be used to query the calibration, record
+ * configuration, tags and attachments of the recording. Reading captures from it or seeking it directly changes which
+ * captures the group returns next.
+ *
+ * \relates k4a_playback_group_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_playback_t k4a_playback_group_get_playback(k4a_playback_group_t group_handle, size_t index);
+
+/** Read the next capture across all of the recordings in a playback group.
+ *
+ * \param group_handle
+ * Handle obtained by k4a_playback_group_open().
+ *
+ * \param capture_handle
+ * If successful this contains a handle to a capture object. Caller must call k4a_capture_release() when its done
+ * using this capture.
+ *
+ * \param index
+ * Optional. If not NULL, this is set to the index of the recording the capture was read from.
+ *
+ * \returns
+ * ::K4A_STREAM_RESULT_SUCCEEDED if a capture is returned, or ::K4A_STREAM_RESULT_EOF if the end of every recording has
+ * been reached. All other failures will return ::K4A_STREAM_RESULT_FAILED.
+ *
+ * \remarks
+ * The recordings are merged with a heap holding the next capture of each recording, so each call only reads from the
+ * recording the returned capture came from.
+ *
+ * \remarks
+ * If reading the next capture of a recording fails, the capture that was already read is still returned. Every later
+ * call then returns ::K4A_STREAM_RESULT_FAILED, since the captures can no longer be returned in order.
+ *
+ * \relates k4a_playback_group_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_stream_result_t k4a_playback_group_get_next_capture(k4a_playback_group_t group_handle,
+                                                                         k4a_capture_t *capture_handle,
+                                                                         size_t *index);
+
+/** Closes a playback group and every recording in it.
+ *
+ * \param group_handle
+ * Handle obtained by k4a_playback_group_open().
+ *
+ * \relates k4a_playback_group_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">playback.h (include k4arecord/playback.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT void k4a_playback_group_close(k4a_playback_group_t group_handle);
+
 /**
  * @}
  */
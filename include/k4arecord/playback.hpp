@@ -356,6 +356,29 @@ public:
         throw error("Failed to get next IMU sample!");
     }
 
+    /** Get the next IMU samples in the recording, up to max_count.
+     * Returns the number of samples read, 0 if there are none left.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_get_next_imu_samples
+     */
+    size_t get_next_imu_samples(k4a_imu_sample_t *samples, size_t max_count)
+    {
+        size_t sample_count = 0;
+        k4a_stream_result_t result = k4a_playback_get_next_imu_samples(m_handle, samples, max_count, &sample_count);
+
+        if (K4A_STREAM_RESULT_SUCCEEDED == result)
+        {
+            return sample_count;
+        }
+        else if (K4A_STREAM_RESULT_EOF == result)
+        {
+            return 0;
+        }
+
+        throw error("Failed to get next IMU samples!");
+    }
+
     /** Get the previous IMU sample in the recording.
      * Returns true if a sample was available, false if there are none left.
      * Throws error on failure.
@@ -378,6 +401,42 @@ public:
         throw error("Failed to get previous IMU sample!");
     }
 
+    /** Get all of the IMU samples with a device timestamp in [start, end).
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_get_imu_samples
+     */
+    std::vector<k4a_imu_sample_t>
+    get_imu_samples(std::chrono::microseconds start = std::chrono::microseconds::zero(),
+                    std::chrono::microseconds end = std::chrono::microseconds::max()) const
+    {
+        std::vector<k4a_imu_sample_t> samples;
+        size_t sample_count = 0;
+        k4a_buffer_result_t result = k4a_playback_get_imu_samples(m_handle,
+                                                                  static_cast<uint64_t>(start.count()),
+                                                                  static_cast<uint64_t>(end.count()),
+                                                                  nullptr,
+                                                                  &sample_count);
+
+        if (result == K4A_BUFFER_RESULT_TOO_SMALL)
+        {
+            samples.resize(sample_count);
+            result = k4a_playback_get_imu_samples(m_handle,
+                                                  static_cast<uint64_t>(start.count()),
+                                                  static_cast<uint64_t>(end.count()),
+                                                  samples.data(),
+                                                  &sample_count);
+        }
+
+        if (result != K4A_BUFFER_RESULT_SUCCEEDED)
+        {
+            throw error("Failed to read IMU samples!");
+        }
+
+        samples.resize(sample_count);
+        return samples;
+    }
+
     /** Seeks to a specific time point in the recording
      * Throws error on failure.
      *
@@ -419,6 +478,72 @@ public:
         }
     }
 
+    /** Set how many clusters are read from disk ahead of the current playback position, and in which direction.
+     *
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_set_read_ahead
+     */
+    void set_read_ahead(size_t cluster_count,
+                        k4a_playback_read_ahead_direction_t direction = K4A_PLAYBACK_READ_AHEAD_FOLLOW)
+    {
+        k4a_result_t result = k4a_playback_set_read_ahead(m_handle, cluster_count, direction);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to set read-ahead!");
+        }
+    }
+
+    /** Enable or disable reading a track from the recording. Blocks of disabled tracks are not read from disk.
+     *
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_set_track_enabled
+     */
+    void set_track_enabled(const char *track_name, bool enabled)
+    {
+        k4a_result_t result = k4a_playback_set_track_enabled(m_handle, track_name, enabled);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to set track enabled!");
+        }
+    }
+
+    /** Set the memory limit of the cluster cache. Set to 0 to disable the cache.
+     *
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_set_cache_size
+     */
+    void set_cache_size(uint64_t size_bytes)
+    {
+        k4a_result_t result = k4a_playback_set_cache_size(m_handle, size_bytes);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to set cache size!");
+        }
+    }
+
+    /** Gets the cluster cache statistics
+     *
+     * \sa k4a_playback_get_cache_stats
+     */
+    k4a_playback_cache_stats_t get_cache_stats() const
+    {
+        k4a_playback_cache_stats_t stats;
+        k4a_result_t result = k4a_playback_get_cache_stats(m_handle, &stats);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to read cache stats!");
+        }
+
+        return stats;
+    }
+
     /** Get the next data block in the recording.
      * Returns true if a block was available, false if there are none left.
      * Throws error on failure.
@@ -508,10 +633,156 @@ public:
         return playback(handle);
     }
 
+    /** Opens one of \p range_count parts of the recording as an independent playback object.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_open_range
+     */
+    playback open_range(size_t range_index, size_t range_count) const
+    {
+        k4a_playback_t handle = nullptr;
+        k4a_result_t result = k4a_playback_open_range(m_handle, range_index, range_count, &handle);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to open recording range!");
+        }
+
+        return playback(handle);
+    }
+
 private:
     k4a_playback_t m_handle;
 };
 
+/** \class playback_group playback.hpp <k4arecord/playback.hpp>
+ * Wrapper for \ref k4a_playback_group_t
+ *
+ * Wraps a handle for a set of recordings played back together in timestamp order
+ *
+ * \sa k4a_playback_group_t
+ */
+class playback_group
+{
+public:
+    /** Creates a k4a::playback_group from a k4a_playback_group_t
+     * Takes ownership of the handle, i.e. you should not call
+     * k4a_playback_group_close on the handle after giving it to the
+     * k4a::playback_group; the k4a::playback_group will take care of that.
+     */
+    playback_group(k4a_playback_group_t handle = nullptr) noexcept : m_handle(handle) {}
+
+    /** Moves another k4a::playback_group into a new k4a::playback_group
+     */
+    playback_group(playback_group &&other) noexcept : m_handle(other.m_handle)
+    {
+        other.m_handle = nullptr;
+    }
+
+    playback_group(const playback_group &) = delete;
+
+    ~playback_group()
+    {
+        close();
+    }
+
+    playback_group &operator=(const playback_group &) = delete;
+
+    /** Moves another k4a::playback_group into this k4a::playback_group; other is set to invalid
+     */
+    playback_group &operator=(playback_group &&other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            m_handle = other.m_handle;
+            other.m_handle = nullptr;
+        }
+
+        return *this;
+    }
+
+    /** Returns true if the k4a::playback_group is valid, false otherwise
+     */
+    explicit operator bool() const noexcept
+    {
+        return m_handle != nullptr;
+    }
+
+    /** Closes the recordings in the group.
+     *
+     * \sa k4a_playback_group_close
+     */
+    void close() noexcept
+    {
+        if (m_handle != nullptr)
+        {
+            k4a_playback_group_close(m_handle);
+            m_handle = nullptr;
+        }
+    }
+
+    /** Get the playback handle of one of the recordings. The handle remains owned by the group.
+     *
+     * \sa k4a_playback_group_get_playback
+     */
+    k4a_playback_t get_playback(size_t index) const noexcept
+    {
+        return k4a_playback_group_get_playback(m_handle, index);
+    }
+
+    /** Get the next capture across all of the recordings, and optionally the index of its recording.
+     * Returns true if a capture was available, false if there are none left.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_group_get_next_capture
+     */
+    bool get_next_capture(capture *cap, size_t *index = nullptr)
+    {
+        k4a_capture_t capture_handle;
+        k4a_stream_result_t result = k4a_playback_group_get_next_capture(m_handle, &capture_handle, index);
+
+        if (K4A_STREAM_RESULT_SUCCEEDED == result)
+        {
+            *cap = capture(capture_handle);
+            return true;
+        }
+        else if (K4A_STREAM_RESULT_EOF == result)
+        {
+            return false;
+        }
+
+        throw error("Failed to get next capture!");
+    }
+
+    /** Opens a set of recordings to be played back together.
+     * Throws error on failure.
+     *
+     * \sa k4a_playback_group_open
+     */
+    static playback_group open(const std::vector<std::string> &paths)
+    {
+        std::vector<const char *> path_strings;
+        for (const std::string &path : paths)
+        {
+            path_strings.push_back(path.c_str());
+        }
+
+        k4a_playback_group_t handle = nullptr;
+        k4a_result_t result = k4a_playback_group_open(path_strings.data(), path_strings.size(), &handle);
+
+        if (K4A_RESULT_SUCCEEDED != result)
+        {
+            throw error("Failed to open recordings!");
+        }
+
+        return playback_group(handle);
+    }
+
+private:
+    k4a_playback_group_t m_handle;
+};
+
 } // namespace k4a
 
 #endif
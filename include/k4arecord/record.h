@@ -68,6 +68,55 @@ K4ARECORD_EXPORT k4a_result_t k4a_record_create(const char *path,
                                                 const k4a_device_configuration_t device_config,
                                                 k4a_record_t *recording_handle);
 
+/** Opens a new recording that is written to a custom output instead of a file.
+ *
+ * \param io_callbacks
+ * The callbacks used to write the recording. The structure is copied, but k4a_record_io_callbacks_t::context must
+ * remain valid until k4a_record_close() returns.
+ *
+ * \param device
+ * The Azure Kinect device that is being recorded. The device handle is used to store device calibration and serial
+ * number information. May be NULL if recording user-generated data.
+ *
+ * \param device_config
+ * The configuration the Azure Kinect device was started with.
+ *
+ * \param recording_handle
+ * If successful, this contains a pointer to the new recording handle. Caller must call k4a_record_close()
+ * when finished with recording.
+ *
+ * \remarks
+ * This function behaves the same as k4a_record_create(), except all recording data is passed to
+ * k4a_record_io_callbacks_t::write. This allows recordings to be streamed to a pipe or socket, or kept in memory.
+ *
+ * \remarks
+ * If k4a_record_io_callbacks_t::seek is provided, the output is identical to a file written by k4a_record_create().
+ *
+ * \remarks
+ * If k4a_record_io_callbacks_t::seek is NULL, the output is only ever appended to. The segment size and duration are
+ * left unknown, and the cues, tags and seek head are written at the end of the recording by k4a_record_close().
+ * k4a_record_flush() only writes pending data in this mode. The resulting file can still be opened with
+ * k4a_playback_open(), but opening it requires a scan of the entire file.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \relates k4a_record_t
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_create_with_io(const k4a_record_io_callbacks_t *io_callbacks,
+                                                        k4a_device_t device,
+                                                        const k4a_device_configuration_t device_config,
+                                                        k4a_record_t *recording_handle);
+
 /** Adds a tag to the recording.
  *
  * \param recording_handle
@@ -105,6 +154,83 @@ K4ARECORD_EXPORT k4a_result_t k4a_record_create(const char *path,
  */
 K4ARECORD_EXPORT k4a_result_t k4a_record_add_tag(k4a_record_t recording_handle, const char *name, const char *value);
 
+/** Sets the codec used to store the depth and IR tracks of the recording.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param codec
+ * The codec to use for the depth and IR tracks.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \remarks
+ * ::K4A_RECORD_DEPTH_CODEC_RVL losslessly compresses depth and IR frames, typically reducing their size by 3-5x.
+ * Frames are compressed in parallel on worker threads during k4a_record_write_capture(). Recordings using this codec
+ * can be read by k4a_playback_open(), but not by tools that only understand the uncompressed b16g format.
+ *
+ * \remarks
+ * The codec needs to be set before the recording header is written.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_set_depth_codec(k4a_record_t recording_handle,
+                                                         k4a_record_depth_codec_t codec);
+
+/** Sets the codec used to store the color track of the recording.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param codec
+ * The codec to use for the color track.
+ *
+ * \param jpeg_quality
+ * The JPEG quality, from 1 (smallest) to 100 (best), used when \p codec is ::K4A_RECORD_COLOR_CODEC_MJPG. Ignored for
+ * other codecs.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \remarks
+ * ::K4A_RECORD_COLOR_CODEC_MJPG can only be used when the recording was created with a color_format of
+ * ::K4A_IMAGE_FORMAT_COLOR_BGRA32. Color images passed to k4a_record_write_capture() are queued and compressed on a
+ * pool of worker threads, and the color track is stored as ::K4A_IMAGE_FORMAT_COLOR_MJPG. k4a_playback_open() reports
+ * the recording as MJPG, and k4a_playback_set_color_conversion() can be used to read it back as BGRA32.
+ *
+ * \remarks
+ * Each queued image holds a reference until it has been compressed. If the encoder threads fall behind,
+ * k4a_record_write_capture() blocks until there is room in the queue. Failures on the encoder threads are returned by
+ * the next call to k4a_record_write_capture() or k4a_record_flush().
+ *
+ * \remarks
+ * The codec needs to be set before the recording header is written.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_set_color_codec(k4a_record_t recording_handle,
+                                                         k4a_record_color_codec_t codec,
+                                                         int jpeg_quality);
+
 /** Adds the track header for recording IMU.
  *
  * \param recording_handle
@@ -367,6 +493,43 @@ K4ARECORD_EXPORT k4a_result_t k4a_record_write_capture(k4a_record_t recording_ha
  */
 K4ARECORD_EXPORT k4a_result_t k4a_record_write_imu_sample(k4a_record_t recording_handle, k4a_imu_sample_t imu_sample);
 
+/** Writes a batch of imu samples to file.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param imu_samples
+ * An array of imu samples, in increasing order of timestamp.
+ *
+ * \param imu_sample_count
+ * The number of samples in \p imu_samples.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \remarks
+ * This is equivalent to calling k4a_record_write_imu_sample() for each sample, but the samples are added to the
+ * recording under a single lock, which reduces overhead when recording high rate IMU data from several devices.
+ *
+ * \remarks
+ * If some samples can't be written, for example because their timestamps are too old, the remaining samples are still
+ * written and ::K4A_RESULT_FAILED is returned.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t k4a_record_write_imu_samples(k4a_record_t recording_handle,
+                                                           const k4a_imu_sample_t *imu_samples,
+                                                           size_t imu_sample_count);
+
 /** Writes data for a custom track to file.
  *
  * \param recording_handle
@@ -410,6 +573,47 @@ K4ARECORD_EXPORT k4a_result_t k4a_record_write_custom_track_data(const k4a_recor
                                                                  uint8_t *custom_data,
                                                                  size_t custom_data_size);
 
+/** Writes a batch of data blocks for a custom track to file.
+ *
+ * \param recording_handle
+ * The handle of a new recording, obtained by k4a_record_create().
+ *
+ * \param track_name
+ * The name of the custom track that the data is going to be written to.
+ *
+ * \param data_blocks
+ * An array of data blocks, in increasing order of timestamp. Each block points to its own buffer.
+ *
+ * \param data_block_count
+ * The number of blocks in \p data_blocks.
+ *
+ * \headerfile record.h <k4arecord/record.h>
+ *
+ * \relates k4a_record_t
+ *
+ * \returns ::K4A_RESULT_SUCCEEDED is returned on success
+ *
+ * \remarks
+ * This is equivalent to calling k4a_record_write_custom_track_data() for each block, but the blocks are added to the
+ * recording under a single lock. The same timestamp rules as k4a_record_write_custom_track_data() apply.
+ *
+ * \remarks
+ * If some blocks can't be written, the remaining blocks are still written and ::K4A_RESULT_FAILED is returned.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">record.h (include k4arecord/record.h)</requirement>
+ *   <requirement name="Library">k4arecord.lib</requirement>
+ *   <requirement name="DLL">k4arecord.dll</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4ARECORD_EXPORT k4a_result_t
+k4a_record_write_custom_track_data_blocks(const k4a_record_t recording_handle,
+                                          const char *track_name,
+                                          const k4a_record_custom_data_block_t *data_blocks,
+                                          size_t data_block_count);
+
 /** Flushes all pending recording data to disk.
  *
  * \param recording_handle
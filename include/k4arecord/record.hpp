@@ -119,6 +119,36 @@ public:
         }
     }
 
+    /** Sets the codec used to store the depth and IR tracks
+     * Throws error on failure
+     *
+     * \sa k4a_record_set_depth_codec
+     */
+    void set_depth_codec(k4a_record_depth_codec_t codec)
+    {
+        k4a_result_t result = k4a_record_set_depth_codec(m_handle, codec);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to set depth codec!");
+        }
+    }
+
+    /** Sets the codec used to store the color track
+     * Throws error on failure
+     *
+     * \sa k4a_record_set_color_codec
+     */
+    void set_color_codec(k4a_record_color_codec_t codec, int jpeg_quality = 90)
+    {
+        k4a_result_t result = k4a_record_set_color_codec(m_handle, codec, jpeg_quality);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to set color codec!");
+        }
+    }
+
     /** Adds the track header for recording IMU
      * Throws error on failure
      *
@@ -242,6 +272,21 @@ public:
         }
     }
 
+    /** Writes a batch of imu samples to file
+     * Throws error on failure
+     *
+     * \sa k4a_record_write_imu_samples
+     */
+    void write_imu_samples(const k4a_imu_sample_t *imu_samples, size_t imu_sample_count)
+    {
+        k4a_result_t result = k4a_record_write_imu_samples(m_handle, imu_samples, imu_sample_count);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to write imu samples!");
+        }
+    }
+
     /** Writes data for a custom track to file
      * Throws error on failure
      *
@@ -265,6 +310,26 @@ public:
         }
     }
 
+    /** Writes a batch of data blocks for a custom track to file
+     * Throws error on failure
+     *
+     * \sa k4a_record_write_custom_track_data_blocks
+     */
+    void write_custom_track_data_blocks(const char *track_name,
+                                        const k4a_record_custom_data_block_t *data_blocks,
+                                        size_t data_block_count)
+    {
+        k4a_result_t result = k4a_record_write_custom_track_data_blocks(m_handle,
+                                                                        track_name,
+                                                                        data_blocks,
+                                                                        data_block_count);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to write custom track data blocks!");
+        }
+    }
+
     /** Opens a new recording file for writing
      * Throws error on failure
      *
@@ -283,6 +348,26 @@ public:
         return record(handle);
     }
 
+    /** Opens a new recording that is written to a custom output
+     * Throws error on failure
+     *
+     * \sa k4a_record_create_with_io
+     */
+    static record create_with_io(const k4a_record_io_callbacks_t &io_callbacks,
+                                 const device &device,
+                                 const k4a_device_configuration_t &device_configuration)
+    {
+        k4a_record_t handle = nullptr;
+        k4a_result_t result = k4a_record_create_with_io(&io_callbacks, device.handle(), device_configuration, &handle);
+
+        if (K4A_FAILED(result))
+        {
+            throw error("Failed to create recorder!");
+        }
+
+        return record(handle);
+    }
+
 private:
     k4a_record_t m_handle;
 };
@@ -63,6 +63,21 @@ K4A_DECLARE_HANDLE(k4a_playback_t);
  */
 K4A_DECLARE_HANDLE(k4a_playback_data_block_t)
 
+/** \class k4a_playback_group_t types.h <k4arecord/types.h>
+ * Handle to a set of recordings played back together in timestamp order.
+ *
+ * \remarks
+ * Handles are created with k4a_playback_group_open(), and closed with k4a_playback_group_close().
+ * Invalid handles are set to 0.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+K4A_DECLARE_HANDLE(k4a_playback_group_t);
+
 /**
  * @}
  *
@@ -147,6 +162,126 @@ typedef enum
     K4A_PLAYBACK_SEEK_DEVICE_TIME /**< Seek to an absolute device timestamp. */
 } k4a_playback_seek_origin_t;
 
+/** Codecs that can be used to store the depth and IR tracks of a recording.
+ *
+ * \see k4a_record_set_depth_codec()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_RECORD_DEPTH_CODEC_RAW = 0, /**< Uncompressed 16-bit big-endian frames (b16g). This is the default. */
+    K4A_RECORD_DEPTH_CODEC_RVL,     /**< Lossless run-length / variable-length compression. */
+} k4a_record_depth_codec_t;
+
+/** Codecs that can be used to store the color track of a recording.
+ *
+ * \see k4a_record_set_color_codec()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_RECORD_COLOR_CODEC_RAW = 0, /**< Color images are stored in their captured format. This is the default. */
+    K4A_RECORD_COLOR_CODEC_MJPG,    /**< ::K4A_IMAGE_FORMAT_COLOR_BGRA32 images are compressed to MJPEG. */
+} k4a_record_color_codec_t;
+
+/** Direction in which playback clusters are read ahead in the background.
+ *
+ * \see k4a_playback_set_read_ahead()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef enum
+{
+    K4A_PLAYBACK_READ_AHEAD_FOLLOW = 0, /**< Read ahead in the direction of the last read. This is the default. */
+    K4A_PLAYBACK_READ_AHEAD_FORWARD,    /**< Always read ahead towards the end of the recording. */
+    K4A_PLAYBACK_READ_AHEAD_BACKWARD,   /**< Always read ahead towards the start of the recording. */
+} k4a_playback_read_ahead_direction_t;
+
+/**
+ * @}
+ *
+ * \addtogroup Prototypes
+ * @{
+ */
+
+/** Callback function for writing recording data to a custom output.
+ *
+ * \param context
+ * The context pointer supplied in k4a_record_io_callbacks_t::context.
+ *
+ * \param buffer
+ * The data to be written at the current output position.
+ *
+ * \param buffer_size
+ * The number of bytes in \p buffer.
+ *
+ * \returns
+ * The number of bytes written. Any value other than \p buffer_size is treated as a write failure.
+ *
+ * \remarks
+ * This callback is called from the recording writer thread as well as from the thread calling the recording API, but
+ * never concurrently.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef size_t(k4a_record_io_write_cb_t)(void *context, const void *buffer, size_t buffer_size);
+
+/** Callback function for moving the write position of a custom output.
+ *
+ * \param context
+ * The context pointer supplied in k4a_record_io_callbacks_t::context.
+ *
+ * \param offset
+ * The absolute byte offset from the start of the recording that the next write should occur at.
+ *
+ * \returns
+ * true if the write position was moved, false on failure.
+ *
+ * \remarks
+ * \p offset is never greater than the number of bytes written so far.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef bool(k4a_record_io_seek_cb_t)(void *context, uint64_t offset);
+
+/** Callback function for closing a custom output.
+ *
+ * \param context
+ * The context pointer supplied in k4a_record_io_callbacks_t::context.
+ *
+ * \remarks
+ * Called once after all recording data has been written, or if k4a_record_create_with_io() fails.
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef void(k4a_record_io_close_cb_t)(void *context);
+
 /**
  * @}
  *
@@ -154,6 +289,34 @@ typedef enum
  * @{
  */
 
+/** Structure describing a custom output for a recording.
+ *
+ * \see k4a_record_create_with_io()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_record_io_callbacks_t
+{
+    /** Called to write data to the output. Required. */
+    k4a_record_io_write_cb_t *write;
+
+    /**
+     * Called to move the write position of the output. Set to NULL for outputs that can only be appended to, such as
+     * pipes and sockets.
+     */
+    k4a_record_io_seek_cb_t *seek;
+
+    /** Called when the recording is closed. Optional, may be NULL. */
+    k4a_record_io_close_cb_t *close;
+
+    /** Context pointer passed to each of the callbacks. */
+    void *context;
+} k4a_record_io_callbacks_t;
+
 /** Structure containing the device configuration used to record.
  *
  * \see k4a_device_configuration_t
@@ -250,6 +413,54 @@ typedef struct _k4a_record_subtitle_settings_t
     bool high_freq_data;
 } k4a_record_subtitle_settings_t;
 
+/** Structure describing one block of data passed to k4a_record_write_custom_track_data_blocks().
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_record_custom_data_block_t
+{
+    /** The timestamp in microseconds for the data block, in the device time domain. */
+    uint64_t device_timestamp_usec;
+
+    /** The data for the block. The data is copied before the write call returns. */
+    const uint8_t *buffer;
+
+    /** The size of \p buffer in bytes. */
+    size_t buffer_size;
+} k4a_record_custom_data_block_t;
+
+/** Structure containing the cluster cache statistics of a playback handle.
+ *
+ * \see k4a_playback_get_cache_stats()
+ *
+ * \xmlonly
+ * <requirements>
+ *   <requirement name="Header">types.h (include k4arecord/types.h)</requirement>
+ * </requirements>
+ * \endxmlonly
+ */
+typedef struct _k4a_playback_cache_stats_t
+{
+    /** The number of cluster reads that were served from memory. */
+    uint64_t hits;
+
+    /** The number of cluster reads that had to load the cluster from disk. */
+    uint64_t misses;
+
+    /** The number of clusters dropped from the cache to stay within \p capacity_bytes. */
+    uint64_t evictions;
+
+    /** The number of bytes of parsed cluster data currently held by the cache. */
+    uint64_t size_bytes;
+
+    /** The memory limit of the cache, see k4a_playback_set_cache_size(). */
+    uint64_t capacity_bytes;
+} k4a_playback_cache_stats_t;
+
 /**
  * @}
  */
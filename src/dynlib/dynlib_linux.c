@@ -46,6 +46,31 @@ static char *generate_file_name(const char *name, uint32_t version)
     return versioned_file_name;
 }
 
+static k4a_result_t load_library(const char *file_name, dynlib_t *dynlib_handle)
+{
+    dynlib_context_t *dynlib = dynlib_t_create(dynlib_handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(dynlib != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        dynlib->handle = dlopen(file_name, RTLD_NOW);
+
+        result = (dynlib->handle != NULL) ? K4A_RESULT_SUCCEEDED : K4A_RESULT_FAILED;
+
+        if (K4A_FAILED(result))
+        {
+            LOG_ERROR("Failed to load shared object %s with error: %s", file_name, dlerror());
+        }
+    }
+
+    if (K4A_FAILED(result))
+    {
+        dynlib_t_destroy(*dynlib_handle);
+        *dynlib_handle = NULL;
+    }
+    return result;
+}
+
 k4a_result_t dynlib_create(const char *name, uint32_t version, dynlib_t *dynlib_handle)
 {
     // Note: A nullptr is allowed on linux systems for "name", however, this is
@@ -68,32 +93,18 @@ k4a_result_t dynlib_create(const char *name, uint32_t version, dynlib_t *dynlib_
         return K4A_RESULT_FAILED;
     }
 
-    dynlib_context_t *dynlib = dynlib_t_create(dynlib_handle);
-    k4a_result_t result = K4A_RESULT_FROM_BOOL(dynlib != NULL);
-
-    if (K4A_SUCCEEDED(result))
-    {
-        dynlib->handle = dlopen(versioned_name, RTLD_NOW);
-
-        result = (dynlib->handle != NULL) ? K4A_RESULT_SUCCEEDED : K4A_RESULT_FAILED;
+    k4a_result_t result = load_library(versioned_name, dynlib_handle);
 
-        if (K4A_FAILED(result))
-        {
-            LOG_ERROR("Failed to load shared object %s with error: %s", versioned_name, dlerror());
-        }
-    }
+    free(versioned_name);
+    return result;
+}
 
-    if (versioned_name)
-    {
-        free(versioned_name);
-    }
+k4a_result_t dynlib_create_from_file_name(const char *file_name, dynlib_t *dynlib_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, file_name == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, dynlib_handle == NULL);
 
-    if (K4A_FAILED(result))
-    {
-        dynlib_t_destroy(*dynlib_handle);
-        *dynlib_handle = NULL;
-    }
-    return result;
+    return load_library(file_name, dynlib_handle);
 }
 
 k4a_result_t dynlib_find_symbol(dynlib_t dynlib_handle, const char *symbol, void **address)
@@ -78,26 +78,8 @@ static DLL_DIRECTORY_COOKIE add_current_module_to_search()
     return dllDirectory;
 }
 
-k4a_result_t dynlib_create(const char *name, uint32_t version, dynlib_t *dynlib_handle)
+static k4a_result_t load_library(const char *file_name, dynlib_t *dynlib_handle)
 {
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, name == NULL);
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, dynlib_handle == NULL);
-
-    if (version > DYNLIB_MAX_VERSION)
-    {
-        LOG_ERROR("Failed to load dynamic library %s. version %u is too large to load. Max is %u\n",
-                  name,
-                  version,
-                  DYNLIB_MAX_VERSION);
-        return K4A_RESULT_FAILED;
-    }
-
-    char *versioned_name = generate_file_name(name, version);
-    if (versioned_name == NULL)
-    {
-        return K4A_RESULT_FAILED;
-    }
-
     DLL_DIRECTORY_COOKIE dllDirectory = add_current_module_to_search();
 
     dynlib_context_t *dynlib = dynlib_t_create(dynlib_handle);
@@ -105,18 +87,18 @@ k4a_result_t dynlib_create(const char *name, uint32_t version, dynlib_t *dynlib_
 
     if (K4A_SUCCEEDED(result))
     {
-        dynlib->handle = LoadLibraryExA(versioned_name,
+        dynlib->handle = LoadLibraryExA(file_name,
                                         NULL,
                                         LOAD_LIBRARY_SEARCH_DEFAULT_DIRS | LOAD_LIBRARY_SEARCH_USER_DIRS);
         result = (dynlib->handle != NULL) ? K4A_RESULT_SUCCEEDED : K4A_RESULT_FAILED;
 
         if (K4A_FAILED(result))
         {
-            LOG_ERROR("Failed to load DLL %s with error code: %u", versioned_name, GetLastError());
+            LOG_ERROR("Failed to load DLL %s with error code: %u", file_name, GetLastError());
         }
     }
 
-    if (dynlib->handle)
+    if (K4A_SUCCEEDED(result))
     {
         char file_path[MAX_PATH];
 
@@ -128,7 +110,7 @@ k4a_result_t dynlib_create(const char *name, uint32_t version, dynlib_t *dynlib_
         }
         else
         {
-            LOG_INFO("Depth Engine loaded %s", file_path);
+            LOG_INFO("Dynamic library loaded %s", file_path);
         }
     }
 
@@ -140,11 +122,6 @@ k4a_result_t dynlib_create(const char *name, uint32_t version, dynlib_t *dynlib_
         }
     }
 
-    if (versioned_name != NULL)
-    {
-        free(versioned_name);
-    }
-
     if (K4A_FAILED(result))
     {
         dynlib_t_destroy(*dynlib_handle);
@@ -154,6 +131,40 @@ k4a_result_t dynlib_create(const char *name, uint32_t version, dynlib_t *dynlib_
     return result;
 }
 
+k4a_result_t dynlib_create(const char *name, uint32_t version, dynlib_t *dynlib_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, name == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, dynlib_handle == NULL);
+
+    if (version > DYNLIB_MAX_VERSION)
+    {
+        LOG_ERROR("Failed to load dynamic library %s. version %u is too large to load. Max is %u\n",
+                  name,
+                  version,
+                  DYNLIB_MAX_VERSION);
+        return K4A_RESULT_FAILED;
+    }
+
+    char *versioned_name = generate_file_name(name, version);
+    if (versioned_name == NULL)
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_result_t result = load_library(versioned_name, dynlib_handle);
+
+    free(versioned_name);
+    return result;
+}
+
+k4a_result_t dynlib_create_from_file_name(const char *file_name, dynlib_t *dynlib_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, file_name == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, dynlib_handle == NULL);
+
+    return load_library(file_name, dynlib_handle);
+}
+
 k4a_result_t dynlib_find_symbol(dynlib_t dynlib_handle, const char *symbol, void **address)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, dynlib_t, dynlib_handle);
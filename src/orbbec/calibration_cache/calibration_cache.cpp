@@ -0,0 +1,188 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// This library
+#include <calibration_cache.h>
+
+// Dependent libraries
+#include <k4ainternal/common.h>
+#include <k4ainternal/logging.h>
+
+#include <azure_c_shared_utility/envvariable.h>
+
+// System dependencies
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <random>
+#include <string>
+
+#define CALIBRATION_CACHE_FILE_SUFFIX ".k4acal"
+
+static const char calibration_cache_magic[8] = "K4ACAL1";
+
+typedef struct _calibration_cache_header_t
+{
+    char magic[8];
+    uint32_t key_size;
+    uint32_t data_size;
+    uint64_t checksum;
+} calibration_cache_header_t;
+
+static_assert(sizeof(calibration_cache_header_t) == 24,
+              "calibration_cache_header_t size does not match the on-disk format.");
+
+// The key is stored in the entry as well, file names only keep the characters that are safe on every platform
+static std::string get_key(const char *serial_number, const char *firmware_version)
+{
+    return std::string(serial_number) + '\n' + firmware_version;
+}
+
+static std::string get_entry_path(const char *directory, const char *serial_number, const char *firmware_version)
+{
+    std::string name = std::string(serial_number) + "_" + firmware_version;
+    for (char &c : name)
+    {
+        bool is_safe = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '.' ||
+                       c == '-' || c == '_';
+        if (!is_safe)
+        {
+            c = '_';
+        }
+    }
+
+    std::string path = directory;
+    if (!path.empty() && path.back() != '/' && path.back() != '\\')
+    {
+        path += '/';
+    }
+    return path + name + CALIBRATION_CACHE_FILE_SUFFIX;
+}
+
+// FNV-1a over the key followed by the calibration
+static uint64_t calibration_cache_checksum(const std::string &key, const uint8_t *data, size_t data_size)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : key)
+    {
+        hash ^= (uint8_t)c;
+        hash *= 1099511628211ull;
+    }
+    for (size_t i = 0; i < data_size; i++)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+const char *calibration_cache_get_directory(void)
+{
+    const char *directory = environment_get_variable(CALIBRATION_CACHE_ENV_VAR);
+    if (directory == NULL || directory[0] == '\0')
+    {
+        return NULL;
+    }
+    return directory;
+}
+
+k4a_result_t calibration_cache_read(const char *directory,
+                                    const char *serial_number,
+                                    const char *firmware_version,
+                                    uint8_t *data,
+                                    size_t *data_size)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, directory == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, serial_number == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, firmware_version == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, data == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, data_size == NULL);
+
+    std::string path = get_entry_path(directory, serial_number, firmware_version);
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    std::string key = get_key(serial_number, firmware_version);
+    calibration_cache_header_t header = {};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file || memcmp(header.magic, calibration_cache_magic, sizeof(header.magic)) != 0 ||
+        header.key_size != key.size())
+    {
+        LOG_WARNING("Ignoring calibration cache entry %s, it does not match the device", path.c_str());
+        return K4A_RESULT_FAILED;
+    }
+
+    if (header.data_size > *data_size)
+    {
+        LOG_WARNING("Ignoring calibration cache entry %s, it is larger than the calibration buffer", path.c_str());
+        return K4A_RESULT_FAILED;
+    }
+
+    std::string stored_key(header.key_size, '\0');
+    file.read(&stored_key[0], (std::streamsize)stored_key.size());
+    file.read(reinterpret_cast<char *>(data), (std::streamsize)header.data_size);
+    if (!file || stored_key != key || calibration_cache_checksum(key, data, header.data_size) != header.checksum)
+    {
+        LOG_WARNING("Ignoring calibration cache entry %s, it is corrupted", path.c_str());
+        return K4A_RESULT_FAILED;
+    }
+
+    *data_size = header.data_size;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t calibration_cache_write(const char *directory,
+                                     const char *serial_number,
+                                     const char *firmware_version,
+                                     const uint8_t *data,
+                                     size_t data_size)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, directory == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, serial_number == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, firmware_version == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, data == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, data_size == 0 || data_size > UINT32_MAX);
+
+    std::string path = get_entry_path(directory, serial_number, firmware_version);
+    std::string key = get_key(serial_number, firmware_version);
+
+    calibration_cache_header_t header = {};
+    memcpy(header.magic, calibration_cache_magic, sizeof(header.magic));
+    header.key_size = (uint32_t)key.size();
+    header.data_size = (uint32_t)data_size;
+    header.checksum = calibration_cache_checksum(key, data, data_size);
+
+    // Several processes may open the same device at once, each writes its own temporary file
+    std::string temp_path = path + "." + std::to_string(std::random_device()()) + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            LOG_WARNING("Failed to create calibration cache entry %s", path.c_str());
+            return K4A_RESULT_FAILED;
+        }
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(key.data(), (std::streamsize)key.size());
+        file.write(reinterpret_cast<const char *>(data), (std::streamsize)data_size);
+        file.close();
+        if (file.fail())
+        {
+            LOG_WARNING("Failed to write calibration cache entry %s", path.c_str());
+            (void)remove(temp_path.c_str());
+            return K4A_RESULT_FAILED;
+        }
+    }
+
+    // rename() does not replace existing files on all platforms
+    (void)remove(path.c_str());
+    if (rename(temp_path.c_str(), path.c_str()) != 0)
+    {
+        LOG_WARNING("Failed to write calibration cache entry %s", path.c_str());
+        (void)remove(temp_path.c_str());
+        return K4A_RESULT_FAILED;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
@@ -16,6 +16,19 @@
 #include <string.h>
 #include <stdbool.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#else
+#include <time.h>
+#endif
+
 typedef struct _frame_queue_entry_t
 {
     k4a_capture_t capture;
@@ -36,6 +49,24 @@ typedef struct _frame_queue_context_t
     LOCK_HANDLE lock;
     COND_HANDLE condition;
     void(*capture_release)(k4a_capture_t capture);
+
+    // Single producer mode, see frame_queue_create_single_producer(). The producer publishes captures by advancing
+    // write_count and consumers claim them by advancing read_count, so neither side takes the lock. The counts run
+    // freely and wrap, the slot of a count is count & mask.
+    bool single_producer;
+    uint32_t mask;                   // Number of slots in queue - 1, the number of slots is a power of 2
+    volatile uint32_t read_count;    // Number of captures read from the queue
+    volatile uint32_t write_count;   // Number of captures written to the queue
+    volatile uint32_t accepting;     // 1 while the queue is enabled
+    volatile uint32_t pushing;       // 1 while the producer is in frame_queue_push
+    volatile uint32_t pop_blocked;   // Number of threads in frame_queue_pop
+    volatile uint32_t signal;        // Incremented on every push and disable, blocked consumers wait for it to change
+    volatile uint32_t signal_waiters; // Number of threads waiting on signal
+
+    // Statistics since the queue was last enabled, see frame_queue_get_stats()
+    volatile uint64_t pushed_total;
+    volatile uint64_t dropped_total;
+    volatile uint32_t high_water;
 } frame_queue_context_t;
 
 K4A_DECLARE_CONTEXT(frame_queue_t, frame_queue_context_t);
@@ -47,7 +78,96 @@ K4A_DECLARE_CONTEXT(frame_queue_t, frame_queue_context_t);
 #define is_queue_empty(queue) ((queue)->write_location == (queue)->read_location)
 #define is_queue_full(queue) (inc_read_write_location((queue), (queue)->write_location) == (queue)->read_location)
 
-k4a_result_t frame_queue_create(uint32_t queue_depth, const char *queue_name, frame_queue_t *queue_handle, k4a_capture_release_t capture_release)
+// Sequentially consistent atomics for the single producer queue
+#ifdef _WIN32
+#define atomic_load_u32(ptr) ((uint32_t)InterlockedCompareExchange((volatile LONG *)(ptr), 0, 0))
+#define atomic_store_u32(ptr, value) ((void)InterlockedExchange((volatile LONG *)(ptr), (LONG)(value)))
+#define atomic_add_u32(ptr, value) ((void)InterlockedExchangeAdd((volatile LONG *)(ptr), (LONG)(value)))
+#define atomic_cas_u32(ptr, expected, desired)                                                                         \
+    ((uint32_t)InterlockedCompareExchange((volatile LONG *)(ptr), (LONG)(desired), (LONG)(expected)) == (expected))
+#define atomic_load_u64(ptr) ((uint64_t)InterlockedCompareExchange64((volatile LONG64 *)(ptr), 0, 0))
+#define atomic_store_u64(ptr, value) ((void)InterlockedExchange64((volatile LONG64 *)(ptr), (LONG64)(value)))
+#define atomic_add_u64(ptr, value) ((void)InterlockedExchangeAdd64((volatile LONG64 *)(ptr), (LONG64)(value)))
+#define atomic_load_capture(ptr) ((k4a_capture_t)InterlockedCompareExchangePointer((PVOID volatile *)(ptr), NULL, NULL))
+#define atomic_store_capture(ptr, value) ((void)InterlockedExchangePointer((PVOID volatile *)(ptr), (PVOID)(value)))
+#else
+#define atomic_load_u32(ptr) __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+#define atomic_store_u32(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_SEQ_CST)
+#define atomic_add_u32(ptr, value) ((void)__atomic_add_fetch((ptr), (uint32_t)(value), __ATOMIC_SEQ_CST))
+#define atomic_cas_u32(ptr, expected, desired)                                                                         \
+    __sync_bool_compare_and_swap((ptr), (uint32_t)(expected), (uint32_t)(desired))
+#define atomic_load_u64(ptr) __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+#define atomic_store_u64(ptr, value) __atomic_store_n((ptr), (uint64_t)(value), __ATOMIC_SEQ_CST)
+#define atomic_add_u64(ptr, value) ((void)__atomic_add_fetch((ptr), (uint64_t)(value), __ATOMIC_SEQ_CST))
+#define atomic_load_capture(ptr) __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+#define atomic_store_capture(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_SEQ_CST)
+#endif
+
+#define SIGNAL_WAIT_INFINITE UINT32_MAX
+
+static uint64_t get_monotonic_time_ms(void)
+{
+#ifdef _WIN32
+    return (uint64_t)GetTickCount64();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+#endif
+}
+
+// Blocks until *signal no longer equals seen, timeout_ms expires, or a spurious wake up. Checking *signal and going
+// to sleep is atomic, so a wake_signal() issued after *signal changed can't be missed.
+static void wait_on_signal(volatile uint32_t *signal, uint32_t seen, uint32_t timeout_ms)
+{
+#ifdef _WIN32
+    WaitOnAddress(signal, &seen, sizeof(seen), timeout_ms == SIGNAL_WAIT_INFINITE ? INFINITE : timeout_ms);
+#elif defined(__linux__)
+    struct timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (long)(timeout_ms % 1000) * 1000000;
+    syscall(SYS_futex,
+            signal,
+            FUTEX_WAIT_PRIVATE,
+            seen,
+            timeout_ms == SIGNAL_WAIT_INFINITE ? NULL : &timeout,
+            NULL,
+            0);
+#else
+    // No futex equivalent, poll instead
+    (void)timeout_ms;
+    if (atomic_load_u32(signal) == seen)
+    {
+        ThreadAPI_Sleep(1);
+    }
+#endif
+}
+
+static void wake_signal(volatile uint32_t *signal)
+{
+#ifdef _WIN32
+    WakeByAddressAll((PVOID)signal);
+#elif defined(__linux__)
+    syscall(SYS_futex, signal, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+    (void)signal;
+#endif
+}
+
+static void notify_consumers(frame_queue_context_t *queue)
+{
+    atomic_add_u32(&queue->signal, 1);
+    if (atomic_load_u32(&queue->signal_waiters) != 0)
+    {
+        wake_signal(&queue->signal);
+    }
+}
+
+static k4a_result_t frame_queue_create_internal(uint32_t queue_depth,
+                                                const char *queue_name,
+                                                bool single_producer,
+                                                frame_queue_t *queue_handle,
+                                                k4a_capture_release_t capture_release)
 {
     k4a_result_t result;
     frame_queue_context_t *queue = frame_queue_t_create(queue_handle);
@@ -62,7 +182,21 @@ k4a_result_t frame_queue_create(uint32_t queue_depth, const char *queue_name, fr
     }
 
     queue->capture_release = capture_release;
-    queue->queue =(frame_queue_entry_t *) malloc(sizeof(frame_queue_entry_t) * queue->depth);
+    queue->single_producer = single_producer;
+
+    uint32_t slots = queue->depth;
+    if (single_producer)
+    {
+        // The free running counts map to a slot with a mask, which needs a power of 2 number of slots
+        slots = 1;
+        while (slots < queue->depth)
+        {
+            slots <<= 1;
+        }
+        queue->mask = slots - 1;
+    }
+
+    queue->queue = (frame_queue_entry_t *)calloc(slots, sizeof(frame_queue_entry_t));
     result = K4A_RESULT_FROM_BOOL(queue->queue != NULL);
 
     if (K4A_SUCCEEDED(result))
@@ -86,6 +220,164 @@ k4a_result_t frame_queue_create(uint32_t queue_depth, const char *queue_name, fr
     return result;
 }
 
+k4a_result_t frame_queue_create(uint32_t queue_depth, const char *queue_name, frame_queue_t *queue_handle, k4a_capture_release_t capture_release)
+{
+    return frame_queue_create_internal(queue_depth, queue_name, false, queue_handle, capture_release);
+}
+
+k4a_result_t frame_queue_create_single_producer(uint32_t queue_depth,
+                                                const char *queue_name,
+                                                frame_queue_t *queue_handle,
+                                                k4a_capture_release_t capture_release)
+{
+    return frame_queue_create_internal(queue_depth, queue_name, true, queue_handle, capture_release);
+}
+
+// Claims the oldest capture in a single producer queue. Both the consumers and the producer, when it drops the oldest
+// capture of a full queue, claim captures with a compare and swap of read_count, so each capture is claimed once.
+static k4a_capture_t frame_queue_pop_single_producer_internal(frame_queue_context_t *queue)
+{
+    for (;;)
+    {
+        uint32_t read_count = atomic_load_u32(&queue->read_count);
+        if (read_count == atomic_load_u32(&queue->write_count))
+        {
+            return NULL;
+        }
+
+        // The slot can only be reused by the producer after read_count has moved on, in which case the compare and
+        // swap fails and we try again.
+        k4a_capture_t capture = atomic_load_capture(&queue->queue[read_count & queue->mask].capture);
+        if (atomic_cas_u32(&queue->read_count, read_count, read_count + 1))
+        {
+            return capture;
+        }
+    }
+}
+
+static k4a_wait_result_t frame_queue_pop_single_producer(frame_queue_context_t *queue,
+                                                         int32_t wait_in_ms,
+                                                         k4a_capture_t *out_captures,
+                                                         uint32_t max_count,
+                                                         uint32_t *out_count)
+{
+    k4a_capture_t capture = NULL;
+    uint32_t count = 0;
+    k4a_wait_result_t wresult = K4A_WAIT_RESULT_TIMEOUT;
+
+    atomic_add_u32(&queue->pop_blocked, 1);
+    if (atomic_load_u32(&queue->accepting) == 0)
+    {
+        LOG_ERROR("Queue \"%s\" was popped in a disabled state.", queue->name);
+        wresult = K4A_WAIT_RESULT_FAILED;
+    }
+
+    uint64_t deadline = get_monotonic_time_ms() + (uint64_t)(wait_in_ms > 0 ? wait_in_ms : 0);
+    while (wresult == K4A_WAIT_RESULT_TIMEOUT)
+    {
+        // Read the signal before looking at the queue, so a push after the check below wakes up the wait
+        uint32_t seen = atomic_load_u32(&queue->signal);
+
+        capture = frame_queue_pop_single_producer_internal(queue);
+        if (capture != NULL)
+        {
+            wresult = K4A_WAIT_RESULT_SUCCEEDED;
+            out_captures[count++] = capture;
+            while (count < max_count && (capture = frame_queue_pop_single_producer_internal(queue)) != NULL)
+            {
+                out_captures[count++] = capture;
+            }
+            break;
+        }
+
+        if (atomic_load_u32(&queue->accepting) == 0)
+        {
+            wresult = K4A_WAIT_RESULT_FAILED;
+            break;
+        }
+
+        // Anything less than 0 is a wait forever condition. K4A_WAIT_INFINITE (-1) is defined for the user for this
+        // purpose
+        uint32_t timeout_ms = SIGNAL_WAIT_INFINITE;
+        if (wait_in_ms >= 0)
+        {
+            uint64_t now = get_monotonic_time_ms();
+            if (now >= deadline)
+            {
+                break;
+            }
+            timeout_ms = (uint32_t)(deadline - now);
+        }
+
+        atomic_add_u32(&queue->signal_waiters, 1);
+        wait_on_signal(&queue->signal, seen, timeout_ms);
+        atomic_add_u32(&queue->signal_waiters, -1);
+    }
+
+    if (count != 0 && atomic_load_u32(&queue->accepting) == 0)
+    {
+        wresult = K4A_WAIT_RESULT_FAILED;
+        while (count != 0)
+        {
+            queue->capture_release(out_captures[--count]);
+        }
+    }
+    atomic_add_u32(&queue->pop_blocked, -1);
+
+    *out_count = count;
+    return wresult;
+}
+
+static void frame_queue_push_single_producer(frame_queue_context_t *queue,
+                                             k4a_capture_t capture,
+                                             k4a_capture_t *dropped_handle)
+{
+    // frame_queue_disable() waits for pushing to clear after it stops accepting, so a capture can't be left behind in
+    // a disabled queue.
+    atomic_add_u32(&queue->pushing, 1);
+
+    if (atomic_load_u32(&queue->accepting) == 0)
+    {
+        LOG_WARNING("Capture pushed into disabled queue.", queue->name);
+        queue->capture_release(capture);
+    }
+    else
+    {
+        uint32_t write_count = atomic_load_u32(&queue->write_count);
+        while (write_count - atomic_load_u32(&queue->read_count) >= queue->depth - 1)
+        {
+            // Full, drop the oldest capture. A consumer may claim it first, in which case there is room now.
+            k4a_capture_t dropped = frame_queue_pop_single_producer_internal(queue);
+            if (dropped != NULL)
+            {
+                atomic_add_u64(&queue->dropped_total, 1);
+                if (dropped_handle != NULL)
+                {
+                    *dropped_handle = dropped;
+                }
+                else
+                {
+                    queue->capture_release(dropped);
+                }
+            }
+        }
+
+        atomic_store_capture(&queue->queue[write_count & queue->mask].capture, capture);
+        atomic_store_u32(&queue->write_count, write_count + 1);
+        notify_consumers(queue);
+
+        // Only the producer writes these, the atomics are for frame_queue_get_stats()
+        atomic_add_u64(&queue->pushed_total, 1);
+        uint32_t count = write_count + 1 - atomic_load_u32(&queue->read_count);
+        if (count > atomic_load_u32(&queue->high_water))
+        {
+            atomic_store_u32(&queue->high_water, count);
+        }
+    }
+
+    atomic_add_u32(&queue->pushing, -1);
+}
+
 static k4a_capture_t frame_queue_pop_internal_locked(frame_queue_context_t *queue)
 {
     if (is_queue_empty(queue) == false)
@@ -99,13 +391,14 @@ static k4a_capture_t frame_queue_pop_internal_locked(frame_queue_context_t *queu
     return NULL;
 }
 
-k4a_wait_result_t frame_queue_pop(frame_queue_t queue_handle, int32_t wait_in_ms, k4a_capture_t *out_capture)
+static k4a_wait_result_t frame_queue_pop_locked(frame_queue_context_t *queue,
+                                                int32_t wait_in_ms,
+                                                k4a_capture_t *out_captures,
+                                                uint32_t max_count,
+                                                uint32_t *out_count)
 {
-    RETURN_VALUE_IF_HANDLE_INVALID(K4A_WAIT_RESULT_FAILED, frame_queue_t, queue_handle);
-    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, out_capture == NULL);
-
-    frame_queue_context_t *queue = frame_queue_t_get_context(queue_handle);
     k4a_capture_t capture = NULL;
+    uint32_t count = 0;
     k4a_wait_result_t wresult = K4A_WAIT_RESULT_SUCCEEDED;
 
     Lock(queue->lock);
@@ -155,14 +448,24 @@ k4a_wait_result_t frame_queue_pop(frame_queue_t queue_handle, int32_t wait_in_ms
             }
         }
         queue->queue_pop_blocked--;
+
+        // Drain whatever else is queued in the same critical section
+        if (capture != NULL)
+        {
+            out_captures[count++] = capture;
+            while (count < max_count && (capture = frame_queue_pop_internal_locked(queue)) != NULL)
+            {
+                out_captures[count++] = capture;
+            }
+        }
     }
 
     if (queue->enabled == false)
     {
         wresult = K4A_WAIT_RESULT_FAILED;
-        if (capture)
+        while (count != 0)
         {
-            queue->capture_release(capture);
+            queue->capture_release(out_captures[--count]);
         }
     }
 
@@ -176,11 +479,39 @@ k4a_wait_result_t frame_queue_pop(frame_queue_t queue_handle, int32_t wait_in_ms
 
     // We are transfering the ref we had to the caller.
     // capture_dec_ref(capture);
-    *out_capture = capture;
+    *out_count = count;
 
     return wresult;
 }
 
+k4a_wait_result_t frame_queue_pop_many(frame_queue_t queue_handle,
+                                       int32_t wait_in_ms,
+                                       k4a_capture_t *out_captures,
+                                       uint32_t max_count,
+                                       uint32_t *out_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_WAIT_RESULT_FAILED, frame_queue_t, queue_handle);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, out_captures == NULL);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, max_count == 0);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, out_count == NULL);
+
+    frame_queue_context_t *queue = frame_queue_t_get_context(queue_handle);
+    if (queue->single_producer)
+    {
+        return frame_queue_pop_single_producer(queue, wait_in_ms, out_captures, max_count, out_count);
+    }
+    return frame_queue_pop_locked(queue, wait_in_ms, out_captures, max_count, out_count);
+}
+
+k4a_wait_result_t frame_queue_pop(frame_queue_t queue_handle, int32_t wait_in_ms, k4a_capture_t *out_capture)
+{
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, out_capture == NULL);
+
+    uint32_t count = 0;
+    *out_capture = NULL;
+    return frame_queue_pop_many(queue_handle, wait_in_ms, out_capture, 1, &count);
+}
+
 static void frame_queue_push_internal_locked(frame_queue_context_t *queue, k4a_capture_t capture)
 {
     frame_queue_entry_t *entry = &queue->queue[queue->write_location];
@@ -189,13 +520,24 @@ static void frame_queue_push_internal_locked(frame_queue_context_t *queue, k4a_c
     queue->write_location = inc_read_write_location(queue, queue->write_location);
 }
 
-void frame_queue_push_w_dropped(frame_queue_t queue_handle, k4a_capture_t capture)
+void frame_queue_push_w_dropped(frame_queue_t queue_handle, k4a_capture_t capture, k4a_capture_t *dropped_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, frame_queue_t, queue_handle);
     RETURN_VALUE_IF_ARG(VOID_VALUE, capture == NULL);
 
     frame_queue_context_t *queue = frame_queue_t_get_context(queue_handle);
 
+    if (dropped_handle != NULL)
+    {
+        *dropped_handle = NULL;
+    }
+
+    if (queue->single_producer)
+    {
+        frame_queue_push_single_producer(queue, capture, dropped_handle);
+        return;
+    }
+
     Lock(queue->lock);
 
     if (queue->enabled == false)
@@ -208,12 +550,26 @@ void frame_queue_push_w_dropped(frame_queue_t queue_handle, k4a_capture_t captur
         if (is_queue_full(queue))
         {
             k4a_capture_t dropped =frame_queue_pop_internal_locked(queue);
-            queue->capture_release(dropped);
-
+            queue->dropped_total++;
+            if (dropped_handle != NULL)
+            {
+                *dropped_handle = dropped;
+            }
+            else
+            {
+                queue->capture_release(dropped);
+            }
         }
 
         frame_queue_push_internal_locked(queue, capture);
 
+        queue->pushed_total++;
+        uint32_t count = (queue->write_location + queue->depth - queue->read_location) % queue->depth;
+        if (count > queue->high_water)
+        {
+            queue->high_water = count;
+        }
+
         Condition_Post(queue->condition);
     }
     Unlock(queue->lock);
@@ -221,7 +577,7 @@ void frame_queue_push_w_dropped(frame_queue_t queue_handle, k4a_capture_t captur
 
 void frame_queue_push(frame_queue_t queue_handle, k4a_capture_t capture)
 {
-    frame_queue_push_w_dropped(queue_handle, capture);
+    frame_queue_push_w_dropped(queue_handle, capture, NULL);
 }
 
 void frame_queue_destroy(frame_queue_t queue_handle)
@@ -253,6 +609,24 @@ void frame_queue_enable(frame_queue_t queue_handle)
     Lock(queue->lock);
     queue->enabled = true;
     queue->stopped = false;
+    atomic_store_u64(&queue->pushed_total, 0);
+    atomic_store_u64(&queue->dropped_total, 0);
+    atomic_store_u32(&queue->high_water, 0);
+    atomic_store_u32(&queue->accepting, 1);
+    Unlock(queue->lock);
+}
+
+void frame_queue_get_stats(frame_queue_t queue_handle, frame_queue_stats_t *stats)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, frame_queue_t, queue_handle);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, stats == NULL);
+    frame_queue_context_t *queue = frame_queue_t_get_context(queue_handle);
+
+    // The lock covers the locked queue, a single producer queue updates the statistics atomically without it
+    Lock(queue->lock);
+    stats->pushed_count = atomic_load_u64(&queue->pushed_total);
+    stats->dropped_count = atomic_load_u64(&queue->dropped_total);
+    stats->high_water = atomic_load_u32(&queue->high_water);
     Unlock(queue->lock);
 }
 
@@ -265,6 +639,26 @@ void frame_queue_disable(frame_queue_t queue_handle)
 
     queue->enabled = false;
 
+    if (queue->single_producer)
+    {
+        atomic_store_u32(&queue->accepting, 0);
+
+        // Wake up the blocked consumers and wait for them and the producer to leave the queue
+        while (atomic_load_u32(&queue->pop_blocked) != 0 || atomic_load_u32(&queue->pushing) != 0)
+        {
+            notify_consumers(queue);
+            ThreadAPI_Sleep(1);
+        }
+
+        k4a_capture_t dropped;
+        while ((dropped = frame_queue_pop_single_producer_internal(queue)) != NULL)
+        {
+            queue->capture_release(dropped);
+        }
+        Unlock(queue->lock);
+        return;
+    }
+
     while (queue->queue_pop_blocked != 0)
     {
         LOG_INFO("Queue \"%s\" waiting for blocking call to complete.", queue->name);
@@ -300,6 +694,16 @@ k4a_capture_t get_frame_queue_front(frame_queue_t queue_handle)
 {
     frame_queue_context_t *queue = frame_queue_t_get_context(queue_handle);
 
+    if (queue->single_producer)
+    {
+        uint32_t read_count = atomic_load_u32(&queue->read_count);
+        if (read_count == atomic_load_u32(&queue->write_count))
+        {
+            return NULL;
+        }
+        return atomic_load_capture(&queue->queue[read_count & queue->mask].capture);
+    }
+
     Lock(queue->lock);
     //
     if (is_queue_empty(queue) == false)
@@ -5,149 +5,238 @@
 #include <imusync.h>
 
 // Dependent libraries
-#include <frame_queue.h>
 #include <k4ainternal/handle.h>
 #include <k4ainternal/logging.h>
 #include <k4ainternal/common.h>
 
 #include <azure_c_shared_utility/lock.h>
+#include <azure_c_shared_utility/condition.h>
+#include <azure_c_shared_utility/threadapi.h>
+#include <azure_c_shared_utility/tickcounter.h>
 #include <azure_c_shared_utility/envvariable.h>
 
 // System dependencies
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 
-#define IMU_QUEUE_DEFAULT_SIZE 10
+// Samples of one sensor waiting for a partner from the other sensor
+#define IMU_PENDING_SIZE 16
 
-#define IMU_GRAVITATIONAL_CONSTANT 9.81f
+// Synchronized samples kept for the application, two camera intervals at 5 FPS of 500 Hz samples
+#define IMU_SYNC_QUEUE_SIZE 256
 
-#define PI 3.141592f
-#define IMU_RADIANS_PER_DEGREES (PI / 180.0f)
+// Fixed size ring of samples, oldest first. The counts run freely and wrap, the slot of a count is count % size, which
+// stays consistent across the wrap because the sizes are powers of 2.
+typedef struct _imu_pending_ring_t
+{
+    imu_frame_data samples[IMU_PENDING_SIZE];
+    uint32_t read_count;
+    uint32_t write_count;
+} imu_pending_ring_t;
 
 typedef struct _imusync_context_t
 {
-    frame_queue_t sync_queue;    // Queue for storing synchronized captures in
-    frame_queue_t accel_queue;   
-    frame_queue_t gyro_queue;    
+    imu_pending_ring_t accel; // Accelerometer samples not paired yet
+    imu_pending_ring_t gyro;  // Gyroscope samples not paired yet
+    bool interpolate;         // Interpolate the gyroscope to the accelerometer timestamps instead of matching them
 
-    volatile bool running;              // We have received start and should be processing data when true.
-    LOCK_HANDLE lock;
+    imu_sync_frame_data sync_queue[IMU_SYNC_QUEUE_SIZE]; // Synchronized samples waiting for the application
+    uint32_t sync_read_count;
+    uint32_t sync_write_count;
+    uint32_t pop_blocked; // Number of threads waiting in imusync_get_frames()
+
+    frame_queue_stats_t queue_stats;       // See imusync_get_stats()
+    imusync_pairing_stats_t pairing_stats; // See imusync_get_pairing_stats()
 
+    volatile bool running; // We have received start and should be processing data when true.
+    LOCK_HANDLE lock;
+    COND_HANDLE condition;
+    TICK_COUNTER_HANDLE tick; // Measures the time imusync_get_frames() has waited so far
 } imusync_context_t;
 
 K4A_DECLARE_CONTEXT(imusync_t, imusync_context_t);
 
-void free_imu_buff(k4a_capture_t capture)
+#define ring_count(ring) ((ring)->write_count - (ring)->read_count)
+#define ring_at(ring, index) (&(ring)->samples[((ring)->read_count + (index)) % IMU_PENDING_SIZE])
+
+static void ring_push(imu_pending_ring_t *ring, const imu_frame_data *sample, uint64_t *dropped_count)
 {
-    void *pBuff = (void *)capture;
-    if (pBuff != NULL)
+    if (ring_count(ring) == IMU_PENDING_SIZE)
     {
-        free(pBuff);
-        pBuff = NULL;
+        // The other sensor stopped delivering, the oldest sample won't find a partner
+        ring->read_count++;
+        (*dropped_count)++;
     }
+    ring->samples[ring->write_count % IMU_PENDING_SIZE] = *sample;
+    ring->write_count++;
 }
 
+static void ring_clear(imu_pending_ring_t *ring)
+{
+    ring->read_count = ring->write_count;
+}
 
-void imusync_push_frame(imusync_t imusync_handle, imu_frame_data imu_data, imu_data_type imu_type)
+// Adds a synchronized sample to the queue for the application. Called with the lock held.
+static void imusync_emit(imusync_context_t *sync,
+                         const imu_frame_data *accel,
+                         const float gyro_data[3],
+                         uint64_t gyro_timestamp,
+                         uint64_t gap_usec,
+                         bool interpolated)
 {
-    imusync_context_t *sync = NULL;
-    k4a_wait_result_t wresult = K4A_WAIT_RESULT_SUCCEEDED;
-    k4a_result_t result;
-    bool locked = false;
+    if (sync->sync_write_count - sync->sync_read_count == IMU_SYNC_QUEUE_SIZE)
+    {
+        sync->sync_read_count++;
+        sync->queue_stats.dropped_count++;
+    }
 
-    result = K4A_RESULT_FROM_BOOL(imusync_handle != NULL);
-    if (K4A_SUCCEEDED(result))
+    imu_sync_frame_data *frame = &sync->sync_queue[sync->sync_write_count % IMU_SYNC_QUEUE_SIZE];
+    frame->timestamp = accel->timestamp;
+    frame->gyro_timestamp = gyro_timestamp;
+    frame->temp = accel->temp;
+    memcpy(frame->accel_data, accel->data, sizeof(frame->accel_data));
+    memcpy(frame->gyro_data, gyro_data, sizeof(frame->gyro_data));
+    sync->sync_write_count++;
+
+    sync->queue_stats.pushed_count++;
+    uint32_t count = sync->sync_write_count - sync->sync_read_count;
+    if (count > sync->queue_stats.high_water)
     {
-        sync = imusync_t_get_context(imusync_handle);
-        result = K4A_RESULT_FROM_BOOL(sync != NULL);
+        sync->queue_stats.high_water = count;
     }
-    
-    if (K4A_SUCCEEDED(result))
+
+    imusync_pairing_stats_t *stats = &sync->pairing_stats;
+    stats->paired_count++;
+    stats->interpolated_count += interpolated ? 1 : 0;
+    stats->total_gap_usec += gap_usec;
+    if (gap_usec > stats->max_gap_usec)
     {
-        Lock(sync->lock);
-        locked = true;
-        result = sync->running == true ? K4A_RESULT_SUCCEEDED : K4A_RESULT_FAILED;
+        stats->max_gap_usec = gap_usec;
     }
-   
-    if (K4A_SUCCEEDED(result))
+
+    Condition_Post(sync->condition);
+}
+
+// Pairs the pending samples in timestamp order. Both sensors deliver their samples in timestamp order, so a sample
+// that can't be paired with the oldest pending sample of the other sensor never will be. Called with the lock held.
+static void imusync_match(imusync_context_t *sync)
+{
+    imusync_pairing_stats_t *stats = &sync->pairing_stats;
+
+    while (ring_count(&sync->accel) != 0 && ring_count(&sync->gyro) != 0)
     {
-        // TODO: ʹڴع
-        imu_sync_frame_data *p_imu_frame_data = (imu_sync_frame_data *)malloc(sizeof(imu_sync_frame_data));
-        p_imu_frame_data->temp = imu_data.temp;
-        p_imu_frame_data->timestamp = imu_data.timestamp;
-   
-        if (imu_type == ACCEL_FRAME_TYPE)
+        const imu_frame_data *accel = ring_at(&sync->accel, 0);
+
+        if (!sync->interpolate)
         {
-            memcpy(p_imu_frame_data->accel_data, imu_data.data, sizeof(imu_data.data));
-            frame_queue_push(sync->accel_queue, (k4a_capture_t)p_imu_frame_data);
+            // Pair samples with the same timestamp, drop the older sample otherwise
+            const imu_frame_data *gyro = ring_at(&sync->gyro, 0);
+            if (accel->timestamp == gyro->timestamp)
+            {
+                imusync_emit(sync, accel, gyro->data, gyro->timestamp, 0, false);
+                sync->accel.read_count++;
+                sync->gyro.read_count++;
+            }
+            else if (accel->timestamp > gyro->timestamp)
+            {
+                sync->gyro.read_count++;
+                stats->unmatched_gyro_count++;
+            }
+            else
+            {
+                sync->accel.read_count++;
+                stats->unmatched_accel_count++;
+            }
+            continue;
         }
-        else
+
+        // Skip the gyroscope samples before the pair that brackets the accelerometer sample
+        while (ring_count(&sync->gyro) >= 2 && ring_at(&sync->gyro, 1)->timestamp <= accel->timestamp)
         {
-            memcpy(p_imu_frame_data->gyro_data, imu_data.data, sizeof(imu_data.data));
-            frame_queue_push(sync->gyro_queue, (k4a_capture_t)p_imu_frame_data);
+            sync->gyro.read_count++;
         }
 
-        //2.ȡͷڵ
-        k4a_capture_t accel_data = get_frame_queue_front(sync->accel_queue);
-        k4a_capture_t gyro_data = get_frame_queue_front(sync->gyro_queue);
-        if (accel_data != NULL && gyro_data != NULL)
+        const imu_frame_data *gyro0 = ring_at(&sync->gyro, 0);
+        if (gyro0->timestamp > accel->timestamp)
         {
-            imu_sync_frame_data *p_accel_data = (imu_sync_frame_data *)accel_data;
-            imu_sync_frame_data *p_gyro_data = (imu_sync_frame_data *)gyro_data;
-            if (p_accel_data->timestamp == p_gyro_data->timestamp)
+            // Older than every gyroscope sample, there is nothing to interpolate from
+            sync->accel.read_count++;
+            stats->unmatched_accel_count++;
+        }
+        else if (gyro0->timestamp == accel->timestamp)
+        {
+            imusync_emit(sync, accel, gyro0->data, gyro0->timestamp, 0, false);
+            sync->accel.read_count++;
+        }
+        else if (ring_count(&sync->gyro) >= 2)
+        {
+            const imu_frame_data *gyro1 = ring_at(&sync->gyro, 1);
+            uint64_t span = gyro1->timestamp - gyro0->timestamp;
+            uint64_t before = accel->timestamp - gyro0->timestamp;
+            uint64_t after = gyro1->timestamp - accel->timestamp;
+            float weight = (float)before / (float)span;
+
+            float gyro_data[3];
+            for (int i = 0; i < 3; i++)
             {
-                //ϳһImupushͬ
-                imu_sync_frame_data *p_imu_sync_frame_data = (imu_sync_frame_data *) malloc(sizeof(imu_sync_frame_data));
-
-                p_imu_sync_frame_data->timestamp = p_accel_data->timestamp;
-                p_imu_sync_frame_data->temp = p_accel_data->temp;
-                memcpy(p_imu_sync_frame_data->accel_data,p_accel_data->accel_data,sizeof(p_accel_data->accel_data));
-                memcpy(p_imu_sync_frame_data->gyro_data, p_gyro_data->gyro_data, sizeof(p_gyro_data->gyro_data));
+                gyro_data[i] = gyro0->data[i] + (gyro1->data[i] - gyro0->data[i]) * weight;
+            }
 
-                frame_queue_push(sync->sync_queue, (k4a_capture_t)p_imu_sync_frame_data);
+            // The interpolated sample is at the accelerometer timestamp
+            imusync_emit(sync, accel, gyro_data, accel->timestamp, before > after ? before : after, true);
+            sync->accel.read_count++;
+        }
+        else
+        {
+            // Wait for the gyroscope sample after the accelerometer sample
+            break;
+        }
+    }
+}
 
-                k4a_capture_t accel_handle = NULL;
-                wresult =frame_queue_pop(sync->accel_queue, 0, &accel_handle);
-                if (wresult == K4A_WAIT_RESULT_SUCCEEDED)
-                {
-                    free_imu_buff(accel_handle);
-                }
+void imusync_push_frame(imusync_t imusync_handle, imu_frame_data imu_data, imu_data_type imu_type)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, imusync_t, imusync_handle);
+    imusync_context_t *sync = imusync_t_get_context(imusync_handle);
 
-                k4a_capture_t gyro_handle = NULL;
-                wresult =frame_queue_pop(sync->gyro_queue, 0, &gyro_handle);
-                if (wresult == K4A_WAIT_RESULT_SUCCEEDED)
-                {
-                    free_imu_buff(gyro_handle);
-                }
-            }
-            else if (p_accel_data->timestamp > p_gyro_data->timestamp)
-            {
-                //pop gyro_data
-                k4a_capture_t capture_handle;
-                wresult = frame_queue_pop(sync->gyro_queue, 0, &capture_handle);
-                if (wresult == K4A_WAIT_RESULT_SUCCEEDED)
-                {
-                    free_imu_buff(capture_handle);
-                }
-            }
-            else
-            {
-                // pop accel_data
-                k4a_capture_t capture_handle;
-                wresult = frame_queue_pop(sync->accel_queue, 0, &capture_handle);
-                if (wresult == K4A_WAIT_RESULT_SUCCEEDED)
-                {
-                    free_imu_buff(capture_handle);
-                }
-            }
+    Lock(sync->lock);
+    if (sync->running)
+    {
+        if (imu_type == ACCEL_FRAME_TYPE)
+        {
+            ring_push(&sync->accel, &imu_data, &sync->pairing_stats.unmatched_accel_count);
+        }
+        else
+        {
+            ring_push(&sync->gyro, &imu_data, &sync->pairing_stats.unmatched_gyro_count);
         }
+        imusync_match(sync);
     }
+    Unlock(sync->lock);
+}
 
-    if (locked)
+void imusync_push_sample(imusync_t imusync_handle, const k4a_imu_sample_t *imu_sample)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, imusync_t, imusync_handle);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, imu_sample == NULL);
+    imusync_context_t *sync = imusync_t_get_context(imusync_handle);
+
+    imu_frame_data accel;
+    accel.timestamp = imu_sample->acc_timestamp_usec;
+    accel.temp = imu_sample->temperature;
+    memcpy(accel.data, imu_sample->acc_sample.v, sizeof(accel.data));
+
+    uint64_t gap_usec = imu_sample->acc_timestamp_usec > imu_sample->gyro_timestamp_usec ?
+                            imu_sample->acc_timestamp_usec - imu_sample->gyro_timestamp_usec :
+                            imu_sample->gyro_timestamp_usec - imu_sample->acc_timestamp_usec;
+
+    Lock(sync->lock);
+    if (sync->running)
     {
-        Unlock(sync->lock);
-        locked = false;
+        imusync_emit(sync, &accel, imu_sample->gyro_sample.v, imu_sample->gyro_timestamp_usec, gap_usec, false);
     }
+    Unlock(sync->lock);
 }
 
 k4a_result_t imusync_create(imusync_t *imusync_handle)
@@ -157,7 +246,6 @@ k4a_result_t imusync_create(imusync_t *imusync_handle)
     imusync_context_t *sync = imusync_t_create(imusync_handle);
     k4a_result_t result = K4A_RESULT_FROM_BOOL(sync != NULL);
 
-
     if (K4A_SUCCEEDED(result))
     {
         sync->lock = Lock_Init();
@@ -166,33 +254,23 @@ k4a_result_t imusync_create(imusync_t *imusync_handle)
 
     if (K4A_SUCCEEDED(result))
     {
-        result = TRACE_CALL(frame_queue_create(IMU_QUEUE_DEFAULT_SIZE,
-                                               "Queue_depth",
-                                               &sync->accel_queue,
-                                               free_imu_buff));
-    }
-
-    if (K4A_SUCCEEDED(result))
-    {
-        result = TRACE_CALL(frame_queue_create(IMU_QUEUE_DEFAULT_SIZE,
-                                               "Queue_color",
-                                               &sync->gyro_queue,
-                                               free_imu_buff));
+        sync->condition = Condition_Init();
+        result = K4A_RESULT_FROM_BOOL(sync->condition != NULL);
     }
 
     if (K4A_SUCCEEDED(result))
     {
-        result = TRACE_CALL(frame_queue_create(IMU_QUEUE_DEFAULT_SIZE / 2,
-                                               "Queue_capture",
-                                               &sync->sync_queue,
-                                               free_imu_buff));
+        sync->tick = tickcounter_create();
+        result = K4A_RESULT_FROM_BOOL(sync->tick != NULL);
     }
 
     if (K4A_SUCCEEDED(result))
     {
-        frame_queue_disable(sync->accel_queue);
-        frame_queue_disable(sync->gyro_queue);
-        frame_queue_disable(sync->sync_queue);
+        const char *interpolate = environment_get_variable("K4A_IMU_INTERPOLATION");
+        if (interpolate != NULL && interpolate[0] != '\0' && interpolate[0] != '0')
+        {
+            sync->interpolate = true;
+        }
     }
 
     if (K4A_FAILED(result))
@@ -209,37 +287,48 @@ void imusync_destroy(imusync_t imusync_handle)
     RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, imusync_t, imusync_handle);
     imusync_context_t *sync = imusync_t_get_context(imusync_handle);
 
-    imusync_stop(imusync_handle);
-
-    if (sync->accel_queue)
+    if (sync->lock)
     {
-        frame_queue_destroy(sync->accel_queue);
+        imusync_stop(imusync_handle);
+        Lock_Deinit(sync->lock);
     }
-    if (sync->gyro_queue)
+
+    if (sync->condition)
     {
-        frame_queue_destroy(sync->gyro_queue);
+        Condition_Deinit(sync->condition);
     }
-    if (sync->sync_queue)
+
+    if (sync->tick)
     {
-        frame_queue_destroy(sync->sync_queue);
+        tickcounter_destroy(sync->tick);
     }
 
-    Lock_Deinit(sync->lock);
     imusync_t_destroy(imusync_handle);
 }
 
-k4a_result_t imusync_start(imusync_t imusync_handle)
+void imusync_set_interpolation(imusync_t imusync_handle, bool interpolate)
 {
-    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, imusync_t, imusync_handle);
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, imusync_t, imusync_handle);
     imusync_context_t *sync = imusync_t_get_context(imusync_handle);
 
+    Lock(sync->lock);
+    sync->interpolate = interpolate;
+    Unlock(sync->lock);
+}
 
-    frame_queue_enable(sync->accel_queue);
-    frame_queue_enable(sync->gyro_queue);
-    frame_queue_enable(sync->sync_queue);
+k4a_result_t imusync_start(imusync_t imusync_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, imusync_t, imusync_handle);
+    imusync_context_t *sync = imusync_t_get_context(imusync_handle);
 
-    // Not taking the lock as we don't need to synchronize this on start
+    Lock(sync->lock);
+    ring_clear(&sync->accel);
+    ring_clear(&sync->gyro);
+    sync->sync_read_count = sync->sync_write_count;
+    memset(&sync->queue_stats, 0, sizeof(sync->queue_stats));
+    memset(&sync->pairing_stats, 0, sizeof(sync->pairing_stats));
     sync->running = true;
+    Unlock(sync->lock);
 
     return K4A_RESULT_SUCCEEDED;
 }
@@ -252,50 +341,141 @@ void imusync_stop(imusync_t imusync_handle)
     Lock(sync->lock);
     sync->running = false;
 
-    if (sync->accel_queue)
-    {
-        frame_queue_disable(sync->accel_queue);
-    }
-    if (sync->gyro_queue)
-    {
-        frame_queue_disable(sync->gyro_queue);
-    }
-    if (sync->sync_queue)
+    while (sync->pop_blocked != 0)
     {
-        frame_queue_disable(sync->sync_queue);
+        Condition_Post(sync->condition);
+        Unlock(sync->lock);
+        ThreadAPI_Sleep(1);
+        Lock(sync->lock);
     }
 
+    ring_clear(&sync->accel);
+    ring_clear(&sync->gyro);
+    sync->sync_read_count = sync->sync_write_count;
     Unlock(sync->lock);
 }
 
+static void imusync_convert_frame(const imu_sync_frame_data *p_imu_sync_frame_data, k4a_imu_sample_t *capture)
+{
+    capture->acc_timestamp_usec = p_imu_sync_frame_data->timestamp;
+    capture->gyro_timestamp_usec = p_imu_sync_frame_data->gyro_timestamp;
+    capture->temperature = p_imu_sync_frame_data->temp;
+    capture->acc_sample.xyz.x = p_imu_sync_frame_data->accel_data[0];
+    capture->acc_sample.xyz.y = p_imu_sync_frame_data->accel_data[1];
+    capture->acc_sample.xyz.z = p_imu_sync_frame_data->accel_data[2];
+
+    capture->gyro_sample.xyz.x = p_imu_sync_frame_data->gyro_data[0];
+    capture->gyro_sample.xyz.y = p_imu_sync_frame_data->gyro_data[1];
+    capture->gyro_sample.xyz.z = p_imu_sync_frame_data->gyro_data[2];
+}
+
 k4a_wait_result_t imusync_get_frame(imusync_t imusync_handle, k4a_imu_sample_t *capture, int32_t timeout_in_ms)
+{
+    size_t sample_count = 0;
+    return imusync_get_frames(imusync_handle, capture, 1, timeout_in_ms, &sample_count);
+}
+
+k4a_wait_result_t imusync_get_frames(imusync_t imusync_handle,
+                                     k4a_imu_sample_t *samples,
+                                     size_t max_count,
+                                     int32_t timeout_in_ms,
+                                     size_t *sample_count)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_WAIT_RESULT_FAILED, imusync_t, imusync_handle);
-    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, capture == NULL);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, samples == NULL);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, max_count == 0);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, sample_count == NULL);
 
     imusync_context_t *sync = imusync_t_get_context(imusync_handle);
-    k4a_capture_t capture_handle;
+    k4a_wait_result_t wresult = K4A_WAIT_RESULT_SUCCEEDED;
+    size_t count = 0;
 
-    k4a_wait_result_t wresult = frame_queue_pop(sync->sync_queue, timeout_in_ms, &capture_handle);
+    Lock(sync->lock);
 
-    if (wresult == K4A_WAIT_RESULT_SUCCEEDED)
+    if (!sync->running)
     {
-        imu_sync_frame_data *p_imu_sync_frame_data = (imu_sync_frame_data *)capture_handle;
-        capture->acc_timestamp_usec = p_imu_sync_frame_data->timestamp;
-        capture->gyro_timestamp_usec = p_imu_sync_frame_data->timestamp;
-        capture->temperature = p_imu_sync_frame_data->temp;
-        //λת g to m/s/s
-        capture->acc_sample.xyz.x = (float)(p_imu_sync_frame_data->accel_data[0] );
-        capture->acc_sample.xyz.y = (float)(p_imu_sync_frame_data->accel_data[1] );
-        capture->acc_sample.xyz.z = (float)(p_imu_sync_frame_data->accel_data[2] );
-
-        
-        capture->gyro_sample.xyz.x = (float)(p_imu_sync_frame_data->gyro_data[0] );
-        capture->gyro_sample.xyz.y = (float)(p_imu_sync_frame_data->gyro_data[1] );
-        capture->gyro_sample.xyz.z = (float)(p_imu_sync_frame_data->gyro_data[2] );
-        
+        LOG_ERROR("IMU samples read while the IMU is stopped.", 0);
+        wresult = K4A_WAIT_RESULT_FAILED;
     }
+    else if (sync->sync_read_count == sync->sync_write_count)
+    {
+        wresult = K4A_WAIT_RESULT_TIMEOUT;
+        if (timeout_in_ms != 0)
+        {
+            tickcounter_ms_t start_ms = 0;
+            tickcounter_ms_t now_ms = 0;
+            (void)tickcounter_get_current_ms(sync->tick, &start_ms);
+
+            // The wait can end without a new sample, on a spurious wake up or because another thread read the sample
+            // first, so wait again for the rest of the timeout
+            sync->pop_blocked++;
+            while (sync->running && sync->sync_read_count == sync->sync_write_count)
+            {
+                // Anything less than 0 is a wait forever condition, which is a timeout of 0 for Condition_Wait
+                int wait_in_ms = 0;
+                if (timeout_in_ms > 0)
+                {
+                    (void)tickcounter_get_current_ms(sync->tick, &now_ms);
+                    if (now_ms - start_ms >= (tickcounter_ms_t)timeout_in_ms)
+                    {
+                        break;
+                    }
+                    wait_in_ms = timeout_in_ms - (int)(now_ms - start_ms);
+                }
+
+                if (Condition_Wait(sync->condition, sync->lock, wait_in_ms) == COND_ERROR)
+                {
+                    wresult = K4A_WAIT_RESULT_FAILED;
+                    break;
+                }
+            }
+            sync->pop_blocked--;
+
+            if (!sync->running)
+            {
+                wresult = K4A_WAIT_RESULT_FAILED;
+            }
+        }
+    }
+
+    if (sync->running)
+    {
+        while (count < max_count && sync->sync_read_count != sync->sync_write_count)
+        {
+            imusync_convert_frame(&sync->sync_queue[sync->sync_read_count % IMU_SYNC_QUEUE_SIZE], &samples[count]);
+            sync->sync_read_count++;
+            count++;
+        }
+        if (count != 0)
+        {
+            wresult = K4A_WAIT_RESULT_SUCCEEDED;
+        }
+    }
+
+    Unlock(sync->lock);
 
-    free_imu_buff(capture_handle);
+    *sample_count = count;
     return wresult;
 }
+
+void imusync_get_stats(imusync_t imusync_handle, frame_queue_stats_t *stats)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, imusync_t, imusync_handle);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, stats == NULL);
+    imusync_context_t *sync = imusync_t_get_context(imusync_handle);
+
+    Lock(sync->lock);
+    *stats = sync->queue_stats;
+    Unlock(sync->lock);
+}
+
+void imusync_get_pairing_stats(imusync_t imusync_handle, imusync_pairing_stats_t *stats)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, imusync_t, imusync_handle);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, stats == NULL);
+    imusync_context_t *sync = imusync_t_get_context(imusync_handle);
+
+    Lock(sync->lock);
+    *stats = sync->pairing_stats;
+    Unlock(sync->lock);
+}
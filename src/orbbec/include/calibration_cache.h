@@ -0,0 +1,89 @@
+/** \file calibration_cache.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure SDK.
+ *
+ * On-disk cache of the raw calibration read from devices
+ */
+
+#ifndef CALIBRATION_CACHE_H
+#define CALIBRATION_CACHE_H
+
+#include <k4a/k4atypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Environment variable holding the directory the calibration cache is stored in. The cache is disabled when it is
+ * not set.
+ */
+#define CALIBRATION_CACHE_ENV_VAR "K4A_CALIBRATION_CACHE_DIR"
+
+/** Get the directory of the calibration cache
+ *
+ * \return The value of \ref CALIBRATION_CACHE_ENV_VAR, or NULL if it is not set and calibration should always be
+ * read from the device
+ */
+const char *calibration_cache_get_directory(void);
+
+/** Reads the raw calibration of a device from the cache
+ *
+ * \param directory
+ * Directory of the cache
+ *
+ * \param serial_number
+ * Serial number of the device
+ *
+ * \param firmware_version
+ * Firmware version of the device. Entries written for another firmware version are not used.
+ *
+ * \param data
+ * Location to write the calibration to
+ *
+ * \param data_size
+ * On input the size of data, on output the size of the calibration
+ *
+ * \return K4A_RESULT_SUCCEEDED if the entry exists, its checksum matches and it fits in data. Nothing is logged when
+ * there is no entry yet.
+ */
+k4a_result_t calibration_cache_read(const char *directory,
+                                    const char *serial_number,
+                                    const char *firmware_version,
+                                    uint8_t *data,
+                                    size_t *data_size);
+
+/** Writes the raw calibration of a device to the cache, replacing any previous entry
+ *
+ * \param directory
+ * Directory of the cache, it must already exist
+ *
+ * \param serial_number
+ * Serial number of the device
+ *
+ * \param firmware_version
+ * Firmware version of the device
+ *
+ * \param data
+ * Calibration to store
+ *
+ * \param data_size
+ * Size of data
+ *
+ * \remarks
+ * The entry is written to a temporary file first, so a concurrent calibration_cache_read() never sees a partially
+ * written entry.
+ *
+ * \return K4A_RESULT_SUCCEEDED if the entry was written
+ */
+k4a_result_t calibration_cache_write(const char *directory,
+                                     const char *serial_number,
+                                     const char *firmware_version,
+                                     const uint8_t *data,
+                                     size_t data_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CALIBRATION_CACHE_H */
@@ -33,6 +33,15 @@ K4A_DECLARE_HANDLE(frame_queue_t);
 
 typedef void(k4a_capture_release_t)(k4a_capture_t capture);
 
+/** Statistics of a queue since it was last enabled, see \ref frame_queue_get_stats.
+ */
+typedef struct _frame_queue_stats_t
+{
+    uint64_t pushed_count;  // Number of captures pushed into the enabled queue
+    uint64_t dropped_count; // Number of captures dropped because the queue was full
+    uint32_t high_water;    // Largest number of captures held by the queue at once
+} frame_queue_stats_t;
+
 /** Open a handle to the queue device.
  *
  * \param queue_depth [IN]
@@ -53,6 +62,28 @@ typedef void(k4a_capture_release_t)(k4a_capture_t capture);
  */
 k4a_result_t frame_queue_create(uint32_t queue_depth, const char *queue_name, frame_queue_t *queue_handle, k4a_capture_release_t capture_release);
 
+/** Open a handle to a queue that only one thread pushes to.
+ *
+ * \param queue_depth [IN]
+ *  The max number of elements the queue can hold. This value is capped at 10,000.
+ *
+ * \param queue_name [IN]
+ *  The name of the queue, used by the logger to generate error messages.
+ *
+ * \param queue_handle [OUT]
+ *  A pointer to write the opened queue handle to
+ *
+ * \return K4A_RESULT_SUCCEEDED if the device was opened, otherwise K4A_RESULT_FAILED
+ *
+ * Behaves like a queue from \ref frame_queue_create, but \ref frame_queue_push and \ref frame_queue_pop don't take a
+ * lock. A blocked \ref frame_queue_pop sleeps on a futex (WaitOnAddress on Windows) and is woken directly by the push.
+ * \ref frame_queue_push must only be called from one thread at a time.
+ */
+k4a_result_t frame_queue_create_single_producer(uint32_t queue_depth,
+                                                const char *queue_name,
+                                                frame_queue_t *queue_handle,
+                                                k4a_capture_release_t capture_release);
+
 /** Destroys the handle to the queue device.
  *
  * \param queue_handle [in]
@@ -91,7 +122,7 @@ void frame_queue_push(frame_queue_t queue_handle, k4a_capture_t capture_handle);
  * The queue has a fixed size, when that size is been reached a capture needs to be dropped for this API to succeed. In
  * this case that dropped capture will be returned with dropped_handle.
  */
-void frame_queue_push_w_dropped(frame_queue_t queue_handle, k4a_capture_t capture_handle);
+void frame_queue_push_w_dropped(frame_queue_t queue_handle, k4a_capture_t capture_handle, k4a_capture_t *dropped_handle);
 
 
 /** Removes a \ref k4a_capture_t object from the queue.
@@ -112,6 +143,32 @@ void frame_queue_push_w_dropped(frame_queue_t queue_handle, k4a_capture_t captur
  */
 k4a_wait_result_t frame_queue_pop(frame_queue_t queue_handle, int32_t wait_in_ms, k4a_capture_t *capture_handle);
 
+/** Removes up to max_count \ref k4a_capture_t objects from the queue.
+ *
+ * \param queue_handle [in]
+ *  A queue handle
+ *
+ * \param wait_in_ms [in]
+ * How long to wait for the first capture if the queue is empty, see \ref frame_queue_pop.
+ *
+ * \param capture_handles [out]
+ * The location to write the popped captures to, oldest first
+ *
+ * \param max_count [in]
+ * The number of captures capture_handles can hold
+ *
+ * \param count [out]
+ * The number of captures written to capture_handles
+ *
+ * Waits like \ref frame_queue_pop until the queue holds at least one capture, then takes every queued capture up to
+ * max_count while holding the queue lock once. Returns the same results as \ref frame_queue_pop.
+ */
+k4a_wait_result_t frame_queue_pop_many(frame_queue_t queue_handle,
+                                       int32_t wait_in_ms,
+                                       k4a_capture_t *capture_handles,
+                                       uint32_t max_count,
+                                       uint32_t *count);
+
 /** Enables the queue for accepting data
  *
  * \param queue_handle [in]
@@ -128,6 +185,16 @@ void frame_queue_enable(frame_queue_t queue_handle);
  */
 void frame_queue_disable(frame_queue_t queue_handle);
 
+/** Gets the statistics of the queue since it was last enabled
+ *
+ * \param queue_handle [in]
+ *  A queue handle
+ *
+ * \param stats [out]
+ *  Location to write the statistics to
+ */
+void frame_queue_get_stats(frame_queue_t queue_handle, frame_queue_stats_t *stats);
+
 /** Notify the queue that it needs to stop
  *
  * \param queue_handle [in]
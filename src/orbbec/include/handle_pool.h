@@ -0,0 +1,92 @@
+/** \file handle_pool.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure SDK.
+ *
+ * Pool of released image and capture handles
+ */
+
+#ifndef HANDLE_POOL_H
+#define HANDLE_POOL_H
+
+#include <stddef.h>
+#include <atomic>
+
+/** The number of released handles of each type that are kept for reuse.
+ */
+#define HANDLE_POOL_SIZE 64
+
+// Free list of released handles, so streaming reuses the image and capture handles instead of allocating new ones
+// for every frame. Each slot is claimed or filled with a single atomic operation, which keeps the pool lock-free and
+// means a handle can't be handed out twice. Handles that don't fit in the pool are destroyed.
+//
+// Handles in the pool are recycled, see K4A_DECLARE_POOLED_CONTEXT, so a handle that is used after its last release
+// is rejected by get_context until the next create hands it out again.
+template<typename handle_t, typename context_t> class handle_pool
+{
+public:
+    handle_pool(void (*recycle_handle)(handle_t),
+                context_t *(*reuse_handle)(handle_t),
+                void (*destroy_handle)(handle_t)) :
+        m_recycle_handle(recycle_handle),
+        m_reuse_handle(reuse_handle),
+        m_destroy_handle(destroy_handle)
+    {
+        for (size_t i = 0; i < HANDLE_POOL_SIZE; i++)
+        {
+            m_slots[i] = NULL;
+        }
+    }
+
+    ~handle_pool()
+    {
+        handle_t handle = NULL;
+        while (acquire(&handle) != NULL)
+        {
+            m_destroy_handle(handle);
+        }
+    }
+
+    // Returns the context of a pooled handle, or NULL if the pool is empty
+    context_t *acquire(handle_t *handle)
+    {
+        for (size_t i = 0; i < HANDLE_POOL_SIZE; i++)
+        {
+            if (m_slots[i].load(std::memory_order_relaxed) != NULL)
+            {
+                *handle = m_slots[i].exchange(NULL, std::memory_order_acquire);
+                if (*handle != NULL)
+                {
+                    return m_reuse_handle(*handle);
+                }
+            }
+        }
+        *handle = NULL;
+        return NULL;
+    }
+
+    void release(handle_t handle)
+    {
+        // Recycled before it is published, another thread may acquire it as soon as it is in a slot
+        m_recycle_handle(handle);
+        for (size_t i = 0; i < HANDLE_POOL_SIZE; i++)
+        {
+            handle_t empty = NULL;
+            if (m_slots[i].load(std::memory_order_relaxed) == NULL &&
+                m_slots[i].compare_exchange_strong(empty, handle, std::memory_order_release))
+            {
+                return;
+            }
+        }
+        (void)m_reuse_handle(handle);
+        m_destroy_handle(handle);
+    }
+
+private:
+    std::atomic<handle_t> m_slots[HANDLE_POOL_SIZE];
+    void (*m_recycle_handle)(handle_t);
+    context_t *(*m_reuse_handle)(handle_t);
+    void (*m_destroy_handle)(handle_t);
+};
+
+#endif /* HANDLE_POOL_H */
@@ -11,6 +11,7 @@
 
 //TODO:delete
 #include <k4a/k4atypes.h>
+#include <frame_queue.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -28,6 +29,7 @@ typedef struct _imu_sync_frame_data
     float accel_data[3];
     float gyro_data[3];
     uint64_t timestamp;
+    uint64_t gyro_timestamp; // Same as timestamp, unless the sample was added with imusync_push_sample()
     float temp;
 } imu_sync_frame_data;
 
@@ -37,6 +39,19 @@ typedef enum _imu_data_type
     GYRO_FRAME_TYPE = 1,
 } imu_data_type;
 
+/** How well the accelerometer and gyroscope samples were paired since imusync_start(), see
+ * imusync_get_pairing_stats()
+ */
+typedef struct _imusync_pairing_stats_t
+{
+    uint64_t paired_count;          // Synchronized samples produced
+    uint64_t interpolated_count;    // Synchronized samples with an interpolated gyroscope sample
+    uint64_t unmatched_accel_count; // Accelerometer samples dropped without a partner
+    uint64_t unmatched_gyro_count;  // Gyroscope samples dropped without a partner, interpolation may skip more
+    uint64_t max_gap_usec;          // Largest distance from a synchronized sample to a gyroscope sample used for it
+    uint64_t total_gap_usec;        // Sum of those distances, divide by paired_count for the mean
+} imusync_pairing_stats_t;
+
 /** Handle to the imusync module
  *
  * Handles are created with imusync_create() and closed
@@ -103,6 +118,33 @@ k4a_wait_result_t imusync_get_frame(imusync_t imusync_handle,
                                       k4a_imu_sample_t *capture_handle,
                                           int32_t timeout_in_ms);
 
+/** Reads every available sample from the synchronized sample queue
+ *
+ * \param imusync_handle
+ * The imusync handle from imusync_create()
+ *
+ * \param samples
+ * The location to write the samples to, oldest first
+ *
+ * \param max_count
+ * The number of samples \p samples can hold
+ *
+ * \param timeout_in_ms
+ * How long to wait for the first sample if none is queued
+ *
+ * \param sample_count
+ * The location to write the number of samples read to
+ *
+ * \remarks
+ * Waits like imusync_get_frame() for the first sample, then takes all queued samples up to \p max_count while locking
+ * the queue once.
+ */
+k4a_wait_result_t imusync_get_frames(imusync_t imusync_handle,
+                                     k4a_imu_sample_t *samples,
+                                     size_t max_count,
+                                     int32_t timeout_in_ms,
+                                     size_t *sample_count);
+
 /** Capturesync module asynchronously accepts new captures from color and depth modules through this API.
  *
  * \param imusync_handle
@@ -123,8 +165,54 @@ k4a_wait_result_t imusync_get_frame(imusync_t imusync_handle,
  */
 void imusync_push_frame(imusync_t imusync_handle, imu_frame_data imu_data, imu_data_type imu_type);
 
-//ܣͷڴ
-void free_imu_buff(k4a_capture_t capture);
+/** Adds a sample that is already synchronized, such as a sample read from a recording
+ *
+ * \param imusync_handle
+ * The imusync handle from imusync_create()
+ *
+ * \param imu_sample
+ * The sample to add. Its accelerometer and gyroscope timestamps may differ, both are kept.
+ *
+ * \remarks
+ * The sample is queued for imusync_get_frame() as is, without pairing it with the samples from imusync_push_frame().
+ * It is counted as a paired sample in imusync_get_pairing_stats().
+ */
+void imusync_push_sample(imusync_t imusync_handle, const k4a_imu_sample_t *imu_sample);
+
+/** Gets the statistics of the synchronized sample queue since imusync_start()
+ *
+ * \param imusync_handle
+ * The imusync handle from imusync_create()
+ *
+ * \param stats
+ * The location to write the statistics to
+ */
+void imusync_get_stats(imusync_t imusync_handle, frame_queue_stats_t *stats);
+
+/** Gets how well the samples were paired since imusync_start()
+ *
+ * \param imusync_handle
+ * The imusync handle from imusync_create()
+ *
+ * \param stats
+ * The location to write the statistics to
+ */
+void imusync_get_pairing_stats(imusync_t imusync_handle, imusync_pairing_stats_t *stats);
+
+/** Chooses how accelerometer and gyroscope samples are paired
+ *
+ * \param imusync_handle
+ * The imusync handle from imusync_create()
+ *
+ * \param interpolate
+ * False to pair samples with equal timestamps and drop the rest. True to produce a sample for every accelerometer
+ * sample, with the gyroscope linearly interpolated between the samples before and after it.
+ *
+ * \remarks
+ * Pairing equal timestamps is the default. Setting the K4A_IMU_INTERPOLATION environment variable to a non zero value
+ * makes interpolation the default.
+ */
+void imusync_set_interpolation(imusync_t imusync_handle, bool interpolate);
 
 #ifdef __cplusplus
 }
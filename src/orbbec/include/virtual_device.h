@@ -0,0 +1,140 @@
+/** \file virtual_device.h
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License.
+ * Kinect For Azure SDK.
+ *
+ * Replay a recording as if it was streamed by a device
+ */
+
+#ifndef VIRTUAL_DEVICE_H
+#define VIRTUAL_DEVICE_H
+
+#include <k4a/k4atypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Environment variable holding the path of the recording to open as a virtual device.
+ */
+#define VIRTUAL_DEVICE_ENV_VAR "K4A_VIRTUAL_DEVICE"
+
+/** Handle to the virtual device module
+ *
+ * Handles are created with virtual_device_create() and closed
+ * with virtual_device_destroy().
+ * Invalid handles are set to 0.
+ */
+K4A_DECLARE_HANDLE(virtual_device_t);
+
+/** Called from the replay thread with each capture once it is due. The callback owns the reference on the capture.
+ */
+typedef void(virtual_device_capture_cb_t)(k4a_capture_t capture_handle, void *context);
+
+/** Called from the replay thread with each IMU sample once it is due.
+ */
+typedef void(virtual_device_imu_cb_t)(const k4a_imu_sample_t *imu_sample, void *context);
+
+/** Get the path of the recording to replay
+ *
+ * \return The value of \ref VIRTUAL_DEVICE_ENV_VAR, or NULL if it is not set and real devices should be used
+ */
+const char *virtual_device_get_recording_path(void);
+
+/** Opens a recording as a virtual device
+ *
+ * \param path
+ * Path of the .mkv file to replay
+ *
+ * \param virtual_device_handle
+ * pointer to a handle location to store the handle. This is only written on K4A_RESULT_SUCCEEDED;
+ *
+ * \remarks
+ * The recording is read through k4arecord, which is loaded when the first virtual device is created since k4arecord
+ * itself links against this library.
+ *
+ * To cleanup this resource call virtual_device_destroy().
+ *
+ * \ref K4A_RESULT_SUCCEEDED is returned on success
+ */
+k4a_result_t virtual_device_create(const char *path, virtual_device_t *virtual_device_handle);
+
+/** Stops any replay and closes the recording
+ *
+ * \param virtual_device_handle
+ * The virtual device handle to destroy
+ */
+void virtual_device_destroy(virtual_device_t virtual_device_handle);
+
+/** Get the raw calibration stored in the recording
+ *
+ * \remarks
+ * Follows the same buffer conventions as k4a_device_get_raw_calibration()
+ */
+k4a_buffer_result_t virtual_device_get_raw_calibration(virtual_device_t virtual_device_handle,
+                                                       uint8_t *data,
+                                                       size_t *data_size);
+
+/** Get a tag stored in the recording, such as K4A_DEVICE_SERIAL_NUMBER
+ *
+ * \remarks
+ * Follows the same buffer conventions as k4a_playback_get_tag()
+ */
+k4a_buffer_result_t virtual_device_get_tag(virtual_device_t virtual_device_handle,
+                                           const char *name,
+                                           char *value,
+                                           size_t *value_size);
+
+/** Starts replaying the camera tracks of the recording
+ *
+ * \param virtual_device_handle
+ * The virtual device handle
+ *
+ * \param config
+ * The configuration requested by the caller. The recording is replayed as it was recorded, a warning is logged when
+ * the configuration does not match it.
+ *
+ * \param capture_cb
+ * Called with each capture at the recorded frame rate. When the end of the recording is reached it is replayed from
+ * the start, with device timestamps that keep increasing.
+ *
+ * \param context
+ * Passed to capture_cb
+ *
+ * \ref K4A_RESULT_SUCCEEDED is returned on success
+ */
+k4a_result_t virtual_device_start_cameras(virtual_device_t virtual_device_handle,
+                                          const k4a_device_configuration_t *config,
+                                          virtual_device_capture_cb_t *capture_cb,
+                                          void *context);
+
+/** Stops replaying the camera tracks. capture_cb is not called once this returns.
+ */
+void virtual_device_stop_cameras(virtual_device_t virtual_device_handle);
+
+/** Starts replaying the IMU track of the recording
+ *
+ * \param virtual_device_handle
+ * The virtual device handle
+ *
+ * \param imu_cb
+ * Called with each IMU sample at the recorded rate, looping like virtual_device_start_cameras()
+ *
+ * \param context
+ * Passed to imu_cb
+ *
+ * \ref K4A_RESULT_SUCCEEDED is returned on success
+ */
+k4a_result_t virtual_device_start_imu(virtual_device_t virtual_device_handle,
+                                      virtual_device_imu_cb_t *imu_cb,
+                                      void *context);
+
+/** Stops replaying the IMU track. imu_cb is not called once this returns.
+ */
+void virtual_device_stop_imu(virtual_device_t virtual_device_handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VIRTUAL_DEVICE_H */
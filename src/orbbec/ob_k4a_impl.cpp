@@ -24,6 +24,9 @@
 
 #include <imusync.h>
 #include <frame_queue.h>
+#include <virtual_device.h>
+#include <calibration_cache.h>
+#include <handle_pool.h>
 
 #include "obmetadata.h"
 #include "ob_type_helper.hpp"
@@ -43,6 +46,8 @@
 #include <mutex>
 #include <atomic>
 #include <condition_variable>
+#include <cmath>
+#include <algorithm>
 
 #define ORBBEC_MEGA_PID 0x0669
 #define ORBBEC_BOLT_PID 0x066B
@@ -128,6 +133,29 @@ typedef struct _calibration_json
     uint32_t status;
 } calibration_json_t;
 
+#define LATENCY_BUCKET_COUNT 128
+
+// Histogram of latencies in microseconds. Each power of 2 is split into 4 buckets, so a percentile read from it is
+// within 25% of the real value. Every thread calling k4a_device_get_capture() adds to it, so it is updated atomically.
+typedef struct _latency_histogram_t
+{
+    std::atomic<uint32_t> buckets[LATENCY_BUCKET_COUNT];
+    std::atomic<uint32_t> max_usec;
+} latency_histogram_t;
+
+// Frame counts and device timestamp intervals of one stream, see k4a_device_get_stream_stats()
+typedef struct _stream_counters_t
+{
+    uint64_t delivered_count;
+    uint64_t dropped_count;
+    uint64_t last_timestamp_usec;
+
+    // Running mean and sum of squared differences from the mean (Welford's method) of the intervals
+    uint64_t interval_count;
+    double interval_mean;
+    double interval_m2;
+} stream_counters_t;
+
 typedef struct _k4a_device_context_t
 {
     char serial_number[16];
@@ -155,6 +183,24 @@ typedef struct _k4a_device_context_t
     std::condition_variable clock_sync_cv;
     std::mutex clock_sync_mtx;
     std::thread clock_sync_thread;
+
+    // Set by k4a_device_set_capture_callback(). When set, captures are passed to capture_cb instead of frameset_queue.
+    std::mutex capture_cb_lock;
+    k4a_capture_ready_cb_t *capture_cb;
+    void *capture_cb_context;
+
+    // Statistics for k4a_device_get_stream_stats(). The counters are written by the libobsensor callback threads.
+    std::mutex stats_lock;
+    stream_counters_t color_counters;
+    stream_counters_t depth_counters;
+    stream_counters_t ir_counters;
+    stream_counters_t imu_counters;
+    latency_histogram_t capture_latency;
+
+    // Set when the device replays a recording, see virtual_device.h. device and pipe stay NULL in that case.
+    virtual_device_t virtual_device;
+    k4a_color_control_mode_t virtual_color_control_modes[K4A_COLOR_CONTROL_HDR + 1];
+    int32_t virtual_color_control_values[K4A_COLOR_CONTROL_HDR + 1];
 } k4a_device_context_t;
 
 K4A_DECLARE_CONTEXT(k4a_device_t, k4a_device_context_t);
@@ -164,9 +210,80 @@ typedef struct _k4a_image_context_t
     ob_frame *frame;
     int stride;
     std::atomic<int> ref_cnt;
+
+    // Properties that don't change for the lifetime of the frame, read once by init_image_context() so the image
+    // getters don't call into libobsensor.
+    uint8_t *buffer;
+    size_t size;
+    k4a_image_format_t format;
+    int width_pixels;
+    int height_pixels;
+    int stride_bytes;
 } k4a_image_context_t;
 
-K4A_DECLARE_CONTEXT(k4a_image_t, k4a_image_context_t);
+K4A_DECLARE_POOLED_CONTEXT(k4a_image_t, k4a_image_context_t);
+
+typedef struct _k4a_capture_context_t
+{
+    ob_frame *frame_set;
+    std::atomic<int> ref_cnt;
+
+    // When the capture was received from the device, for the latency in k4a_device_get_stream_stats()
+    std::chrono::steady_clock::time_point arrival_time;
+
+    // Streams counted in k4a_device_get_stream_stats() when the capture arrived, bit i is capture_stream_types[i]
+    uint32_t stream_mask;
+
+    // Images returned by k4a_capture_get_*_image(), so repeated calls on the same capture return the same handle
+    // instead of creating a new one. The capture holds a reference on each of them.
+    std::mutex images_lock;
+    k4a_image_t color_image;
+    k4a_image_t depth_image;
+    k4a_image_t ir_image;
+} k4a_capture_context_t;
+
+K4A_DECLARE_POOLED_CONTEXT(k4a_capture_t, k4a_capture_context_t);
+
+static handle_pool<k4a_image_t, k4a_image_context_t> image_handle_pool(k4a_image_t_recycle,
+                                                                       k4a_image_t_reuse,
+                                                                       k4a_image_t_destroy);
+static handle_pool<k4a_capture_t, k4a_capture_context_t> capture_handle_pool(k4a_capture_t_recycle,
+                                                                             k4a_capture_t_reuse,
+                                                                             k4a_capture_t_destroy);
+
+static k4a_image_context_t *create_image_handle(k4a_image_t *image_handle)
+{
+    k4a_image_context_t *image_ctx = image_handle_pool.acquire(image_handle);
+    if (image_ctx != NULL)
+    {
+        return image_ctx;
+    }
+    return k4a_image_t_create(image_handle);
+}
+
+// Wraps frame_set in a capture handle, which takes ownership of the frame_set reference
+static k4a_capture_t create_capture_handle(ob_frame *frame_set)
+{
+    k4a_capture_t capture_handle = NULL;
+    k4a_capture_context_t *capture_ctx = capture_handle_pool.acquire(&capture_handle);
+    if (capture_ctx == NULL)
+    {
+        capture_ctx = k4a_capture_t_create(&capture_handle);
+    }
+
+    if (capture_ctx == NULL)
+    {
+        return NULL;
+    }
+
+    capture_ctx->frame_set = frame_set;
+    capture_ctx->ref_cnt = 1;
+    capture_ctx->stream_mask = 0;
+    capture_ctx->color_image = NULL;
+    capture_ctx->depth_image = NULL;
+    capture_ctx->ir_image = NULL;
+    return capture_handle;
+}
 
 typedef struct _k4a_depthengine_instance_helper_t
 {
@@ -192,6 +309,10 @@ K4A_DECLARE_CONTEXT(k4a_depthengine_t, k4a_depthengine_instance_helper_t);
 
 k4a_wired_sync_mode_t k4a_device_get_wired_sync_mode(k4a_device_t device_handle){
     k4a_device_context_t *device_ctx = k4a_device_t_get_context(device_handle);
+    if (device_ctx->virtual_device != NULL)
+    {
+        return K4A_WIRED_SYNC_MODE_STANDALONE;
+    }
     OB_DEVICE_SYNC_CONFIG ob_config;
     memset(&ob_config, 0, sizeof(OB_DEVICE_SYNC_CONFIG));
     uint32_t len;
@@ -235,6 +356,11 @@ void k4a_depth_engine_helper_release(k4a_depthengine_t handle){
 
 uint32_t k4a_device_get_installed_count(void)
 {
+    if (virtual_device_get_recording_path() != NULL)
+    {
+        // The recording replaces all real devices
+        return 1;
+    }
 
     auto ob_context_handler = get_ob_context_handler_instance();
     ob_context *context = ob_context_handler->context;
@@ -258,6 +384,202 @@ k4a_result_t k4a_set_allocator(k4a_memory_allocate_cb_t allocate, k4a_memory_des
     return result;
 }
 
+static void count_stream_frame(stream_counters_t *counters, uint64_t timestamp_usec)
+{
+    counters->delivered_count++;
+    if (counters->last_timestamp_usec != 0 && timestamp_usec > counters->last_timestamp_usec)
+    {
+        double interval = (double)(timestamp_usec - counters->last_timestamp_usec);
+        counters->interval_count++;
+        double delta = interval - counters->interval_mean;
+        counters->interval_mean += delta / (double)counters->interval_count;
+        counters->interval_m2 += delta * (interval - counters->interval_mean);
+    }
+    counters->last_timestamp_usec = timestamp_usec;
+}
+
+static void reset_latency_histogram(latency_histogram_t *histogram)
+{
+    for (size_t i = 0; i < LATENCY_BUCKET_COUNT; i++)
+    {
+        histogram->buckets[i] = 0;
+    }
+    histogram->max_usec = 0;
+}
+
+static uint32_t get_latency_bucket(uint32_t latency_usec)
+{
+    if (latency_usec < 4)
+    {
+        return latency_usec;
+    }
+
+    uint32_t msb = 2;
+    while (msb < 31 && (latency_usec >> (msb + 1)) != 0)
+    {
+        msb++;
+    }
+    return (msb - 1) * 4 + ((latency_usec >> (msb - 2)) & 3);
+}
+
+// Largest latency that falls into bucket
+static uint32_t get_latency_bucket_limit(uint32_t bucket)
+{
+    if (bucket < 4)
+    {
+        return bucket;
+    }
+
+    uint32_t shift = bucket / 4 - 1;
+    uint64_t limit = ((uint64_t)(4 + bucket % 4 + 1) << shift) - 1;
+    return limit > UINT32_MAX ? UINT32_MAX : (uint32_t)limit;
+}
+
+static void record_latency(latency_histogram_t *histogram, std::chrono::steady_clock::time_point start)
+{
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    uint32_t latency_usec = latency.count() > UINT32_MAX ? UINT32_MAX : (uint32_t)latency.count();
+
+    histogram->buckets[get_latency_bucket(latency_usec)]++;
+    uint32_t max_usec = histogram->max_usec;
+    while (latency_usec > max_usec && !histogram->max_usec.compare_exchange_weak(max_usec, latency_usec))
+    {
+    }
+}
+
+static uint32_t get_latency_percentile(const latency_histogram_t *histogram, uint64_t total, uint32_t percentile)
+{
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    uint64_t target = (total * percentile + 99) / 100;
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < LATENCY_BUCKET_COUNT; i++)
+    {
+        count += histogram->buckets[i];
+        if (count >= target)
+        {
+            return std::min(get_latency_bucket_limit(i), (uint32_t)histogram->max_usec);
+        }
+    }
+    return histogram->max_usec;
+}
+
+static void reset_camera_stats(k4a_device_context_t *device_ctx)
+{
+    std::lock_guard<std::mutex> lock(device_ctx->stats_lock);
+    device_ctx->color_counters = stream_counters_t();
+    device_ctx->depth_counters = stream_counters_t();
+    device_ctx->ir_counters = stream_counters_t();
+    reset_latency_histogram(&device_ctx->capture_latency);
+}
+
+static const ob_frame_type capture_stream_types[] = { OB_FRAME_COLOR, OB_FRAME_DEPTH, OB_FRAME_IR };
+
+// Returns a new reference on the frame of frame_set for frame_type, or NULL if frame_set has no such frame
+static ob_frame *get_frameset_frame(ob_frame *frame_set, ob_frame_type frame_type)
+{
+    ob_error *ob_err = NULL;
+    ob_frame *frame = NULL;
+    switch (frame_type)
+    {
+    case OB_FRAME_COLOR:
+        frame = ob_frameset_color_frame(frame_set, &ob_err);
+        break;
+    case OB_FRAME_DEPTH:
+        frame = ob_frameset_depth_frame(frame_set, &ob_err);
+        break;
+    default:
+        frame = ob_frameset_ir_frame(frame_set, &ob_err);
+        break;
+    }
+    CHECK_OB_ERROR_RETURN_VALUE(&ob_err, NULL);
+    return frame;
+}
+
+// Counts the streams of a capture that just arrived from the device. This queries the frame set only, so no image
+// handles are created. The intervals of each stream are measured with the device timestamp of its own frame.
+static void count_capture_frames(k4a_device_context_t *device_ctx, k4a_capture_context_t *capture_ctx)
+{
+    stream_counters_t *counters[] = { &device_ctx->color_counters,
+                                      &device_ctx->depth_counters,
+                                      &device_ctx->ir_counters };
+
+    uint32_t stream_mask = 0;
+    uint64_t timestamps_usec[COUNTOF(capture_stream_types)] = { 0 };
+    for (size_t i = 0; i < COUNTOF(capture_stream_types); i++)
+    {
+        ob_frame *frame = get_frameset_frame(capture_ctx->frame_set, capture_stream_types[i]);
+        if (frame != NULL)
+        {
+            ob_error *ob_err = NULL;
+            timestamps_usec[i] = ob_frame_time_stamp_us(frame, &ob_err);
+            CHECK_OB_ERROR(&ob_err);
+            stream_mask |= 1u << i;
+            ob_delete_frame(frame, &ob_err);
+            CHECK_OB_ERROR(&ob_err);
+        }
+    }
+    capture_ctx->stream_mask = stream_mask;
+
+    std::lock_guard<std::mutex> lock(device_ctx->stats_lock);
+    for (size_t i = 0; i < COUNTOF(capture_stream_types); i++)
+    {
+        if ((stream_mask & (1u << i)) != 0)
+        {
+            count_stream_frame(counters[i], timestamps_usec[i]);
+        }
+    }
+}
+
+static void count_dropped_frames(k4a_device_context_t *device_ctx, k4a_capture_t capture_handle)
+{
+    k4a_capture_context_t *capture_ctx = k4a_capture_t_get_context(capture_handle);
+    stream_counters_t *counters[] = { &device_ctx->color_counters,
+                                      &device_ctx->depth_counters,
+                                      &device_ctx->ir_counters };
+
+    std::lock_guard<std::mutex> lock(device_ctx->stats_lock);
+    for (size_t i = 0; i < COUNTOF(capture_stream_types); i++)
+    {
+        if ((capture_ctx->stream_mask & (1u << i)) != 0)
+        {
+            counters[i]->dropped_count++;
+        }
+    }
+}
+
+// Hands a new capture to the application, through the capture callback if one is set or else the capture queue.
+// Takes over the reference on the capture.
+static void device_capture_ready(k4a_device_context_t *device_ctx, k4a_capture_t capture_handle)
+{
+    k4a_capture_context_t *capture_ctx = k4a_capture_t_get_context(capture_handle);
+    capture_ctx->arrival_time = std::chrono::steady_clock::now();
+    count_capture_frames(device_ctx, capture_ctx);
+
+    {
+        // Held while calling the callback so k4a_device_set_capture_callback() doesn't return while the old callback
+        // is still running
+        std::lock_guard<std::mutex> lock(device_ctx->capture_cb_lock);
+        if (device_ctx->capture_cb != NULL)
+        {
+            // The callback takes over the reference on the capture
+            device_ctx->capture_cb(capture_handle, device_ctx->capture_cb_context);
+            return;
+        }
+    }
+
+    k4a_capture_t dropped_handle = NULL;
+    frame_queue_push_w_dropped(device_ctx->frameset_queue, capture_handle, &dropped_handle);
+    if (dropped_handle != NULL)
+    {
+        count_dropped_frames(device_ctx, dropped_handle);
+        k4a_capture_release(dropped_handle);
+    }
+}
+
 void ob_frame_set_ready(ob_frame *frame_set, void *user_data)
 {
     if (frame_set == NULL)
@@ -278,7 +600,36 @@ void ob_frame_set_ready(ob_frame *frame_set, void *user_data)
         return;
     }
 
-    frame_queue_push(device_ctx->frameset_queue, (k4a_capture_t)frame_set);
+    k4a_capture_t capture_handle = create_capture_handle(frame_set);
+    if (capture_handle == NULL)
+    {
+        ob_delete_frame(frame_set, &ob_err);
+        CHECK_OB_ERROR_RETURN(&ob_err);
+        LOG_ERROR("Failed to create capture", 0);
+        return;
+    }
+
+    device_capture_ready(device_ctx, capture_handle);
+}
+
+// Called from the replay thread of a virtual device, see virtual_device_start_cameras()
+void virtual_capture_ready(k4a_capture_t capture_handle, void *context)
+{
+    device_capture_ready((k4a_device_context_t *)context, capture_handle);
+}
+
+// Called from the replay thread of a virtual device, see virtual_device_start_imu()
+void virtual_imu_sample_ready(const k4a_imu_sample_t *imu_sample, void *context)
+{
+    k4a_device_context_t *device_ctx = (k4a_device_context_t *)context;
+
+    {
+        std::lock_guard<std::mutex> lock(device_ctx->stats_lock);
+        count_stream_frame(&device_ctx->imu_counters, imu_sample->acc_timestamp_usec);
+    }
+
+    // Recorded samples are already paired, they are queued as is with both of their timestamps
+    imusync_push_sample(device_ctx->imusync, imu_sample);
 }
 
 void ob_get_json_callback(ob_data_tran_state state, ob_data_chunk *data_chunk, void *user_data)
@@ -327,10 +678,54 @@ void ob_get_json_callback(ob_data_tran_state state, ob_data_chunk *data_chunk, v
     }
 }
 
+static k4a_result_t open_virtual_device(uint32_t index, const char *recording_path, k4a_device_t *device_handle)
+{
+    if (index != 0)
+    {
+        LOG_INFO("index is out of range", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_device_t handle = NULL;
+    k4a_device_context_t *device_ctx = k4a_device_t_create(&handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(device_ctx != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(virtual_device_create(recording_path, &device_ctx->virtual_device));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        // Recordings are not required to store the serial number
+        size_t serial_number_size = sizeof(device_ctx->serial_number);
+        if (virtual_device_get_tag(device_ctx->virtual_device,
+                                   "K4A_DEVICE_SERIAL_NUMBER",
+                                   device_ctx->serial_number,
+                                   &serial_number_size) != K4A_BUFFER_RESULT_SUCCEEDED)
+        {
+            memcpy(device_ctx->serial_number, "virtual", sizeof("virtual"));
+        }
+        *device_handle = handle;
+    }
+    else if (handle != NULL)
+    {
+        k4a_device_t_destroy(handle);
+    }
+
+    return result;
+}
+
 k4a_result_t k4a_device_open(uint32_t index, k4a_device_t *device_handle)
 {
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, device_handle == NULL);
 
+    const char *recording_path = virtual_device_get_recording_path();
+    if (recording_path != NULL)
+    {
+        return open_virtual_device(index, recording_path, device_handle);
+    }
+
     auto ob_context_handler = get_ob_context_handler_instance();
     ob_context *ob_ctx = ob_context_handler->context;
     std::vector<int> effective_device = get_effective_device(ob_ctx);
@@ -451,6 +846,42 @@ k4a_result_t update_imu_raw_calibration_data_from_orbbec_sdk(k4a_device_context_
 }
 
 
+static void create_calibration_json(k4a_device_context_t *device_ctx)
+{
+    if (device_ctx->json == NULL)
+    {
+        device_ctx->json = (calibration_json_t *)malloc(sizeof(calibration_json_t));
+        device_ctx->json->json_max_size = MAX_JSON_FILE_SIZE;
+        device_ctx->json->json_actual_size = 0;
+        device_ctx->json->calibration_json = (char *)malloc(device_ctx->json->json_max_size);
+        device_ctx->json->status = JSON_FILE_INVALID;
+    }
+}
+
+// Reads the calibration, with the IMU extrinsics already updated, from the cache instead of the device
+static k4a_result_t read_cached_calibration_data(k4a_device_context_t *device_ctx,
+                                                 const char *cache_directory,
+                                                 const char *serial_number,
+                                                 const char *firmware_version)
+{
+    // Leave room for the terminating '\0', like ob_get_json_callback()
+    size_t json_size = device_ctx->json->json_max_size - 1;
+    if (K4A_FAILED(calibration_cache_read(cache_directory,
+                                          serial_number,
+                                          firmware_version,
+                                          (uint8_t *)device_ctx->json->calibration_json,
+                                          &json_size)))
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    device_ctx->json->json_actual_size = (uint32_t)json_size;
+    device_ctx->json->calibration_json[json_size] = '\0';
+    device_ctx->json->status = JSON_FILE_VALID;
+    LOG_INFO("Calibration of device %s read from the cache", serial_number);
+    return K4A_RESULT_SUCCEEDED;
+}
+
 k4a_result_t fetch_raw_calibration_data(k4a_device_context_t *device_ctx)
 {
     k4a_result_t cali_create_rst = K4A_RESULT_FAILED;
@@ -465,13 +896,26 @@ k4a_result_t fetch_raw_calibration_data(k4a_device_context_t *device_ctx)
         CHECK_OB_ERROR_BREAK(&ob_err);
 
         if (pid == ORBBEC_MEGA_PID || pid == ORBBEC_BOLT_PID){
-            if (device_ctx->json == NULL)
+            create_calibration_json(device_ctx);
+
+            // Entries are keyed by serial number and firmware version, a firmware update may change the calibration
+            const char *cache_directory = calibration_cache_get_directory();
+            const char *firmware_version = NULL;
+            char serial_number[sizeof(device_ctx->serial_number) + 1] = { 0 };
+            if (cache_directory != NULL)
             {
-                device_ctx->json = (calibration_json_t *)malloc(sizeof(calibration_json_t));
-                device_ctx->json->json_max_size = MAX_JSON_FILE_SIZE;
-                device_ctx->json->json_actual_size = 0;
-                device_ctx->json->calibration_json = (char *)malloc(device_ctx->json->json_max_size);
-                device_ctx->json->status = JSON_FILE_INVALID;
+                memcpy(serial_number, device_ctx->serial_number, sizeof(device_ctx->serial_number));
+                firmware_version = ob_device_info_firmware_version(device_info, &ob_err);
+                CHECK_OB_ERROR_BREAK(&ob_err);
+
+                cali_create_rst = read_cached_calibration_data(device_ctx,
+                                                               cache_directory,
+                                                               serial_number,
+                                                               firmware_version);
+                if (K4A_SUCCEEDED(cali_create_rst))
+                {
+                    break;
+                }
             }
 
             ob_device_get_raw_data(device_ctx->device,
@@ -483,6 +927,16 @@ k4a_result_t fetch_raw_calibration_data(k4a_device_context_t *device_ctx)
             CHECK_OB_ERROR_BREAK(&ob_err);
 
             cali_create_rst = update_imu_raw_calibration_data_from_orbbec_sdk(device_ctx);
+
+            if (K4A_SUCCEEDED(cali_create_rst) && cache_directory != NULL)
+            {
+                // Failing to cache the calibration only makes the next open slower
+                (void)calibration_cache_write(cache_directory,
+                                              serial_number,
+                                              firmware_version,
+                                              (const uint8_t *)device_ctx->json->calibration_json,
+                                              device_ctx->json->json_actual_size);
+            }
         }
     } while(0);
 
@@ -494,30 +948,62 @@ k4a_result_t fetch_raw_calibration_data(k4a_device_context_t *device_ctx)
     return cali_create_rst;
 }
 
+// The recording stands in for the device's calibration, so k4a_device_get_calibration() and
+// k4a_device_get_raw_calibration() work the same for virtual devices
+static k4a_result_t read_virtual_calibration_data(k4a_device_context_t *device_ctx)
+{
+    create_calibration_json(device_ctx);
+
+    // Leave room for the terminating '\0', like ob_get_json_callback()
+    size_t json_size = device_ctx->json->json_max_size - 1;
+    if (virtual_device_get_raw_calibration(device_ctx->virtual_device,
+                                           (uint8_t *)device_ctx->json->calibration_json,
+                                           &json_size) != K4A_BUFFER_RESULT_SUCCEEDED)
+    {
+        LOG_WARNING("The recording of the virtual device has no calibration", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    device_ctx->json->json_actual_size = (uint32_t)json_size;
+    device_ctx->json->calibration_json[json_size] = '\0';
+    device_ctx->json->status = JSON_FILE_VALID;
+    return K4A_RESULT_SUCCEEDED;
+}
+
 k4a_result_t init_device_context(k4a_device_t device_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
     k4a_device_context_t *device_ctx = k4a_device_t_get_context(device_handle);
 
-    auto ob_context_handler = get_ob_context_handler_instance();
-    ob_context *ob_ctx = ob_context_handler->context;
+    std::shared_ptr<ob_context_handler> ob_context_handler;
     ob_device_list *dev_list = NULL;
     ob_error *ob_err = NULL;
 
     k4a_result_t result = K4A_RESULT_FAILED;
     do
     {
-        dev_list = ob_query_device_list(ob_ctx, &ob_err);
-        CHECK_OB_ERROR_BREAK(&ob_err);
+        if (device_ctx->virtual_device != NULL)
+        {
+            // Recordings made without a device have no calibration, they can still be replayed
+            read_virtual_calibration_data(device_ctx);
+        }
+        else
+        {
+            ob_context_handler = get_ob_context_handler_instance();
+            dev_list = ob_query_device_list(ob_context_handler->context, &ob_err);
+            CHECK_OB_ERROR_BREAK(&ob_err);
 
-        device_ctx->device = ob_device_list_get_device_by_serial_number(dev_list, device_ctx->serial_number, &ob_err);
-        CHECK_OB_ERROR_BREAK(&ob_err);
+            device_ctx->device = ob_device_list_get_device_by_serial_number(dev_list,
+                                                                            device_ctx->serial_number,
+                                                                            &ob_err);
+            CHECK_OB_ERROR_BREAK(&ob_err);
 
-        device_ctx->pipe = ob_create_pipeline_with_device((ob_device *)device_ctx->device, &ob_err);
-        CHECK_OB_ERROR_BREAK(&ob_err);
+            device_ctx->pipe = ob_create_pipeline_with_device((ob_device *)device_ctx->device, &ob_err);
+            CHECK_OB_ERROR_BREAK(&ob_err);
 
-        if (K4A_FAILED(fetch_raw_calibration_data(device_ctx))){
-            break;
+            if (K4A_FAILED(fetch_raw_calibration_data(device_ctx))){
+                break;
+            }
         }
 
         if (K4A_FAILED(TRACE_CALL(imusync_create(&device_ctx->imusync))))
@@ -525,7 +1011,8 @@ k4a_result_t init_device_context(k4a_device_t device_handle)
             break;
         }
 
-        if (K4A_FAILED(TRACE_CALL(frame_queue_create(
+        // Only the libobsensor frame set callback, or the replay thread of a virtual device, pushes to this queue
+        if (K4A_FAILED(TRACE_CALL(frame_queue_create_single_producer(
                 FRAME_QUEUE_DEFAULT_SIZE / 2, "frame_set", &device_ctx->frameset_queue, k4a_capture_release))))
         {
             break;
@@ -534,6 +1021,12 @@ k4a_result_t init_device_context(k4a_device_t device_handle)
         frame_queue_disable(device_ctx->frameset_queue);
         result = K4A_RESULT_SUCCEEDED;
 
+        if (device_ctx->virtual_device != NULL)
+        {
+            // Recorded timestamps are replayed as they are
+            break;
+        }
+
         const k4a_device_clock_sync_mode_t default_clock_sync_mode = K4A_DEVICE_CLOCK_SYNC_MODE_SYNC;
         const uint32_t default_interval_us = 60*1000*1000; // 60s
         k4a_device_switch_device_clock_sync_mode(device_handle, default_clock_sync_mode, default_interval_us);
@@ -600,7 +1093,7 @@ k4a_result_t init_device_context(k4a_device_t device_handle)
             device_ctx->have_been_init_once = true;                                                                    \
             init_device_context(device_handle);                                                                        \
         }                                                                                                              \
-        if (device_ctx->device == NULL)                                                                                \
+        if (device_ctx->device == NULL && device_ctx->virtual_device == NULL)                                          \
         {                                                                                                              \
             return _fail_value_;                                                                                       \
         }                                                                                                              \
@@ -628,6 +1121,11 @@ void device_timestamp_sync_with_host(k4a_device_t device_handle, uint32_t interv
 k4a_result_t k4a_device_enable_soft_filter(k4a_device_t device_handle, bool enable){
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
     k4a_device_context_t *device_ctx = k4a_device_t_get_context(device_handle);
+    if (device_ctx->virtual_device != NULL)
+    {
+        LOG_ERROR("The soft filter of a virtual device can't be changed, the recording is replayed as it is", 0);
+        return K4A_RESULT_FAILED;
+    }
     ob_error *ob_err = NULL;
     ob_device_set_bool_property(device_ctx->device, OB_PROP_DEPTH_SOFT_FILTER_BOOL, enable, &ob_err);
     CHECK_OB_ERROR_RETURN_K4A_RESULT(&ob_err);
@@ -649,6 +1147,13 @@ k4a_result_t k4a_device_switch_device_clock_sync_mode(k4a_device_t device_handle
     CHECK_AND_TRY_INIT_DEVICE_CONTEXT(K4A_RESULT_FAILED, device_handle);
     ob_error *ob_err = NULL;
     k4a_device_context_t *device_ctx = k4a_device_t_get_context(device_handle);
+    if (device_ctx->virtual_device != NULL)
+    {
+        // Recorded timestamps are replayed as they are, there is no device clock to synchronize
+        device_ctx->current_device_clock_sync_mode = timestamp_mode;
+        return K4A_RESULT_SUCCEEDED;
+    }
+
     k4a_result_t result = K4A_RESULT_FAILED;
     do{
         OB_DEVICE_SYNC_CONFIG ob_sync_config;
@@ -708,6 +1213,12 @@ void k4a_device_close(k4a_device_t device_handle)
         k4a_device_stop_imu(device_handle);
     }
 
+    if (device_ctx->virtual_device != NULL)
+    {
+        virtual_device_destroy(device_ctx->virtual_device);
+        device_ctx->virtual_device = NULL;
+    }
+
     if (device_ctx->device)
     {
         ob_delete_device((ob_device *)device_ctx->device, &ob_err);
@@ -762,6 +1273,11 @@ k4a_wait_result_t k4a_device_get_capture(k4a_device_t device_handle,
     k4a_wait_result_t result = K4A_WAIT_RESULT_SUCCEEDED;
 
     result = frame_queue_pop(device_ctx->frameset_queue, timeout_in_ms, (k4a_capture_t *)capture_handle);
+    if (result == K4A_WAIT_RESULT_SUCCEEDED)
+    {
+        k4a_capture_context_t *capture_ctx = k4a_capture_t_get_context(*capture_handle);
+        record_latency(&device_ctx->capture_latency, capture_ctx->arrival_time);
+    }
 
     // for test
     // if (result == K4A_WAIT_RESULT_SUCCEEDED)
@@ -802,6 +1318,84 @@ k4a_wait_result_t k4a_device_get_capture(k4a_device_t device_handle,
     return result;
 }
 
+k4a_result_t k4a_device_set_capture_callback(k4a_device_t device_handle,
+                                             k4a_capture_ready_cb_t *capture_cb,
+                                             void *capture_cb_context)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    CHECK_AND_TRY_INIT_DEVICE_CONTEXT(K4A_RESULT_FAILED, device_handle);
+    k4a_device_context_t *device_ctx = k4a_device_t_get_context(device_handle);
+
+    std::lock_guard<std::mutex> lock(device_ctx->capture_cb_lock);
+    device_ctx->capture_cb = capture_cb;
+    device_ctx->capture_cb_context = capture_cb_context;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+static void get_stream_counters(k4a_stream_stats_t *stats, const stream_counters_t *counters, uint32_t high_water)
+{
+    stats->delivered_count = counters->delivered_count;
+    stats->dropped_count = counters->dropped_count;
+    stats->queue_high_water = high_water;
+    stats->interval_mean_usec = (float)counters->interval_mean;
+    stats->interval_jitter_usec = 0;
+    if (counters->interval_count > 1)
+    {
+        stats->interval_jitter_usec = (float)std::sqrt(counters->interval_m2 / (double)(counters->interval_count - 1));
+    }
+}
+
+k4a_result_t k4a_device_get_stream_stats(k4a_device_t device_handle, k4a_device_stream_stats_t *stats)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stats == NULL);
+    CHECK_AND_TRY_INIT_DEVICE_CONTEXT(K4A_RESULT_FAILED, device_handle);
+    k4a_device_context_t *device_ctx = k4a_device_t_get_context(device_handle);
+
+    memset(stats, 0, sizeof(*stats));
+
+    frame_queue_stats_t capture_queue_stats = {};
+    if (device_ctx->frameset_queue != NULL)
+    {
+        frame_queue_get_stats(device_ctx->frameset_queue, &capture_queue_stats);
+    }
+
+    frame_queue_stats_t imu_queue_stats = {};
+    if (device_ctx->imusync != NULL)
+    {
+        imusync_get_stats(device_ctx->imusync, &imu_queue_stats);
+    }
+
+    const latency_histogram_t *histogram = &device_ctx->capture_latency;
+    uint64_t latency_count = 0;
+    for (size_t i = 0; i < LATENCY_BUCKET_COUNT; i++)
+    {
+        latency_count += histogram->buckets[i];
+    }
+
+    k4a_stream_stats_t camera_latency = {};
+    camera_latency.latency_p50_usec = get_latency_percentile(histogram, latency_count, 50);
+    camera_latency.latency_p90_usec = get_latency_percentile(histogram, latency_count, 90);
+    camera_latency.latency_p99_usec = get_latency_percentile(histogram, latency_count, 99);
+    camera_latency.latency_max_usec = histogram->max_usec;
+
+    std::lock_guard<std::mutex> lock(device_ctx->stats_lock);
+    k4a_stream_stats_t *camera_stats[] = { &stats->color, &stats->depth, &stats->ir };
+    const stream_counters_t *camera_counters[] = { &device_ctx->color_counters,
+                                                   &device_ctx->depth_counters,
+                                                   &device_ctx->ir_counters };
+    for (size_t i = 0; i < 3; i++)
+    {
+        *camera_stats[i] = camera_latency;
+        get_stream_counters(camera_stats[i], camera_counters[i], capture_queue_stats.high_water);
+    }
+
+    get_stream_counters(&stats->imu, &device_ctx->imu_counters, imu_queue_stats.high_water);
+    stats->imu.dropped_count = imu_queue_stats.dropped_count;
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
 void ob_accel_frame(ob_frame *frame, void *user_data)
 {
     k4a_device_t device_handle = (k4a_device_t)user_data;
@@ -833,6 +1427,11 @@ void ob_accel_frame(ob_frame *frame, void *user_data)
     memcpy(imu_data.data, &accel_value, sizeof(accel_value));
     imu_data.temp = temperature;
 
+    {
+        std::lock_guard<std::mutex> lock(device_ctx->stats_lock);
+        count_stream_frame(&device_ctx->imu_counters, timestamp);
+    }
+
     imusync_push_frame(device_ctx->imusync, imu_data, ACCEL_FRAME_TYPE);
     ob_delete_frame(frame, &ob_err);
     CHECK_OB_ERROR_RETURN(&ob_err);
@@ -893,6 +1492,28 @@ k4a_wait_result_t k4a_device_get_imu_sample(k4a_device_t device_handle,
     return result;
 }
 
+k4a_wait_result_t k4a_device_get_imu_samples(k4a_device_t device_handle,
+                                             k4a_imu_sample_t *imu_samples,
+                                             size_t max_count,
+                                             int32_t timeout_in_ms,
+                                             size_t *sample_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_WAIT_RESULT_FAILED, k4a_device_t, device_handle);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, imu_samples == NULL);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, max_count == 0);
+    RETURN_VALUE_IF_ARG(K4A_WAIT_RESULT_FAILED, sample_count == NULL);
+    CHECK_AND_TRY_INIT_DEVICE_CONTEXT(K4A_WAIT_RESULT_FAILED, device_handle);
+    k4a_device_context_t *device_ctx = k4a_device_t_get_context(device_handle);
+
+    *sample_count = 0;
+    if (device_ctx->imusync == NULL)
+    {
+        return K4A_WAIT_RESULT_FAILED;
+    }
+
+    return imusync_get_frames(device_ctx->imusync, imu_samples, max_count, timeout_in_ms, sample_count);
+}
+
 k4a_result_t k4a_device_start_imu(k4a_device_t device_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
@@ -905,6 +1526,29 @@ k4a_result_t k4a_device_start_imu(k4a_device_t device_handle)
         return K4A_RESULT_FAILED;
     }
 
+    {
+        std::lock_guard<std::mutex> lock(device_ctx->stats_lock);
+        device_ctx->imu_counters = stream_counters_t();
+    }
+
+    if (device_ctx->virtual_device != NULL)
+    {
+        if (K4A_FAILED(TRACE_CALL(imusync_start(device_ctx->imusync))))
+        {
+            return K4A_RESULT_FAILED;
+        }
+
+        if (K4A_FAILED(TRACE_CALL(
+                virtual_device_start_imu(device_ctx->virtual_device, virtual_imu_sample_ready, device_ctx))))
+        {
+            imusync_stop(device_ctx->imusync);
+            return K4A_RESULT_FAILED;
+        }
+
+        device_ctx->is_imu_streaming = true;
+        return K4A_RESULT_SUCCEEDED;
+    }
+
     if(!device_ctx->is_camera_streaming && device_ctx->current_device_clock_sync_mode == K4A_DEVICE_CLOCK_SYNC_MODE_RESET){
         OB_DEVICE_SYNC_CONFIG ob_sync_config;
         memset(&ob_sync_config, 0, sizeof(OB_DEVICE_SYNC_CONFIG));
@@ -1097,6 +1741,11 @@ void k4a_device_stop_imu(k4a_device_t device_handle)
     k4a_device_context_t *device_ctx = k4a_device_t_get_context(device_handle);
     ob_error *ob_err = NULL;
 
+    if (device_ctx->virtual_device != NULL)
+    {
+        virtual_device_stop_imu(device_ctx->virtual_device);
+    }
+
     if (device_ctx->accel_sensor != NULL)
     {
         ob_sensor_stop(device_ctx->accel_sensor, &ob_err);
@@ -1119,51 +1768,249 @@ void k4a_device_stop_imu(k4a_device_t device_handle)
     {
         imusync_stop(device_ctx->imusync);
     }
-    device_ctx->is_imu_streaming = false;
+    device_ctx->is_imu_streaming = false;
+}
+
+k4a_result_t k4a_capture_create(k4a_capture_t *capture_handle)
+{
+    k4a_result_t result = K4A_RESULT_FAILED;
+    ob_error *ob_err = NULL;
+    ob_frame *frame = ob_create_frameset(&ob_err);
+    CHECK_OB_ERROR_RETURN_K4A_RESULT(&ob_err);
+    if (frame != NULL)
+    {
+        *capture_handle = create_capture_handle(frame);
+        if (*capture_handle != NULL)
+        {
+            result = K4A_RESULT_SUCCEEDED;
+        }
+        else
+        {
+            ob_delete_frame(frame, &ob_err);
+            CHECK_OB_ERROR(&ob_err);
+        }
+    }
+    return result;
+}
+
+void k4a_capture_release(k4a_capture_t capture_handle)
+{
+    if (capture_handle != NULL)
+    {
+        auto capture_ctx = k4a_capture_t_get_context(capture_handle);
+        if (capture_ctx != NULL && --capture_ctx->ref_cnt == 0)
+        {
+            k4a_image_release(capture_ctx->color_image);
+            k4a_image_release(capture_ctx->depth_image);
+            k4a_image_release(capture_ctx->ir_image);
+
+            ob_error *ob_err = NULL;
+            ob_frame *frame = capture_ctx->frame_set;
+            capture_ctx->frame_set = NULL;
+            capture_handle_pool.release(capture_handle);
+            ob_delete_frame(frame, &ob_err);
+            CHECK_OB_ERROR_RETURN(&ob_err);
+        }
+    }
+}
+
+void k4a_capture_reference(k4a_capture_t capture_handle)
+{
+    if (capture_handle != NULL)
+    {
+        auto capture_ctx = k4a_capture_t_get_context(capture_handle);
+        if (capture_ctx != NULL)
+        {
+            capture_ctx->ref_cnt++;
+        }
+    }
+}
+
+float k4a_capture_get_temperature_c(k4a_capture_t capture_handle)
+{
+
+    UNREFERENCED_VALUE(capture_handle);
+    LOG_WARNING("k4a_capture_get_temperature_c unsupport api ", 0);
+    return 0;
+}
+
+static k4a_image_format_t get_k4a_image_format(ob_format frame_format, ob_frame_type frame_type)
+{
+    k4a_image_format_t k4a_image_format = K4A_IMAGE_FORMAT_CUSTOM;
+    switch (frame_format)
+    {
+    case OB_FORMAT_YUY2:
+    case OB_FORMAT_YUYV:
+        if (frame_type == OB_FRAME_DEPTH)
+        {
+            k4a_image_format = K4A_IMAGE_FORMAT_DEPTH16;
+        }
+        else if (frame_type == OB_FRAME_IR)
+        {
+            k4a_image_format = K4A_IMAGE_FORMAT_IR16;
+        }
+        else
+        {
+            k4a_image_format = K4A_IMAGE_FORMAT_COLOR_YUY2;
+        }
+
+        break;
+    case OB_FORMAT_Y16:
+        if (frame_type == OB_FRAME_DEPTH)
+        {
+            k4a_image_format = K4A_IMAGE_FORMAT_DEPTH16;
+        }
+        else if (frame_type == OB_FRAME_IR)
+        {
+            k4a_image_format = K4A_IMAGE_FORMAT_IR16;
+        }
+        else
+        {
+            k4a_image_format = K4A_IMAGE_FORMAT_CUSTOM16;
+        }
+        break;
+    case OB_FORMAT_Y8:
+        k4a_image_format = K4A_IMAGE_FORMAT_CUSTOM8;
+        break;
+    case OB_FORMAT_MJPG:
+        k4a_image_format = K4A_IMAGE_FORMAT_COLOR_MJPG;
+        break;
+    case OB_FORMAT_BGRA:
+        k4a_image_format = K4A_IMAGE_FORMAT_COLOR_BGRA32;
+        break;
+    case OB_FORMAT_NV12:
+        k4a_image_format = K4A_IMAGE_FORMAT_COLOR_NV12;
+        break;
+    case OB_FORMAT_UNKNOWN:
+        k4a_image_format = K4A_IMAGE_FORMAT_CUSTOM;
+    default:
+        break;
+    }
+    return k4a_image_format;
+}
+
+static int get_stride_bytes(ob_format frame_format, int width_pixels, int stride)
+{
+    int stride_bytes = 0;
+    switch (frame_format)
+    {
+    case OB_FORMAT_YUYV:
+    case OB_FORMAT_YUY2:
+    case OB_FORMAT_UYVY:
+    case OB_FORMAT_Y16:
+        stride_bytes = width_pixels * 2;
+        break;
+    case OB_FORMAT_RGB888:
+    case OB_FORMAT_BGR:
+        stride_bytes = width_pixels * 3;
+        break;
+    case OB_FORMAT_Y8:
+        stride_bytes = width_pixels;
+        break;
+    case OB_FORMAT_BGRA:
+        stride_bytes = width_pixels * 4;
+        break;
+    case OB_FORMAT_UNKNOWN:
+        stride_bytes = stride;
+        break;
+    default:
+        break;
+    }
+    return stride_bytes;
+}
+
+// The image getters are called many times per frame, so the frame properties that can't change are read from
+// libobsensor once here instead of on every call. Properties that fail to read are left at 0, which is what the
+// getters returned on failure before.
+static void init_image_context(k4a_image_context_t *image_ctx, ob_frame *frame, int stride)
+{
+    image_ctx->frame = frame;
+    image_ctx->stride = stride;
+    image_ctx->ref_cnt = 1;
+
+    ob_error *ob_err = NULL;
+    uint8_t *buffer = (uint8_t *)ob_frame_data(frame, &ob_err);
+    image_ctx->buffer = OB_SUCCEEDED(&ob_err) ? buffer : NULL;
+
+    uint32_t data_size = ob_frame_data_size(frame, &ob_err);
+    image_ctx->size = OB_SUCCEEDED(&ob_err) ? (size_t)data_size : 0;
+
+    int width_pixels = ob_video_frame_width(frame, &ob_err);
+    image_ctx->width_pixels = OB_SUCCEEDED(&ob_err) ? width_pixels : 0;
+
+    int height_pixels = ob_video_frame_height(frame, &ob_err);
+    image_ctx->height_pixels = OB_SUCCEEDED(&ob_err) ? height_pixels : 0;
+
+    image_ctx->format = K4A_IMAGE_FORMAT_CUSTOM;
+    image_ctx->stride_bytes = 0;
+    ob_format frame_format = ob_frame_format(frame, &ob_err);
+    if (OB_SUCCEEDED(&ob_err))
+    {
+        ob_frame_type frame_type = ob_frame_get_type(frame, &ob_err);
+        if (OB_SUCCEEDED(&ob_err))
+        {
+            image_ctx->format = get_k4a_image_format(frame_format, frame_type);
+        }
+        image_ctx->stride_bytes = get_stride_bytes(frame_format, image_ctx->width_pixels, stride);
+    }
 }
 
-k4a_result_t k4a_capture_create(k4a_capture_t *capture_handle)
+static k4a_image_t *get_cached_image(k4a_capture_context_t *capture_ctx, ob_frame_type frame_type)
 {
-    k4a_result_t result = K4A_RESULT_FAILED;
-    ob_error *ob_err = NULL;
-    ob_frame *frame = ob_create_frameset(&ob_err);
-    CHECK_OB_ERROR_RETURN_K4A_RESULT(&ob_err);
-    if (frame != NULL)
+    switch (frame_type)
     {
-        *capture_handle = (k4a_capture_t)frame;
-        result = K4A_RESULT_SUCCEEDED;
+    case OB_FRAME_COLOR:
+        return &capture_ctx->color_image;
+    case OB_FRAME_DEPTH:
+        return &capture_ctx->depth_image;
+    default:
+        return &capture_ctx->ir_image;
     }
-    return result;
 }
 
-void k4a_capture_release(k4a_capture_t capture_handle)
+// Returns the capture's image for frame_type with a reference added for the caller. The image handle is created on
+// the first call and kept in the capture, so later calls on the same capture don't allocate.
+static k4a_image_t get_capture_image(k4a_capture_t capture_handle, ob_frame_type frame_type)
 {
-    if (capture_handle != NULL)
+    auto capture_ctx = k4a_capture_t_get_context(capture_handle);
+    if (capture_ctx == NULL)
     {
-        ob_error *ob_err = NULL;
-        ob_frame *frame = (ob_frame *)capture_handle;
-        ob_delete_frame(frame, &ob_err);
-        CHECK_OB_ERROR_RETURN(&ob_err);
+        return NULL;
     }
-}
 
-void k4a_capture_reference(k4a_capture_t capture_handle)
-{
-    if (capture_handle != NULL)
+    k4a_image_t *cached_image = get_cached_image(capture_ctx, frame_type);
+    std::lock_guard<std::mutex> lock(capture_ctx->images_lock);
+    if (*cached_image == NULL)
     {
-        ob_error *ob_err = NULL;
-        ob_frame *frame = (ob_frame *)capture_handle;
-        ob_frame_add_ref(frame, &ob_err);
-        CHECK_OB_ERROR_RETURN(&ob_err);
+        ob_frame *frame = get_frameset_frame(capture_ctx->frame_set, frame_type);
+        if (frame == NULL)
+        {
+            return NULL;
+        }
+
+        k4a_image_context_t *image_ctx = create_image_handle(cached_image);
+        if (image_ctx == NULL)
+        {
+            ob_error *ob_err = NULL;
+            ob_delete_frame(frame, &ob_err);
+            CHECK_OB_ERROR(&ob_err);
+            return NULL;
+        }
+        init_image_context(image_ctx, frame, 0);
     }
+
+    k4a_image_reference(*cached_image);
+    return *cached_image;
 }
 
-float k4a_capture_get_temperature_c(k4a_capture_t capture_handle)
+// Replaces the image the capture returns for frame_type. The frame itself has already been pushed to the frame_set.
+static void set_capture_image(k4a_capture_context_t *capture_ctx, ob_frame_type frame_type, k4a_image_t image_handle)
 {
-
-    UNREFERENCED_VALUE(capture_handle);
-    LOG_WARNING("k4a_capture_get_temperature_c unsupport api ", 0);
-    return 0;
+    k4a_image_t *cached_image = get_cached_image(capture_ctx, frame_type);
+    std::lock_guard<std::mutex> lock(capture_ctx->images_lock);
+    k4a_image_reference(image_handle);
+    k4a_image_release(*cached_image);
+    *cached_image = image_handle;
 }
 
 k4a_image_t k4a_capture_get_color_image(k4a_capture_t capture_handle)
@@ -1174,21 +2021,12 @@ k4a_image_t k4a_capture_get_color_image(k4a_capture_t capture_handle)
         return NULL;
     }
 
-    ob_error *ob_err = NULL;
-    ob_frame *frame_set = (ob_frame *)capture_handle;
-    ob_frame *color_frame = ob_frameset_color_frame(frame_set, &ob_err);
-    CHECK_OB_ERROR_RETURN_VALUE(&ob_err, NULL);
-
-    if (color_frame == NULL)
+    k4a_image_t image_handle = get_capture_image(capture_handle, OB_FRAME_COLOR);
+    if (image_handle == NULL)
     {
         LOG_INFO("color_frame is null ", 0);
-        return NULL;
     }
-    k4a_image_t handle = NULL;
-    k4a_image_context_t *image_ctx = k4a_image_t_create(&handle);
-    image_ctx->frame = color_frame;
-    image_ctx->ref_cnt = 1;
-    return handle;
+    return image_handle;
 }
 
 k4a_image_t k4a_capture_get_depth_image(k4a_capture_t capture_handle)
@@ -1199,21 +2037,12 @@ k4a_image_t k4a_capture_get_depth_image(k4a_capture_t capture_handle)
         return NULL;
     }
 
-    ob_error *ob_err = NULL;
-    ob_frame *frame_set = (ob_frame *)capture_handle;
-    ob_frame *depth_frame = ob_frameset_depth_frame(frame_set, &ob_err);
-    CHECK_OB_ERROR_RETURN_VALUE(&ob_err, NULL);
-    if (depth_frame == NULL)
+    k4a_image_t image_handle = get_capture_image(capture_handle, OB_FRAME_DEPTH);
+    if (image_handle == NULL)
     {
         LOG_INFO("depth_frame is null ", 0);
-        return NULL;
     }
-
-    k4a_image_t handle = NULL;
-    k4a_image_context_t *image_ctx = k4a_image_t_create(&handle);
-    image_ctx->frame = depth_frame;
-    image_ctx->ref_cnt = 1;
-    return handle;
+    return image_handle;
 }
 
 k4a_image_t k4a_capture_get_ir_image(k4a_capture_t capture_handle)
@@ -1224,21 +2053,12 @@ k4a_image_t k4a_capture_get_ir_image(k4a_capture_t capture_handle)
         return NULL;
     }
 
-    ob_error *ob_err = NULL;
-    ob_frame *frame_set = (ob_frame *)capture_handle;
-    ob_frame *ir_frame = ob_frameset_ir_frame(frame_set, &ob_err);
-    CHECK_OB_ERROR_RETURN_VALUE(&ob_err, NULL);
-
-    if (ir_frame == NULL)
+    k4a_image_t image_handle = get_capture_image(capture_handle, OB_FRAME_IR);
+    if (image_handle == NULL)
     {
         LOG_INFO("ir_frame is null ", 0);
-        return NULL;
     }
-    k4a_image_t handle = NULL;
-    k4a_image_context_t *image_ctx = k4a_image_t_create(&handle);
-    image_ctx->frame = ir_frame;
-    image_ctx->ref_cnt = 1;
-    return handle;
+    return image_handle;
 }
 
 void k4a_capture_set_color_image(k4a_capture_t capture_handle, k4a_image_t image_handle)
@@ -1249,12 +2069,18 @@ void k4a_capture_set_color_image(k4a_capture_t capture_handle, k4a_image_t image
         return;
     }
 
-    ob_error *ob_err = NULL;
-    ob_frame *frame_set = (ob_frame *)capture_handle;
+    auto capture_ctx = k4a_capture_t_get_context(capture_handle);
     auto image_ctx = k4a_image_t_get_context(image_handle);
+    if (capture_ctx == NULL || image_ctx == NULL)
+    {
+        return;
+    }
+
+    ob_error *ob_err = NULL;
     ob_frame *color_frame = image_ctx->frame;
-    ob_frameset_push_frame(frame_set, OB_FRAME_COLOR, color_frame, &ob_err);
+    ob_frameset_push_frame(capture_ctx->frame_set, OB_FRAME_COLOR, color_frame, &ob_err);
     CHECK_OB_ERROR_RETURN(&ob_err);
+    set_capture_image(capture_ctx, OB_FRAME_COLOR, image_handle);
 }
 
 void k4a_capture_set_depth_image(k4a_capture_t capture_handle, k4a_image_t image_handle)
@@ -1265,12 +2091,18 @@ void k4a_capture_set_depth_image(k4a_capture_t capture_handle, k4a_image_t image
         return;
     }
 
-    ob_error *ob_err = NULL;
-    ob_frame *frame_set = (ob_frame *)capture_handle;
+    auto capture_ctx = k4a_capture_t_get_context(capture_handle);
     auto image_ctx = k4a_image_t_get_context(image_handle);
+    if (capture_ctx == NULL || image_ctx == NULL)
+    {
+        return;
+    }
+
+    ob_error *ob_err = NULL;
     ob_frame *depth_frame = image_ctx->frame;
-    ob_frameset_push_frame(frame_set, OB_FRAME_DEPTH, depth_frame, &ob_err);
+    ob_frameset_push_frame(capture_ctx->frame_set, OB_FRAME_DEPTH, depth_frame, &ob_err);
     CHECK_OB_ERROR_RETURN(&ob_err);
+    set_capture_image(capture_ctx, OB_FRAME_DEPTH, image_handle);
 }
 
 void k4a_capture_set_ir_image(k4a_capture_t capture_handle, k4a_image_t image_handle)
@@ -1281,12 +2113,18 @@ void k4a_capture_set_ir_image(k4a_capture_t capture_handle, k4a_image_t image_ha
         return;
     }
 
-    ob_error *ob_err = NULL;
-    ob_frame *frame_set = (ob_frame *)capture_handle;
+    auto capture_ctx = k4a_capture_t_get_context(capture_handle);
     auto image_ctx = k4a_image_t_get_context(image_handle);
+    if (capture_ctx == NULL || image_ctx == NULL)
+    {
+        return;
+    }
+
+    ob_error *ob_err = NULL;
     ob_frame *ir_frame = image_ctx->frame;
-    ob_frameset_push_frame(frame_set, OB_FRAME_IR, ir_frame, &ob_err);
+    ob_frameset_push_frame(capture_ctx->frame_set, OB_FRAME_IR, ir_frame, &ob_err);
     CHECK_OB_ERROR_RETURN(&ob_err);
+    set_capture_image(capture_ctx, OB_FRAME_IR, image_handle);
 }
 
 void k4a_capture_set_temperature_c(k4a_capture_t capture_handle, float temperature_c)
@@ -1342,10 +2180,8 @@ k4a_result_t k4a_image_create(k4a_image_format_t format,
     }
     CHECK_OB_ERROR_RETURN_K4A_RESULT(&ob_err);
     k4a_image_t handle = NULL;
-    k4a_image_context_t *image_ctx = k4a_image_t_create(&handle);
-    image_ctx->frame = obFrame;
-    image_ctx->stride = stride_bytes;
-    image_ctx->ref_cnt = 1;
+    k4a_image_context_t *image_ctx = create_image_handle(&handle);
+    init_image_context(image_ctx, obFrame, stride_bytes);
     *image_handle = handle;
     return result;
 }
@@ -1416,10 +2252,8 @@ k4a_result_t k4a_image_create_from_buffer(k4a_image_format_t format,
     if (obFrame != NULL)
     {
         k4a_image_t handle = NULL;
-        k4a_image_context_t *image_ctx = k4a_image_t_create(&handle);
-        image_ctx->frame = obFrame;
-        image_ctx->stride = stride_bytes;
-        image_ctx->ref_cnt = 1;
+        k4a_image_context_t *image_ctx = create_image_handle(&handle);
+        init_image_context(image_ctx, obFrame, stride_bytes);
         *image_handle = handle;
         result = K4A_RESULT_SUCCEEDED;
     }
@@ -1435,12 +2269,12 @@ uint8_t *k4a_image_get_buffer(k4a_image_t image_handle)
         return NULL;
     }
 
-    ob_error *ob_err = NULL;
     auto image_ctx = k4a_image_t_get_context(image_handle);
-    ob_frame *frame = image_ctx->frame;
-    uint8_t *data = (uint8_t *)ob_frame_data(frame, &ob_err);
-    CHECK_OB_ERROR_RETURN_VALUE(&ob_err, NULL);
-    return data;
+    if (image_ctx == NULL)
+    {
+        return NULL;
+    }
+    return image_ctx->buffer;
 }
 
 size_t k4a_image_get_size(k4a_image_t image_handle)
@@ -1451,12 +2285,12 @@ size_t k4a_image_get_size(k4a_image_t image_handle)
         return 0;
     }
 
-    ob_error *ob_err = NULL;
     auto image_ctx = k4a_image_t_get_context(image_handle);
-    ob_frame *frame = image_ctx->frame;
-    uint32_t data_size = ob_frame_data_size(frame, &ob_err);
-    CHECK_OB_ERROR_RETURN_VALUE(&ob_err, 0);
-    return (size_t)data_size;
+    if (image_ctx == NULL)
+    {
+        return 0;
+    }
+    return image_ctx->size;
 }
 
 k4a_image_format_t k4a_image_get_format(k4a_image_t image_handle)
@@ -1467,65 +2301,12 @@ k4a_image_format_t k4a_image_get_format(k4a_image_t image_handle)
         return K4A_IMAGE_FORMAT_CUSTOM;
     }
 
-    ob_error *ob_err = NULL;
     auto image_ctx = k4a_image_t_get_context(image_handle);
-    ob_frame *frame = image_ctx->frame;
-    ob_format frame_format = ob_frame_format(frame, &ob_err);
-    CHECK_OB_ERROR_RETURN_VALUE(&ob_err, K4A_IMAGE_FORMAT_CUSTOM);
-    k4a_image_format_t k4a_image_format = K4A_IMAGE_FORMAT_CUSTOM;
-    ob_frame_type frame_type = ob_frame_get_type(frame, &ob_err);
-    CHECK_OB_ERROR_RETURN_VALUE(&ob_err, K4A_IMAGE_FORMAT_CUSTOM);
-
-    switch (frame_format)
+    if (image_ctx == NULL)
     {
-    case OB_FORMAT_YUY2:
-    case OB_FORMAT_YUYV:
-        if (frame_type == OB_FRAME_DEPTH)
-        {
-            k4a_image_format = K4A_IMAGE_FORMAT_DEPTH16;
-        }
-        else if (frame_type == OB_FRAME_IR)
-        {
-            k4a_image_format = K4A_IMAGE_FORMAT_IR16;
-        }
-        else
-        {
-            k4a_image_format = K4A_IMAGE_FORMAT_COLOR_YUY2;
-        }
-
-        break;
-    case OB_FORMAT_Y16:
-        if (frame_type == OB_FRAME_DEPTH)
-        {
-            k4a_image_format = K4A_IMAGE_FORMAT_DEPTH16;
-        }
-        else if (frame_type == OB_FRAME_IR)
-        {
-            k4a_image_format = K4A_IMAGE_FORMAT_IR16;
-        }
-        else
-        {
-            k4a_image_format = K4A_IMAGE_FORMAT_CUSTOM16;
-        }
-        break;
-    case OB_FORMAT_Y8:
-        k4a_image_format = K4A_IMAGE_FORMAT_CUSTOM8;
-        break;
-    case OB_FORMAT_MJPG:
-        k4a_image_format = K4A_IMAGE_FORMAT_COLOR_MJPG;
-        break;
-    case OB_FORMAT_BGRA:
-        k4a_image_format = K4A_IMAGE_FORMAT_COLOR_BGRA32;
-        break;
-    case OB_FORMAT_NV12:
-        k4a_image_format = K4A_IMAGE_FORMAT_COLOR_NV12;
-        break;
-    case OB_FORMAT_UNKNOWN:
-        k4a_image_format = K4A_IMAGE_FORMAT_CUSTOM;
-    default:
-        break;
+        return K4A_IMAGE_FORMAT_CUSTOM;
     }
-    return k4a_image_format;
+    return image_ctx->format;
 }
 
 int k4a_image_get_width_pixels(k4a_image_t image_handle)
@@ -1535,12 +2316,12 @@ int k4a_image_get_width_pixels(k4a_image_t image_handle)
         LOG_WARNING("k4a_image_get_width_pixels param invalid ", 0);
         return 0;
     }
-    ob_error *ob_err = NULL;
     auto image_ctx = k4a_image_t_get_context(image_handle);
-    ob_frame *frame = image_ctx->frame;
-    int width_pixels = ob_video_frame_width(frame, &ob_err);
-    CHECK_OB_ERROR_RETURN_VALUE(&ob_err, 0);
-    return width_pixels;
+    if (image_ctx == NULL)
+    {
+        return 0;
+    }
+    return image_ctx->width_pixels;
 }
 
 int k4a_image_get_height_pixels(k4a_image_t image_handle)
@@ -1550,12 +2331,12 @@ int k4a_image_get_height_pixels(k4a_image_t image_handle)
         LOG_WARNING("k4a_image_get_height_pixels param invalid ", 0);
         return 0;
     }
-    ob_error *ob_err = NULL;
     auto image_ctx = k4a_image_t_get_context(image_handle);
-    ob_frame *frame = image_ctx->frame;
-    int height_pixels = ob_video_frame_height(frame, &ob_err);
-    CHECK_OB_ERROR_RETURN_VALUE(&ob_err, 0);
-    return height_pixels;
+    if (image_ctx == NULL)
+    {
+        return 0;
+    }
+    return image_ctx->height_pixels;
 }
 
 int k4a_image_get_stride_bytes(k4a_image_t image_handle)
@@ -1567,38 +2348,11 @@ int k4a_image_get_stride_bytes(k4a_image_t image_handle)
     }
 
     auto image_ctx = k4a_image_t_get_context(image_handle);
-    ob_frame *frame = image_ctx->frame;
-    ob_error *ob_err = NULL;
-    ob_format frame_format = ob_frame_format(frame, &ob_err);
-    CHECK_OB_ERROR_RETURN_VALUE(&ob_err, 0);
-    int width_pixels = ob_video_frame_width(frame, &ob_err);
-    CHECK_OB_ERROR_RETURN_VALUE(&ob_err, 0);
-    int stride_bytes = 0;
-    switch (frame_format)
+    if (image_ctx == NULL)
     {
-    case OB_FORMAT_YUYV:
-    case OB_FORMAT_YUY2:
-    case OB_FORMAT_UYVY:
-    case OB_FORMAT_Y16:
-        stride_bytes = width_pixels * 2;
-        break;
-    case OB_FORMAT_RGB888:
-    case OB_FORMAT_BGR:
-        stride_bytes = width_pixels * 3;
-        break;
-    case OB_FORMAT_Y8:
-        stride_bytes = width_pixels;
-        break;
-    case OB_FORMAT_BGRA:
-        stride_bytes = width_pixels * 4;
-        break;
-    case OB_FORMAT_UNKNOWN:
-        stride_bytes = image_ctx->stride;
-        break;
-    default:
-        break;
+        return 0;
     }
-    return stride_bytes;
+    return image_ctx->stride_bytes;
 }
 
 // Deprecated
@@ -1617,6 +2371,10 @@ uint64_t k4a_image_get_device_timestamp_usec(k4a_image_t image_handle)
 
     ob_error *ob_err = NULL;
     auto image_ctx = k4a_image_t_get_context(image_handle);
+    if (image_ctx == NULL)
+    {
+        return 0;
+    }
     ob_frame *frame = image_ctx->frame;
 
     uint64_t time_stamp = ob_frame_time_stamp_us(frame, &ob_err);
@@ -1636,6 +2394,10 @@ uint64_t k4a_image_get_system_timestamp_nsec(k4a_image_t image_handle)
 
     ob_error *ob_err = NULL;
     auto image_ctx = k4a_image_t_get_context(image_handle);
+    if (image_ctx == NULL)
+    {
+        return 0;
+    }
     ob_frame *frame = image_ctx->frame;
 
     uint64_t time_stamp = ob_frame_system_time_stamp(frame, &ob_err);
@@ -1650,6 +2412,10 @@ uint64_t k4a_image_get_exposure_usec(k4a_image_t image_handle)
 {
     ob_error *ob_err = NULL;
     auto image_ctx = k4a_image_t_get_context(image_handle);
+    if (image_ctx == NULL)
+    {
+        return 0;
+    }
     ob_frame *frame = image_ctx->frame;
 
     void *metadata = ob_video_frame_metadata(frame, &ob_err);
@@ -1670,6 +2436,10 @@ uint32_t k4a_image_get_white_balance(k4a_image_t image_handle)
 {
     ob_error *ob_err = NULL;
     auto image_ctx = k4a_image_t_get_context(image_handle);
+    if (image_ctx == NULL)
+    {
+        return 0;
+    }
     ob_frame *frame = image_ctx->frame;
 
     void *metadata = ob_video_frame_metadata(frame, &ob_err);
@@ -1690,6 +2460,10 @@ uint32_t k4a_image_get_iso_speed(k4a_image_t image_handle)
 {
     ob_error *ob_err = NULL;
     auto image_ctx = k4a_image_t_get_context(image_handle);
+    if (image_ctx == NULL)
+    {
+        return 0;
+    }
     ob_frame *frame = image_ctx->frame;
 
     void *metadata = ob_video_frame_metadata(frame, &ob_err);
@@ -1715,6 +2489,10 @@ void k4a_image_set_device_timestamp_usec(k4a_image_t image_handle, uint64_t time
     }
 
     auto image_ctx = k4a_image_t_get_context(image_handle);
+    if (image_ctx == NULL)
+    {
+        return;
+    }
     ob_frame *frame = image_ctx->frame;
     ob_error *ob_err = NULL;
 
@@ -1742,6 +2520,10 @@ void k4a_image_set_system_timestamp_nsec(k4a_image_t image_handle, uint64_t time
     }
 
     auto image_ctx = k4a_image_t_get_context(image_handle);
+    if (image_ctx == NULL)
+    {
+        return;
+    }
     ob_frame *frame = image_ctx->frame;
     ob_error *ob_err = NULL;
     uint64_t timestamp_mill = timestamp_nsec / 1000000;
@@ -1790,7 +2572,10 @@ void k4a_image_reference(k4a_image_t image_handle)
     {
         ob_error *ob_err = NULL;
         auto image_ctx = k4a_image_t_get_context(image_handle);
-        image_ctx->ref_cnt ++;
+        if (image_ctx != NULL)
+        {
+            image_ctx->ref_cnt++;
+        }
         CHECK_OB_ERROR_RETURN(&ob_err);
     }
 }
@@ -1800,15 +2585,15 @@ void k4a_image_release(k4a_image_t image_handle)
     if (image_handle != NULL)
     {
         auto image_ctx = k4a_image_t_get_context(image_handle);
-        image_ctx->ref_cnt--;
-        if(image_ctx->ref_cnt  == 0){
+        if (image_ctx != NULL && --image_ctx->ref_cnt == 0)
+        {
             ob_error *ob_err = NULL;
             ob_frame *frame = image_ctx->frame;
+            image_ctx->frame = NULL;
+            image_handle_pool.release(image_handle);
             ob_delete_frame(frame, &ob_err);
-            k4a_image_t_destroy(image_handle);
             CHECK_OB_ERROR_RETURN(&ob_err);
         }
-
     }
 }
 /*
@@ -2025,6 +2810,23 @@ k4a_result_t k4a_device_start_cameras(k4a_device_t device_handle, const k4a_devi
         return result;
     }
 
+    if (device_ctx->virtual_device != NULL)
+    {
+        reset_camera_stats(device_ctx);
+        frame_queue_enable(device_ctx->frameset_queue);
+
+        result = TRACE_CALL(
+            virtual_device_start_cameras(device_ctx->virtual_device, config, virtual_capture_ready, device_ctx));
+        if (K4A_FAILED(result))
+        {
+            frame_queue_disable(device_ctx->frameset_queue);
+            return result;
+        }
+
+        device_ctx->is_camera_streaming = true;
+        return result;
+    }
+
     OB_DEVICE_SYNC_CONFIG ob_sync_config;
     memset(&ob_sync_config, 0, sizeof(OB_DEVICE_SYNC_CONFIG));
     uint32_t len;
@@ -2303,6 +3105,7 @@ k4a_result_t k4a_device_start_cameras(k4a_device_t device_handle, const k4a_devi
             CHECK_OB_ERROR_BREAK(&ob_err);
         }
 
+        reset_camera_stats(device_ctx);
         frame_queue_enable(device_ctx->frameset_queue);
 
         ob_pipeline_start_with_callback(device_ctx->pipe, pipe_config, ob_frame_set_ready, device_handle, &ob_err);
@@ -2366,6 +3169,12 @@ void k4a_device_stop_cameras(k4a_device_t device_handle)
     {
         ob_error *ob_err = NULL;
 
+        if (device_ctx->virtual_device != NULL)
+        {
+            virtual_device_stop_cameras(device_ctx->virtual_device);
+            device_ctx->is_camera_streaming = false;
+        }
+
         if (device_ctx->pipe != NULL)
         {
             ob_pipeline_stop(device_ctx->pipe, &ob_err);
@@ -2479,6 +3288,35 @@ k4a_result_t version_convert(const char *orbbec_version, k4a_version_t *k4a_vers
     return K4A_RESULT_SUCCEEDED;
 }
 
+// Report the firmware versions the recording was made with
+static k4a_result_t get_virtual_device_version(k4a_device_context_t *device_ctx, k4a_hardware_version_t *version)
+{
+    memset(version, 0, sizeof(k4a_hardware_version_t));
+
+    char firmware_version[MAX_FIREWARE_VERSION_LEN];
+    size_t firmware_version_size = sizeof(firmware_version);
+    if (virtual_device_get_tag(device_ctx->virtual_device,
+                               "K4A_COLOR_FIRMWARE_VERSION",
+                               firmware_version,
+                               &firmware_version_size) == K4A_BUFFER_RESULT_SUCCEEDED)
+    {
+        version_convert(firmware_version, &version->rgb);
+    }
+
+    firmware_version_size = sizeof(firmware_version);
+    if (virtual_device_get_tag(device_ctx->virtual_device,
+                               "K4A_DEPTH_FIRMWARE_VERSION",
+                               firmware_version,
+                               &firmware_version_size) == K4A_BUFFER_RESULT_SUCCEEDED)
+    {
+        version_convert(firmware_version, &version->depth);
+    }
+
+    version->firmware_build = K4A_FIRMWARE_BUILD_RELEASE;
+    version->firmware_signature = K4A_FIRMWARE_SIGNATURE_UNSIGNED;
+    return K4A_RESULT_SUCCEEDED;
+}
+
 k4a_result_t k4a_device_get_version(k4a_device_t device_handle, k4a_hardware_version_t *version)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
@@ -2491,6 +3329,10 @@ k4a_result_t k4a_device_get_version(k4a_device_t device_handle, k4a_hardware_ver
 
     k4a_result_t result = K4A_RESULT_SUCCEEDED;
     k4a_device_context_t *device_ctx = k4a_device_t_get_context(device_handle);
+    if (device_ctx->virtual_device != NULL)
+    {
+        return get_virtual_device_version(device_ctx, version);
+    }
 
     ob_error *ob_err = NULL;
     ob_device_info *dev_info = ob_device_get_device_info(device_ctx->device, &ob_err);
@@ -2552,6 +3394,11 @@ k4a_result_t k4a_device_get_color_control_capabilities(k4a_device_t device_handl
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
     CHECK_AND_TRY_INIT_DEVICE_CONTEXT(K4A_RESULT_FAILED, device_handle);
     k4a_device_context_t *device_ctx = k4a_device_t_get_context(device_handle);
+    if (device_ctx->virtual_device != NULL)
+    {
+        LOG_ERROR("A virtual device has no color control capabilities", 0);
+        return K4A_RESULT_FAILED;
+    }
 
     ob_device *obDevice = device_ctx->device;
     k4a_result_t result = K4A_RESULT_FAILED;
@@ -2791,6 +3638,20 @@ k4a_result_t k4a_device_get_color_control(k4a_device_t device_handle,
         return K4A_RESULT_FAILED;
     }
 
+    if (device_ctx->virtual_device != NULL)
+    {
+        // Report back what was set, the recording was made with whatever the settings were at the time
+        if (mode != NULL)
+        {
+            *mode = device_ctx->virtual_color_control_modes[command];
+        }
+        if (value != NULL)
+        {
+            *value = device_ctx->virtual_color_control_values[command];
+        }
+        return K4A_RESULT_SUCCEEDED;
+    }
+
     switch (command)
     {
     case K4A_COLOR_CONTROL_EXPOSURE_TIME_ABSOLUTE: {
@@ -2932,6 +3793,13 @@ k4a_result_t k4a_device_set_color_control(k4a_device_t device_handle,
         return K4A_RESULT_FAILED;
     }
 
+    if (device_ctx->virtual_device != NULL)
+    {
+        device_ctx->virtual_color_control_modes[command] = mode;
+        device_ctx->virtual_color_control_values[command] = value;
+        return K4A_RESULT_SUCCEEDED;
+    }
+
     switch (command)
     {
     case K4A_COLOR_CONTROL_EXPOSURE_TIME_ABSOLUTE: {
@@ -3311,7 +4179,7 @@ k4a_buffer_result_t k4a_device_get_raw_calibration(k4a_device_t device_handle, u
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_BUFFER_RESULT_FAILED, k4a_device_t, device_handle);
     CHECK_AND_TRY_INIT_DEVICE_CONTEXT(K4A_BUFFER_RESULT_FAILED, device_handle);
     k4a_device_context_t *device_ctx = k4a_device_t_get_context(device_handle);
-    if (device_ctx->device == NULL)
+    if (device_ctx->device == NULL && device_ctx->virtual_device == NULL)
     {
         return K4A_BUFFER_RESULT_FAILED;
     }
@@ -3636,6 +4504,11 @@ k4a_result_t k4a_device_get_calibration(k4a_device_t device_handle,
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_device_t, device_handle);
     CHECK_AND_TRY_INIT_DEVICE_CONTEXT(K4A_RESULT_FAILED, device_handle);
     k4a_device_context_t *device_ctx = k4a_device_t_get_context(device_handle);
+    if (device_ctx->virtual_device != NULL)
+    {
+        // The recording's calibration was loaded in place of the device's by read_virtual_calibration_data()
+        return k4a_device_get_calibration_from_json(device_handle, depth_mode, color_resolution, calibration);
+    }
 
     ob_error *ob_err = NULL;
     ob_device_info *dev_info = ob_device_get_device_info(device_ctx->device, &ob_err);
@@ -0,0 +1,508 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// This library
+#include <virtual_device.h>
+
+// Dependent libraries
+#include <k4a/k4a.h>
+#include <k4arecord/types.h>
+#include <k4ainternal/common.h>
+#include <k4ainternal/dynlib.h>
+#include <k4ainternal/handle.h>
+#include <k4ainternal/logging.h>
+
+#include <azure_c_shared_utility/envvariable.h>
+
+// System dependencies
+#include <string.h>
+#include <string>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifndef K4A_RECORD_LIBRARY_FILE_NAME
+#error K4A_RECORD_LIBRARY_FILE_NAME must name the k4arecord shared library
+#endif
+
+// Interval used when the recording has no camera tracks to space the loops of the IMU track
+#define DEFAULT_LOOP_GAP_USEC 1000
+
+// Functions used from k4arecord, see playback.h. k4arecord links against this library, so they are looked up at
+// runtime instead of linking k4arecord in.
+typedef struct _playback_api_t
+{
+    k4a_result_t (*open)(const char *path, k4a_playback_t *playback_handle);
+    void (*close)(k4a_playback_t playback_handle);
+    k4a_buffer_result_t (*get_raw_calibration)(k4a_playback_t playback_handle, uint8_t *data, size_t *data_size);
+    k4a_result_t (*get_record_configuration)(k4a_playback_t playback_handle, k4a_record_configuration_t *config);
+    k4a_buffer_result_t (*get_tag)(k4a_playback_t playback_handle, const char *name, char *value, size_t *value_size);
+    k4a_stream_result_t (*get_next_capture)(k4a_playback_t playback_handle, k4a_capture_t *capture_handle);
+    k4a_stream_result_t (*get_next_imu_sample)(k4a_playback_t playback_handle, k4a_imu_sample_t *imu_sample);
+    k4a_result_t (*seek_timestamp)(k4a_playback_t playback_handle,
+                                   int64_t offset_usec,
+                                   k4a_playback_seek_origin_t origin);
+    uint64_t (*get_recording_length_usec)(k4a_playback_t playback_handle);
+} playback_api_t;
+
+// k4arecord stays loaded once a virtual device was created, it references this library anyway
+static std::mutex g_playback_api_lock;
+static dynlib_t g_playback_library = NULL;
+static playback_api_t g_playback_api;
+
+// One replayed track, owned by the thread reading it from its own playback handle
+typedef struct _replay_stream_t
+{
+    k4a_playback_t playback;
+    std::thread thread;
+
+    std::mutex lock;
+    std::condition_variable stop_cv;
+    bool stop;
+
+    virtual_device_capture_cb_t *capture_cb;
+    virtual_device_imu_cb_t *imu_cb;
+    void *context;
+} replay_stream_t;
+
+typedef struct _virtual_device_context_t
+{
+    const playback_api_t *api;
+    std::string path;
+
+    // Only used for the recording's metadata, the replay threads read through their own handles
+    k4a_playback_t playback;
+    k4a_record_configuration_t record_config;
+
+    // Added to the device timestamps each time the recording starts over
+    uint64_t loop_usec;
+
+    replay_stream_t cameras;
+    replay_stream_t imu;
+} virtual_device_context_t;
+
+K4A_DECLARE_CONTEXT(virtual_device_t, virtual_device_context_t);
+
+#define FIND_PLAYBACK_SYMBOL(_result_, _library_, _api_, _field_, _symbol_)                                            \
+    if (K4A_SUCCEEDED(_result_))                                                                                       \
+    {                                                                                                                  \
+        _result_ = TRACE_CALL(dynlib_find_symbol(_library_, _symbol_, (void **)&(_api_)._field_));                     \
+    }
+
+static const playback_api_t *load_playback_api(void)
+{
+    std::lock_guard<std::mutex> lock(g_playback_api_lock);
+    if (g_playback_library != NULL)
+    {
+        return &g_playback_api;
+    }
+
+    dynlib_t library = NULL;
+    k4a_result_t result = TRACE_CALL(dynlib_create_from_file_name(K4A_RECORD_LIBRARY_FILE_NAME, &library));
+
+    playback_api_t api;
+    memset(&api, 0, sizeof(api));
+    FIND_PLAYBACK_SYMBOL(result, library, api, open, "k4a_playback_open");
+    FIND_PLAYBACK_SYMBOL(result, library, api, close, "k4a_playback_close");
+    FIND_PLAYBACK_SYMBOL(result, library, api, get_raw_calibration, "k4a_playback_get_raw_calibration");
+    FIND_PLAYBACK_SYMBOL(result, library, api, get_record_configuration, "k4a_playback_get_record_configuration");
+    FIND_PLAYBACK_SYMBOL(result, library, api, get_tag, "k4a_playback_get_tag");
+    FIND_PLAYBACK_SYMBOL(result, library, api, get_next_capture, "k4a_playback_get_next_capture");
+    FIND_PLAYBACK_SYMBOL(result, library, api, get_next_imu_sample, "k4a_playback_get_next_imu_sample");
+    FIND_PLAYBACK_SYMBOL(result, library, api, seek_timestamp, "k4a_playback_seek_timestamp");
+    FIND_PLAYBACK_SYMBOL(result, library, api, get_recording_length_usec, "k4a_playback_get_recording_length_usec");
+
+    if (K4A_FAILED(result))
+    {
+        LOG_ERROR("Failed to load %s, virtual devices are not available", K4A_RECORD_LIBRARY_FILE_NAME);
+        if (library != NULL)
+        {
+            dynlib_destroy(library);
+        }
+        return NULL;
+    }
+
+    g_playback_api = api;
+    g_playback_library = library;
+    return &g_playback_api;
+}
+
+const char *virtual_device_get_recording_path(void)
+{
+    const char *path = environment_get_variable(VIRTUAL_DEVICE_ENV_VAR);
+    if (path == NULL || path[0] == '\0')
+    {
+        return NULL;
+    }
+    return path;
+}
+
+static uint32_t fps_to_uint(k4a_fps_t fps)
+{
+    switch (fps)
+    {
+    case K4A_FRAMES_PER_SECOND_5:
+        return 5;
+    case K4A_FRAMES_PER_SECOND_15:
+        return 15;
+    case K4A_FRAMES_PER_SECOND_30:
+        return 30;
+    default:
+        return 0;
+    }
+}
+
+k4a_result_t virtual_device_create(const char *path, virtual_device_t *virtual_device_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, path == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, virtual_device_handle == NULL);
+
+    const playback_api_t *api = load_playback_api();
+    if (api == NULL)
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    virtual_device_context_t *virtual_device = virtual_device_t_create(virtual_device_handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(virtual_device != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        virtual_device->api = api;
+        virtual_device->path = path;
+        result = TRACE_CALL(api->open(path, &virtual_device->playback));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(api->get_record_configuration(virtual_device->playback, &virtual_device->record_config));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        // Leave one frame interval between the last frame of a loop and the first frame of the next
+        uint32_t fps = fps_to_uint(virtual_device->record_config.camera_fps);
+        uint64_t gap_usec = fps != 0 ? 1000000 / fps : DEFAULT_LOOP_GAP_USEC;
+        virtual_device->loop_usec = api->get_recording_length_usec(virtual_device->playback) + gap_usec;
+
+        LOG_INFO("Opened %s as a virtual device", path);
+    }
+
+    if (K4A_FAILED(result))
+    {
+        LOG_ERROR("Failed to open recording %s as a virtual device", path);
+        if (virtual_device != NULL)
+        {
+            virtual_device_destroy(*virtual_device_handle);
+        }
+        *virtual_device_handle = NULL;
+    }
+
+    return result;
+}
+
+static void stop_stream(virtual_device_context_t *virtual_device, replay_stream_t *stream)
+{
+    {
+        std::lock_guard<std::mutex> lock(stream->lock);
+        stream->stop = true;
+    }
+    stream->stop_cv.notify_all();
+
+    if (stream->thread.joinable())
+    {
+        stream->thread.join();
+    }
+
+    if (stream->playback != NULL)
+    {
+        virtual_device->api->close(stream->playback);
+        stream->playback = NULL;
+    }
+}
+
+void virtual_device_destroy(virtual_device_t virtual_device_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, virtual_device_t, virtual_device_handle);
+    virtual_device_context_t *virtual_device = virtual_device_t_get_context(virtual_device_handle);
+
+    if (virtual_device->api != NULL)
+    {
+        stop_stream(virtual_device, &virtual_device->cameras);
+        stop_stream(virtual_device, &virtual_device->imu);
+
+        if (virtual_device->playback != NULL)
+        {
+            virtual_device->api->close(virtual_device->playback);
+        }
+    }
+
+    virtual_device_t_destroy(virtual_device_handle);
+}
+
+k4a_buffer_result_t virtual_device_get_raw_calibration(virtual_device_t virtual_device_handle,
+                                                       uint8_t *data,
+                                                       size_t *data_size)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_BUFFER_RESULT_FAILED, virtual_device_t, virtual_device_handle);
+    virtual_device_context_t *virtual_device = virtual_device_t_get_context(virtual_device_handle);
+
+    return virtual_device->api->get_raw_calibration(virtual_device->playback, data, data_size);
+}
+
+k4a_buffer_result_t virtual_device_get_tag(virtual_device_t virtual_device_handle,
+                                           const char *name,
+                                           char *value,
+                                           size_t *value_size)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_BUFFER_RESULT_FAILED, virtual_device_t, virtual_device_handle);
+    virtual_device_context_t *virtual_device = virtual_device_t_get_context(virtual_device_handle);
+
+    return virtual_device->api->get_tag(virtual_device->playback, name, value, value_size);
+}
+
+// Returns true when the stream was stopped before the deadline
+static bool wait_until_due(replay_stream_t *stream, std::chrono::steady_clock::time_point due)
+{
+    std::unique_lock<std::mutex> lock(stream->lock);
+    return stream->stop_cv.wait_until(lock, due, [stream]() { return stream->stop; });
+}
+
+static std::chrono::steady_clock::time_point get_due_time(std::chrono::steady_clock::time_point start_time,
+                                                          uint64_t start_timestamp_usec,
+                                                          uint64_t timestamp_usec)
+{
+    // Tracks are not strictly ordered against each other, anything recorded before the first frame is due at once
+    uint64_t elapsed_usec = timestamp_usec > start_timestamp_usec ? timestamp_usec - start_timestamp_usec : 0;
+    return start_time + std::chrono::microseconds(elapsed_usec);
+}
+
+// Shifts the device timestamps of the images in the capture by offset_usec and returns the earliest one
+static uint64_t offset_capture_timestamps(k4a_capture_t capture_handle, uint64_t offset_usec)
+{
+    k4a_image_t images[3] = { k4a_capture_get_color_image(capture_handle),
+                              k4a_capture_get_depth_image(capture_handle),
+                              k4a_capture_get_ir_image(capture_handle) };
+
+    uint64_t earliest_usec = UINT64_MAX;
+    for (size_t i = 0; i < COUNTOF(images); i++)
+    {
+        if (images[i] == NULL)
+        {
+            continue;
+        }
+
+        uint64_t timestamp_usec = k4a_image_get_device_timestamp_usec(images[i]) + offset_usec;
+        if (offset_usec != 0)
+        {
+            k4a_image_set_device_timestamp_usec(images[i], timestamp_usec);
+        }
+        earliest_usec = timestamp_usec < earliest_usec ? timestamp_usec : earliest_usec;
+        k4a_image_release(images[i]);
+    }
+
+    return earliest_usec != UINT64_MAX ? earliest_usec : offset_usec;
+}
+
+// Starts the recording over, returns false when it is empty or can't be read again
+static bool restart_stream(virtual_device_context_t *virtual_device, replay_stream_t *stream, bool read_since_seek)
+{
+    if (!read_since_seek)
+    {
+        LOG_ERROR("Virtual device recording %s has no data to replay", virtual_device->path.c_str());
+        return false;
+    }
+
+    if (K4A_FAILED(TRACE_CALL(virtual_device->api->seek_timestamp(stream->playback, 0, K4A_PLAYBACK_SEEK_BEGIN))))
+    {
+        return false;
+    }
+    return true;
+}
+
+static void replay_cameras(virtual_device_context_t *virtual_device)
+{
+    replay_stream_t *stream = &virtual_device->cameras;
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    uint64_t start_timestamp_usec = 0;
+    uint64_t loop_offset_usec = 0;
+    bool started = false;
+    bool read_since_seek = false;
+
+    while (true)
+    {
+        k4a_capture_t capture_handle = NULL;
+        k4a_stream_result_t result = virtual_device->api->get_next_capture(stream->playback, &capture_handle);
+        if (result == K4A_STREAM_RESULT_EOF)
+        {
+            if (!restart_stream(virtual_device, stream, read_since_seek))
+            {
+                break;
+            }
+            loop_offset_usec += virtual_device->loop_usec;
+            read_since_seek = false;
+            continue;
+        }
+        else if (result != K4A_STREAM_RESULT_SUCCEEDED)
+        {
+            LOG_ERROR("Failed to read the next capture from %s", virtual_device->path.c_str());
+            break;
+        }
+        read_since_seek = true;
+
+        uint64_t timestamp_usec = offset_capture_timestamps(capture_handle, loop_offset_usec);
+        if (!started)
+        {
+            start_timestamp_usec = timestamp_usec;
+            started = true;
+        }
+
+        if (wait_until_due(stream, get_due_time(start_time, start_timestamp_usec, timestamp_usec)))
+        {
+            k4a_capture_release(capture_handle);
+            break;
+        }
+
+        stream->capture_cb(capture_handle, stream->context);
+    }
+}
+
+static void replay_imu(virtual_device_context_t *virtual_device)
+{
+    replay_stream_t *stream = &virtual_device->imu;
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    uint64_t start_timestamp_usec = 0;
+    uint64_t loop_offset_usec = 0;
+    bool started = false;
+    bool read_since_seek = false;
+
+    while (true)
+    {
+        k4a_imu_sample_t imu_sample;
+        k4a_stream_result_t result = virtual_device->api->get_next_imu_sample(stream->playback, &imu_sample);
+        if (result == K4A_STREAM_RESULT_EOF)
+        {
+            if (!restart_stream(virtual_device, stream, read_since_seek))
+            {
+                break;
+            }
+            loop_offset_usec += virtual_device->loop_usec;
+            read_since_seek = false;
+            continue;
+        }
+        else if (result != K4A_STREAM_RESULT_SUCCEEDED)
+        {
+            LOG_ERROR("Failed to read the next IMU sample from %s", virtual_device->path.c_str());
+            break;
+        }
+        read_since_seek = true;
+
+        imu_sample.acc_timestamp_usec += loop_offset_usec;
+        imu_sample.gyro_timestamp_usec += loop_offset_usec;
+        if (!started)
+        {
+            start_timestamp_usec = imu_sample.acc_timestamp_usec;
+            started = true;
+        }
+
+        if (wait_until_due(stream, get_due_time(start_time, start_timestamp_usec, imu_sample.acc_timestamp_usec)))
+        {
+            break;
+        }
+
+        stream->imu_cb(&imu_sample, stream->context);
+    }
+}
+
+static k4a_result_t start_stream(virtual_device_context_t *virtual_device,
+                                 replay_stream_t *stream,
+                                 void (*replay)(virtual_device_context_t *))
+{
+    if (stream->thread.joinable())
+    {
+        LOG_ERROR("Virtual device stream is already running", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_result_t result = TRACE_CALL(virtual_device->api->open(virtual_device->path.c_str(), &stream->playback));
+    if (K4A_SUCCEEDED(result))
+    {
+        stream->stop = false;
+        stream->thread = std::thread(replay, virtual_device);
+    }
+    return result;
+}
+
+static void warn_if_mismatched(const char *name, int requested, int recorded)
+{
+    if (requested != recorded)
+    {
+        LOG_WARNING("Virtual device replays %s %d as recorded instead of the requested %d", name, recorded, requested);
+    }
+}
+
+k4a_result_t virtual_device_start_cameras(virtual_device_t virtual_device_handle,
+                                          const k4a_device_configuration_t *config,
+                                          virtual_device_capture_cb_t *capture_cb,
+                                          void *context)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, virtual_device_t, virtual_device_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, config == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, capture_cb == NULL);
+    virtual_device_context_t *virtual_device = virtual_device_t_get_context(virtual_device_handle);
+
+    const k4a_record_configuration_t *record_config = &virtual_device->record_config;
+    if (!record_config->color_track_enabled && !record_config->depth_track_enabled && !record_config->ir_track_enabled)
+    {
+        LOG_ERROR("Virtual device recording %s has no camera tracks", virtual_device->path.c_str());
+        return K4A_RESULT_FAILED;
+    }
+
+    if (config->color_resolution != K4A_COLOR_RESOLUTION_OFF)
+    {
+        warn_if_mismatched("color_format", config->color_format, record_config->color_format);
+        warn_if_mismatched("color_resolution", config->color_resolution, record_config->color_resolution);
+    }
+    warn_if_mismatched("depth_mode", config->depth_mode, record_config->depth_mode);
+    warn_if_mismatched("camera_fps", config->camera_fps, record_config->camera_fps);
+
+    virtual_device->cameras.capture_cb = capture_cb;
+    virtual_device->cameras.context = context;
+    return start_stream(virtual_device, &virtual_device->cameras, replay_cameras);
+}
+
+void virtual_device_stop_cameras(virtual_device_t virtual_device_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, virtual_device_t, virtual_device_handle);
+    virtual_device_context_t *virtual_device = virtual_device_t_get_context(virtual_device_handle);
+
+    stop_stream(virtual_device, &virtual_device->cameras);
+}
+
+k4a_result_t virtual_device_start_imu(virtual_device_t virtual_device_handle,
+                                      virtual_device_imu_cb_t *imu_cb,
+                                      void *context)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, virtual_device_t, virtual_device_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, imu_cb == NULL);
+    virtual_device_context_t *virtual_device = virtual_device_t_get_context(virtual_device_handle);
+
+    if (!virtual_device->record_config.imu_track_enabled)
+    {
+        LOG_ERROR("Virtual device recording %s has no IMU track", virtual_device->path.c_str());
+        return K4A_RESULT_FAILED;
+    }
+
+    virtual_device->imu.imu_cb = imu_cb;
+    virtual_device->imu.context = context;
+    return start_stream(virtual_device, &virtual_device->imu, replay_imu);
+}
+
+void virtual_device_stop_imu(virtual_device_t virtual_device_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, virtual_device_t, virtual_device_handle);
+    virtual_device_context_t *virtual_device = virtual_device_t_get_context(virtual_device_handle);
+
+    stop_stream(virtual_device, &virtual_device->imu);
+}
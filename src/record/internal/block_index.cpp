@@ -0,0 +1,163 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <k4ainternal/block_index.h>
+#include <k4ainternal/matroska_common.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace k4arecord
+{
+namespace
+{
+const char block_index_magic[8] = "K4AIDX2";
+
+struct block_index_header_t
+{
+    char magic[8];
+    uint64_t recording_size;
+    uint64_t recording_hash;
+    uint64_t entry_count;
+    uint64_t checksum;
+};
+
+static_assert(sizeof(block_index_header_t) == 40, "block_index_header_t size does not match the on-disk format.");
+
+const uint64_t fnv_offset_basis = 14695981039346656037ull;
+
+// FNV-1a over 64-bit words, any trailing bytes are hashed one at a time.
+uint64_t fnv1a(uint64_t hash, const uint8_t *data, size_t size)
+{
+    size_t word_count = size / sizeof(uint64_t);
+    for (size_t i = 0; i < word_count; i++)
+    {
+        uint64_t word;
+        memcpy(&word, data + i * sizeof(uint64_t), sizeof(word));
+        hash ^= word;
+        hash *= 1099511628211ull;
+    }
+    for (size_t i = word_count * sizeof(uint64_t); i < size; i++)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t block_index_checksum(const std::vector<block_index_entry_t> &entries)
+{
+    return fnv1a(fnv_offset_basis,
+                 reinterpret_cast<const uint8_t *>(entries.data()),
+                 entries.size() * sizeof(block_index_entry_t));
+}
+} // namespace
+
+std::string get_block_index_path(const char *recording_path)
+{
+    return std::string(recording_path) + BLOCK_INDEX_FILE_SUFFIX;
+}
+
+uint64_t get_recording_hash(libebml::IOCallback &file, uint64_t recording_size)
+{
+    // Small recordings are hashed completely, larger ones only at both ends.
+    uint64_t head_size = std::min<uint64_t>(recording_size, BLOCK_INDEX_HASH_WINDOW);
+    uint64_t tail_size = std::min<uint64_t>(recording_size - head_size, BLOCK_INDEX_HASH_WINDOW);
+
+    std::vector<uint8_t> buffer((size_t)head_size);
+    file.setFilePointer(0);
+    if (file.read(buffer.data(), buffer.size()) != buffer.size())
+    {
+        throw std::ios_base::failure("Failed to read the start of the recording");
+    }
+    uint64_t hash = fnv1a(fnv_offset_basis, buffer.data(), buffer.size());
+
+    buffer.resize((size_t)tail_size);
+    file.setFilePointer((int64_t)(recording_size - tail_size));
+    if (file.read(buffer.data(), buffer.size()) != buffer.size())
+    {
+        throw std::ios_base::failure("Failed to read the end of the recording");
+    }
+    return fnv1a(hash, buffer.data(), buffer.size());
+}
+
+bool write_block_index(const std::string &index_path,
+                       uint64_t recording_size,
+                       uint64_t recording_hash,
+                       const std::vector<block_index_entry_t> &entries)
+{
+    block_index_header_t header = {};
+    memcpy(header.magic, block_index_magic, sizeof(header.magic));
+    header.recording_size = recording_size;
+    header.recording_hash = recording_hash;
+    header.entry_count = entries.size();
+    header.checksum = block_index_checksum(entries);
+
+    // Write to a temporary file first so a reader never sees a partially written index.
+    std::string temp_path = index_path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(entries.data()),
+                   (std::streamsize)(entries.size() * sizeof(block_index_entry_t)));
+        file.close();
+        if (file.fail())
+        {
+            (void)std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+
+    // std::rename() does not replace existing files on all platforms.
+    (void)std::remove(index_path.c_str());
+    if (std::rename(temp_path.c_str(), index_path.c_str()) != 0)
+    {
+        (void)std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool read_block_index(const std::string &index_path,
+                      uint64_t recording_size,
+                      uint64_t recording_hash,
+                      std::vector<block_index_entry_t> *entries)
+{
+    if (entries == NULL)
+    {
+        return false;
+    }
+
+    std::ifstream file(index_path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    block_index_header_t header = {};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file || memcmp(header.magic, block_index_magic, sizeof(header.magic)) != 0 ||
+        header.recording_size != recording_size || header.recording_hash != recording_hash ||
+        header.entry_count == 0 || header.entry_count > recording_size)
+    {
+        return false;
+    }
+
+    entries->resize((size_t)header.entry_count);
+    file.read(reinterpret_cast<char *>(entries->data()),
+              (std::streamsize)(entries->size() * sizeof(block_index_entry_t)));
+    if (!file || block_index_checksum(*entries) != header.checksum)
+    {
+        entries->clear();
+        return false;
+    }
+    return true;
+}
+
+} // namespace k4arecord
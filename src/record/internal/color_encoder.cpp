@@ -0,0 +1,261 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <algorithm>
+
+#include <k4a/k4a.h>
+#include <k4ainternal/matroska_write.h>
+#include <k4ainternal/logging.h>
+#include <turbojpeg.h>
+
+using namespace LIBMATROSKA_NAMESPACE;
+
+namespace k4arecord
+{
+// Compresses a BGRA image to MJPEG and passes it to write_track_data().
+static k4a_result_t encode_color_image(k4a_record_context_t *context, tjhandle jpeg, const color_encode_job_t &job)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, jpeg == NULL);
+
+    int width = k4a_image_get_width_pixels(job.image);
+    int height = k4a_image_get_height_pixels(job.image);
+    int stride = k4a_image_get_stride_bytes(job.image);
+    uint8_t *image_buffer = k4a_image_get_buffer(job.image);
+    size_t buffer_size = k4a_image_get_size(job.image);
+    if (image_buffer == NULL || width <= 0 || height <= 0 || (size_t)stride * (size_t)height > buffer_size)
+    {
+        LOG_ERROR("Invalid color image passed to the color encoder.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    // 4:2:2 subsampling matches the MJPEG stream produced by the color camera.
+    unsigned char *jpeg_buffer = NULL;
+    unsigned long jpeg_size = 0;
+    if (tjCompress2(jpeg,
+                    image_buffer,
+                    width,
+                    stride,
+                    height,
+                    TJPF_BGRA,
+                    &jpeg_buffer,
+                    &jpeg_size,
+                    TJSAMP_422,
+                    job.track->jpeg_quality,
+                    TJFLAG_FASTDCT) != 0)
+    {
+        LOG_ERROR("Failed to compress color image: %s", tjGetErrorStr());
+        tjFree(jpeg_buffer);
+        return K4A_RESULT_FAILED;
+    }
+
+    assert(jpeg_size <= UINT32_MAX);
+    DataBuffer *data_buffer = new (std::nothrow) DataBuffer(jpeg_buffer, (uint32)jpeg_size, NULL, true);
+    tjFree(jpeg_buffer);
+    if (data_buffer == NULL)
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    k4a_result_t result = TRACE_CALL(write_track_data(context, job.track, job.timestamp_ns, data_buffer));
+    if (K4A_FAILED(result))
+    {
+        data_buffer->FreeBuffer(*data_buffer);
+        delete data_buffer;
+    }
+    return result;
+}
+
+static void color_encoder_thread(k4a_record_context_t *context)
+{
+    assert(context->encoder_notify);
+    assert(context->encoder_done);
+
+    // Each thread owns its compressor so that no locking is needed while encoding.
+    tjhandle jpeg = tjInitCompress();
+    if (jpeg == NULL)
+    {
+        LOG_ERROR("Failed to initialize color encoder: %s", tjGetErrorStr());
+    }
+
+    try
+    {
+        std::unique_lock<std::mutex> lock(context->encoder_lock);
+        while (true)
+        {
+            context->encoder_notify->wait(lock, [context]() {
+                return context->encoder_stopping || !context->encoder_queue.empty();
+            });
+
+            // Queued jobs are always finished before stopping so no images are dropped on close.
+            if (context->encoder_queue.empty())
+            {
+                break;
+            }
+
+            color_encode_job_t job = context->encoder_queue.front();
+            context->encoder_queue.pop_front();
+            context->encoder_jobs_active++;
+            lock.unlock();
+
+            k4a_result_t result = TRACE_CALL(encode_color_image(context, jpeg, job));
+            k4a_image_release(job.image);
+
+            lock.lock();
+            context->encoder_jobs_active--;
+            if (K4A_FAILED(result))
+            {
+                context->encoder_failures++;
+            }
+            context->encoder_done->notify_all();
+        }
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Color encoder thread threw exception: %s", e.what());
+    }
+
+    if (jpeg != NULL)
+    {
+        (void)tjDestroy(jpeg);
+    }
+}
+
+// Lock(context->encoder_lock) should be active when calling this function
+static k4a_result_t take_encoder_failures(k4a_record_context_t *context)
+{
+    if (context->encoder_failures > 0)
+    {
+        LOG_ERROR("Failed to write %zu color images after encoding.", context->encoder_failures);
+        context->encoder_failures = 0;
+        return K4A_RESULT_FAILED;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t start_color_encoder_threads(k4a_record_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !context->encoder_threads.empty());
+
+    // Leave half of the cores for the capture and writer threads.
+    size_t thread_count = std::thread::hardware_concurrency() / 2;
+    thread_count = std::max<size_t>(1, std::min<size_t>(thread_count, MAX_COLOR_ENCODER_THREADS));
+
+    try
+    {
+        context->encoder_notify.reset(new std::condition_variable());
+        context->encoder_done.reset(new std::condition_variable());
+
+        context->encoder_stopping = false;
+        context->encoder_jobs_active = 0;
+        context->encoder_failures = 0;
+        for (size_t i = 0; i < thread_count; i++)
+        {
+            context->encoder_threads.emplace_back(color_encoder_thread, context);
+        }
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to start color encoder threads: %s", e.what());
+        stop_color_encoder_threads(context);
+        return K4A_RESULT_FAILED;
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+void stop_color_encoder_threads(k4a_record_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, context == NULL);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, context->encoder_notify == nullptr);
+
+    try
+    {
+        {
+            std::lock_guard<std::mutex> lock(context->encoder_lock);
+            context->encoder_stopping = true;
+        }
+        context->encoder_notify->notify_all();
+
+        for (std::thread &thread : context->encoder_threads)
+        {
+            if (thread.joinable())
+            {
+                thread.join();
+            }
+        }
+        context->encoder_threads.clear();
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to stop color encoder threads: %s", e.what());
+    }
+}
+
+// Queues a color image to be compressed and written by the encoder threads. A reference to the image is kept until
+// the job is finished. Blocks while the queue is full.
+k4a_result_t queue_color_encode(k4a_record_context_t *context,
+                                track_header_t *track,
+                                uint64_t timestamp_ns,
+                                k4a_image_t image)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, image == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->encoder_threads.empty());
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    try
+    {
+        std::unique_lock<std::mutex> lock(context->encoder_lock);
+
+        // Two jobs per thread keeps every thread busy while the next capture is being read.
+        size_t queue_limit = context->encoder_threads.size() * 2;
+        context->encoder_done->wait(lock, [context, queue_limit]() {
+            return context->encoder_queue.size() < queue_limit;
+        });
+
+        result = take_encoder_failures(context);
+
+        color_encode_job_t job = { track, timestamp_ns, image };
+        context->encoder_queue.push_back(job);
+        k4a_image_reference(image);
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to queue color image for encoding: %s", e.what());
+        return K4A_RESULT_FAILED;
+    }
+
+    context->encoder_notify->notify_one();
+
+    return result;
+}
+
+// Waits until all queued color images have been written to the pending clusters.
+k4a_result_t wait_for_color_encoder(k4a_record_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (context->encoder_threads.empty())
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    try
+    {
+        std::unique_lock<std::mutex> lock(context->encoder_lock);
+        context->encoder_done->wait(lock, [context]() {
+            return context->encoder_queue.empty() && context->encoder_jobs_active == 0;
+        });
+
+        return take_encoder_failures(context);
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to wait for color encoder: %s", e.what());
+        return K4A_RESULT_FAILED;
+    }
+}
+
+} // namespace k4arecord
@@ -3,6 +3,21 @@
 
 #include "k4ainternal/matroska_common.h"
 
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 using namespace k4arecord;
 
 static_assert(sizeof(std::streamoff) == sizeof(int64), "64-bit seeking is not supported on this architecture");
@@ -105,3 +120,310 @@ void LargeFileIOCallback::setOwnerThread()
 {
     m_owner = std::this_thread::get_id();
 }
+
+CustomIOCallback::CustomIOCallback(const k4a_record_io_callbacks_t &callbacks) : m_callbacks(callbacks)
+{
+    if (m_callbacks.write == NULL)
+    {
+        throw std::invalid_argument("A write callback is required");
+    }
+}
+
+CustomIOCallback::~CustomIOCallback()
+{
+    close();
+}
+
+uint32 CustomIOCallback::read(void *buffer, size_t size)
+{
+    (void)buffer;
+    (void)size;
+    // Custom outputs are write-only, nothing in the recording path reads back from the output.
+    return 0;
+}
+
+void CustomIOCallback::setFilePointer(int64 offset, libebml::seek_mode mode)
+{
+    assert(mode == SEEK_SET || mode == SEEK_CUR || mode == SEEK_END);
+
+    int64 target = 0;
+    switch (mode)
+    {
+    case SEEK_SET:
+        target = offset;
+        break;
+    case SEEK_CUR:
+        target = (int64)m_position + offset;
+        break;
+    case SEEK_END:
+        target = (int64)m_size + offset;
+        break;
+    }
+
+    if (target < 0 || (uint64)target > m_size)
+    {
+        throw std::ios_base::failure("Seek position is outside of the recording");
+    }
+    if ((uint64)target == m_position)
+    {
+        return;
+    }
+    if (m_callbacks.seek == NULL)
+    {
+        throw std::ios_base::failure("Recording output does not support seeking");
+    }
+    if (!m_callbacks.seek(m_callbacks.context, (uint64_t)target))
+    {
+        throw std::ios_base::failure("Recording output seek failed");
+    }
+    m_position = (uint64)target;
+}
+
+size_t CustomIOCallback::write(const void *buffer, size_t size)
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    size_t written = m_callbacks.write(m_callbacks.context, buffer, size);
+    if (written != size)
+    {
+        throw std::ios_base::failure("Recording output write failed");
+    }
+
+    m_position += size;
+    if (m_position > m_size)
+    {
+        m_size = m_position;
+    }
+    return size;
+}
+
+uint64 CustomIOCallback::getFilePointer()
+{
+    return m_position;
+}
+
+void CustomIOCallback::close()
+{
+    // CustomIOCallback::close() can be called more than once, only notify the user the first time.
+    if (!m_closed)
+    {
+        m_closed = true;
+        if (m_callbacks.close != NULL)
+        {
+            m_callbacks.close(m_callbacks.context);
+        }
+    }
+}
+
+bool CustomIOCallback::isSeekable() const
+{
+    return m_callbacks.seek != NULL;
+}
+
+UnknownSizeHeadIOCallback::UnknownSizeHeadIOCallback(libebml::IOCallback &output, size_t id_length) :
+    m_output(output),
+    m_id_length(id_length)
+{
+    assert(id_length > 0 && id_length <= 4);
+}
+
+uint32 UnknownSizeHeadIOCallback::read(void *buffer, size_t size)
+{
+    return m_output.read(buffer, size);
+}
+
+void UnknownSizeHeadIOCallback::setFilePointer(int64 offset, libebml::seek_mode mode)
+{
+    m_output.setFilePointer(offset, mode);
+}
+
+size_t UnknownSizeHeadIOCallback::write(const void *buffer, size_t size)
+{
+    // libebml writes the whole head at once, the element id followed by the size field
+    if (size <= m_id_length || size > m_id_length + 8)
+    {
+        throw std::ios_base::failure("Unexpected element head size");
+    }
+
+    uint8_t head[4 + 8];
+    memcpy(head, buffer, size);
+
+    // An unknown size is the length marker bit followed by all ones
+    size_t size_length = size - m_id_length;
+    memset(head + m_id_length, 0xFF, size_length);
+    head[m_id_length] = (uint8_t)(0xFF >> (size_length - 1));
+
+    return m_output.write(head, size);
+}
+
+uint64 UnknownSizeHeadIOCallback::getFilePointer()
+{
+    return m_output.getFilePointer();
+}
+
+void UnknownSizeHeadIOCallback::close()
+{
+    // The output is owned by the caller
+}
+
+MappedFileIOCallback::MappedFileIOCallback(const char *path)
+{
+    assert(path);
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path,
+                              GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              NULL,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw std::ios_base::failure("Failed to open file for mapping");
+    }
+
+    LARGE_INTEGER file_size = { 0 };
+    void *data = NULL;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0 && (uint64)file_size.QuadPart <= SIZE_MAX)
+    {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL)
+        {
+            // The view keeps its own reference to the mapping object.
+            data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+
+    if (data == NULL)
+    {
+        throw std::ios_base::failure("Failed to map file");
+    }
+    m_size = (uint64)file_size.QuadPart;
+    m_data = std::shared_ptr<const uint8_t>(static_cast<const uint8_t *>(data),
+                                            [](const uint8_t *ptr) { UnmapViewOfFile(ptr); });
+#else
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw std::ios_base::failure("Failed to open file for mapping");
+    }
+
+    struct stat file_stat = {};
+    void *data = MAP_FAILED;
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0 && (uint64)file_stat.st_size <= SIZE_MAX)
+    {
+        data = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd); // The mapping stays valid after the descriptor is closed.
+
+    if (data == MAP_FAILED)
+    {
+        throw std::ios_base::failure("Failed to map file");
+    }
+    size_t size = (size_t)file_stat.st_size;
+    m_size = size;
+    m_data = std::shared_ptr<const uint8_t>(static_cast<const uint8_t *>(data),
+                                            [size](const uint8_t *ptr) { munmap((void *)ptr, size); });
+#endif
+}
+
+MappedFileIOCallback::MappedFileIOCallback(const MappedFileIOCallback &file) : m_data(file.m_data), m_size(file.m_size)
+{
+}
+
+MappedFileIOCallback::~MappedFileIOCallback()
+{
+    m_data.reset();
+}
+
+uint32 MappedFileIOCallback::read(void *buffer, size_t size)
+{
+    assert(size <= UINT32_MAX); // can't properly return > uint32
+
+    if (m_data == nullptr || m_position >= m_size)
+    {
+        return 0;
+    }
+
+    size_t count = (size_t)std::min<uint64>(size, m_size - m_position);
+    memcpy(buffer, m_data.get() + m_position, count);
+    m_position += count;
+    return (uint32)count;
+}
+
+void MappedFileIOCallback::setFilePointer(int64 offset, libebml::seek_mode mode)
+{
+    assert(mode == SEEK_SET || mode == SEEK_CUR || mode == SEEK_END);
+
+    int64 target = 0;
+    switch (mode)
+    {
+    case SEEK_SET:
+        target = offset;
+        break;
+    case SEEK_CUR:
+        target = (int64)m_position + offset;
+        break;
+    case SEEK_END:
+        target = (int64)m_size + offset;
+        break;
+    }
+
+    // Like a file stream, seeking past the end is allowed and the following reads return 0 bytes.
+    if (target < 0)
+    {
+        throw std::ios_base::failure("Seek position is before the start of the file");
+    }
+    m_position = (uint64)target;
+}
+
+size_t MappedFileIOCallback::write(const void *buffer, size_t size)
+{
+    (void)buffer;
+    (void)size;
+    throw std::ios_base::failure("Memory mapped files are read-only");
+}
+
+uint64 MappedFileIOCallback::getFilePointer()
+{
+    return m_position;
+}
+
+void MappedFileIOCallback::close()
+{
+    // Readers created from this handler may still be in use, so the mapping is only released by the destructor.
+}
+
+std::shared_ptr<const uint8_t> MappedFileIOCallback::view(uint64 offset, uint64 size) const
+{
+    if (m_data == nullptr || offset > m_size || size > m_size - offset)
+    {
+        return nullptr;
+    }
+    return std::shared_ptr<const uint8_t>(m_data, m_data.get() + offset);
+}
+
+void MappedFileIOCallback::willNeed(uint64 offset, uint64 size) const
+{
+    if (m_data == nullptr || offset >= m_size)
+    {
+        return;
+    }
+    size = std::min<uint64>(size, m_size - offset);
+
+#ifdef _WIN32
+    // PrefetchVirtualMemory() is not available on all supported versions of Windows, rely on the OS read-ahead.
+    (void)size;
+#else
+    // madvise() requires a page aligned address.
+    static const uint64 page_size = (uint64)sysconf(_SC_PAGESIZE);
+    uint64 aligned_offset = offset - offset % page_size;
+    (void)madvise((void *)(m_data.get() + aligned_offset), (size_t)(size + offset - aligned_offset), MADV_WILLNEED);
+#endif
+}
@@ -5,10 +5,12 @@
 #include <iostream>
 #include <algorithm>
 #include <climits>
+#include <cstring>
 #include <sstream>
 
 #include <k4a/k4a.h>
 #include <k4ainternal/matroska_read.h>
+#include <k4ainternal/rvl_codec.h>
 #include <k4ainternal/common.h>
 #include <k4ainternal/logging.h>
 
@@ -20,12 +22,23 @@ using namespace LIBMATROSKA_NAMESPACE;
 namespace k4arecord
 {
 std::unique_ptr<EbmlElement> next_child(k4a_playback_context_t *context, EbmlElement *parent)
+{
+    return next_child(context, *context->stream, parent);
+}
+
+std::unique_ptr<EbmlElement> next_child(k4a_playback_context_t *context, EbmlStream &stream, EbmlElement *parent)
 {
     try
     {
+        // Segments of append-only recordings have an unknown size, their children continue up to the end of the file
+        uint64_t max_data_size = parent->IsFiniteSize() ? parent->GetSize() : UINT64_MAX;
+
         int upper_level = 0;
-        EbmlElement *element =
-            context->stream->FindNextElement(parent->Generic().Context, upper_level, parent->GetSize(), false, 0);
+        EbmlElement *element = stream.FindNextElement(parent->Generic().Context, upper_level, max_data_size, false, 0);
+        if (element == NULL)
+        {
+            return nullptr;
+        }
 
         // upper_level shows the relationship of the element to the parent element
         // -1 : global element
@@ -38,7 +51,7 @@ std::unique_ptr<EbmlElement> next_child(k4a_playback_context_t *context, EbmlEle
             // return nullptr.
             uint64_t file_offset = element->GetElementPosition();
             assert(file_offset <= INT64_MAX);
-            context->ebml_file->setFilePointer((int64_t)file_offset);
+            stream.I_O().setFilePointer((int64_t)file_offset);
             delete element;
             return nullptr;
         }
@@ -49,7 +62,7 @@ std::unique_ptr<EbmlElement> next_child(k4a_playback_context_t *context, EbmlEle
     {
         LOG_ERROR("Failed to get next child (parent id %x) in recording '%s': %s",
                   EbmlId(*parent).GetValue(),
-                  context->file_path,
+                  context->file_path.c_str(),
                   e.what());
         return nullptr;
     }
@@ -69,7 +82,7 @@ k4a_result_t skip_element(k4a_playback_context_t *context, EbmlElement *element)
     {
         LOG_ERROR("Failed seek past element (id %x) in recording '%s': %s",
                   EbmlId(*element).GetValue(),
-                  context->file_path,
+                  context->file_path.c_str(),
                   e.what());
         return K4A_RESULT_FAILED;
     }
@@ -327,9 +340,46 @@ k4a_result_t populate_cluster_cache(k4a_playback_context_t *context)
         context->cluster_cache = cluster_cache_t(new cluster_info_t, cluster_cache_deleter);
         populate_cluster_info(context, first_cluster, context->cluster_cache.get());
 
-        // Populate the rest of the cache with the Cue data stored in the file.
+        // Use the block index stored next to the recording if there is one. Recordings without Cues would need every
+        // cluster to be read from disk while seeking, so an index is generated for them if it is missing. An index that
+        // does not match the recording is rebuilt.
+        std::string index_path = get_block_index_path(context->file_path.c_str());
+        context->ebml_file->setFilePointer(0, seek_end);
+        uint64_t recording_size = context->ebml_file->getFilePointer();
+        bool index_exists = std::ifstream(index_path, std::ios::binary).is_open();
+
+        std::vector<block_index_entry_t> block_index;
+        bool index_found = false;
+        uint64_t recording_hash = 0;
+        if (index_exists || !context->cues)
+        {
+            recording_hash = get_recording_hash(*context->ebml_file, recording_size);
+            index_found = index_exists && read_block_index(index_path, recording_size, recording_hash, &block_index);
+        }
+        if (!index_found && (index_exists || !context->cues))
+        {
+            if (index_exists)
+            {
+                LOG_INFO("Recording index does not match the recording, rebuilding it: %s", index_path.c_str());
+            }
+            else
+            {
+                LOG_INFO("Recording is missing Cue entries, generating index: %s", index_path.c_str());
+            }
+            index_found = scan_block_index(context, &block_index);
+            if (index_found && !write_block_index(index_path, recording_size, recording_hash, block_index))
+            {
+                LOG_INFO("Failed to write recording index '%s'.", index_path.c_str());
+            }
+        }
+
+        // Populate the rest of the cache with the block index or the Cue data stored in the file.
         cluster_info_t *cluster_cache_end = context->cluster_cache.get();
-        if (context->cues)
+        if (index_found && load_block_index(context, block_index))
+        {
+            LOG_TRACE("Loaded %llu blocks from recording index.", (unsigned long long)block_index.size());
+        }
+        else if (context->cues)
         {
             uint64_t last_offset = context->first_cluster_offset;
             uint64_t last_timestamp_ns = context->cluster_cache->timestamp_ns;
@@ -382,10 +432,246 @@ k4a_result_t populate_cluster_cache(k4a_playback_context_t *context)
         LOG_ERROR("Failed to populate cluster cache: %s", e.what());
         return K4A_RESULT_FAILED;
     }
+    catch (std::ios_base::failure &e)
+    {
+        LOG_ERROR("Failed to populate cluster cache: %s", e.what());
+        return K4A_RESULT_FAILED;
+    }
 
     return K4A_RESULT_SUCCEEDED;
 }
 
+// Read the track number and relative timecode from the header of a Block or SimpleBlock element.
+static bool read_block_header(EbmlStream &stream, EbmlElement *block, uint64_t *track_number, int16_t *timecode)
+{
+    // The track number is an EBML variable size integer of up to 8 bytes, followed by a 16-bit timecode.
+    uint8_t header[10];
+    uint64_t header_size = std::min((uint64_t)sizeof(header), (uint64_t)block->GetSize());
+    stream.I_O().setFilePointer((int64_t)(block->GetElementPosition() + block->HeadSize()));
+    if (stream.I_O().read(header, (size_t)header_size) != header_size)
+    {
+        return false;
+    }
+
+    size_t length = 1;
+    uint8_t length_mask = 0x80;
+    while (length <= 8 && (header[0] & length_mask) == 0)
+    {
+        length_mask >>= 1;
+        length++;
+    }
+    if (length > 8 || length + 2 > header_size)
+    {
+        return false;
+    }
+
+    *track_number = header[0] & (length_mask - 1);
+    for (size_t i = 1; i < length; i++)
+    {
+        *track_number = (*track_number << 8) | header[i];
+    }
+    *timecode = (int16_t)((header[length] << 8) | header[length + 1]);
+    return true;
+}
+
+// Read the track number and relative timecode of a SimpleBlock or BlockGroup element without reading the block data.
+// Returns false if the element is not a block. The file pointer is left inside the element.
+static bool peek_block_header(k4a_playback_context_t *context,
+                              EbmlStream &stream,
+                              EbmlElement *element,
+                              uint64_t *track_number,
+                              int16_t *timecode)
+{
+    EbmlId element_id(*element);
+    if (element_id == KaxSimpleBlock::ClassInfos.GlobalId)
+    {
+        return read_block_header(stream, element, track_number, timecode);
+    }
+    else if (element_id != KaxBlockGroup::ClassInfos.GlobalId)
+    {
+        return false;
+    }
+
+    // Only the Block inside the group is needed, the remaining children are skipped.
+    uint64_t element_end = element->GetElementPosition() + element->HeadSize() + element->GetSize();
+    stream.I_O().setFilePointer((int64_t)(element->GetElementPosition() + element->HeadSize()));
+    while (stream.I_O().getFilePointer() < element_end)
+    {
+        std::unique_ptr<EbmlElement> child = next_child(context, stream, element);
+        if (child == nullptr)
+        {
+            break;
+        }
+        if (EbmlId(*child) == KaxBlock::ClassInfos.GlobalId)
+        {
+            return read_block_header(stream, child.get(), track_number, timecode);
+        }
+        stream.I_O().setFilePointer((int64_t)(child->GetElementPosition() + child->HeadSize() + child->GetSize()));
+    }
+    return false;
+}
+
+// Build a block index by reading only the element headers in each cluster, the block data is skipped.
+bool scan_block_index(k4a_playback_context_t *context, std::vector<block_index_entry_t> *entries)
+{
+    RETURN_VALUE_IF_ARG(false, context == NULL);
+    RETURN_VALUE_IF_ARG(false, context->segment == nullptr);
+    RETURN_VALUE_IF_ARG(false, entries == NULL);
+
+    entries->clear();
+    if (K4A_FAILED(seek_offset(context, context->first_cluster_offset)))
+    {
+        return false;
+    }
+
+    try
+    {
+        std::shared_ptr<KaxCluster> cluster = find_next<KaxCluster>(context);
+        while (cluster)
+        {
+            uint64_t cluster_offset = context->segment->GetRelativePosition(*cluster);
+            uint64_t cluster_end = cluster->GetElementPosition() + cluster->HeadSize() + cluster->GetSize();
+            int64_t cluster_timecode = 0;
+
+            while (context->ebml_file->getFilePointer() < cluster_end)
+            {
+                std::unique_ptr<EbmlElement> element = next_child(context, cluster.get());
+                if (element == nullptr)
+                {
+                    break;
+                }
+                uint64_t element_end = element->GetElementPosition() + element->HeadSize() + element->GetSize();
+
+                uint64_t track_number = 0;
+                int16_t timecode = 0;
+                if (EbmlId(*element) == KaxClusterTimecode::ClassInfos.GlobalId)
+                {
+                    KaxClusterTimecode *timecode_element = read_element<KaxClusterTimecode>(context, element.get());
+                    if (timecode_element == NULL)
+                    {
+                        return false;
+                    }
+                    cluster_timecode = (int64_t)timecode_element->GetValue();
+                }
+                else if (peek_block_header(context, *context->stream, element.get(), &track_number, &timecode))
+                {
+                    // The index entry covers the whole SimpleBlock or BlockGroup element.
+                    block_index_entry_t entry = {};
+                    int64_t block_timecode = std::max(cluster_timecode + timecode, (int64_t)0);
+                    entry.timestamp_ns = (uint64_t)block_timecode * context->timecode_scale;
+                    entry.cluster_offset = cluster_offset;
+                    entry.block_offset = context->segment->GetRelativePosition(*element);
+                    entry.block_size = (uint32_t)(element_end - element->GetElementPosition());
+                    entry.track_number = (uint16_t)track_number;
+                    entries->push_back(entry);
+                }
+
+                context->ebml_file->setFilePointer((int64_t)element_end);
+            }
+
+            context->ebml_file->setFilePointer((int64_t)cluster_end);
+            cluster = find_next<KaxCluster>(context, true);
+        }
+    }
+    catch (std::ios_base::failure &e)
+    {
+        LOG_ERROR("Failed to scan blocks in recording '%s': %s", context->file_path.c_str(), e.what());
+        entries->clear();
+        return false;
+    }
+
+    return !entries->empty();
+}
+
+// Fill in the cluster cache and the per-track block indexes from a block index. The cache must only contain the first
+// cluster. Returns false without modifying the cache if the index does not match the recording.
+// The caller should currently own the lock for the cluster cache.
+bool load_block_index(k4a_playback_context_t *context, const std::vector<block_index_entry_t> &entries)
+{
+    RETURN_VALUE_IF_ARG(false, context == NULL);
+    RETURN_VALUE_IF_ARG(false, context->cluster_cache == nullptr);
+    RETURN_VALUE_IF_ARG(false, context->cluster_cache->next != NULL);
+
+    if (entries.empty() || entries[0].cluster_offset != context->cluster_cache->file_offset)
+    {
+        return false;
+    }
+
+    std::map<uint64_t, track_reader_t *> track_numbers;
+    for (auto &track : context->track_map)
+    {
+        track_numbers[GetChild<KaxTrackNumber>(*track.second.track).GetValue()] = &track.second;
+    }
+
+    // Validate the whole index before using it, clusters and timestamps within a track need to be in file order.
+    std::map<uint64_t, uint64_t> last_track_timestamps;
+    uint64_t cluster_offset = entries[0].cluster_offset;
+    uint64_t cluster_count = 1;
+    for (const block_index_entry_t &entry : entries)
+    {
+        if (entry.cluster_offset < cluster_offset || entry.block_offset <= entry.cluster_offset ||
+            entry.block_size == 0)
+        {
+            return false;
+        }
+        if (entry.cluster_offset != cluster_offset)
+        {
+            cluster_offset = entry.cluster_offset;
+            cluster_count++;
+        }
+
+        auto last_timestamp = last_track_timestamps.find(entry.track_number);
+        if (last_timestamp != last_track_timestamps.end() && entry.timestamp_ns < last_timestamp->second)
+        {
+            return false;
+        }
+        last_track_timestamps[entry.track_number] = entry.timestamp_ns;
+    }
+
+    context->cluster_index.clear();
+    context->cluster_index.reserve((size_t)cluster_count);
+    context->cluster_index.push_back(context->cluster_cache.get());
+
+    cluster_info_t *cluster_cache_end = context->cluster_cache.get();
+    for (const block_index_entry_t &entry : entries)
+    {
+        // Block timestamps are stored with the precision of the recording.
+        uint64_t timestamp_ns = entry.timestamp_ns - entry.timestamp_ns % context->timecode_scale;
+        if (entry.cluster_offset != cluster_cache_end->file_offset)
+        {
+            cluster_info_t *cluster_info = new cluster_info_t;
+            // The cluster timestamp is only used for seeking, the first block timestamp is close enough.
+            cluster_info->timestamp_ns = std::max(timestamp_ns, cluster_cache_end->timestamp_ns);
+            cluster_info->file_offset = entry.cluster_offset;
+            cluster_info->previous = cluster_cache_end;
+
+            cluster_cache_end->next = cluster_info;
+            cluster_cache_end->next_known = true;
+            cluster_cache_end = cluster_info;
+            context->cluster_index.push_back(cluster_info);
+        }
+
+        if (cluster_cache_end != context->cluster_cache.get())
+        {
+            // The cluster ends with its last block.
+            cluster_cache_end->cluster_size = entry.block_offset + entry.block_size - entry.cluster_offset;
+        }
+
+        auto track = track_numbers.find(entry.track_number);
+        if (track != track_numbers.end())
+        {
+            indexed_block_t block;
+            block.timestamp_ns = timestamp_ns;
+            block.cluster_info = cluster_cache_end;
+            track->second->block_index.push_back(block);
+        }
+    }
+    // The index contains every cluster in the recording.
+    cluster_cache_end->next_known = true;
+
+    return true;
+}
+
 k4a_result_t parse_recording_config(k4a_playback_context_t *context)
 {
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
@@ -767,7 +1053,9 @@ k4a_result_t read_bitmap_info_header(track_reader_t *track)
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track->track == NULL);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track->codec_id.empty());
 
-    if (track->codec_id == "V_MS/VFW/FOURCC")
+    // RVL compressed tracks store the BITMAPINFOHEADER of the uncompressed image.
+    bool rvl_compressed = track->codec_id == K4A_RVL_CODEC_ID;
+    if (track->codec_id == "V_MS/VFW/FOURCC" || rvl_compressed)
     {
         KaxCodecPrivate &codec_private = GetChild<KaxCodecPrivate>(*track->track);
         RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, codec_private.GetSize() != sizeof(BITMAPINFOHEADER));
@@ -807,6 +1095,15 @@ k4a_result_t read_bitmap_info_header(track_reader_t *track)
             return K4A_RESULT_FAILED;
         }
 
+        if (rvl_compressed && track->format != K4A_IMAGE_FORMAT_DEPTH16)
+        {
+            LOG_ERROR("RVL codec is only supported for 16-bit tracks '%s': %x",
+                      GetChild<KaxTrackName>(*track->track).GetValueUTF8().c_str(),
+                      bitmap_header->biCompression);
+            return K4A_RESULT_FAILED;
+        }
+        track->rvl_compressed = rvl_compressed;
+
         return K4A_RESULT_SUCCEEDED;
     }
     else
@@ -828,6 +1125,7 @@ void reset_seek_pointers(k4a_playback_context_t *context, uint64_t seek_timestam
     {
         auto &track_reader = itr.second;
         track_reader.current_block.reset();
+        track_reader.seek_timestamp_ns = seek_timestamp_ns;
     }
 }
 
@@ -1043,6 +1341,14 @@ KaxAttached *get_attachment_by_tag(k4a_playback_context_t *context, const char *
 }
 
 k4a_result_t seek_offset(k4a_playback_context_t *context, uint64_t offset)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->stream == nullptr);
+
+    return seek_offset(context, *context->stream, offset);
+}
+
+k4a_result_t seek_offset(k4a_playback_context_t *context, EbmlStream &stream, uint64_t offset)
 {
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->segment == nullptr);
@@ -1053,7 +1359,7 @@ k4a_result_t seek_offset(k4a_playback_context_t *context, uint64_t offset)
     {
         LOG_TRACE("Seeking to file position: %llu", file_offset);
         assert(file_offset <= INT64_MAX);
-        context->ebml_file->setFilePointer((int64_t)file_offset);
+        stream.I_O().setFilePointer((int64_t)file_offset);
         return K4A_RESULT_SUCCEEDED;
     }
     catch (std::ios_base::failure &e)
@@ -1061,7 +1367,7 @@ k4a_result_t seek_offset(k4a_playback_context_t *context, uint64_t offset)
         LOG_ERROR("Failed to seek file to %llu (relative %llu) '%s': %s",
                   file_offset,
                   offset,
-                  context->file_path,
+                  context->file_path.c_str(),
                   e.what());
         return K4A_RESULT_FAILED;
     }
@@ -1135,6 +1441,20 @@ cluster_info_t *find_cluster(k4a_playback_context_t *context, uint64_t timestamp
 
         // Find the closest cluster in the cache
         cluster_info_t *cluster_info = context->cluster_cache.get();
+        if (!context->cluster_index.empty())
+        {
+            // Every cluster is known, binary search for the last cluster starting at or before timestamp_ns.
+            auto it = std::upper_bound(context->cluster_index.begin(),
+                                       context->cluster_index.end(),
+                                       timestamp_ns,
+                                       [](uint64_t timestamp, const cluster_info_t *cluster) {
+                                           return timestamp < cluster->timestamp_ns;
+                                       });
+            if (it != context->cluster_index.begin())
+            {
+                cluster_info = *(it - 1);
+            }
+        }
         while (cluster_info->next)
         {
             if (cluster_info->next->timestamp_ns > timestamp_ns)
@@ -1186,7 +1506,11 @@ cluster_info_t *next_cluster(k4a_playback_context_t *context, cluster_info_t *cu
             }
             else
             {
-                std::lock_guard<std::mutex> io_lock(context->io_lock);
+                std::unique_lock<std::mutex> io_lock(context->io_lock, std::defer_lock);
+                if (!context->file_mapped)
+                {
+                    io_lock.lock();
+                }
                 if (context->file_closing)
                 {
                     // User called k4a_playback_close(), return immediately.
@@ -1294,223 +1618,1279 @@ cluster_info_t *next_cluster(k4a_playback_context_t *context, cluster_info_t *cu
     }
 }
 
-// Load a cluster from the cluster cache / disk without any neighbor preloading.
-// This should never fail unless there is a file IO error.
-std::shared_ptr<KaxCluster> load_cluster_internal(k4a_playback_context_t *context, cluster_info_t *cluster_info)
+// Splits the clusters of a recording into range_count ranges with roughly the same amount of data, and returns the
+// first and last cluster of the range at range_index. Every range contains at least one cluster. Any gaps in the
+// cluster cache are filled in first, which reads the cluster headers of the whole file if the recording has no index.
+k4a_result_t find_cluster_range(k4a_playback_context_t *context,
+                                size_t range_index,
+                                size_t range_count,
+                                cluster_info_t **first_cluster,
+                                cluster_info_t **last_cluster)
 {
-    RETURN_VALUE_IF_ARG(nullptr, context == NULL);
-    RETURN_VALUE_IF_ARG(nullptr, context->ebml_file == nullptr);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->cluster_cache == nullptr);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, range_count == 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, range_index >= range_count);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, first_cluster == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, last_cluster == NULL);
 
     try
     {
-        // Check if the cluster already exists in memory, and if so, return it.
-        std::shared_ptr<KaxCluster> cluster = cluster_info->cluster.lock();
-        if (cluster)
+        std::lock_guard<std::recursive_mutex> lock(context->cache_lock);
+
+        std::vector<cluster_info_t *> clusters;
+        if (context->cluster_index.empty())
         {
-            context->cache_hits++;
+            for (cluster_info_t *cluster_info = context->cluster_cache.get(); cluster_info != NULL;
+                 cluster_info = next_cluster(context, cluster_info, true))
+            {
+                clusters.push_back(cluster_info);
+            }
         }
         else
         {
-            std::lock_guard<std::mutex> lock(context->io_lock);
-            if (context->file_closing)
-            {
-                // User called k4a_playback_close(), return immediately.
-                return nullptr;
-            }
+            clusters = context->cluster_index;
+        }
 
-            // The cluster may have been loaded while we were acquiring the io lock, check again before actually loading
-            // from disk.
-            cluster = cluster_info->cluster.lock();
-            if (cluster)
+        if (clusters.size() < range_count)
+        {
+            LOG_ERROR("Recording has %llu clusters and cannot be split into %llu ranges.",
+                      (unsigned long long)clusters.size(),
+                      (unsigned long long)range_count);
+            return K4A_RESULT_FAILED;
+        }
+
+        // Ranges are split by file offset so that each range has about the same amount of data to read.
+        uint64_t start_offset = clusters.front()->file_offset;
+        uint64_t data_size = clusters.back()->file_offset + clusters.back()->cluster_size - start_offset;
+        size_t range_start = 0;
+        size_t range_end = clusters.size();
+        for (size_t i = 1; i <= range_index + 1 && i < range_count; i++)
+        {
+            uint64_t split_offset = start_offset + (uint64_t)((double)data_size * i / range_count);
+            auto it = std::lower_bound(clusters.begin(),
+                                       clusters.end(),
+                                       split_offset,
+                                       [](const cluster_info_t *cluster, uint64_t offset) {
+                                           return cluster->file_offset < offset;
+                                       });
+            size_t split = (size_t)(it - clusters.begin());
+            split = std::max(split, range_start + 1);
+            split = std::min(split, clusters.size() - (range_count - i));
+            if (i == range_index + 1)
             {
-                context->cache_hits++;
+                range_end = split;
             }
             else
             {
-                context->load_count++;
-
-                // Start reading the actual cluster data from disk.
-                LargeFileIOCallback *file_io = dynamic_cast<LargeFileIOCallback *>(context->ebml_file.get());
-                if (file_io != NULL)
-                {
-                    file_io->setOwnerThread();
-                }
-
-                if (K4A_FAILED(seek_offset(context, cluster_info->file_offset)))
-                {
-                    LOG_ERROR("Failed to seek to cluster cluster at: %llu", cluster_info->file_offset);
-                    return nullptr;
-                }
-                cluster = find_next<KaxCluster>(context, true);
-                if (cluster)
-                {
-                    if (read_element<KaxCluster>(context, cluster.get()) == NULL)
-                    {
-                        LOG_ERROR("Failed to load cluster at: %llu", cluster_info->file_offset);
-                        return nullptr;
-                    }
-
-                    uint64_t timecode = GetChild<KaxClusterTimecode>(*cluster).GetValue();
-                    assert(context->timecode_scale <= INT64_MAX);
-                    cluster->InitTimecode(timecode, (int64_t)context->timecode_scale);
-
-                    cluster_info->cluster = cluster;
-                }
+                range_start = split;
             }
         }
-        return cluster;
+
+        *first_cluster = clusters[range_start];
+        *last_cluster = clusters[range_end - 1];
+        return K4A_RESULT_SUCCEEDED;
     }
     catch (std::system_error &e)
     {
-        LOG_ERROR("Failed to load cluster from disk: %s", e.what());
-        return nullptr;
+        LOG_ERROR("Failed to split recording into ranges: %s", e.what());
+        return K4A_RESULT_FAILED;
     }
 }
 
-// Load the actual block data for a cluster off the disk, and start preloading the neighboring clusters.
-// This should never fail unless there is a file IO error.
-std::shared_ptr<loaded_cluster_t> load_cluster(k4a_playback_context_t *context, cluster_info_t *cluster_info)
+// Initializes a context for reading the clusters from first_cluster to last_cluster of the source recording. The parsed
+// headers, calibration and cluster index are copied from the source instead of being read again. The context must
+// already have its own ebml_file and stream, and the clusters outside of the range are treated as the end of the file.
+k4a_result_t open_cluster_range(k4a_playback_context_t *source,
+                                k4a_playback_context_t *context,
+                                cluster_info_t *first_cluster,
+                                cluster_info_t *last_cluster)
 {
-    RETURN_VALUE_IF_ARG(nullptr, context == NULL);
-    RETURN_VALUE_IF_ARG(nullptr, context->cluster_cache == nullptr);
-    RETURN_VALUE_IF_ARG(nullptr, cluster_info == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, source == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, source->segment == nullptr);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->stream == nullptr);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->cluster_cache != nullptr);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, first_cluster == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, last_cluster == NULL);
+
+    context->segment.reset(static_cast<KaxSegment *>(source->segment->Clone()));
+    if (source->segment_info)
+        context->segment_info.reset(static_cast<KaxInfo *>(source->segment_info->Clone()));
+    if (source->tracks)
+        context->tracks.reset(static_cast<KaxTracks *>(source->tracks->Clone()));
+    if (source->attachments)
+        context->attachments.reset(static_cast<KaxAttachments *>(source->attachments->Clone()));
+    if (source->tags)
+        context->tags.reset(static_cast<KaxTags *>(source->tags->Clone()));
+
+    context->segment_info_offset = source->segment_info_offset;
+    context->first_cluster_offset = source->first_cluster_offset;
+    context->tracks_offset = source->tracks_offset;
+    context->cues_offset = source->cues_offset;
+    context->attachments_offset = source->attachments_offset;
+    context->tags_offset = source->tags_offset;
+    context->last_file_timestamp_ns = source->last_file_timestamp_ns;
 
-    std::shared_ptr<KaxCluster> cluster = load_cluster_internal(context, cluster_info);
-    if (cluster == nullptr)
+    RETURN_IF_ERROR(parse_recording_config(context));
+
+    if (source->device_calibration)
     {
-        return nullptr;
+        context->device_calibration = make_unique<k4a_calibration_t>(*source->device_calibration);
     }
+    context->color_format_conversion = source->color_format_conversion;
 
-    std::shared_ptr<loaded_cluster_t> result = std::shared_ptr<loaded_cluster_t>(new loaded_cluster_t());
-    result->cluster_info = cluster_info;
-    result->cluster = cluster;
+    // Tracks keep the same numbers, the enabled state is carried over by name.
+    context->disabled_tracks = source->disabled_tracks;
+    for (auto &itr : source->track_map)
+    {
+        auto range_track = context->track_map.find(itr.first);
+        if (range_track != context->track_map.end())
+        {
+            range_track->second.enabled = itr.second.enabled;
+        }
+    }
 
-#if CLUSTER_READ_AHEAD_COUNT
     try
     {
-        // Preload the neighboring clusters immediately
-        cluster_info_t *previous_cluster_info = cluster_info;
-        cluster_info_t *next_cluster_info = cluster_info;
-        for (size_t i = 0; i < CLUSTER_READ_AHEAD_COUNT; i++)
+        std::lock_guard<std::recursive_mutex> lock(source->cache_lock);
+
+        // Copy the clusters in the range, mapping each source entry to its copy so the block index can be copied.
+        std::map<cluster_info_t *, cluster_info_t *> range_clusters;
+        context->cluster_cache = cluster_cache_t(new cluster_info_t, cluster_cache_deleter);
+        cluster_info_t *cluster_info = context->cluster_cache.get();
+        for (cluster_info_t *source_cluster = first_cluster; source_cluster != NULL;
+             source_cluster = next_cluster(source, source_cluster, true))
+        {
+            cluster_info->timestamp_ns = source_cluster->timestamp_ns;
+            cluster_info->file_offset = source_cluster->file_offset;
+            cluster_info->cluster_size = source_cluster->cluster_size;
+            cluster_info->next_known = true;
+            range_clusters[source_cluster] = cluster_info;
+            if (!source->cluster_index.empty())
+            {
+                context->cluster_index.push_back(cluster_info);
+            }
+
+            if (source_cluster == last_cluster)
+            {
+                break;
+            }
+            cluster_info->next = new cluster_info_t;
+            cluster_info->next->previous = cluster_info;
+            cluster_info = cluster_info->next;
+        }
+
+        if (range_clusters.count(last_cluster) == 0)
+        {
+            LOG_ERROR("Failed to find the end of the recording range.", 0);
+            return K4A_RESULT_FAILED;
+        }
+
+        for (auto &itr : source->track_map)
         {
-            if (previous_cluster_info != NULL)
+            auto range_track = context->track_map.find(itr.first);
+            if (range_track == context->track_map.end())
             {
-                previous_cluster_info = next_cluster(context, previous_cluster_info, false);
+                continue;
             }
-            if (next_cluster_info != NULL)
+            for (const indexed_block_t &indexed_block : itr.second.block_index)
             {
-                next_cluster_info = next_cluster(context, next_cluster_info, true);
+                auto range_cluster = range_clusters.find(indexed_block.cluster_info);
+                if (range_cluster != range_clusters.end())
+                {
+                    indexed_block_t range_block;
+                    range_block.timestamp_ns = indexed_block.timestamp_ns;
+                    range_block.cluster_info = range_cluster->second;
+                    range_track->second.block_index.push_back(range_block);
+                }
             }
-            result->previous_clusters[i] = std::async(std::launch::deferred, [context, previous_cluster_info] {
-                return previous_cluster_info ? load_cluster_internal(context, previous_cluster_info) : nullptr;
-            });
-            result->next_clusters[i] = std::async(std::launch::deferred, [context, next_cluster_info] {
-                return next_cluster_info ? load_cluster_internal(context, next_cluster_info) : nullptr;
-            });
-            result->previous_clusters[i].wait();
-            result->next_clusters[i].wait();
         }
+
+        // Each range has its own cluster cache with the same memory limit as the source.
+        std::lock_guard<std::mutex> lru_lock(source->cluster_lru_lock);
+        context->cluster_cache_capacity = source->cluster_cache_capacity;
     }
     catch (std::system_error &e)
     {
-        LOG_ERROR("Failed to load read-ahead clusters: %s", e.what());
-        return nullptr;
+        LOG_ERROR("Failed to copy the recording cluster index: %s", e.what());
+        return K4A_RESULT_FAILED;
     }
-#endif
 
-    return result;
+    return K4A_RESULT_SUCCEEDED;
 }
 
-// Load the next or previous cluster off the disk using the existing preloaded neighbors.
-// The next neighbor in sequence will start being preloaded asynchronously.
-std::shared_ptr<loaded_cluster_t> load_next_cluster(k4a_playback_context_t *context,
-                                                    loaded_cluster_t *current_cluster,
-                                                    bool next)
+// Moves a color, depth or IR track that was just enabled to the last capture read from the other image tracks. The
+// clusters the track stopped in are dropped, so its block is looked up again in clusters loaded with the track enabled.
+static k4a_result_t reposition_capture_track(k4a_playback_context_t *context, track_reader_t *track_reader)
 {
-    RETURN_VALUE_IF_ARG(nullptr, context == NULL);
-    RETURN_VALUE_IF_ARG(nullptr, context->cluster_cache == nullptr);
-    RETURN_VALUE_IF_ARG(nullptr, current_cluster == NULL);
-
-    cluster_info_t *cluster_info = next_cluster(context, current_cluster->cluster_info, next);
-    if (cluster_info == NULL)
+    track_reader_t *capture_tracks[] = { context->color_track, context->depth_track, context->ir_track };
+    std::shared_ptr<block_info_t> reference;
+    for (track_reader_t *other : capture_tracks)
     {
-        // End of file reached.
-        return nullptr;
-    }
+        if (other == NULL || other == track_reader || !other->enabled || other->current_block == nullptr)
+        {
+            continue;
+        }
+        if (other->current_block->block == NULL || reference == nullptr ||
+            other->current_block->sync_timestamp_ns < reference->sync_timestamp_ns)
+        {
+            reference = other->current_block;
+            if (reference->block == NULL)
+            {
+                break;
+            }
+        }
+    }
+    if (reference == nullptr)
+    {
+        // Nothing was read from the other tracks since the last seek, or they are all disabled. In both cases the
+        // track is already at the right position.
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    std::shared_ptr<block_info_t> block;
+    if (reference->block == NULL && reference->index < 0)
+    {
+        // The start of the recording was reached reading backwards.
+        block = find_block(context, track_reader, 0);
+        if (block && block->block)
+        {
+            block = next_block(context, block.get(), false);
+        }
+    }
+    else if (reference->block == NULL)
+    {
+        block = find_block(context, track_reader, UINT64_MAX);
+    }
+    else
+    {
+        // Use the block of this track that belongs to the last capture, if there is one.
+        uint64_t window_ns = context->sync_period_ns / 2;
+        uint64_t start_ns = reference->sync_timestamp_ns > window_ns ? reference->sync_timestamp_ns - window_ns : 0;
+        block = find_block(context, track_reader, start_ns);
+        if (block && (block->block == NULL || block->sync_timestamp_ns >= reference->sync_timestamp_ns + window_ns))
+        {
+            // The track has no block in the last capture, continue from its timestamp in both directions.
+            track_reader->current_block.reset();
+            track_reader->seek_timestamp_ns = reference->sync_timestamp_ns;
+            return K4A_RESULT_SUCCEEDED;
+        }
+    }
+
+    if (block == nullptr)
+    {
+        LOG_ERROR("Failed to find the playback position of track: %s", track_reader->track_name.c_str());
+        return K4A_RESULT_FAILED;
+    }
+    track_reader->current_block = block;
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Enables or disables reading a track. Clusters already in memory may be missing the blocks of disabled tracks, so they
+// are dropped from the cache. Other tracks keep their read position. An image track that is enabled again continues
+// from the last capture. The IMU and custom tracks are not read while they are disabled, so they continue from where
+// they were.
+k4a_result_t set_track_enabled(k4a_playback_context_t *context, track_reader_t *track_reader, bool enabled)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track_reader == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track_reader->track == NULL);
+
+    if (track_reader->enabled == enabled)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    try
+    {
+        std::lock_guard<std::recursive_mutex> cache_lock(context->cache_lock);
+        std::lock_guard<std::mutex> io_lock(context->io_lock);
+
+        uint64_t track_number = GetChild<KaxTrackNumber>(*track_reader->track).GetValue();
+        if (enabled)
+        {
+            context->disabled_tracks.erase(track_number);
+        }
+        else
+        {
+            context->disabled_tracks.insert(track_number);
+        }
+        track_reader->enabled = enabled;
+
+        for (cluster_info_t *cluster_info = context->cluster_cache.get(); cluster_info != NULL;
+             cluster_info = cluster_info->next)
+        {
+            cluster_info->cluster.reset();
+        }
+        clear_cluster_cache(context);
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to update enabled tracks: %s", e.what());
+        return K4A_RESULT_FAILED;
+    }
+
+    context->seek_cluster.reset();
+    if (enabled && (track_reader == context->color_track || track_reader == context->depth_track ||
+                    track_reader == context->ir_track))
+    {
+        return TRACE_CALL(reposition_capture_track(context, track_reader));
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Read the children of a cluster one at a time, stepping over the blocks of disabled tracks without reading their
+// data. Only the elements needed for playback are kept. The caller should currently own the io lock, unless the stream
+// belongs to a reader of a mapped file.
+static bool read_cluster_blocks(k4a_playback_context_t *context,
+                                EbmlStream &stream,
+                                KaxCluster *cluster,
+                                const std::set<uint64_t> &disabled_tracks)
+{
+    uint64_t cluster_end = cluster->GetElementPosition() + cluster->HeadSize() + cluster->GetSize();
+    while (stream.I_O().getFilePointer() < cluster_end)
+    {
+        std::unique_ptr<EbmlElement> element = next_child(context, stream, cluster);
+        if (element == nullptr)
+        {
+            break;
+        }
+        uint64_t element_start = element->GetElementPosition() + element->HeadSize();
+        uint64_t element_end = element_start + element->GetSize();
+
+        EbmlElement *read = NULL;
+        uint64_t track_number = 0;
+        int16_t timecode = 0;
+        if (EbmlId(*element) == KaxClusterTimecode::ClassInfos.GlobalId)
+        {
+            read = read_element<KaxClusterTimecode>(context, stream, element.get());
+        }
+        else if (peek_block_header(context, stream, element.get(), &track_number, &timecode) &&
+                 disabled_tracks.count(track_number) == 0)
+        {
+            stream.I_O().setFilePointer((int64_t)element_start);
+            if (EbmlId(*element) == KaxSimpleBlock::ClassInfos.GlobalId)
+            {
+                read = read_element<KaxSimpleBlock>(context, stream, element.get());
+            }
+            else
+            {
+                read = read_element<KaxBlockGroup>(context, stream, element.get());
+            }
+        }
+        else
+        {
+            // Disabled track or an element that isn't used for playback, skip it without reading the data.
+            stream.I_O().setFilePointer((int64_t)element_end);
+            continue;
+        }
+
+        if (read == NULL)
+        {
+            return false;
+        }
+        cluster->PushElement(*element.release());
+        stream.I_O().setFilePointer((int64_t)element_end);
+    }
+    return true;
+}
+
+// Returns the number of bytes a parsed cluster holds in memory. This is less than the size of the cluster on disk if
+// the blocks of disabled tracks were skipped.
+static uint64_t get_cluster_memory_size(KaxCluster *cluster)
+{
+    uint64_t size = 0;
+    for (size_t i = 0; i < cluster->ListSize(); i++)
+    {
+        size += (*cluster)[i]->HeadSize() + (*cluster)[i]->GetSize();
+    }
+    return size;
+}
+
+// Evicts the least recently used clusters until the cache fits in capacity bytes.
+// cluster_lru_lock must be held by the caller.
+static void evict_clusters(k4a_playback_context_t *context, uint64_t capacity)
+{
+    while (context->cluster_lru_bytes > capacity && !context->cluster_lru.empty())
+    {
+        cached_cluster_t &cached = context->cluster_lru.back();
+        context->cluster_lru_bytes -= cached.size;
+        context->cluster_lru_index.erase(cached.cluster_info);
+        context->cluster_lru.pop_back();
+        context->cache_evictions++;
+    }
+}
+
+// Marks a cluster as the most recently used, adding it to the cache if it is not already there, and updates the cache
+// stats. loaded is true if the cluster was just read from disk.
+static void cache_cluster(k4a_playback_context_t *context,
+                          cluster_info_t *cluster_info,
+                          std::shared_ptr<KaxCluster> &cluster,
+                          bool loaded)
+{
+    std::lock_guard<std::mutex> lock(context->cluster_lru_lock);
+    if (loaded)
+    {
+        context->load_count++;
+    }
+    else
+    {
+        context->cache_hits++;
+    }
+
+    auto entry = context->cluster_lru_index.find(cluster_info);
+    if (entry != context->cluster_lru_index.end())
+    {
+        if (entry->second->cluster == cluster)
+        {
+            context->cluster_lru.splice(context->cluster_lru.begin(), context->cluster_lru, entry->second);
+            return;
+        }
+
+        // The cluster was read again after the enabled tracks changed, replace the stale copy.
+        context->cluster_lru_bytes -= entry->second->size;
+        context->cluster_lru.erase(entry->second);
+        context->cluster_lru_index.erase(entry);
+    }
+
+    uint64_t size = get_cluster_memory_size(cluster.get());
+    if (size > context->cluster_cache_capacity)
+    {
+        // The cluster would evict everything else and then itself, don't bother caching it.
+        return;
+    }
+
+    cached_cluster_t cached;
+    cached.cluster_info = cluster_info;
+    cached.cluster = cluster;
+    cached.size = size;
+    context->cluster_lru.push_front(cached);
+    context->cluster_lru_index[cluster_info] = context->cluster_lru.begin();
+    context->cluster_lru_bytes += size;
+
+    evict_clusters(context, context->cluster_cache_capacity);
+}
+
+k4a_result_t set_cluster_cache_size(k4a_playback_context_t *context, uint64_t size_bytes)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    try
+    {
+        std::lock_guard<std::mutex> lock(context->cluster_lru_lock);
+        context->cluster_cache_capacity = size_bytes;
+        evict_clusters(context, size_bytes);
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to resize the cluster cache: %s", e.what());
+        return K4A_RESULT_FAILED;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Drops every cluster from the cache without counting them as evictions.
+void clear_cluster_cache(k4a_playback_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, context == NULL);
+
+    std::lock_guard<std::mutex> lock(context->cluster_lru_lock);
+    context->cluster_lru.clear();
+    context->cluster_lru_index.clear();
+    context->cluster_lru_bytes = 0;
+}
+
+// Load a cluster from the cluster cache / disk without any neighbor preloading.
+// This should never fail unless there is a file IO error.
+std::shared_ptr<KaxCluster> load_cluster_internal(k4a_playback_context_t *context, cluster_info_t *cluster_info)
+{
+    RETURN_VALUE_IF_ARG(nullptr, context == NULL);
+    RETURN_VALUE_IF_ARG(nullptr, context->ebml_file == nullptr);
+
+    try
+    {
+        // Check if the cluster already exists in memory, and if so, return it.
+        std::shared_ptr<KaxCluster> cluster = cluster_info->cluster.lock();
+        if (cluster)
+        {
+            cache_cluster(context, cluster_info, cluster, false);
+        }
+        else
+        {
+            // Mapped files are read through a reader of their own, so several clusters can be read at once.
+            std::unique_lock<std::mutex> lock(context->io_lock, std::defer_lock);
+            if (!context->file_mapped)
+            {
+                lock.lock();
+            }
+            if (context->file_closing)
+            {
+                // User called k4a_playback_close(), return immediately.
+                return nullptr;
+            }
+
+            // The cluster may have been loaded while we were acquiring the io lock, check again before actually loading
+            // from disk.
+            cluster = cluster_info->cluster.lock();
+            if (cluster)
+            {
+                cache_cluster(context, cluster_info, cluster, false);
+            }
+            else
+            {
+                // Without the io lock, disabled_tracks is read under cache_lock. Taking cache_lock while holding the io
+                // lock would invert the lock order of next_cluster().
+                std::set<uint64_t> disabled_tracks;
+                if (context->file_mapped)
+                {
+                    std::lock_guard<std::recursive_mutex> cache_lock(context->cache_lock);
+                    disabled_tracks = context->disabled_tracks;
+                }
+                else
+                {
+                    disabled_tracks = context->disabled_tracks;
+                }
+
+                // Start reading the actual cluster data from disk.
+                LargeFileIOCallback *file_io = dynamic_cast<LargeFileIOCallback *>(context->ebml_file.get());
+                if (file_io != NULL)
+                {
+                    file_io->setOwnerThread();
+                }
+
+                std::unique_ptr<MappedFileIOCallback> reader;
+                std::unique_ptr<libebml::EbmlStream> reader_stream;
+                if (context->file_mapped)
+                {
+                    reader = make_unique<MappedFileIOCallback>(
+                        *static_cast<MappedFileIOCallback *>(context->ebml_file.get()));
+                    reader_stream = make_unique<libebml::EbmlStream>(*reader);
+                }
+                EbmlStream &stream = reader_stream ? *reader_stream : *context->stream;
+
+                if (K4A_FAILED(seek_offset(context, stream, cluster_info->file_offset)))
+                {
+                    LOG_ERROR("Failed to seek to cluster cluster at: %llu", cluster_info->file_offset);
+                    return nullptr;
+                }
+                cluster = find_next<KaxCluster>(context, stream, true);
+                if (cluster)
+                {
+                    bool cluster_read = disabled_tracks.empty() ?
+                                            read_element<KaxCluster>(context, stream, cluster.get()) != NULL :
+                                            read_cluster_blocks(context, stream, cluster.get(), disabled_tracks);
+                    if (!cluster_read)
+                    {
+                        LOG_ERROR("Failed to load cluster at: %llu", cluster_info->file_offset);
+                        return nullptr;
+                    }
+
+                    uint64_t timecode = GetChild<KaxClusterTimecode>(*cluster).GetValue();
+                    assert(context->timecode_scale <= INT64_MAX);
+                    cluster->InitTimecode(timecode, (int64_t)context->timecode_scale);
+
+                    if (context->file_mapped)
+                    {
+                        std::lock_guard<std::recursive_mutex> cache_lock(context->cache_lock);
+                        std::shared_ptr<KaxCluster> loaded = cluster_info->cluster.lock();
+                        if (loaded)
+                        {
+                            // Another thread read the same cluster at the same time, keep a single copy.
+                            cluster = loaded;
+                            cache_cluster(context, cluster_info, cluster, false);
+                        }
+                        else if (disabled_tracks == context->disabled_tracks)
+                        {
+                            cluster_info->cluster = cluster;
+                            cache_cluster(context, cluster_info, cluster, true);
+                        }
+                    }
+                    else
+                    {
+                        cluster_info->cluster = cluster;
+                        cache_cluster(context, cluster_info, cluster, true);
+                    }
+                }
+            }
+        }
+        return cluster;
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to load cluster from disk: %s", e.what());
+        return nullptr;
+    }
+}
+
+// Load the actual block data for a cluster off the disk, and start preloading the neighboring clusters in the
+// background. This should never fail unless there is a file IO error.
+std::shared_ptr<loaded_cluster_t> load_cluster(k4a_playback_context_t *context, cluster_info_t *cluster_info)
+{
+    RETURN_VALUE_IF_ARG(nullptr, context == NULL);
+    RETURN_VALUE_IF_ARG(nullptr, context->cluster_cache == nullptr);
+    RETURN_VALUE_IF_ARG(nullptr, cluster_info == NULL);
+
+    std::shared_ptr<KaxCluster> cluster = load_cluster_internal(context, cluster_info);
+    if (cluster == nullptr)
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<loaded_cluster_t> result = std::shared_ptr<loaded_cluster_t>(new loaded_cluster_t());
+    result->cluster_info = cluster_info;
+    result->cluster = cluster;
+
+    // The read position jumped, so the prefetch thread needs to start over from the new cluster.
+    request_prefetch(context, cluster_info, context->prefetch_next, true);
+
+    return result;
+}
+
+// Load the next or previous cluster, which will already be in memory if the prefetch thread has caught up.
+// The prefetch thread is then moved forward to keep preloading the clusters after it.
+std::shared_ptr<loaded_cluster_t> load_next_cluster(k4a_playback_context_t *context,
+                                                    loaded_cluster_t *current_cluster,
+                                                    bool next)
+{
+    RETURN_VALUE_IF_ARG(nullptr, context == NULL);
+    RETURN_VALUE_IF_ARG(nullptr, context->cluster_cache == nullptr);
+    RETURN_VALUE_IF_ARG(nullptr, current_cluster == NULL);
+
+    cluster_info_t *cluster_info = next_cluster(context, current_cluster->cluster_info, next);
+    if (cluster_info == NULL)
+    {
+        // End of file reached.
+        return nullptr;
+    }
+
+    std::shared_ptr<loaded_cluster_t> result = std::shared_ptr<loaded_cluster_t>(new loaded_cluster_t());
+    result->cluster_info = cluster_info;
+
+    // Let the prefetch thread start on the following clusters before waiting for this one.
+    request_prefetch(context, cluster_info, next, false);
+    result->cluster = load_cluster_internal(context, cluster_info);
+
+#if CLUSTER_READ_AHEAD_COUNT
+    // Keep the clusters that were just read in memory in case the read direction is reversed.
+    if (next)
+    {
+        result->previous_clusters[0] = current_cluster->cluster;
+        for (size_t i = 1; i < CLUSTER_READ_AHEAD_COUNT; i++)
+        {
+            result->previous_clusters[i] = current_cluster->previous_clusters[i - 1];
+        }
+        for (size_t i = 0; i < CLUSTER_READ_AHEAD_COUNT - 1; i++)
+        {
+            result->next_clusters[i] = current_cluster->next_clusters[i + 1];
+        }
+    }
+    else
+    {
+        result->next_clusters[0] = current_cluster->cluster;
+        for (size_t i = 1; i < CLUSTER_READ_AHEAD_COUNT; i++)
+        {
+            result->next_clusters[i] = current_cluster->next_clusters[i - 1];
+        }
+        for (size_t i = 0; i < CLUSTER_READ_AHEAD_COUNT - 1; i++)
+        {
+            result->previous_clusters[i] = current_cluster->previous_clusters[i + 1];
+        }
+    }
+#endif
+
+    return result;
+}
+
+// Returns an idle turbojpeg decompressor from the pool, or creates a new one if they are all in use.
+static tjhandle acquire_jpeg_decoder(k4a_playback_context_t *context)
+{
+    {
+        std::lock_guard<std::mutex> lock(context->decoder_pool_lock);
+        if (!context->decoder_pool.empty())
+        {
+            tjhandle decoder = context->decoder_pool.back();
+            context->decoder_pool.pop_back();
+            return decoder;
+        }
+    }
+    return tjInitDecompress();
+}
+
+static void release_jpeg_decoder(k4a_playback_context_t *context, tjhandle decoder)
+{
+    if (decoder != NULL)
+    {
+        std::lock_guard<std::mutex> lock(context->decoder_pool_lock);
+        context->decoder_pool.push_back(decoder);
+    }
+}
+
+// Decodes an MJPEG block into a BGRA buffer using a pooled decompressor.
+static bool decode_mjpeg_block(k4a_playback_context_t *context,
+                               KaxInternalBlock *block,
+                               int width,
+                               int height,
+                               std::vector<uint8_t> *buffer)
+{
+    DataBuffer &data_buffer = block->GetBuffer(0);
+    assert(buffer->size() >= (size_t)width * (size_t)height * 4);
+
+    tjhandle decoder = acquire_jpeg_decoder(context);
+    if (decoder == NULL)
+    {
+        return false;
+    }
+    bool result = tjDecompress2(decoder,
+                                data_buffer.Buffer(),
+                                data_buffer.Size(),
+                                buffer->data(),
+                                width,
+                                0, // pitch
+                                height,
+                                TJPF_BGRA,
+                                TJFLAG_FASTDCT | TJFLAG_FASTUPSAMPLE) == 0;
+    release_jpeg_decoder(context, decoder);
+    return result;
+}
+
+// Worker thread that decodes the color frames queued by queue_color_decode().
+static void color_decode_thread(k4a_playback_context_t *context)
+{
+    assert(context->decode_notify);
+    assert(context->decode_complete);
+
+    try
+    {
+        std::unique_lock<std::mutex> lock(context->decode_lock);
+        while (true)
+        {
+            context->decode_notify->wait(lock, [context]() {
+                return context->decode_stopping || !context->decode_queue.empty();
+            });
+            if (context->decode_stopping)
+            {
+                break;
+            }
+
+            uint64_t offset = context->decode_queue.front();
+            context->decode_queue.pop_front();
+            auto frame = context->decoded_frames.find(offset);
+            if (frame == context->decoded_frames.end() || !frame->second.queued)
+            {
+                continue;
+            }
+            frame->second.queued = false;
+            std::shared_ptr<KaxCluster> cluster = frame->second.cluster;
+            KaxInternalBlock *block = frame->second.block;
+            lock.unlock();
+
+            int width = (int)context->color_track->width;
+            int height = (int)context->color_track->height;
+            std::vector<uint8_t> *buffer = new std::vector<uint8_t>((size_t)width * (size_t)height * 4);
+            if (!decode_mjpeg_block(context, block, width, height, buffer))
+            {
+                // The reader will decode the frame again and report the error.
+                delete buffer;
+                buffer = NULL;
+            }
+
+            lock.lock();
+            // Frames are not evicted while they are being decoded.
+            frame = context->decoded_frames.find(offset);
+            assert(frame != context->decoded_frames.end());
+            frame->second.buffer = buffer;
+            frame->second.done = true;
+            frame->second.cluster.reset();
+            context->decode_complete->notify_all();
+
+            // Release the cluster outside of the lock.
+            lock.unlock();
+            cluster.reset();
+            lock.lock();
+        }
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Color decode thread threw exception: %s", e.what());
+    }
+}
+
+// Queues the next COLOR_DECODE_AHEAD_COUNT color frames in the given clusters for decoding, in the read direction from
+// the last frame returned to the user. Decoded frames that are no longer ahead of the reader are freed.
+static void queue_color_decode(k4a_playback_context_t *context,
+                               cluster_info_t *position,
+                               const std::vector<std::shared_ptr<KaxCluster>> &window,
+                               bool next)
+{
+    if (context->color_track == NULL || position == NULL)
+    {
+        return;
+    }
+
+    uint64_t read_offset = 0;
+    {
+        std::lock_guard<std::mutex> lock(context->decode_lock);
+        if (!context->decode_ahead_enabled)
+        {
+            return;
+        }
+        read_offset = context->decode_read_offset;
+    }
+
+    // The reader may not have reached the color frame in the current cluster yet.
+    std::vector<std::shared_ptr<KaxCluster>> clusters;
+    clusters.reserve(window.size() + 1);
+    clusters.push_back(load_cluster_internal(context, position));
+    clusters.insert(clusters.end(), window.begin(), window.end());
+
+    uint64_t color_track_number = GetChild<KaxTrackNumber>(*context->color_track->track).GetValue();
+    std::vector<std::pair<uint64_t, decoded_frame_t>> wanted;
+    for (const std::shared_ptr<KaxCluster> &cluster : clusters)
+    {
+        if (cluster == nullptr)
+        {
+            continue;
+        }
+        for (EbmlElement *e : cluster->GetElementList())
+        {
+            KaxSimpleBlock *simple_block = NULL;
+            if (check_element_type(e, &simple_block) && simple_block->TrackNum() == color_track_number &&
+                simple_block->NumberFrames() == 1)
+            {
+                uint64_t offset = simple_block->GetElementPosition();
+                if (next ? offset > read_offset : offset < read_offset)
+                {
+                    decoded_frame_t frame;
+                    frame.cluster = cluster;
+                    frame.block = simple_block;
+                    wanted.emplace_back(offset, frame);
+                }
+            }
+        }
+    }
+
+    // Decode the frames closest to the reader first.
+    std::sort(wanted.begin(),
+              wanted.end(),
+              [next](const std::pair<uint64_t, decoded_frame_t> &a, const std::pair<uint64_t, decoded_frame_t> &b) {
+                  return next ? a.first < b.first : a.first > b.first;
+              });
+    wanted.erase(std::unique(wanted.begin(),
+                             wanted.end(),
+                             [](const std::pair<uint64_t, decoded_frame_t> &a,
+                                const std::pair<uint64_t, decoded_frame_t> &b) { return a.first == b.first; }),
+                 wanted.end());
+    if (wanted.size() > COLOR_DECODE_AHEAD_COUNT)
+    {
+        wanted.resize(COLOR_DECODE_AHEAD_COUNT);
+    }
+
+    std::vector<std::vector<uint8_t> *> evicted;
+    std::vector<std::shared_ptr<KaxCluster>> evicted_clusters;
+    {
+        std::lock_guard<std::mutex> lock(context->decode_lock);
+        for (auto frame = context->decoded_frames.begin(); frame != context->decoded_frames.end();)
+        {
+            bool keep = frame->second.claimed || (!frame->second.queued && !frame->second.done);
+            for (size_t i = 0; i < wanted.size() && !keep; i++)
+            {
+                keep = wanted[i].first == frame->first;
+            }
+            if (keep)
+            {
+                ++frame;
+            }
+            else
+            {
+                evicted.push_back(frame->second.buffer);
+                evicted_clusters.push_back(frame->second.cluster);
+                frame = context->decoded_frames.erase(frame);
+            }
+        }
+
+        context->decode_queue.clear();
+        for (auto &frame : wanted)
+        {
+            auto existing = context->decoded_frames.find(frame.first);
+            if (existing == context->decoded_frames.end())
+            {
+                context->decoded_frames[frame.first] = frame.second;
+                context->decode_queue.push_back(frame.first);
+            }
+            else if (existing->second.queued)
+            {
+                context->decode_queue.push_back(frame.first);
+            }
+        }
+    }
+    context->decode_notify->notify_all();
+
+    for (std::vector<uint8_t> *buffer : evicted)
+    {
+        delete buffer;
+    }
+}
+
+// If the color block was decoded ahead of time, returns the BGRA buffer and removes it from the decode cache.
+// Returns NULL if the frame needs to be decoded by the caller.
+static std::vector<uint8_t> *take_decoded_frame(k4a_playback_context_t *context, block_info_t *block)
+{
+    if (context->decode_complete == nullptr)
+    {
+        return NULL;
+    }
+
+    uint64_t offset = block->block->GetElementPosition();
+    std::vector<uint8_t> *buffer = NULL;
+    std::shared_ptr<KaxCluster> cluster;
+    try
+    {
+        std::unique_lock<std::mutex> lock(context->decode_lock);
+        if (!context->decode_ahead_enabled)
+        {
+            return NULL;
+        }
+        context->decode_read_offset = offset;
+
+        auto frame = context->decoded_frames.find(offset);
+        if (frame == context->decoded_frames.end())
+        {
+            return NULL;
+        }
+        if (frame->second.queued)
+        {
+            // Decoding hasn't started yet, it is faster to decode it on this thread than to wait for a worker.
+            cluster = frame->second.cluster;
+            context->decoded_frames.erase(frame);
+        }
+        else
+        {
+            frame->second.claimed = true;
+            context->decode_complete->wait(lock, [context, offset]() {
+                auto waiting = context->decoded_frames.find(offset);
+                return waiting == context->decoded_frames.end() || waiting->second.done;
+            });
+            frame = context->decoded_frames.find(offset);
+            if (frame != context->decoded_frames.end())
+            {
+                buffer = frame->second.buffer;
+                context->decoded_frames.erase(frame);
+            }
+        }
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to read decoded color frame: %s", e.what());
+    }
+    return buffer;
+}
+
+// If the recording is memory mapped, lets the OS start paging in the clusters that are about to be prefetched. Cluster
+// sizes are only known once a cluster has been read, so the range is estimated from the size of the current cluster.
+static void advise_read_ahead(k4a_playback_context_t *context, cluster_info_t *cluster_info, size_t count, bool next)
+{
+    MappedFileIOCallback *mapped_file = dynamic_cast<MappedFileIOCallback *>(context->ebml_file.get());
+    if (mapped_file == NULL || cluster_info == NULL || cluster_info->cluster_size == 0 || count == 0)
+    {
+        return;
+    }
+
+    uint64_t cluster_offset = context->segment->GetGlobalPosition(cluster_info->file_offset);
+    uint64_t range_size = cluster_info->cluster_size * count;
+    if (next)
+    {
+        mapped_file->willNeed(cluster_offset + cluster_info->cluster_size, range_size);
+    }
+    else
+    {
+        uint64_t range_start = cluster_offset > range_size ? cluster_offset - range_size : 0;
+        mapped_file->willNeed(range_start, cluster_offset - range_start);
+    }
+}
+
+// Background thread that keeps the next read_ahead_count clusters after prefetch_position loaded in memory.
+// Clusters are kept alive by holding a reference in the local window until the read position moves past them.
+static void prefetch_thread(k4a_playback_context_t *context)
+{
+    assert(context->prefetch_notify);
+
+    std::vector<std::shared_ptr<KaxCluster>> window;
+    std::vector<std::shared_ptr<KaxCluster>> loading;
+    uint64_t generation = 0;
+
+    try
+    {
+        std::unique_lock<std::mutex> lock(context->prefetch_lock);
+        while (true)
+        {
+            context->prefetch_notify->wait(lock, [context, &generation]() {
+                return context->prefetch_stopping || context->prefetch_generation != generation;
+            });
+            if (context->prefetch_stopping)
+            {
+                break;
+            }
+
+            generation = context->prefetch_generation;
+            cluster_info_t *position = context->prefetch_position;
+            cluster_info_t *cluster_info = position;
+            size_t read_ahead_count = context->read_ahead_count;
+            bool next = context->prefetch_next;
+            if (context->read_ahead_direction != K4A_PLAYBACK_READ_AHEAD_FOLLOW)
+            {
+                next = context->read_ahead_direction == K4A_PLAYBACK_READ_AHEAD_FORWARD;
+            }
+            lock.unlock();
+
+            advise_read_ahead(context, cluster_info, read_ahead_count, next);
+
+            // Clusters that are still in the window from the last pass are cache hits and will not be re-read.
+            bool interrupted = false;
+            loading.clear();
+            for (size_t i = 0; i < read_ahead_count && cluster_info != NULL && !interrupted; i++)
+            {
+                cluster_info = next_cluster(context, cluster_info, next);
+                if (cluster_info != NULL)
+                {
+                    std::shared_ptr<KaxCluster> cluster = load_cluster_internal(context, cluster_info);
+                    if (cluster == nullptr)
+                    {
+                        // The file is closing or could not be read, the error is reported when the user reaches it.
+                        break;
+                    }
+                    loading.push_back(cluster);
+                }
+
+                lock.lock();
+                interrupted = context->prefetch_stopping || context->prefetch_generation != generation;
+                lock.unlock();
+            }
+
+            if (interrupted)
+            {
+                // The read position moved before this pass was finished. Keep the previous window as well so that
+                // clusters ahead of the new position are not freed, but bound it in case the reader stays ahead.
+                loading.insert(loading.end(), window.begin(), window.end());
+                if (loading.size() > read_ahead_count * 2)
+                {
+                    loading.resize(read_ahead_count * 2);
+                }
+            }
+            window.swap(loading);
+            loading.clear();
+
+            queue_color_decode(context, position, window, next);
+
+            lock.lock();
+        }
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Cluster prefetch thread threw exception: %s", e.what());
+    }
+}
+
+k4a_result_t start_prefetch_thread(k4a_playback_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->prefetch_thread.joinable());
+
+    try
+    {
+        context->prefetch_notify.reset(new std::condition_variable());
+        context->prefetch_stopping = false;
+        // The prefetch thread queues color frames for the decode threads, see set_color_decode_ahead().
+        context->decode_notify.reset(new std::condition_variable());
+        context->decode_complete.reset(new std::condition_variable());
+        context->decode_stopping = false;
+        context->prefetch_thread = std::thread(prefetch_thread, context);
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to start cluster prefetch thread: %s", e.what());
+        return K4A_RESULT_FAILED;
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+void stop_prefetch_thread(k4a_playback_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, context == NULL);
+
+    if (context->prefetch_notify == nullptr)
+    {
+        // Prefetching was never started.
+        return;
+    }
+
+    try
+    {
+        {
+            std::lock_guard<std::mutex> lock(context->prefetch_lock);
+            context->prefetch_stopping = true;
+        }
+        context->prefetch_notify->notify_one();
+
+        if (context->prefetch_thread.joinable())
+        {
+            context->prefetch_thread.join();
+        }
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to stop cluster prefetch thread: %s", e.what());
+    }
+}
+
+// Moves the prefetch position to a cluster that was just read. Each track reads clusters independently, so unless
+// reset is set, the position only moves if the cluster is further along in the read direction than the current one.
+void request_prefetch(k4a_playback_context_t *context, cluster_info_t *position, bool next, bool reset)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, context == NULL);
+    RETURN_VALUE_IF_ARG(VOID_VALUE, position == NULL);
+
+    if (context->prefetch_notify == nullptr)
+    {
+        // Prefetching has not been started.
+        return;
+    }
+
+    try
+    {
+        {
+            std::lock_guard<std::mutex> lock(context->prefetch_lock);
+            cluster_info_t *current = context->prefetch_position;
+            if (current == position && context->prefetch_next == next)
+            {
+                return;
+            }
+            if (!reset && current != NULL && context->prefetch_next == next)
+            {
+                bool ahead = next ? position->timestamp_ns > current->timestamp_ns :
+                                    position->timestamp_ns < current->timestamp_ns;
+                if (!ahead)
+                {
+                    return;
+                }
+            }
+
+            context->prefetch_position = position;
+            context->prefetch_next = next;
+            context->prefetch_generation++;
+        }
+        context->prefetch_notify->notify_one();
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to update cluster prefetch position: %s", e.what());
+    }
+}
 
-    std::shared_ptr<loaded_cluster_t> result = std::shared_ptr<loaded_cluster_t>(new loaded_cluster_t());
-    result->cluster_info = cluster_info;
+// Enables decoding MJPEG color frames ahead of the read position. The worker threads are started the first time this is
+// enabled, and run until stop_color_decode_threads() is called.
+k4a_result_t set_color_decode_ahead(k4a_playback_context_t *context, bool enabled)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, enabled && context->color_track == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->decode_notify == nullptr);
 
-#if CLUSTER_READ_AHEAD_COUNT
+    std::vector<std::vector<uint8_t> *> evicted;
+    std::vector<std::shared_ptr<KaxCluster>> evicted_clusters;
     try
     {
-        // Use the current cluster as one of the neightbors, and then wait for the target cluster to be available.
-        std::shared_ptr<KaxCluster> old_cluster = current_cluster->cluster;
-        if (next)
+        if (enabled && context->decode_threads.empty())
         {
-            result->previous_clusters[0] = std::async(std::launch::deferred, [old_cluster] { return old_cluster; });
-            for (size_t i = 1; i < CLUSTER_READ_AHEAD_COUNT; i++)
+            // Leave one core for the thread reading the recording.
+            unsigned int thread_count = std::thread::hardware_concurrency();
+            thread_count = thread_count > 1 ? thread_count - 1 : 1;
+            thread_count = std::min(thread_count, (unsigned int)MAX_COLOR_DECODE_THREADS);
+            for (unsigned int i = 0; i < thread_count; i++)
             {
-                result->previous_clusters[i] = current_cluster->previous_clusters[i - 1];
+                context->decode_threads.emplace_back(color_decode_thread, context);
             }
-
-            current_cluster->next_clusters[0].wait();
-            result->cluster = current_cluster->next_clusters[0].get();
         }
-        else
+
         {
-            result->next_clusters[0] = std::async(std::launch::deferred, [old_cluster] { return old_cluster; });
-            for (size_t i = 1; i < CLUSTER_READ_AHEAD_COUNT; i++)
+            std::lock_guard<std::mutex> lock(context->decode_lock);
+            context->decode_ahead_enabled = enabled;
+            if (!enabled)
             {
-                result->next_clusters[i] = current_cluster->next_clusters[i - 1];
+                // Free the frames that are not currently being decoded.
+                context->decode_queue.clear();
+                for (auto frame = context->decoded_frames.begin(); frame != context->decoded_frames.end();)
+                {
+                    if (frame->second.queued || frame->second.done)
+                    {
+                        evicted.push_back(frame->second.buffer);
+                        evicted_clusters.push_back(frame->second.cluster);
+                        frame = context->decoded_frames.erase(frame);
+                    }
+                    else
+                    {
+                        ++frame;
+                    }
+                }
             }
-
-            current_cluster->previous_clusters[0].wait();
-            result->cluster = current_cluster->previous_clusters[0].get();
         }
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to start color decode threads: %s", e.what());
+        return K4A_RESULT_FAILED;
+    }
 
-        // Spawn a new async task to preload the next cluster in sequence.
-        if (next)
+    for (std::vector<uint8_t> *buffer : evicted)
+    {
+        delete buffer;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Stops the color decode threads and frees all decoded frames and turbojpeg decompressors.
+void stop_color_decode_threads(k4a_playback_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(VOID_VALUE, context == NULL);
+
+    try
+    {
+        if (context->decode_notify != nullptr)
         {
-            for (size_t i = 0; i < CLUSTER_READ_AHEAD_COUNT - 1; i++)
             {
-                result->next_clusters[i] = current_cluster->next_clusters[i + 1];
+                std::lock_guard<std::mutex> lock(context->decode_lock);
+                context->decode_stopping = true;
             }
-            result->next_clusters[CLUSTER_READ_AHEAD_COUNT - 1] = std::async([context, cluster_info] {
-                cluster_info_t *new_cluster = cluster_info;
-                for (size_t i = 0; i < CLUSTER_READ_AHEAD_COUNT && new_cluster != NULL; i++)
+            context->decode_notify->notify_all();
+
+            for (std::thread &thread : context->decode_threads)
+            {
+                if (thread.joinable())
                 {
-                    new_cluster = next_cluster(context, new_cluster, true);
+                    thread.join();
                 }
-                return new_cluster ? load_cluster_internal(context, new_cluster) : nullptr;
-            });
+            }
+            context->decode_threads.clear();
         }
-        else
+
+        for (auto &frame : context->decoded_frames)
         {
-            for (size_t i = 0; i < CLUSTER_READ_AHEAD_COUNT - 1; i++)
-            {
-                result->previous_clusters[i] = current_cluster->previous_clusters[i + 1];
-            }
-            result->previous_clusters[CLUSTER_READ_AHEAD_COUNT - 1] = std::async([context, cluster_info] {
-                cluster_info_t *new_cluster = cluster_info;
-                for (size_t i = 0; i < CLUSTER_READ_AHEAD_COUNT && new_cluster != NULL; i++)
-                {
-                    new_cluster = next_cluster(context, new_cluster, false);
-                }
-                return new_cluster ? load_cluster_internal(context, new_cluster) : nullptr;
-            });
+            delete frame.second.buffer;
+        }
+        context->decoded_frames.clear();
+        context->decode_queue.clear();
+
+        std::lock_guard<std::mutex> lock(context->decoder_pool_lock);
+        for (tjhandle decoder : context->decoder_pool)
+        {
+            (void)tjDestroy(decoder);
         }
+        context->decoder_pool.clear();
     }
     catch (std::system_error &e)
     {
-        LOG_ERROR("Failed to load next cluster: %s", e.what());
-        return nullptr;
+        LOG_ERROR("Failed to stop color decode threads: %s", e.what());
     }
-#else
-    result->cluster = load_cluster_internal(context, cluster_info);
-#endif
-
-    return result;
 }
 
 // If the block contains more than 1 frame, estimate the timestamp for the current frame based on the block duration.
@@ -1540,7 +2920,28 @@ std::shared_ptr<block_info_t> find_block(k4a_playback_context_t *context, track_
     block->reader = reader;
     block->index = -1;
     block->sub_index = 0;
-    cluster_info_t *cluster_info = find_cluster(context, timestamp_ns);
+    cluster_info_t *cluster_info = NULL;
+    if (!reader->block_index.empty())
+    {
+        // Start from the block before the first indexed block >= timestamp_ns, since it may be a block group
+        // containing timestamp_ns.
+        uint64_t block_timestamp_ns = timestamp_ns > reader->sync_delay_ns ? timestamp_ns - reader->sync_delay_ns : 0;
+        auto it = std::lower_bound(reader->block_index.begin(),
+                                   reader->block_index.end(),
+                                   block_timestamp_ns,
+                                   [](const indexed_block_t &indexed_block, uint64_t timestamp) {
+                                       return indexed_block.timestamp_ns < timestamp;
+                                   });
+        if (it != reader->block_index.begin())
+        {
+            --it;
+        }
+        cluster_info = it->cluster_info;
+    }
+    else
+    {
+        cluster_info = find_cluster(context, timestamp_ns);
+    }
     if (cluster_info == NULL)
     {
         LOG_ERROR("Failed to find data cluster for timestamp: %llu", timestamp_ns);
@@ -1671,6 +3072,110 @@ static void free_vector_buffer(void *buffer, void *context)
     delete vector;
 }
 
+typedef struct _pooled_buffer_t
+{
+    std::shared_ptr<image_buffer_pool_t> pool;
+    std::vector<uint8_t> *buffer = NULL;
+} pooled_buffer_t;
+
+static void image_buffer_pool_deleter(image_buffer_pool_t *pool)
+{
+    for (std::vector<uint8_t> *buffer : pool->buffers)
+    {
+        delete buffer;
+    }
+    delete pool;
+}
+
+// Returns a buffer of the specified size, reusing one from a released image if possible.
+static pooled_buffer_t *acquire_pooled_buffer(k4a_playback_context_t *context, size_t size)
+{
+    if (context->image_buffer_pool == nullptr)
+    {
+        context->image_buffer_pool = std::shared_ptr<image_buffer_pool_t>(new image_buffer_pool_t,
+                                                                          image_buffer_pool_deleter);
+    }
+
+    pooled_buffer_t *pooled_buffer = new pooled_buffer_t;
+    pooled_buffer->pool = context->image_buffer_pool;
+    {
+        // Buffers are only reused for images of the same size, so a large buffer is never held by a small image.
+        std::lock_guard<std::mutex> lock(pooled_buffer->pool->lock);
+        std::vector<std::vector<uint8_t> *> &buffers = pooled_buffer->pool->buffers;
+        for (size_t i = buffers.size(); i > 0; i--)
+        {
+            if (buffers[i - 1]->size() == size)
+            {
+                pooled_buffer->buffer = buffers[i - 1];
+                buffers.erase(buffers.begin() + (ptrdiff_t)(i - 1));
+                break;
+            }
+        }
+    }
+
+    if (pooled_buffer->buffer == NULL)
+    {
+        pooled_buffer->buffer = new std::vector<uint8_t>(size);
+    }
+    return pooled_buffer;
+}
+
+// If the recording is memory mapped, returns a read-only reference to a frame of the block in place within the file
+// mapping. Otherwise nullptr is returned and the frame needs to be copied out of the loaded cluster.
+static std::shared_ptr<const uint8_t> get_mapped_frame(k4a_playback_context_t *context, block_info_t *block, int frame)
+{
+    MappedFileIOCallback *mapped_file = dynamic_cast<MappedFileIOCallback *>(context->ebml_file.get());
+    if (mapped_file == NULL)
+    {
+        return nullptr;
+    }
+
+    // The frame buffers point into the block element data, which was read from the file starting after the element
+    // header. Blocks that store their frames elsewhere are not referenced in place.
+    DataBuffer &data_buffer = block->block->GetBuffer((unsigned int)frame);
+    const binary *element_data = block->block->EbmlBinary::GetBuffer();
+    if (element_data == NULL || data_buffer.Buffer() < element_data ||
+        data_buffer.Buffer() + data_buffer.Size() > element_data + block->block->GetSize())
+    {
+        return nullptr;
+    }
+
+    uint64_t offset = block->block->GetElementPosition() + block->block->HeadSize() +
+                      (uint64_t)(data_buffer.Buffer() - element_data);
+    return mapped_file->view(offset, data_buffer.Size());
+}
+
+static void free_mapped_buffer(void *buffer, void *context)
+{
+    (void)buffer;
+    assert(context != nullptr);
+    std::shared_ptr<uint8_t> *view = static_cast<std::shared_ptr<uint8_t> *>(context);
+    delete view;
+}
+
+// Returns the buffer to its pool when the image is released, the pool may already be detached from the playback.
+static void free_pooled_buffer(void *buffer, void *context)
+{
+    (void)buffer;
+    assert(context != nullptr);
+    pooled_buffer_t *pooled_buffer = static_cast<pooled_buffer_t *>(context);
+    if (pooled_buffer->buffer != NULL)
+    {
+        std::lock_guard<std::mutex> lock(pooled_buffer->pool->lock);
+        std::vector<std::vector<uint8_t> *> &buffers = pooled_buffer->pool->buffers;
+        if (buffers.size() >= IMAGE_BUFFER_POOL_SIZE)
+        {
+            // Drop the least recently released buffer, it may be of a size that is no longer requested.
+            delete buffers.front();
+            buffers.erase(buffers.begin());
+        }
+        buffers.push_back(pooled_buffer->buffer);
+        pooled_buffer->buffer = NULL;
+    }
+    delete pooled_buffer->buffer;
+    delete pooled_buffer;
+}
+
 // Allocates a new image in the specified format from in_block
 k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
                                     block_info_t *in_block,
@@ -1688,6 +3193,8 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
 
     k4a_result_t result = K4A_RESULT_SUCCEEDED;
     std::vector<uint8_t> *buffer = NULL;
+    std::shared_ptr<uint8_t> *mapped_buffer = NULL;
+    pooled_buffer_t *pooled_buffer = NULL;
     assert(in_block->reader->width <= INT_MAX);
     assert(in_block->reader->height <= INT_MAX);
     assert(in_block->reader->stride <= INT_MAX);
@@ -1700,22 +3207,41 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
     {
     case K4A_IMAGE_FORMAT_DEPTH16:
     case K4A_IMAGE_FORMAT_IR16:
-        buffer = new std::vector<uint8_t>(data_buffer.Buffer(), data_buffer.Buffer() + data_buffer.Size());
+        if (in_block->reader->rvl_compressed)
+        {
+            // Decoded values are native 16-bit integers, no byte swapping is needed.
+            pooled_buffer = acquire_pooled_buffer(context, (size_t)out_height * (size_t)out_stride);
+            if (!rvl_decode_image(data_buffer.Buffer(),
+                                  data_buffer.Size(),
+                                  reinterpret_cast<uint16_t *>(pooled_buffer->buffer->data()),
+                                  pooled_buffer->buffer->size() / sizeof(uint16_t)))
+            {
+                LOG_ERROR("Failed to decompress RVL image.", 0);
+                result = K4A_RESULT_FAILED;
+            }
+            break;
+        }
+
         if (in_block->reader->format == K4A_IMAGE_FORMAT_DEPTH16 || in_block->reader->format == K4A_IMAGE_FORMAT_IR16)
         {
             // 16 bit grayscale needs to be converted from big-endian back to little-endian.
-            assert(buffer->size() % sizeof(uint16_t) == 0);
-            uint16_t *buffer_raw = reinterpret_cast<uint16_t *>(buffer->data());
-            size_t buffer_size = buffer->size() / sizeof(uint16_t);
+            // The samples are swapped straight from the block into the output buffer.
+            assert(data_buffer.Size() % sizeof(uint16_t) == 0);
+            pooled_buffer = acquire_pooled_buffer(context, data_buffer.Size());
+            const uint8_t *block_raw = data_buffer.Buffer();
+            uint16_t *buffer_raw = reinterpret_cast<uint16_t *>(pooled_buffer->buffer->data());
+            size_t buffer_size = data_buffer.Size() / sizeof(uint16_t);
             for (size_t i = 0; i < buffer_size; i++)
             {
-                buffer_raw[i] = swap_bytes_16(buffer_raw[i]);
+                buffer_raw[i] = (uint16_t)((block_raw[i * 2] << 8) | block_raw[i * 2 + 1]);
             }
         }
         else if (in_block->reader->format == K4A_IMAGE_FORMAT_COLOR_YUY2)
         {
             // For backward compatibility with early recordings, the YUY2 format was used. The actual data buffer is
             // 16-bit little-endian, so we can just use the buffer as-is.
+            pooled_buffer = acquire_pooled_buffer(context, data_buffer.Size());
+            memcpy(pooled_buffer->buffer->data(), data_buffer.Buffer(), data_buffer.Size());
         }
         else
         {
@@ -1729,32 +3255,46 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
     case K4A_IMAGE_FORMAT_COLOR_BGRA32:
         if (in_block->reader->format == target_format)
         {
-            // No format conversion is required, just copy the buffer.
-            buffer = new std::vector<uint8_t>(data_buffer.Buffer(), data_buffer.Buffer() + data_buffer.Size());
+            // No format conversion is required, reference the frame in the loaded cluster. The image buffer is
+            // read-only, writing to it changes the cached frame returned by later reads of the same cluster.
+            if (in_block->cluster != nullptr && in_block->cluster->cluster != nullptr)
+            {
+                // The block data is owned by the cluster, which stays in memory until the image is released.
+                mapped_buffer = new std::shared_ptr<uint8_t>(in_block->cluster->cluster, data_buffer.Buffer());
+            }
+            else
+            {
+                pooled_buffer = acquire_pooled_buffer(context, data_buffer.Size());
+                memcpy(pooled_buffer->buffer->data(), data_buffer.Buffer(), data_buffer.Size());
+            }
         }
         else
         {
             // Convert the buffer to BGRA format first
             out_stride = out_width * 4 * (int)sizeof(uint8_t);
-            buffer = new std::vector<uint8_t>((size_t)(out_height * out_stride));
+            if (in_block->reader->format == K4A_IMAGE_FORMAT_COLOR_MJPG && in_block->reader == context->color_track)
+            {
+                // Use the frame decoded ahead of time by the color decode threads if there is one.
+                buffer = take_decoded_frame(context, in_block);
+                if (buffer != NULL && buffer->size() != (size_t)(out_height * out_stride))
+                {
+                    delete buffer;
+                    buffer = NULL;
+                }
+            }
+            bool decoded = buffer != NULL;
+            if (!decoded)
+            {
+                buffer = new std::vector<uint8_t>((size_t)(out_height * out_stride));
+            }
 
             if (in_block->reader->format == K4A_IMAGE_FORMAT_COLOR_MJPG)
             {
-                tjhandle turbojpeg_handle = tjInitDecompress();
-                if (tjDecompress2(turbojpeg_handle,
-                                  data_buffer.Buffer(),
-                                  data_buffer.Size(),
-                                  buffer->data(),
-                                  out_width,
-                                  0, // pitch
-                                  out_height,
-                                  TJPF_BGRA,
-                                  TJFLAG_FASTDCT | TJFLAG_FASTUPSAMPLE) != 0)
+                if (!decoded && !decode_mjpeg_block(context, in_block->block, out_width, out_height, buffer))
                 {
                     LOG_ERROR("Failed to decompress jpeg image to BGRA format.", 0);
                     result = K4A_RESULT_FAILED;
                 }
-                (void)tjDestroy(turbojpeg_handle);
             }
             else if (in_block->reader->format == K4A_IMAGE_FORMAT_COLOR_NV12)
             {
@@ -1849,7 +3389,32 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
         result = K4A_RESULT_FAILED;
     }
 
-    if (K4A_SUCCEEDED(result) && buffer != NULL)
+    if (K4A_SUCCEEDED(result) && mapped_buffer != NULL)
+    {
+        // The image keeps the cluster alive until it is released.
+        result = TRACE_CALL(k4a_image_create_from_buffer(target_format,
+                                                         out_width,
+                                                         out_height,
+                                                         out_stride,
+                                                         mapped_buffer->get(),
+                                                         data_buffer.Size(),
+                                                         &free_mapped_buffer,
+                                                         mapped_buffer,
+                                                         image_out));
+    }
+    else if (K4A_SUCCEEDED(result) && pooled_buffer != NULL)
+    {
+        result = TRACE_CALL(k4a_image_create_from_buffer(target_format,
+                                                         out_width,
+                                                         out_height,
+                                                         out_stride,
+                                                         pooled_buffer->buffer->data(),
+                                                         pooled_buffer->buffer->size(),
+                                                         &free_pooled_buffer,
+                                                         pooled_buffer,
+                                                         image_out));
+    }
+    else if (K4A_SUCCEEDED(result) && buffer != NULL)
     {
         result = TRACE_CALL(k4a_image_create_from_buffer(target_format,
                                                          out_width,
@@ -1860,6 +3425,10 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
                                                          &free_vector_buffer,
                                                          buffer,
                                                          image_out));
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
         uint64_t device_timestamp_usec = in_block->timestamp_ns / 1000 +
                                          (uint64_t)context->record_config.start_timestamp_offset_usec;
         k4a_image_set_device_timestamp_usec(*image_out, device_timestamp_usec);
@@ -1869,6 +3438,14 @@ k4a_result_t convert_block_to_image(k4a_playback_context_t *context,
     {
         delete buffer;
     }
+    if (K4A_FAILED(result) && pooled_buffer != NULL)
+    {
+        free_pooled_buffer(NULL, pooled_buffer);
+    }
+    if (K4A_FAILED(result) && mapped_buffer != NULL)
+    {
+        delete mapped_buffer;
+    }
 
     return result;
 }
@@ -1923,6 +3500,14 @@ k4a_stream_result_t get_capture(k4a_playback_context_t *context, k4a_capture_t *
 
     track_reader_t *blocks[] = { context->color_track, context->depth_track, context->ir_track };
     std::shared_ptr<block_info_t> next_blocks[arraysize(blocks)];
+    for (size_t i = 0; i < arraysize(blocks); i++)
+    {
+        if (blocks[i] != NULL && !blocks[i]->enabled)
+        {
+            // Disabled tracks are left out of the capture as if they were not recorded.
+            blocks[i] = NULL;
+        }
+    }
 
     uint64_t timestamp_start_ns = UINT64_MAX;
     uint64_t timestamp_end_ns = 0;
@@ -1938,7 +3523,7 @@ k4a_stream_result_t get_capture(k4a_playback_context_t *context, k4a_capture_t *
             // If the current block is NULL, find the next block before/after the seek timestamp.
             if (blocks[i]->current_block == nullptr)
             {
-                next_blocks[i] = find_block(context, blocks[i], context->seek_timestamp_ns);
+                next_blocks[i] = find_block(context, blocks[i], blocks[i]->seek_timestamp_ns);
                 if (!next && next_blocks[i])
                 {
                     next_blocks[i] = next_block(context, next_blocks[i].get(), false);
@@ -2020,7 +3605,7 @@ k4a_stream_result_t get_capture(k4a_playback_context_t *context, k4a_capture_t *
                 {
                     std::shared_ptr<block_info_t> test_block = find_block(context,
                                                                           blocks[i],
-                                                                          context->seek_timestamp_ns);
+                                                                          blocks[i]->seek_timestamp_ns);
                     if (next)
                     {
                         test_block = next_block(context, test_block.get(), false);
@@ -2108,6 +3693,18 @@ static matroska_imu_sample_t *parse_imu_sample_buffer(DataBuffer &data_buffer)
     }
 }
 
+static void convert_imu_sample(const matroska_imu_sample_t *sample, k4a_imu_sample_t *imu_sample)
+{
+    imu_sample->acc_timestamp_usec = sample->acc_timestamp_ns / 1000;
+    imu_sample->gyro_timestamp_usec = sample->gyro_timestamp_ns / 1000;
+    imu_sample->temperature = std::numeric_limits<float>::quiet_NaN();
+    for (size_t i = 0; i < 3; i++)
+    {
+        imu_sample->acc_sample.v[i] = sample->acc_data[i];
+        imu_sample->gyro_sample.v[i] = sample->gyro_data[i];
+    }
+}
+
 k4a_stream_result_t get_imu_sample(k4a_playback_context_t *context, k4a_imu_sample_t *imu_sample, bool next)
 {
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, context == NULL);
@@ -2119,13 +3716,20 @@ k4a_stream_result_t get_imu_sample(k4a_playback_context_t *context, k4a_imu_samp
         *imu_sample = { 0 };
         return K4A_STREAM_RESULT_EOF;
     }
+    else if (!context->imu_track->enabled)
+    {
+        LOG_WARNING("The IMU track is disabled.", 0);
+        *imu_sample = { 0 };
+        return K4A_STREAM_RESULT_EOF;
+    }
 
     std::shared_ptr<block_info_t> block_info = context->imu_track->current_block;
 
     if (block_info == nullptr)
     {
         // There is no current IMU sample, find the next/previous sample based on seek_timestamp.
-        block_info = find_block(context, context->imu_track, context->seek_timestamp_ns);
+        uint64_t seek_timestamp_ns = context->imu_track->seek_timestamp_ns;
+        block_info = find_block(context, context->imu_track, seek_timestamp_ns);
         if (block_info && !block_info->block)
         {
             // The seek timestamp is past the end of the file, get the last block instead.
@@ -2137,12 +3741,12 @@ k4a_stream_result_t get_imu_sample(k4a_playback_context_t *context, k4a_imu_samp
             // The returned block will not have an accurate sub_index due to timestamp estimation, select the correct
             // sub_index based on the real timestamp stored in the sample.
             size_t sample_count = block_info->block->NumberFrames();
-            if (block_info->sync_timestamp_ns > context->seek_timestamp_ns)
+            if (block_info->sync_timestamp_ns > seek_timestamp_ns)
             {
                 // The timestamp we're looking for is before the found block.
                 block_info->sub_index = next ? 0 : -1;
             }
-            else if (block_info->sync_timestamp_ns + block_info->block_duration_ns <= context->seek_timestamp_ns)
+            else if (block_info->sync_timestamp_ns + block_info->block_duration_ns <= seek_timestamp_ns)
             {
                 // The timestamp we're looking for is after the found block.
                 block_info->sub_index = (int)sample_count + (next ? 0 : -1);
@@ -2152,7 +3756,7 @@ k4a_stream_result_t get_imu_sample(k4a_playback_context_t *context, k4a_imu_samp
                 // The timestamp we're looking for is within the found block.
                 // IMU timestamps within the sample buffer are device timestamps, not relative to start of file.
                 // The seek timestamp needs to be converted to a device timestamp when comparing.
-                uint64_t seek_device_timestamp_ns = context->seek_timestamp_ns +
+                uint64_t seek_device_timestamp_ns = seek_timestamp_ns +
                                                     ((uint64_t)context->record_config.start_timestamp_offset_usec *
                                                      1000);
                 block_info->sub_index = -1;
@@ -2197,14 +3801,7 @@ k4a_stream_result_t get_imu_sample(k4a_playback_context_t *context, k4a_imu_samp
         }
         else
         {
-            imu_sample->acc_timestamp_usec = sample->acc_timestamp_ns / 1000;
-            imu_sample->gyro_timestamp_usec = sample->gyro_timestamp_ns / 1000;
-            imu_sample->temperature = std::numeric_limits<float>::quiet_NaN();
-            for (size_t i = 0; i < 3; i++)
-            {
-                imu_sample->acc_sample.v[i] = sample->acc_data[i];
-                imu_sample->gyro_sample.v[i] = sample->gyro_data[i];
-            }
+            convert_imu_sample(sample, imu_sample);
             return K4A_STREAM_RESULT_SUCCEEDED;
         }
     }
@@ -2214,6 +3811,169 @@ k4a_stream_result_t get_imu_sample(k4a_playback_context_t *context, k4a_imu_samp
     return K4A_STREAM_RESULT_EOF;
 }
 
+// Reads up to max_count IMU samples forward from the playback position, like calling get_imu_sample() max_count times.
+// Only the first sample goes through the seek logic in get_imu_sample(), the rest are copied straight from the blocks.
+k4a_stream_result_t get_next_imu_samples(k4a_playback_context_t *context,
+                                         k4a_imu_sample_t *samples,
+                                         size_t max_count,
+                                         size_t *sample_count)
+{
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, samples == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, max_count == 0);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, sample_count == NULL);
+
+    *sample_count = 0;
+    k4a_stream_result_t result = get_imu_sample(context, &samples[0], true);
+    if (result != K4A_STREAM_RESULT_SUCCEEDED)
+    {
+        return result;
+    }
+
+    // get_imu_sample() left the current block on samples[0]. Work on a copy, like next_block() does.
+    std::shared_ptr<block_info_t> block_info = std::shared_ptr<block_info_t>(
+        new block_info_t(*context->imu_track->current_block));
+    size_t count = 1;
+    while (count < max_count)
+    {
+        int frame_count = (int)block_info->block->NumberFrames();
+        while (count < max_count && block_info->sub_index + 1 < frame_count)
+        {
+            matroska_imu_sample_t *sample = parse_imu_sample_buffer(
+                block_info->block->GetBuffer((unsigned int)block_info->sub_index + 1));
+            if (sample == NULL)
+            {
+                context->imu_track->current_block = block_info;
+                *sample_count = count;
+                return K4A_STREAM_RESULT_FAILED;
+            }
+            convert_imu_sample(sample, &samples[count]);
+            block_info->sub_index++;
+            count++;
+        }
+
+        if (count < max_count)
+        {
+            // Stop on the last sample at the end of the recording, so the next read reports EOF like get_imu_sample()
+            std::shared_ptr<block_info_t> next = next_block(context, block_info.get(), true);
+            if (next == nullptr || next->block == NULL)
+            {
+                break;
+            }
+            block_info = next;
+
+            matroska_imu_sample_t *sample = parse_imu_sample_buffer(
+                block_info->block->GetBuffer((unsigned int)block_info->sub_index));
+            if (sample == NULL)
+            {
+                context->imu_track->current_block = block_info;
+                *sample_count = count;
+                return K4A_STREAM_RESULT_FAILED;
+            }
+            convert_imu_sample(sample, &samples[count]);
+            count++;
+        }
+    }
+
+    context->imu_track->current_block = block_info;
+    *sample_count = count;
+    return K4A_STREAM_RESULT_SUCCEEDED;
+}
+
+// Copies the IMU samples with an accelerometer timestamp in [start_timestamp_ns, end_timestamp_ns) in one pass over the
+// blocks of the IMU track. Timestamps are device timestamps. Samples beyond sample_capacity are counted but not copied.
+// The playback position is not changed.
+k4a_result_t get_imu_samples(k4a_playback_context_t *context,
+                             uint64_t start_timestamp_ns,
+                             uint64_t end_timestamp_ns,
+                             k4a_imu_sample_t *samples,
+                             size_t sample_capacity,
+                             size_t *sample_count)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, samples == NULL && sample_capacity > 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, sample_count == NULL);
+
+    *sample_count = 0;
+    if (context->imu_track == NULL)
+    {
+        LOG_ERROR("Recording has no IMU track.", 0);
+        return K4A_RESULT_FAILED;
+    }
+    else if (!context->imu_track->enabled)
+    {
+        LOG_ERROR("The IMU track is disabled.", 0);
+        return K4A_RESULT_FAILED;
+    }
+    else if (start_timestamp_ns >= end_timestamp_ns)
+    {
+        return K4A_RESULT_SUCCEEDED;
+    }
+
+    // Blocks are indexed relative to the start of the recording, the samples inside them use device timestamps.
+    uint64_t start_offset_ns = (uint64_t)context->record_config.start_timestamp_offset_usec * 1000;
+    uint64_t search_timestamp_ns = start_timestamp_ns > start_offset_ns ? start_timestamp_ns - start_offset_ns : 0;
+    std::shared_ptr<block_info_t> block_info = find_block(context, context->imu_track, search_timestamp_ns);
+    if (block_info == nullptr)
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    // The block before the found block may still contain samples in the range.
+    std::shared_ptr<block_info_t> previous_block = next_block(context, block_info.get(), false);
+    if (previous_block == nullptr)
+    {
+        return K4A_RESULT_FAILED;
+    }
+    else if (previous_block->block != NULL)
+    {
+        block_info = previous_block;
+    }
+
+    size_t count = 0;
+    bool range_end = false;
+    while (block_info != nullptr && block_info->block != NULL && !range_end)
+    {
+        size_t frame_count = block_info->block->NumberFrames();
+        for (size_t i = 0; i < frame_count; i++)
+        {
+            matroska_imu_sample_t *sample = parse_imu_sample_buffer(block_info->block->GetBuffer((unsigned int)i));
+            if (sample == NULL)
+            {
+                return K4A_RESULT_FAILED;
+            }
+            else if (sample->acc_timestamp_ns >= end_timestamp_ns)
+            {
+                range_end = true;
+                break;
+            }
+            else if (sample->acc_timestamp_ns >= start_timestamp_ns)
+            {
+                if (count < sample_capacity)
+                {
+                    convert_imu_sample(sample, &samples[count]);
+                }
+                count++;
+            }
+        }
+
+        if (!range_end)
+        {
+            // Step over the remaining frames of this block, next_block() moves to the next block in the track.
+            block_info->sub_index = (int)frame_count - 1;
+            block_info = next_block(context, block_info.get(), true);
+        }
+    }
+
+    if (block_info == nullptr)
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    *sample_count = count;
+    return K4A_RESULT_SUCCEEDED;
+}
+
 k4a_stream_result_t get_data_block(k4a_playback_context_t *context,
                                    track_reader_t *track_reader,
                                    k4a_playback_data_block_t *data_block_handle,
@@ -2223,12 +3983,18 @@ k4a_stream_result_t get_data_block(k4a_playback_context_t *context,
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, track_reader == NULL);
     RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, data_block_handle == NULL);
 
+    if (!track_reader->enabled)
+    {
+        LOG_ERROR("Track is disabled: %s", GetChild<KaxTrackName>(*track_reader->track).GetValueUTF8().c_str());
+        return K4A_STREAM_RESULT_FAILED;
+    }
+
     std::shared_ptr<block_info_t> read_block = track_reader->current_block;
     if (read_block == nullptr)
     {
         // If the track current block is nullptr, it means we just performed a seek frame operation.
         // find_block() always finds the block with timestamp >= seek_timestamp.
-        read_block = find_block(context, track_reader, context->seek_timestamp_ns);
+        read_block = find_block(context, track_reader, track_reader->seek_timestamp_ns);
         if (!next && read_block)
         {
             // In order to find the first timestamp < seek_timestamp, we need to query the previous block.
@@ -2265,7 +4031,17 @@ k4a_stream_result_t get_data_block(k4a_playback_context_t *context,
 
     data_block_context->device_timestamp_usec = estimate_block_timestamp_ns(track_reader->current_block) / 1000 +
                                                 context->record_config.start_timestamp_offset_usec;
-    data_block_context->data_block.assign(data_buffer.Buffer(), data_buffer.Buffer() + data_buffer.Size());
+    data_block_context->mapped_block = get_mapped_frame(context,
+                                                        track_reader->current_block.get(),
+                                                        track_reader->current_block->sub_index);
+    if (data_block_context->mapped_block != nullptr)
+    {
+        data_block_context->mapped_block_size = data_buffer.Size();
+    }
+    else
+    {
+        data_block_context->data_block.assign(data_buffer.Buffer(), data_buffer.Buffer() + data_buffer.Size());
+    }
 
     return K4A_STREAM_RESULT_SUCCEEDED;
 }
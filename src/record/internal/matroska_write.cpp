@@ -232,6 +232,72 @@ write_track_data(k4a_record_context_t *context, track_header_t *track, uint64_t
     return K4A_RESULT_SUCCEEDED;
 }
 
+// Batched version of write_track_data(), all of the buffers are added to the pending clusters under one lock.
+// Ownership is taken of each buffer that is written and its entry in buffers is set to NULL. Buffers that can't be
+// written are skipped, and if a failure is returned, the caller will need to free any buffers that are not NULL.
+k4a_result_t write_track_data_batch(k4a_record_context_t *context,
+                                    track_header_t *track,
+                                    const uint64_t *timestamps_ns,
+                                    DataBuffer **buffers,
+                                    size_t count)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !context->header_written);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track->track == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, count > 0 && (timestamps_ns == NULL || buffers == NULL));
+
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+    try
+    {
+        std::lock_guard<std::mutex> lock(context->pending_cluster_lock);
+
+        cluster_t *cluster = NULL;
+        for (size_t i = 0; i < count; i++)
+        {
+            uint64_t timestamp_ns = timestamps_ns[i];
+            if (buffers[i] == NULL)
+            {
+                result = K4A_RESULT_FAILED;
+                continue;
+            }
+
+            if (context->most_recent_timestamp < timestamp_ns)
+            {
+                context->most_recent_timestamp = timestamp_ns;
+            }
+
+            // Consecutive samples usually land in the same cluster, so only look up the cluster when leaving it.
+            if (cluster == NULL || timestamp_ns < cluster->time_start_ns || timestamp_ns >= cluster->time_end_ns)
+            {
+                cluster = get_cluster_for_timestamp(context, timestamp_ns);
+                if (cluster == NULL)
+                {
+                    // The timestamp is too old, the block of data has already been written.
+                    result = K4A_RESULT_FAILED;
+                    continue;
+                }
+            }
+
+            track_data_t data = { track, buffers[i] };
+            cluster->data.push_back(std::make_pair(timestamp_ns, data));
+            buffers[i] = NULL;
+        }
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to write track data to queue: %s", e.what());
+        return K4A_RESULT_FAILED;
+    }
+
+    if (context->writer_notify)
+    {
+        context->writer_notify->notify_one();
+    }
+
+    return result;
+}
+
 // Lock(context->pending_cluster_lock) should be active when calling this function
 cluster_t *get_cluster_for_timestamp(k4a_record_context_t *context, uint64_t timestamp_ns)
 {
@@ -349,6 +415,7 @@ k4a_result_t write_cluster(k4a_record_context_t *context, cluster_t *cluster, ui
     uint64_t block_blob_start = 0;
 
     std::vector<std::unique_ptr<KaxBlockBlob>> blob_list;
+    std::vector<block_index_entry_t> blob_index; // Block offsets are filled in once the cluster is rendered.
 
     bool first = true;
     for (std::pair<uint64_t, track_data_t> data : cluster->data)
@@ -367,6 +434,14 @@ k4a_result_t write_cluster(k4a_record_context_t *context, cluster_t *cluster, ui
             block_blob->SetParent(*new_cluster);
             block_blob_start = data.first;
 
+            if (!context->block_index_path.empty())
+            {
+                block_index_entry_t entry = {};
+                entry.timestamp_ns = data.first - context->start_timestamp_offset;
+                entry.track_number = (uint16_t)GetChild<KaxTrackNumber>(*data.second.track->track).GetValue();
+                blob_index.push_back(entry);
+            }
+
             if (!block_blob->IsSimpleBlock())
             {
                 block_group = new KaxBlockGroup();
@@ -412,6 +487,25 @@ k4a_result_t write_cluster(k4a_record_context_t *context, cluster_t *cluster, ui
     try
     {
         new_cluster->Render(*context->ebml_file, cues);
+
+        // Element positions are only known after rendering.
+        uint64_t cluster_offset = context->file_segment->GetRelativePosition(*new_cluster);
+        for (size_t i = 0; i < blob_index.size(); i++)
+        {
+            EbmlElement *block_element = NULL;
+            if (blob_list[i]->IsSimpleBlock())
+            {
+                block_element = &static_cast<KaxSimpleBlock &>(*blob_list[i]);
+            }
+            else
+            {
+                block_element = &static_cast<KaxBlockGroup &>(*blob_list[i]);
+            }
+            blob_index[i].cluster_offset = cluster_offset;
+            blob_index[i].block_offset = context->file_segment->GetRelativePosition(*block_element);
+            blob_index[i].block_size = (uint32_t)(block_element->HeadSize() + block_element->GetSize());
+        }
+        context->block_index.insert(context->block_index.end(), blob_index.begin(), blob_index.end());
     }
     catch (std::ios_base::failure &e)
     {
@@ -565,6 +659,49 @@ void stop_matroska_writer_thread(k4a_record_context_t *context)
     }
 }
 
+/**
+ * Writes the index elements to the end of an append-only recording.
+ *
+ * Cues and tags can't be rewritten in an append-only output, so they are written once after the last cluster, followed
+ * by a seek head pointing to each of the top level elements. Must be called after the writer thread is stopped and all
+ * pending clusters are written.
+ */
+k4a_result_t write_append_only_trailer(k4a_record_context_t *context)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !context->append_only);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->writer_thread.joinable());
+
+    try
+    {
+        auto &cues = GetChild<KaxCues>(*context->file_segment);
+        cues.Render(*context->ebml_file);
+
+        auto &tags = GetChild<KaxTags>(*context->file_segment);
+        tags.Render(*context->ebml_file);
+
+        auto &seek_head = GetChild<KaxSeekHead>(*context->file_segment);
+        seek_head.IndexThis(GetChild<KaxInfo>(*context->file_segment), *context->file_segment);
+        seek_head.IndexThis(GetChild<KaxTracks>(*context->file_segment), *context->file_segment);
+
+        auto &attachments = GetChild<KaxAttachments>(*context->file_segment);
+        if (attachments.GetElementPosition() > 0)
+        {
+            seek_head.IndexThis(attachments, *context->file_segment);
+        }
+        seek_head.IndexThis(tags, *context->file_segment);
+        seek_head.IndexThis(cues, *context->file_segment);
+        seek_head.Render(*context->ebml_file);
+    }
+    catch (std::ios_base::failure &e)
+    {
+        LOG_ERROR("Failed to write recording trailer '%s': %s", context->file_path, e.what());
+        return K4A_RESULT_FAILED;
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
 KaxTag *
 add_tag(k4a_record_context_t *context, const char *name, const char *value, TagTargetType target, uint64_t target_uid)
 {
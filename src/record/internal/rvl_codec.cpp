@@ -0,0 +1,410 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <k4ainternal/rvl_codec.h>
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+namespace k4arecord
+{
+namespace
+{
+class nibble_writer
+{
+public:
+    nibble_writer(uint8_t *output, size_t output_size) : m_start(output), m_next(output), m_end(output + output_size) {}
+
+    void write_vle(uint32_t value)
+    {
+        do
+        {
+            uint8_t nibble = value & 0x7;
+            value >>= 3;
+            if (value)
+            {
+                nibble |= 0x8;
+            }
+            write_nibble(nibble);
+        } while (value);
+    }
+
+    // Returns the number of bytes written, or 0 on overflow.
+    size_t finish() const
+    {
+        if (m_overflow)
+        {
+            return 0;
+        }
+        return (size_t)(m_next - m_start) + (m_high ? 0 : 1);
+    }
+
+private:
+    void write_nibble(uint8_t nibble)
+    {
+        if (m_high)
+        {
+            if (m_next == m_end)
+            {
+                m_overflow = true;
+                return;
+            }
+            *m_next = (uint8_t)(nibble << 4);
+            m_high = false;
+        }
+        else
+        {
+            *m_next++ |= nibble;
+            m_high = true;
+        }
+    }
+
+    uint8_t *m_start;
+    uint8_t *m_next;
+    uint8_t *m_end;
+    bool m_high = true;
+    bool m_overflow = false;
+};
+
+class nibble_reader
+{
+public:
+    nibble_reader(const uint8_t *input, size_t input_size) : m_next(input), m_end(input + input_size) {}
+
+    bool read_vle(uint32_t *value)
+    {
+        uint32_t result = 0;
+        for (int shift = 0; shift < 32; shift += 3)
+        {
+            if (m_next == m_end)
+            {
+                return false;
+            }
+            uint8_t nibble = m_high ? (uint8_t)(*m_next >> 4) : (uint8_t)(*m_next++ & 0xF);
+            m_high = !m_high;
+
+            result |= (uint32_t)(nibble & 0x7) << shift;
+            if ((nibble & 0x8) == 0)
+            {
+                *value = result;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    const uint8_t *m_next;
+    const uint8_t *m_end;
+    bool m_high = true;
+};
+
+uint32_t read_uint32_le(const uint8_t *input)
+{
+    return (uint32_t)input[0] | (uint32_t)input[1] << 8 | (uint32_t)input[2] << 16 | (uint32_t)input[3] << 24;
+}
+
+void write_uint32_le(uint8_t *output, uint32_t value)
+{
+    output[0] = (uint8_t)value;
+    output[1] = (uint8_t)(value >> 8);
+    output[2] = (uint8_t)(value >> 16);
+    output[3] = (uint8_t)(value >> 24);
+}
+
+// Bands of one image, run by band_pool::run()
+struct band_batch_t
+{
+    const std::function<bool(size_t)> *task;
+    size_t remaining;
+    bool result;
+};
+
+struct band_job_t
+{
+    band_batch_t *batch;
+    size_t band;
+};
+
+// Worker threads shared by every encoder and decoder, so images are coded in parallel without starting threads for
+// each frame. Callers run jobs from the queue while they wait, so images are still coded if no worker thread could be
+// started or every worker is busy with other images.
+class band_pool
+{
+public:
+    static band_pool &instance()
+    {
+        // Never destroyed, the workers may be blocked in the library's code when it is unloaded
+        static band_pool *pool = new band_pool();
+        return *pool;
+    }
+
+    // Runs task(i) for i in [0, count). Task 0 runs on the calling thread.
+    bool run(size_t count, const std::function<bool(size_t)> &task)
+    {
+        band_batch_t batch = { &task, count - 1, true };
+        if (count > 1)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            for (size_t i = 1; i < count; i++)
+            {
+                m_jobs.push_back({ &batch, i });
+            }
+            m_work_cv.notify_all();
+        }
+
+        bool result = task(0);
+
+        std::unique_lock<std::mutex> lock(m_lock);
+        while (batch.remaining > 0)
+        {
+            if (!m_jobs.empty())
+            {
+                run_next_job(lock);
+            }
+            else
+            {
+                m_done_cv.wait(lock);
+            }
+        }
+        return result && batch.result;
+    }
+
+private:
+    band_pool()
+    {
+        for (size_t i = 1; i < RVL_BAND_COUNT; i++)
+        {
+            try
+            {
+                std::thread(&band_pool::worker, this).detach();
+            }
+            catch (std::system_error &)
+            {
+                // Callers run the jobs themselves
+                break;
+            }
+        }
+    }
+
+    void worker()
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        for (;;)
+        {
+            m_work_cv.wait(lock, [this]() { return !m_jobs.empty(); });
+            run_next_job(lock);
+        }
+    }
+
+    // Called with the lock held, which is released while the job runs
+    void run_next_job(std::unique_lock<std::mutex> &lock)
+    {
+        band_job_t job = m_jobs.front();
+        m_jobs.pop_front();
+
+        lock.unlock();
+        bool result = (*job.batch->task)(job.band);
+        lock.lock();
+
+        job.batch->result = job.batch->result && result;
+        if (--job.batch->remaining == 0)
+        {
+            m_done_cv.notify_all();
+        }
+    }
+
+    std::mutex m_lock;
+    std::condition_variable m_work_cv;
+    std::condition_variable m_done_cv;
+    std::deque<band_job_t> m_jobs;
+};
+
+bool run_bands(size_t count, const std::function<bool(size_t)> &task)
+{
+    return band_pool::instance().run(count, task);
+}
+} // namespace
+
+size_t rvl_max_compressed_size(size_t pixel_count)
+{
+    // Worst case is every pixel starting a new run (2 nibbles) followed by a maximum 17-bit delta (6 nibbles).
+    return pixel_count * 4 + 16;
+}
+
+size_t rvl_compress(const uint16_t *input, size_t pixel_count, uint8_t *output, size_t output_size)
+{
+    nibble_writer writer(output, output_size);
+
+    int32_t previous = 0;
+    size_t i = 0;
+    while (i < pixel_count)
+    {
+        uint32_t zeros = 0;
+        while (i < pixel_count && input[i] == 0)
+        {
+            i++;
+            zeros++;
+        }
+        writer.write_vle(zeros);
+
+        uint32_t nonzeros = 0;
+        for (size_t j = i; j < pixel_count && input[j] != 0; j++)
+        {
+            nonzeros++;
+        }
+        writer.write_vle(nonzeros);
+
+        for (uint32_t j = 0; j < nonzeros; j++)
+        {
+            int32_t current = input[i++];
+            int32_t delta = current - previous;
+            // Zig-zag encode so small negative deltas also get short codes.
+            uint32_t positive = delta >= 0 ? (uint32_t)delta << 1 : ((uint32_t)(-delta) << 1) - 1;
+            writer.write_vle(positive);
+            previous = current;
+        }
+    }
+
+    return writer.finish();
+}
+
+bool rvl_decompress(const uint8_t *input, size_t input_size, uint16_t *output, size_t pixel_count)
+{
+    nibble_reader reader(input, input_size);
+
+    int32_t previous = 0;
+    size_t i = 0;
+    while (i < pixel_count)
+    {
+        uint32_t zeros = 0;
+        if (!reader.read_vle(&zeros) || zeros > pixel_count - i)
+        {
+            return false;
+        }
+        for (uint32_t j = 0; j < zeros; j++)
+        {
+            output[i++] = 0;
+        }
+
+        uint32_t nonzeros = 0;
+        if (!reader.read_vle(&nonzeros) || nonzeros > pixel_count - i)
+        {
+            return false;
+        }
+        for (uint32_t j = 0; j < nonzeros; j++)
+        {
+            uint32_t positive = 0;
+            if (!reader.read_vle(&positive))
+            {
+                return false;
+            }
+            int32_t delta = (positive & 1) ? -(int32_t)((positive + 1) >> 1) : (int32_t)(positive >> 1);
+            int32_t current = previous + delta;
+            if (current <= 0 || current > UINT16_MAX)
+            {
+                return false;
+            }
+            output[i++] = (uint16_t)current;
+            previous = current;
+        }
+    }
+
+    return true;
+}
+
+bool rvl_encode_image(const uint16_t *pixels, size_t pixel_count, std::vector<uint8_t> &output)
+{
+    const size_t header_size = sizeof(uint32_t) * (1 + RVL_BAND_COUNT);
+    std::vector<uint8_t> bands[RVL_BAND_COUNT];
+    size_t band_sizes[RVL_BAND_COUNT] = {};
+
+    bool result = run_bands(RVL_BAND_COUNT, [&](size_t band) {
+        size_t start = pixel_count * band / RVL_BAND_COUNT;
+        size_t end = pixel_count * (band + 1) / RVL_BAND_COUNT;
+        if (start == end)
+        {
+            return true;
+        }
+        bands[band].resize(rvl_max_compressed_size(end - start));
+        band_sizes[band] = rvl_compress(pixels + start, end - start, bands[band].data(), bands[band].size());
+        return band_sizes[band] > 0;
+    });
+    if (!result)
+    {
+        return false;
+    }
+
+    size_t total_size = header_size;
+    for (size_t band = 0; band < RVL_BAND_COUNT; band++)
+    {
+        if (band_sizes[band] > UINT32_MAX)
+        {
+            return false;
+        }
+        total_size += band_sizes[band];
+    }
+
+    output.resize(total_size);
+    write_uint32_le(output.data(), RVL_BAND_COUNT);
+    uint8_t *band_data = output.data() + header_size;
+    for (size_t band = 0; band < RVL_BAND_COUNT; band++)
+    {
+        write_uint32_le(output.data() + sizeof(uint32_t) * (1 + band), (uint32_t)band_sizes[band]);
+        if (band_sizes[band] > 0)
+        {
+            memcpy(band_data, bands[band].data(), band_sizes[band]);
+            band_data += band_sizes[band];
+        }
+    }
+
+    return true;
+}
+
+bool rvl_decode_image(const uint8_t *input, size_t input_size, uint16_t *pixels, size_t pixel_count)
+{
+    if (input_size < sizeof(uint32_t))
+    {
+        return false;
+    }
+
+    // Band count is stored in the stream so the decoder does not depend on the encoder's RVL_BAND_COUNT.
+    size_t band_count = read_uint32_le(input);
+    if (band_count == 0 || band_count > RVL_BAND_COUNT)
+    {
+        return false;
+    }
+
+    size_t header_size = sizeof(uint32_t) * (1 + band_count);
+    if (input_size < header_size)
+    {
+        return false;
+    }
+
+    const uint8_t *band_data[RVL_BAND_COUNT] = {};
+    size_t band_sizes[RVL_BAND_COUNT] = {};
+    size_t offset = header_size;
+    for (size_t band = 0; band < band_count; band++)
+    {
+        band_sizes[band] = read_uint32_le(input + sizeof(uint32_t) * (1 + band));
+        if (band_sizes[band] > input_size - offset)
+        {
+            return false;
+        }
+        band_data[band] = input + offset;
+        offset += band_sizes[band];
+    }
+
+    return run_bands(band_count, [&](size_t band) {
+        size_t start = pixel_count * band / band_count;
+        size_t end = pixel_count * (band + 1) / band_count;
+        return rvl_decompress(band_data[band], band_sizes[band], pixels + start, end - start);
+    });
+}
+
+} // namespace k4arecord
@@ -13,6 +13,85 @@
 using namespace k4arecord;
 using namespace LIBMATROSKA_NAMESPACE;
 
+static k4a_result_t open_playback_file(k4a_playback_context_t *context, const char *path)
+{
+    context->file_path = path;
+    context->file_closing = false;
+    context->file_mapped = false;
+
+    try
+    {
+        try
+        {
+            context->ebml_file = make_unique<MappedFileIOCallback>(path);
+            context->file_mapped = true;
+        }
+        catch (std::ios_base::failure &e)
+        {
+            // The file may not fit in the address space, fall back to regular file reads.
+            LOG_WARNING("Unable to memory map file '%s', reading from stream instead: %s", path, e.what());
+            context->ebml_file = make_unique<LargeFileIOCallback>(path, MODE_READ);
+        }
+        context->stream = make_unique<libebml::EbmlStream>(*context->ebml_file);
+    }
+    catch (std::ios_base::failure &e)
+    {
+        LOG_ERROR("Unable to open file '%s': %s", path, e.what());
+        return K4A_RESULT_FAILED;
+    }
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Starts the background threads and loads the first cluster of a playback context that has been parsed.
+static k4a_result_t start_playback(k4a_playback_context_t *context)
+{
+    RETURN_IF_ERROR(start_prefetch_thread(context));
+
+    // Seek to the first cluster
+    cluster_info_t *seek_cluster_info = find_cluster(context, 0);
+    if (seek_cluster_info == NULL)
+    {
+        LOG_ERROR("Failed to parse recording, recording is empty.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    context->seek_cluster = load_cluster(context, seek_cluster_info);
+    if (context->seek_cluster == nullptr)
+    {
+        LOG_ERROR("Failed to load first data cluster of recording.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    reset_seek_pointers(context, 0);
+    return K4A_RESULT_SUCCEEDED;
+}
+
+// Cleans up a playback context that failed to open.
+static void destroy_playback(k4a_playback_t *playback_handle, k4a_playback_context_t *context)
+{
+    if (context)
+    {
+        context->file_closing = true;
+        stop_prefetch_thread(context);
+        stop_color_decode_threads(context);
+    }
+
+    if (context && context->ebml_file)
+    {
+        try
+        {
+            context->ebml_file->close();
+        }
+        catch (std::ios_base::failure &)
+        {
+            // The file was opened as read-only, ignore any close failures.
+        }
+    }
+
+    k4a_playback_t_destroy(*playback_handle);
+    *playback_handle = NULL;
+}
+
 k4a_result_t k4a_playback_open(const char *path, k4a_playback_t *playback_handle)
 {
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, path == NULL);
@@ -25,19 +104,7 @@ k4a_result_t k4a_playback_open(const char *path, k4a_playback_t *playback_handle
 
     if (K4A_SUCCEEDED(result))
     {
-        context->file_path = path;
-        context->file_closing = false;
-
-        try
-        {
-            context->ebml_file = make_unique<LargeFileIOCallback>(path, MODE_READ);
-            context->stream = make_unique<libebml::EbmlStream>(*context->ebml_file);
-        }
-        catch (std::ios_base::failure &e)
-        {
-            LOG_ERROR("Unable to open file '%s': %s", path, e.what());
-            result = K4A_RESULT_FAILED;
-        }
+        result = TRACE_CALL(open_playback_file(context, path));
     }
 
     if (K4A_SUCCEEDED(result))
@@ -47,44 +114,66 @@ k4a_result_t k4a_playback_open(const char *path, k4a_playback_t *playback_handle
 
     if (K4A_SUCCEEDED(result))
     {
-        // Seek to the first cluster
-        cluster_info_t *seek_cluster_info = find_cluster(context, 0);
-        if (seek_cluster_info == NULL)
-        {
-            LOG_ERROR("Failed to parse recording, recording is empty.", 0);
-            result = K4A_RESULT_FAILED;
-        }
-        else
-        {
-            context->seek_cluster = load_cluster(context, seek_cluster_info);
-            if (context->seek_cluster == nullptr)
-            {
-                LOG_ERROR("Failed to load first data cluster of recording.", 0);
-                result = K4A_RESULT_FAILED;
-            }
-        }
+        result = TRACE_CALL(start_playback(context));
     }
 
+    if (K4A_FAILED(result))
+    {
+        destroy_playback(playback_handle, context);
+    }
+
+    return result;
+}
+
+k4a_result_t k4a_playback_open_range(k4a_playback_t playback_handle,
+                                     size_t range_index,
+                                     size_t range_count,
+                                     k4a_playback_t *range_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *source = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, source == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, range_count == 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, range_index >= range_count);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, range_handle == NULL);
+
+    cluster_info_t *first_cluster = NULL;
+    cluster_info_t *last_cluster = NULL;
+    RETURN_IF_ERROR(find_cluster_range(source, range_index, range_count, &first_cluster, &last_cluster));
+
+    k4a_playback_context_t *context = k4a_playback_t_create(range_handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(context != NULL);
+
     if (K4A_SUCCEEDED(result))
     {
-        reset_seek_pointers(context, 0);
+        // Each range has its own file handle so ranges can be read from different threads without sharing io_lock.
+        result = TRACE_CALL(open_playback_file(context, source->file_path.c_str()));
     }
-    else
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(open_cluster_range(source, context, first_cluster, last_cluster));
+    }
+
+    if (K4A_SUCCEEDED(result))
     {
-        if (context && context->ebml_file)
+        result = TRACE_CALL(start_playback(context));
+    }
+
+    if (K4A_SUCCEEDED(result) && context->color_track != NULL &&
+        context->color_track->format == K4A_IMAGE_FORMAT_COLOR_MJPG &&
+        context->color_format_conversion != K4A_IMAGE_FORMAT_COLOR_MJPG)
+    {
+        if (K4A_FAILED(set_color_decode_ahead(context, true)))
         {
-            try
-            {
-                context->ebml_file->close();
-            }
-            catch (std::ios_base::failure &)
-            {
-                // The file was opened as read-only, ignore any close failures.
-            }
+            // Frames will still be decoded when they are read.
+            LOG_WARNING("Failed to start decoding color frames in the background.", 0);
         }
+    }
 
-        k4a_playback_t_destroy(*playback_handle);
-        *playback_handle = NULL;
+    if (K4A_FAILED(result))
+    {
+        destroy_playback(range_handle, context);
     }
 
     return result;
@@ -409,6 +498,100 @@ k4a_result_t k4a_playback_set_color_conversion(k4a_playback_t playback_handle, k
         return K4A_RESULT_FAILED;
     }
 
+    // MJPEG frames are decoded on background threads ahead of the read position.
+    bool decode_ahead = context->color_track->format == K4A_IMAGE_FORMAT_COLOR_MJPG &&
+                        target_format != K4A_IMAGE_FORMAT_COLOR_MJPG;
+    if (K4A_FAILED(set_color_decode_ahead(context, decode_ahead)))
+    {
+        // Frames will still be decoded when they are read.
+        LOG_WARNING("Failed to start decoding color frames in the background.", 0);
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_playback_set_read_ahead(k4a_playback_t playback_handle,
+                                         size_t cluster_count,
+                                         k4a_playback_read_ahead_direction_t direction)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context->prefetch_notify == nullptr);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, cluster_count > MAX_CLUSTER_READ_AHEAD_COUNT);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        direction != K4A_PLAYBACK_READ_AHEAD_FOLLOW && direction != K4A_PLAYBACK_READ_AHEAD_FORWARD &&
+                            direction != K4A_PLAYBACK_READ_AHEAD_BACKWARD);
+
+    try
+    {
+        {
+            std::lock_guard<std::mutex> lock(context->prefetch_lock);
+            context->read_ahead_count = cluster_count;
+            context->read_ahead_direction = direction;
+
+            // Restart the prefetch thread from the current position with the new settings.
+            context->prefetch_generation++;
+        }
+        context->prefetch_notify->notify_one();
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to set playback read-ahead: %s", e.what());
+        return K4A_RESULT_FAILED;
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_playback_set_track_enabled(k4a_playback_t playback_handle, const char *track_name, bool enabled)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track_name == NULL);
+
+    track_reader_t *track_reader = get_track_reader_by_name(context, track_name);
+    if (track_reader == nullptr)
+    {
+        LOG_ERROR("Track name cannot be found: %s", track_name);
+        return K4A_RESULT_FAILED;
+    }
+
+    return set_track_enabled(context, track_reader, enabled);
+}
+
+k4a_result_t k4a_playback_set_cache_size(k4a_playback_t playback_handle, uint64_t size_bytes)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    return set_cluster_cache_size(context, size_bytes);
+}
+
+k4a_result_t k4a_playback_get_cache_stats(k4a_playback_t playback_handle, k4a_playback_cache_stats_t *stats)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, stats == NULL);
+
+    try
+    {
+        std::lock_guard<std::mutex> lock(context->cluster_lru_lock);
+        stats->hits = context->cache_hits;
+        stats->misses = context->load_count;
+        stats->evictions = context->cache_evictions;
+        stats->size_bytes = context->cluster_lru_bytes;
+        stats->capacity_bytes = context->cluster_cache_capacity;
+    }
+    catch (std::system_error &e)
+    {
+        LOG_ERROR("Failed to read the cluster cache stats: %s", e.what());
+        return K4A_RESULT_FAILED;
+    }
+
     return K4A_RESULT_SUCCEEDED;
 }
 
@@ -484,6 +667,49 @@ k4a_stream_result_t k4a_playback_get_previous_imu_sample(k4a_playback_t playback
     return get_imu_sample(context, imu_sample, false);
 }
 
+k4a_stream_result_t k4a_playback_get_next_imu_samples(k4a_playback_t playback_handle,
+                                                      k4a_imu_sample_t *imu_samples,
+                                                      size_t max_count,
+                                                      size_t *sample_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_STREAM_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, imu_samples == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, max_count == 0);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, sample_count == NULL);
+
+    return get_next_imu_samples(context, imu_samples, max_count, sample_count);
+}
+
+k4a_buffer_result_t k4a_playback_get_imu_samples(k4a_playback_t playback_handle,
+                                                 uint64_t start_timestamp_usec,
+                                                 uint64_t end_timestamp_usec,
+                                                 k4a_imu_sample_t *samples,
+                                                 size_t *sample_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_BUFFER_RESULT_FAILED, k4a_playback_t, playback_handle);
+    k4a_playback_context_t *context = k4a_playback_t_get_context(playback_handle);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_BUFFER_RESULT_FAILED, sample_count == NULL);
+
+    // Clamp the range so it doesn't overflow when converted to nanoseconds.
+    uint64_t start_timestamp_ns = start_timestamp_usec > UINT64_MAX / 1000 ? UINT64_MAX : start_timestamp_usec * 1000;
+    uint64_t end_timestamp_ns = end_timestamp_usec > UINT64_MAX / 1000 ? UINT64_MAX : end_timestamp_usec * 1000;
+
+    size_t sample_capacity = samples == NULL ? 0 : *sample_count;
+    size_t count = 0;
+    k4a_result_t result = TRACE_CALL(
+        get_imu_samples(context, start_timestamp_ns, end_timestamp_ns, samples, sample_capacity, &count));
+    if (K4A_FAILED(result))
+    {
+        return K4A_BUFFER_RESULT_FAILED;
+    }
+
+    *sample_count = count;
+    return count > sample_capacity ? K4A_BUFFER_RESULT_TOO_SMALL : K4A_BUFFER_RESULT_SUCCEEDED;
+}
+
 k4a_stream_result_t k4a_playback_get_next_data_block(k4a_playback_t playback_handle,
                                                      const char *track_name,
                                                      k4a_playback_data_block_t *data_block_handle)
@@ -549,6 +775,10 @@ size_t k4a_playback_data_block_get_buffer_size(k4a_playback_data_block_t data_bl
     RETURN_VALUE_IF_HANDLE_INVALID(0, k4a_playback_data_block_t, data_block_handle);
     k4a_playback_data_block_context_t *data_block_context = k4a_playback_data_block_t_get_context(data_block_handle);
     RETURN_VALUE_IF_ARG(0, data_block_context == NULL);
+    if (data_block_context->mapped_block != nullptr)
+    {
+        return data_block_context->mapped_block_size;
+    }
     return data_block_context->data_block.size();
 }
 
@@ -557,6 +787,11 @@ uint8_t *k4a_playback_data_block_get_buffer(k4a_playback_data_block_t data_block
     RETURN_VALUE_IF_HANDLE_INVALID(nullptr, k4a_playback_data_block_t, data_block_handle);
     k4a_playback_data_block_context_t *data_block_context = k4a_playback_data_block_t_get_context(data_block_handle);
     RETURN_VALUE_IF_ARG(nullptr, data_block_context == NULL);
+    if (data_block_context->mapped_block != nullptr)
+    {
+        // The public API returns a non-const pointer, the buffer is documented as read-only.
+        return const_cast<uint8_t *>(data_block_context->mapped_block.get());
+    }
     return data_block_context->data_block.data();
 }
 
@@ -661,11 +896,14 @@ void k4a_playback_close(const k4a_playback_t playback_handle)
     if (context != NULL)
     {
         LOG_TRACE("File reading stats:", 0);
-        LOG_TRACE("  Seek count: %llu", context->seek_count);
+        LOG_TRACE("  Seek count: %llu", context->seek_count.load());
         LOG_TRACE("  Cluster load count: %llu", context->load_count);
         LOG_TRACE("  Cluster cache hits: %llu", context->cache_hits);
+        LOG_TRACE("  Cluster cache evictions: %llu", context->cache_evictions);
 
         context->file_closing = true;
+        stop_prefetch_thread(context);
+        stop_color_decode_threads(context);
 
         try
         {
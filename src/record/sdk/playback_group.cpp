@@ -0,0 +1,211 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <algorithm>
+
+#include <k4a/k4a.h>
+#include <k4arecord/playback.h>
+#include <k4ainternal/matroska_read.h>
+#include <k4ainternal/common.h>
+
+using namespace k4arecord;
+
+// Returns the earliest device timestamp of the images in a capture.
+static uint64_t get_capture_timestamp_usec(k4a_capture_t capture)
+{
+    uint64_t timestamp_usec = UINT64_MAX;
+    k4a_image_t images[] = { k4a_capture_get_color_image(capture),
+                             k4a_capture_get_depth_image(capture),
+                             k4a_capture_get_ir_image(capture) };
+    for (size_t i = 0; i < arraysize(images); i++)
+    {
+        if (images[i] != NULL)
+        {
+            timestamp_usec = std::min(timestamp_usec, k4a_image_get_device_timestamp_usec(images[i]));
+            k4a_image_release(images[i]);
+        }
+    }
+    return timestamp_usec;
+}
+
+// Orders the capture heap so the member with the earliest capture is at the front. Ties keep the recording order.
+static bool capture_heap_compare(k4a_playback_group_context_t *context, size_t a, size_t b)
+{
+    const playback_group_member_t &member_a = context->members[a];
+    const playback_group_member_t &member_b = context->members[b];
+    if (member_a.sync_timestamp_usec != member_b.sync_timestamp_usec)
+    {
+        return member_a.sync_timestamp_usec > member_b.sync_timestamp_usec;
+    }
+    return a > b;
+}
+
+// Reads the next capture of a member and adds it to the capture heap, unless the end of the recording was reached.
+static k4a_stream_result_t read_member_capture(k4a_playback_group_context_t *context, size_t index)
+{
+    playback_group_member_t &member = context->members[index];
+    k4a_stream_result_t result = k4a_playback_get_next_capture(member.handle, &member.capture);
+    if (result != K4A_STREAM_RESULT_SUCCEEDED)
+    {
+        member.capture = NULL;
+        return result;
+    }
+
+    uint64_t timestamp_usec = get_capture_timestamp_usec(member.capture);
+    member.sync_timestamp_usec = timestamp_usec > member.subordinate_delay_usec ?
+                                     timestamp_usec - member.subordinate_delay_usec :
+                                     0;
+
+    context->capture_heap.push_back(index);
+    std::push_heap(context->capture_heap.begin(), context->capture_heap.end(), [context](size_t a, size_t b) {
+        return capture_heap_compare(context, a, b);
+    });
+    return K4A_STREAM_RESULT_SUCCEEDED;
+}
+
+static void close_group_members(k4a_playback_group_context_t *context)
+{
+    for (playback_group_member_t &member : context->members)
+    {
+        if (member.capture != NULL)
+        {
+            k4a_capture_release(member.capture);
+            member.capture = NULL;
+        }
+        if (member.handle != NULL)
+        {
+            k4a_playback_close(member.handle);
+            member.handle = NULL;
+        }
+    }
+    context->members.clear();
+    context->capture_heap.clear();
+}
+
+k4a_result_t k4a_playback_group_open(const char *const *paths, size_t path_count, k4a_playback_group_t *group_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, paths == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, path_count == 0);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, group_handle == NULL);
+
+    k4a_playback_group_context_t *context = k4a_playback_group_t_create(group_handle);
+    k4a_result_t result = K4A_RESULT_FROM_BOOL(context != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        context->members.resize(path_count);
+        context->capture_heap.reserve(path_count);
+    }
+
+    for (size_t i = 0; i < path_count && K4A_SUCCEEDED(result); i++)
+    {
+        playback_group_member_t &member = context->members[i];
+        result = K4A_RESULT_FROM_BOOL(paths[i] != NULL);
+        if (K4A_SUCCEEDED(result))
+        {
+            result = TRACE_CALL(k4a_playback_open(paths[i], &member.handle));
+        }
+
+        k4a_record_configuration_t record_config;
+        if (K4A_SUCCEEDED(result))
+        {
+            result = TRACE_CALL(k4a_playback_get_record_configuration(member.handle, &record_config));
+        }
+
+        if (K4A_SUCCEEDED(result))
+        {
+            member.subordinate_delay_usec = record_config.subordinate_delay_off_master_usec;
+
+            // The group only reads forward, so read ahead in that direction even if a member is seeked backwards.
+            result = TRACE_CALL(
+                k4a_playback_set_read_ahead(member.handle, CLUSTER_READ_AHEAD_COUNT, K4A_PLAYBACK_READ_AHEAD_FORWARD));
+        }
+
+        if (K4A_SUCCEEDED(result) && read_member_capture(context, i) == K4A_STREAM_RESULT_FAILED)
+        {
+            LOG_ERROR("Failed to read first capture from recording: %s", paths[i]);
+            result = K4A_RESULT_FAILED;
+        }
+    }
+
+    if (K4A_FAILED(result))
+    {
+        if (context != NULL)
+        {
+            close_group_members(context);
+        }
+        k4a_playback_group_t_destroy(*group_handle);
+        *group_handle = NULL;
+    }
+
+    return result;
+}
+
+k4a_playback_t k4a_playback_group_get_playback(k4a_playback_group_t group_handle, size_t index)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(NULL, k4a_playback_group_t, group_handle);
+    k4a_playback_group_context_t *context = k4a_playback_group_t_get_context(group_handle);
+    RETURN_VALUE_IF_ARG(NULL, context == NULL);
+    RETURN_VALUE_IF_ARG(NULL, index >= context->members.size());
+
+    return context->members[index].handle;
+}
+
+k4a_stream_result_t k4a_playback_group_get_next_capture(k4a_playback_group_t group_handle,
+                                                        k4a_capture_t *capture_handle,
+                                                        size_t *index)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_STREAM_RESULT_FAILED, k4a_playback_group_t, group_handle);
+    k4a_playback_group_context_t *context = k4a_playback_group_t_get_context(group_handle);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, context == NULL);
+    RETURN_VALUE_IF_ARG(K4A_STREAM_RESULT_FAILED, capture_handle == NULL);
+
+    if (context->read_failed)
+    {
+        LOG_ERROR("Failed to read the next capture of a recording in the group previously.", 0);
+        *capture_handle = NULL;
+        return K4A_STREAM_RESULT_FAILED;
+    }
+
+    if (context->capture_heap.empty())
+    {
+        *capture_handle = NULL;
+        return K4A_STREAM_RESULT_EOF;
+    }
+
+    std::pop_heap(context->capture_heap.begin(), context->capture_heap.end(), [context](size_t a, size_t b) {
+        return capture_heap_compare(context, a, b);
+    });
+    size_t member_index = context->capture_heap.back();
+    context->capture_heap.pop_back();
+
+    playback_group_member_t &member = context->members[member_index];
+    *capture_handle = member.capture;
+    member.capture = NULL;
+    if (index != NULL)
+    {
+        *index = member_index;
+    }
+
+    // Replace the returned capture with the next one from the same recording. The popped capture was read
+    // successfully, so it is still returned and the failure is reported by the next call.
+    if (read_member_capture(context, member_index) == K4A_STREAM_RESULT_FAILED)
+    {
+        LOG_ERROR("Failed to read next capture from recording %llu.", (unsigned long long)member_index);
+        context->read_failed = true;
+    }
+
+    return K4A_STREAM_RESULT_SUCCEEDED;
+}
+
+void k4a_playback_group_close(k4a_playback_group_t group_handle)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(VOID_VALUE, k4a_playback_group_t, group_handle);
+
+    k4a_playback_group_context_t *context = k4a_playback_group_t_get_context(group_handle);
+    if (context != NULL)
+    {
+        close_group_members(context);
+    }
+    k4a_playback_group_t_destroy(group_handle);
+}
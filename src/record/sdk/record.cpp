@@ -8,40 +8,23 @@
 #include <k4a/k4a.h>
 #include <k4arecord/record.h>
 #include <k4ainternal/matroska_write.h>
+#include <k4ainternal/rvl_codec.h>
 #include <k4ainternal/logging.h>
 #include <k4ainternal/common.h>
 
 using namespace k4arecord;
 using namespace LIBMATROSKA_NAMESPACE;
 
-k4a_result_t k4a_record_create(const char *path,
-                               k4a_device_t device,
-                               const k4a_device_configuration_t device_config,
-                               k4a_record_t *recording_handle)
+/**
+ * Populates the segment info, tracks and tags of a new recording from the device configuration.
+ * Shared by k4a_record_create() and k4a_record_create_with_io() once context->ebml_file is open.
+ */
+static k4a_result_t setup_recording(k4a_record_context_t *context,
+                                    k4a_device_t device,
+                                    const k4a_device_configuration_t &device_config)
 {
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, path == NULL);
-    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, recording_handle == NULL);
-    k4a_record_context_t *context = NULL;
     k4a_result_t result = K4A_RESULT_SUCCEEDED;
 
-    context = k4a_record_t_create(recording_handle);
-    result = K4A_RESULT_FROM_BOOL(context != NULL);
-
-    if (K4A_SUCCEEDED(result))
-    {
-        context->file_path = path;
-
-        try
-        {
-            context->ebml_file = make_unique<LargeFileIOCallback>(path, MODE_CREATE);
-        }
-        catch (std::ios_base::failure &e)
-        {
-            LOG_ERROR("Unable to open file '%s': %s", path, e.what());
-            result = K4A_RESULT_FAILED;
-        }
-    }
-
     if (K4A_SUCCEEDED(result))
     {
         context->device_config = device_config;
@@ -164,7 +147,11 @@ k4a_result_t k4a_record_create(const char *path,
             std::ostringstream track_uid_str;
             track_uid_str << track_uid;
             add_tag(context, "K4A_COLOR_TRACK", track_uid_str.str().c_str(), TAG_TARGET_TYPE_TRACK, track_uid);
-            add_tag(context, "K4A_COLOR_MODE", color_mode_str.str().c_str(), TAG_TARGET_TYPE_TRACK, track_uid);
+            context->color_mode_tag = add_tag(context,
+                                              "K4A_COLOR_MODE",
+                                              color_mode_str.str().c_str(),
+                                              TAG_TARGET_TYPE_TRACK,
+                                              track_uid);
         }
         else
         {
@@ -341,22 +328,104 @@ k4a_result_t k4a_record_create(const char *path,
         auto &cues = GetChild<KaxCues>(*context->file_segment);
         cues.SetGlobalTimecodeScale(context->timecode_scale);
     }
-    else
+
+    return result;
+}
+
+static void destroy_failed_recording(k4a_record_context_t *context, k4a_record_t *recording_handle)
+{
+    if (context && context->ebml_file)
     {
-        if (context && context->ebml_file)
+        try
         {
-            try
-            {
-                context->ebml_file->close();
-            }
-            catch (std::ios_base::failure &)
-            {
-                // The file is empty at this point, ignore any close failures.
-            }
+            context->ebml_file->close();
+        }
+        catch (std::ios_base::failure &)
+        {
+            // The file is empty at this point, ignore any close failures.
         }
+    }
+
+    k4a_record_t_destroy(*recording_handle);
+    *recording_handle = NULL;
+}
+
+k4a_result_t k4a_record_create(const char *path,
+                               k4a_device_t device,
+                               const k4a_device_configuration_t device_config,
+                               k4a_record_t *recording_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, path == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, recording_handle == NULL);
+    k4a_record_context_t *context = NULL;
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+
+    context = k4a_record_t_create(recording_handle);
+    result = K4A_RESULT_FROM_BOOL(context != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        context->file_path = path;
+
+        try
+        {
+            context->ebml_file = make_unique<LargeFileIOCallback>(path, MODE_CREATE);
 
-        k4a_record_t_destroy(*recording_handle);
-        *recording_handle = NULL;
+            // Remove any index left over from a previous recording at this path, it is rewritten on close.
+            context->block_index_path = get_block_index_path(path);
+            (void)std::remove(context->block_index_path.c_str());
+        }
+        catch (std::ios_base::failure &e)
+        {
+            LOG_ERROR("Unable to open file '%s': %s", path, e.what());
+            result = K4A_RESULT_FAILED;
+        }
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(setup_recording(context, device, device_config));
+    }
+
+    if (K4A_FAILED(result))
+    {
+        destroy_failed_recording(context, recording_handle);
+    }
+
+    return result;
+}
+
+k4a_result_t k4a_record_create_with_io(const k4a_record_io_callbacks_t *io_callbacks,
+                                       k4a_device_t device,
+                                       const k4a_device_configuration_t device_config,
+                                       k4a_record_t *recording_handle)
+{
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, io_callbacks == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, io_callbacks->write == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, recording_handle == NULL);
+    k4a_record_context_t *context = NULL;
+    k4a_result_t result = K4A_RESULT_SUCCEEDED;
+
+    context = k4a_record_t_create(recording_handle);
+    result = K4A_RESULT_FROM_BOOL(context != NULL);
+
+    if (K4A_SUCCEEDED(result))
+    {
+        context->file_path = "<custom io>";
+
+        auto custom_io = make_unique<CustomIOCallback>(*io_callbacks);
+        context->append_only = !custom_io->isSeekable();
+        context->ebml_file = std::move(custom_io);
+    }
+
+    if (K4A_SUCCEEDED(result))
+    {
+        result = TRACE_CALL(setup_recording(context, device, device_config));
+    }
+
+    if (K4A_FAILED(result))
+    {
+        destroy_failed_recording(context, recording_handle);
     }
 
     return result;
@@ -381,6 +450,94 @@ k4a_result_t k4a_record_add_tag(const k4a_record_t recording_handle, const char
     return K4A_RESULT_SUCCEEDED;
 }
 
+k4a_result_t k4a_record_set_depth_codec(const k4a_record_t recording_handle, k4a_record_depth_codec_t codec)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, codec != K4A_RECORD_DEPTH_CODEC_RAW && codec != K4A_RECORD_DEPTH_CODEC_RVL);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (context->header_written)
+    {
+        LOG_ERROR("The depth codec must be set before the recording header is written.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    // The CodecPrivate BITMAPINFOHEADER is left as b16g so readers know the uncompressed image format.
+    track_header_t *tracks[] = { context->depth_track, context->ir_track };
+    for (track_header_t *track : tracks)
+    {
+        if (track != nullptr)
+        {
+            track->rvl_compressed = codec == K4A_RECORD_DEPTH_CODEC_RVL;
+            GetChild<KaxCodecID>(*track->track).SetValue(track->rvl_compressed ? K4A_RVL_CODEC_ID : "V_MS/VFW/FOURCC");
+        }
+    }
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
+k4a_result_t k4a_record_set_color_codec(const k4a_record_t recording_handle,
+                                        k4a_record_color_codec_t codec,
+                                        int jpeg_quality)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, codec != K4A_RECORD_COLOR_CODEC_RAW && codec != K4A_RECORD_COLOR_CODEC_MJPG);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED,
+                        codec == K4A_RECORD_COLOR_CODEC_MJPG && (jpeg_quality < 1 || jpeg_quality > 100));
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (context->header_written)
+    {
+        LOG_ERROR("The color codec must be set before the recording header is written.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    track_header_t *track = context->color_track;
+    if (track == nullptr)
+    {
+        LOG_ERROR("The recording does not have a color track.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (context->device_config.color_format != K4A_IMAGE_FORMAT_COLOR_BGRA32)
+    {
+        if (codec == K4A_RECORD_COLOR_CODEC_RAW)
+        {
+            return K4A_RESULT_SUCCEEDED;
+        }
+        LOG_ERROR("Only K4A_IMAGE_FORMAT_COLOR_BGRA32 color tracks can be encoded: %d",
+                  context->device_config.color_format);
+        return K4A_RESULT_FAILED;
+    }
+
+    // The track is stored exactly like a recording from an MJPG color camera, so readers need no special handling.
+    k4a_image_format_t track_format = codec == K4A_RECORD_COLOR_CODEC_MJPG ? K4A_IMAGE_FORMAT_COLOR_MJPG :
+                                                                             K4A_IMAGE_FORMAT_COLOR_BGRA32;
+    auto &video_track = GetChild<KaxTrackVideo>(*track->track);
+    uint64_t color_width = GetChild<KaxVideoPixelWidth>(video_track).GetValue();
+    uint64_t color_height = GetChild<KaxVideoPixelHeight>(video_track).GetValue();
+
+    BITMAPINFOHEADER codec_info = {};
+    RETURN_IF_ERROR(populate_bitmap_info_header(&codec_info, color_width, color_height, track_format));
+    GetChild<KaxCodecPrivate>(*track->track).CopyBuffer(reinterpret_cast<uint8_t *>(&codec_info), sizeof(codec_info));
+
+    if (context->color_mode_tag != nullptr)
+    {
+        std::ostringstream color_mode_str;
+        color_mode_str << (codec == K4A_RECORD_COLOR_CODEC_MJPG ? "MJPG_" : "BGRA_") << color_height << "P";
+        auto &tag_simple = GetChild<KaxTagSimple>(*context->color_mode_tag);
+        GetChild<KaxTagString>(tag_simple).SetValueUTF8(color_mode_str.str());
+    }
+
+    track->jpeg_quality = codec == K4A_RECORD_COLOR_CODEC_MJPG ? jpeg_quality : 0;
+
+    return K4A_RESULT_SUCCEEDED;
+}
+
 k4a_result_t k4a_record_add_attachment(const k4a_record_t recording_handle,
                                        const char *file_name,
                                        const uint8_t *buffer,
@@ -550,8 +707,26 @@ k4a_result_t k4a_record_write_header(const k4a_record_t recording_handle)
         }
 
         // Recordings can get very large, so pad the length field up to 8 bytes from the start.
-        context->file_segment->WriteHead(*context->ebml_file, 8);
+        if (context->append_only)
+        {
+            // The final size can't be written to an append-only output, the segment extends to the end of the file.
+            UnknownSizeHeadIOCallback segment_head_output(*context->ebml_file,
+                                                          KaxSegment::ClassInfos.GlobalId.GetLength());
+            context->file_segment->WriteHead(segment_head_output, 8);
+            context->file_segment->SetSizeInfinite(true);
+        }
+        else
+        {
+            context->file_segment->WriteHead(*context->ebml_file, 8);
+        }
 
+        if (context->append_only)
+        {
+            // Append-only outputs can't be updated at the end, so write the segment info now without a duration.
+            auto &segment_info = GetChild<KaxInfo>(*context->file_segment);
+            segment_info.Render(*context->ebml_file);
+        }
+        else
         { // Write void blocks to reserve space for seeking metadata and the segment info so they can be updated at
           // the end
             context->seek_void = make_unique<EbmlVoid>();
@@ -573,6 +748,8 @@ k4a_result_t k4a_record_write_header(const k4a_record_t recording_handle)
             attachments.Render(*context->ebml_file);
         }
 
+        // Tags for append-only outputs are written at the end by write_append_only_trailer().
+        if (!context->append_only)
         { // Write tags with a void block after to make editing easier
             auto &tags = GetChild<KaxTags>(*context->file_segment);
             tags.Render(*context->ebml_file);
@@ -588,13 +765,61 @@ k4a_result_t k4a_record_write_header(const k4a_record_t recording_handle)
         return K4A_RESULT_FAILED;
     }
 
-    RETURN_IF_ERROR(start_matroska_writer_thread(context));
+    if (context->color_track != nullptr && context->color_track->jpeg_quality > 0)
+    {
+        RETURN_IF_ERROR(start_color_encoder_threads(context));
+    }
+
+    if (K4A_FAILED(TRACE_CALL(start_matroska_writer_thread(context))))
+    {
+        stop_color_encoder_threads(context);
+        return K4A_RESULT_FAILED;
+    }
 
     context->header_written = true;
 
     return K4A_RESULT_SUCCEEDED;
 }
 
+// Creates the copy of an image buffer that is written to file, converting it to the track's storage format.
+// Returns NULL on failure.
+static DataBuffer *create_image_data_buffer(track_header_t *track,
+                                            k4a_image_format_t image_format,
+                                            const uint8_t *image_buffer,
+                                            size_t buffer_size)
+{
+    if (track != NULL && track->rvl_compressed)
+    {
+        // Compress the image on worker threads, only the compressed copy is kept for writing to file.
+        std::vector<uint8_t> compressed;
+        if (!rvl_encode_image(reinterpret_cast<const uint16_t *>(image_buffer),
+                              buffer_size / sizeof(uint16_t),
+                              compressed))
+        {
+            LOG_ERROR("Failed to compress 16-bit image.", 0);
+            return NULL;
+        }
+        assert(compressed.size() <= UINT32_MAX);
+        return new (std::nothrow) DataBuffer(compressed.data(), (uint32)compressed.size(), NULL, true);
+    }
+
+    // Create a copy of the image buffer for writing to file.
+    assert(buffer_size <= UINT32_MAX);
+    DataBuffer *data_buffer = new (std::nothrow)
+        DataBuffer(const_cast<uint8_t *>(image_buffer), (uint32)buffer_size, NULL, true);
+    if (data_buffer != NULL && (image_format == K4A_IMAGE_FORMAT_DEPTH16 || image_format == K4A_IMAGE_FORMAT_IR16))
+    {
+        // 16 bit grayscale needs to be converted to big-endian in the file.
+        assert(data_buffer->Size() % sizeof(uint16_t) == 0);
+        uint16_t *data_buffer_raw = reinterpret_cast<uint16_t *>(data_buffer->Buffer());
+        for (size_t j = 0; j < data_buffer->Size() / sizeof(uint16_t); j++)
+        {
+            data_buffer_raw[j] = swap_bytes_16(data_buffer_raw[j]);
+        }
+    }
+    return data_buffer;
+}
+
 k4a_result_t k4a_record_write_capture(const k4a_record_t recording_handle, k4a_capture_t capture)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
@@ -631,32 +856,40 @@ k4a_result_t k4a_record_write_capture(const k4a_record_t recording_handle, k4a_c
             if (image_buffer != NULL && buffer_size > 0)
             {
                 k4a_image_format_t image_format = k4a_image_get_format(images[i]);
-                if (image_format == expected_formats[i])
+                if (image_format == expected_formats[i] && tracks[i] != NULL && tracks[i]->jpeg_quality > 0)
                 {
-                    // Create a copy of the image buffer for writing to file.
-                    assert(buffer_size <= UINT32_MAX);
-                    DataBuffer *data_buffer = new (std::nothrow)
-                        DataBuffer(image_buffer, (uint32)buffer_size, NULL, true);
-                    if (image_format == K4A_IMAGE_FORMAT_DEPTH16 || image_format == K4A_IMAGE_FORMAT_IR16)
+                    // The encoder threads keep a reference to the image and write it once it is compressed.
+                    uint64_t timestamp_ns = k4a_image_get_device_timestamp_usec(images[i]) * 1000;
+                    k4a_result_t tmp_result = TRACE_CALL(
+                        queue_color_encode(context, tracks[i], timestamp_ns, images[i]));
+                    if (K4A_FAILED(tmp_result))
                     {
-                        // 16 bit grayscale needs to be converted to big-endian in the file.
-                        assert(data_buffer->Size() % sizeof(uint16_t) == 0);
-                        uint16_t *data_buffer_raw = reinterpret_cast<uint16_t *>(data_buffer->Buffer());
-                        for (size_t j = 0; j < data_buffer->Size() / sizeof(uint16_t); j++)
+                        result = tmp_result;
+                    }
+                }
+                else if (image_format == expected_formats[i])
+                {
+                    DataBuffer *data_buffer = create_image_data_buffer(tracks[i],
+                                                                       image_format,
+                                                                       image_buffer,
+                                                                       buffer_size);
+                    if (data_buffer != NULL)
+                    {
+                        uint64_t device_timestamp = k4a_image_get_device_timestamp_usec(images[i]);
+                        uint64_t timestamp_ns = device_timestamp * 1000;
+                        k4a_result_t tmp_result = TRACE_CALL(
+                            write_track_data(context, tracks[i], timestamp_ns, data_buffer));
+                        if (K4A_FAILED(tmp_result))
                         {
-                            data_buffer_raw[j] = swap_bytes_16(data_buffer_raw[j]);
+                            // Write as many of the image buffers as possible, even if some fail due to timestamp.
+                            result = tmp_result;
+                            data_buffer->FreeBuffer(*data_buffer);
+                            delete data_buffer;
                         }
                     }
-                    uint64_t device_timestamp = k4a_image_get_device_timestamp_usec(images[i]);
-                    uint64_t timestamp_ns = device_timestamp * 1000;
-                    k4a_result_t tmp_result = TRACE_CALL(
-                        write_track_data(context, tracks[i], timestamp_ns, data_buffer));
-                    if (K4A_FAILED(tmp_result))
+                    else
                     {
-                        // Write as many of the image buffers as possible, even if some fail due to timestamp.
-                        result = tmp_result;
-                        data_buffer->FreeBuffer(*data_buffer);
-                        delete data_buffer;
+                        result = K4A_RESULT_FAILED;
                     }
                 }
                 else
@@ -672,6 +905,18 @@ k4a_result_t k4a_record_write_capture(const k4a_record_t recording_handle, k4a_c
     return result;
 }
 
+static void convert_imu_sample(const k4a_imu_sample_t &imu_sample, matroska_imu_sample_t *sample_data)
+{
+    *sample_data = {};
+    sample_data->acc_timestamp_ns = imu_sample.acc_timestamp_usec * 1000;
+    sample_data->gyro_timestamp_ns = imu_sample.gyro_timestamp_usec * 1000;
+    for (size_t i = 0; i < 3; i++)
+    {
+        sample_data->acc_data[i] = imu_sample.acc_sample.v[i];
+        sample_data->gyro_data[i] = imu_sample.gyro_sample.v[i];
+    }
+}
+
 k4a_result_t k4a_record_write_imu_sample(const k4a_record_t recording_handle, k4a_imu_sample_t imu_sample)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
@@ -692,14 +937,8 @@ k4a_result_t k4a_record_write_imu_sample(const k4a_record_t recording_handle, k4
         return K4A_RESULT_FAILED;
     }
 
-    matroska_imu_sample_t sample_data = { 0 };
-    sample_data.acc_timestamp_ns = imu_sample.acc_timestamp_usec * 1000;
-    sample_data.gyro_timestamp_ns = imu_sample.gyro_timestamp_usec * 1000;
-    for (size_t i = 0; i < 3; i++)
-    {
-        sample_data.acc_data[i] = imu_sample.acc_sample.v[i];
-        sample_data.gyro_data[i] = imu_sample.gyro_sample.v[i];
-    }
+    matroska_imu_sample_t sample_data;
+    convert_imu_sample(imu_sample, &sample_data);
 
     DataBuffer *data_buffer = new (std::nothrow)
         DataBuffer(reinterpret_cast<binary *>(&sample_data), sizeof(matroska_imu_sample_t), NULL, true);
@@ -714,6 +953,74 @@ k4a_result_t k4a_record_write_imu_sample(const k4a_record_t recording_handle, k4
     return K4A_RESULT_SUCCEEDED;
 }
 
+k4a_result_t k4a_record_write_imu_samples(const k4a_record_t recording_handle,
+                                          const k4a_imu_sample_t *imu_samples,
+                                          size_t imu_sample_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, imu_samples == NULL && imu_sample_count > 0);
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (!context->imu_track)
+    {
+        LOG_ERROR("The IMU track needs to be added with k4a_record_add_imu_track() before IMU samples can be written.",
+                  0);
+        return K4A_RESULT_FAILED;
+    }
+
+    if (!context->header_written)
+    {
+        LOG_ERROR("The recording header needs to be written before any imu samples.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    std::vector<uint64_t> timestamps_ns(imu_sample_count);
+    std::vector<DataBuffer *> data_buffers(imu_sample_count);
+    for (size_t i = 0; i < imu_sample_count; i++)
+    {
+        matroska_imu_sample_t sample_data;
+        convert_imu_sample(imu_samples[i], &sample_data);
+
+        timestamps_ns[i] = sample_data.acc_timestamp_ns;
+        data_buffers[i] = new (std::nothrow)
+            DataBuffer(reinterpret_cast<binary *>(&sample_data), sizeof(matroska_imu_sample_t), NULL, true);
+    }
+
+    k4a_result_t result = TRACE_CALL(write_track_data_batch(
+        context, context->imu_track, timestamps_ns.data(), data_buffers.data(), imu_sample_count));
+
+    // Buffers that were written are set to NULL, clean up any that were not.
+    for (DataBuffer *data_buffer : data_buffers)
+    {
+        if (data_buffer != NULL)
+        {
+            data_buffer->FreeBuffer(*data_buffer);
+            delete data_buffer;
+        }
+    }
+
+    return result;
+}
+
+// Returns the custom track with the given name, or NULL if there is no such custom track.
+static track_header_t *find_custom_track(k4a_record_context_t *context, const char *track_name)
+{
+    auto itr = context->tracks.find(track_name);
+    if (itr == context->tracks.end())
+    {
+        LOG_ERROR("The custom track does not exist: %s", track_name);
+        return NULL;
+    }
+    if (!itr->second.custom_track)
+    {
+        LOG_ERROR("Custom track data cannot be written to built-in track: %s", track_name);
+        return NULL;
+    }
+    return &itr->second;
+}
+
 k4a_result_t k4a_record_write_custom_track_data(const k4a_record_t recording_handle,
                                                 const char *track_name,
                                                 uint64_t device_timestamp_usec,
@@ -733,15 +1040,9 @@ k4a_result_t k4a_record_write_custom_track_data(const k4a_record_t recording_han
         return K4A_RESULT_FAILED;
     }
 
-    auto itr = context->tracks.find(track_name);
-    if (itr == context->tracks.end())
-    {
-        LOG_ERROR("The custom track does not exist: %s", track_name);
-        return K4A_RESULT_FAILED;
-    }
-    if (!itr->second.custom_track)
+    track_header_t *track = find_custom_track(context, track_name);
+    if (track == NULL)
     {
-        LOG_ERROR("Custom track data cannot be written to built-in track: %s", track_name);
         return K4A_RESULT_FAILED;
     }
 
@@ -749,8 +1050,7 @@ k4a_result_t k4a_record_write_custom_track_data(const k4a_record_t recording_han
     assert(buffer_size <= UINT32_MAX);
     DataBuffer *data_buffer = new DataBuffer(buffer, (uint32_t)buffer_size, NULL, true);
 
-    k4a_result_t result = TRACE_CALL(
-        write_track_data(context, &itr->second, device_timestamp_usec * 1000, data_buffer));
+    k4a_result_t result = TRACE_CALL(write_track_data(context, track, device_timestamp_usec * 1000, data_buffer));
     if (K4A_FAILED(result))
     {
         // Clean up the data_buffer if write_track_data failed.
@@ -761,6 +1061,63 @@ k4a_result_t k4a_record_write_custom_track_data(const k4a_record_t recording_han
     return result;
 }
 
+k4a_result_t k4a_record_write_custom_track_data_blocks(const k4a_record_t recording_handle,
+                                                       const char *track_name,
+                                                       const k4a_record_custom_data_block_t *data_blocks,
+                                                       size_t data_block_count)
+{
+    RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, track_name == NULL);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, data_blocks == NULL && data_block_count > 0);
+    for (size_t i = 0; i < data_block_count; i++)
+    {
+        RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, data_blocks[i].buffer == NULL);
+    }
+
+    k4a_record_context_t *context = k4a_record_t_get_context(recording_handle);
+    RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
+
+    if (!context->header_written)
+    {
+        LOG_ERROR("The recording header needs to be written before any track data.", 0);
+        return K4A_RESULT_FAILED;
+    }
+
+    track_header_t *track = find_custom_track(context, track_name);
+    if (track == NULL)
+    {
+        return K4A_RESULT_FAILED;
+    }
+
+    std::vector<uint64_t> timestamps_ns(data_block_count);
+    std::vector<DataBuffer *> data_buffers(data_block_count);
+    for (size_t i = 0; i < data_block_count; i++)
+    {
+        // Create a copy of each buffer for writing to file.
+        assert(data_blocks[i].buffer_size <= UINT32_MAX);
+        timestamps_ns[i] = data_blocks[i].device_timestamp_usec * 1000;
+        data_buffers[i] = new (std::nothrow) DataBuffer(const_cast<uint8_t *>(data_blocks[i].buffer),
+                                                        (uint32_t)data_blocks[i].buffer_size,
+                                                        NULL,
+                                                        true);
+    }
+
+    k4a_result_t result = TRACE_CALL(
+        write_track_data_batch(context, track, timestamps_ns.data(), data_buffers.data(), data_block_count));
+
+    // Buffers that were written are set to NULL, clean up any that were not.
+    for (DataBuffer *data_buffer : data_buffers)
+    {
+        if (data_buffer != NULL)
+        {
+            data_buffer->FreeBuffer(*data_buffer);
+            delete data_buffer;
+        }
+    }
+
+    return result;
+}
+
 k4a_result_t k4a_record_flush(const k4a_record_t recording_handle)
 {
     RETURN_VALUE_IF_HANDLE_INVALID(K4A_RESULT_FAILED, k4a_record_t, recording_handle);
@@ -770,6 +1127,9 @@ k4a_result_t k4a_record_flush(const k4a_record_t recording_handle)
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, context == NULL);
     RETURN_VALUE_IF_ARG(K4A_RESULT_FAILED, !context->header_written);
 
+    // Color images still being encoded need to be in the pending clusters before they are written.
+    result = TRACE_CALL(wait_for_color_encoder(context));
+
     try
     {
         // Lock the writer thread first so we don't have conflicts
@@ -798,6 +1158,12 @@ k4a_result_t k4a_record_flush(const k4a_record_t recording_handle)
             context->pending_clusters.clear();
         }
 
+        if (context->append_only)
+        {
+            // Nothing written so far can be updated, the index is written by k4a_record_close().
+            return result;
+        }
+
         auto &segment_info = GetChild<KaxInfo>(*context->file_segment);
 
         uint64_t current_position = context->ebml_file->getFilePointer();
@@ -905,16 +1271,46 @@ void k4a_record_close(const k4a_record_t recording_handle)
         {
             // If these fail, there's nothing we can do but log.
             (void)TRACE_CALL(k4a_record_flush(recording_handle));
+            stop_color_encoder_threads(context);
             stop_matroska_writer_thread(context);
+
+            if (context->append_only)
+            {
+                (void)TRACE_CALL(write_append_only_trailer(context));
+            }
         }
 
+        uint64_t recording_size = 0;
+        uint64_t recording_hash = 0;
         try
         {
+            if (context->header_written && !context->block_index.empty())
+            {
+                // The index is tied to the final size and contents of the recording.
+                LargeFileIOCallback *file_io = dynamic_cast<LargeFileIOCallback *>(context->ebml_file.get());
+                if (file_io != NULL)
+                {
+                    file_io->setOwnerThread();
+                }
+                context->ebml_file->setFilePointer(0, seek_end);
+                recording_size = context->ebml_file->getFilePointer();
+                recording_hash = get_recording_hash(*context->ebml_file, recording_size);
+            }
             context->ebml_file->close();
         }
         catch (std::ios_base::failure &e)
         {
             LOG_ERROR("Failed to close recording '%s': %s", context->file_path, e.what());
+            recording_size = 0;
+        }
+
+        if (recording_size > 0 && !context->block_index_path.empty())
+        {
+            // The index only speeds up playback, the recording is still valid without it.
+            if (!write_block_index(context->block_index_path, recording_size, recording_hash, context->block_index))
+            {
+                LOG_WARNING("Failed to write recording index '%s'.", context->block_index_path.c_str());
+            }
         }
     }
     k4a_record_t_destroy(recording_handle);
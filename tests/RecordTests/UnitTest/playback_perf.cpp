@@ -5,22 +5,180 @@
 #include <k4a/k4a.h>
 #include <k4ainternal/common.h>
 #include <k4ainternal/matroska_common.h>
+#include <k4ainternal/block_index.h>
 
 #include "test_helpers.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <fstream>
+#include <random>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
 
 // Module being tested
 #include <k4arecord/playback.h>
+#include <k4arecord/record.h>
 
 using namespace testing;
 
 static std::string g_test_file_name;
 
+// A synthetic recording is generated when no input file is given on the command line.
+static const char *const synthetic_file_name = "playback_perf_synthetic.mkv";
+static bool g_synthetic_recording = false;
+static uint32_t g_length_sec = 40;
+static k4a_image_format_t g_color_format = K4A_IMAGE_FORMAT_COLOR_MJPG;
+static k4a_color_resolution_t g_color_resolution = K4A_COLOR_RESOLUTION_1080P;
+static k4a_depth_mode_t g_depth_mode = K4A_DEPTH_MODE_NFOV_UNBINNED;
+static bool g_imu_track = true;
+static bool g_custom_track = true;
+
+static const uint64_t synthetic_imu_period_usec = 1000;     // 1kHz, similar to the device IMU rate.
+static const uint64_t synthetic_custom_period_usec = 10000; // 100Hz
+static const size_t synthetic_custom_block_size = 256;
+static const size_t random_seek_count = 200;
+static const size_t open_count = 10;
+
+// Peak resident memory of the whole process, in bytes. This never decreases, so run a single test with --gtest_filter
+// to attribute it to that test.
+static uint64_t get_peak_rss_bytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return 0;
+    }
+    return (uint64_t)counters.PeakWorkingSetSize;
+#else
+    struct rusage usage = {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+    return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+// Prints the latency distribution and records it as test properties, so it is included in the --gtest_output report.
+static void report_latency(const std::string &name, std::vector<int64_t> deltas_ns)
+{
+    if (deltas_ns.empty())
+    {
+        std::cout << "    No " << name << " latency samples." << std::endl;
+        return;
+    }
+
+    std::sort(deltas_ns.begin(), deltas_ns.end(), std::less<int64_t>());
+    int64_t total_ns = 0;
+    for (auto d : deltas_ns)
+    {
+        total_ns += d;
+    }
+    auto percentile_usec = [&deltas_ns](double percentile) {
+        size_t index = (size_t)std::ceil((double)deltas_ns.size() * percentile);
+        return deltas_ns[index > 0 ? index - 1 : 0] / 1000;
+    };
+
+    int64_t avg_usec = total_ns / (int64_t)deltas_ns.size() / 1000;
+    std::cout << "    " << name << " latency: avg " << avg_usec << " usec, P50 " << percentile_usec(0.5)
+              << " usec, P95 " << percentile_usec(0.95) << " usec, P99 " << percentile_usec(0.99) << " usec, max "
+              << (deltas_ns.back() / 1000) << " usec" << std::endl;
+
+    Test::RecordProperty(name + "_avg_usec", (int)avg_usec);
+    Test::RecordProperty(name + "_p50_usec", (int)percentile_usec(0.5));
+    Test::RecordProperty(name + "_p95_usec", (int)percentile_usec(0.95));
+    Test::RecordProperty(name + "_p99_usec", (int)percentile_usec(0.99));
+    Test::RecordProperty(name + "_max_usec", (int)(deltas_ns.back() / 1000));
+}
+
+static void report_cache_stats(k4a_playback_t handle)
+{
+    k4a_playback_cache_stats_t stats = {};
+    if (K4A_SUCCEEDED(k4a_playback_get_cache_stats(handle, &stats)))
+    {
+        Test::RecordProperty("cluster_cache_hits", std::to_string(stats.hits));
+        Test::RecordProperty("cluster_cache_misses", std::to_string(stats.misses));
+        Test::RecordProperty("cluster_cache_evictions", std::to_string(stats.evictions));
+    }
+}
+
+struct read_result_t
+{
+    uint64_t captures = 0;
+    uint64_t bytes = 0; // Total size of the images in the captures.
+    double wall_sec = 0;
+    double cpu_sec = 0;
+};
+
+static void add_image_size(k4a_image_t image, uint64_t *bytes)
+{
+    if (image != NULL)
+    {
+        *bytes += k4a_image_get_size(image);
+        k4a_image_release(image);
+    }
+}
+
+// Reads captures from the current position to the end or start of the recording as fast as possible.
+static bool read_all_captures(k4a_playback_t handle, bool forward, read_result_t *result)
+{
+    std::clock_t cpu_start = std::clock();
+    auto wall_start = std::chrono::steady_clock::now();
+    while (true)
+    {
+        k4a_capture_t capture = NULL;
+        k4a_stream_result_t playback_result = forward ? k4a_playback_get_next_capture(handle, &capture) :
+                                                        k4a_playback_get_previous_capture(handle, &capture);
+        if (playback_result == K4A_STREAM_RESULT_EOF)
+        {
+            break;
+        }
+        else if (playback_result != K4A_STREAM_RESULT_SUCCEEDED)
+        {
+            return false;
+        }
+
+        add_image_size(k4a_capture_get_color_image(capture), &result->bytes);
+        add_image_size(k4a_capture_get_depth_image(capture), &result->bytes);
+        add_image_size(k4a_capture_get_ir_image(capture), &result->bytes);
+        k4a_capture_release(capture);
+        result->captures++;
+    }
+    result->wall_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    result->cpu_sec = (double)(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+    return true;
+}
+
+static void report_throughput(const std::string &name, const read_result_t &result)
+{
+    double captures_per_sec = result.wall_sec > 0 ? (double)result.captures / result.wall_sec : 0;
+    double mb_per_sec = result.wall_sec > 0 ? (double)result.bytes / (1024 * 1024) / result.wall_sec : 0;
+    std::cout << "    " << name << ": " << result.captures << " captures in " << result.wall_sec << " s, "
+              << captures_per_sec << " captures/s, " << mb_per_sec << " MB/s" << std::endl;
+
+    Test::RecordProperty(name + "_captures", std::to_string(result.captures));
+    Test::RecordProperty(name + "_captures_per_sec", std::to_string(captures_per_sec));
+    Test::RecordProperty(name + "_mb_per_sec", std::to_string(mb_per_sec));
+}
+
 class playback_perf : public ::testing::Test
 {
 protected:
     void SetUp() override {}
-    void TearDown() override {}
+    void TearDown() override
+    {
+        RecordProperty("peak_rss_bytes", std::to_string(get_peak_rss_bytes()));
+    }
 };
 
 TEST_F(playback_perf, test_open)
@@ -135,6 +293,47 @@ TEST_F(playback_perf, test_open)
     k4a_playback_close(handle);
 }
 
+// Measures how long k4a_playback_open() takes. For synthetic recordings the open time without the block index is
+// measured as well, by moving the index file aside.
+TEST_F(playback_perf, test_open_time)
+{
+    std::vector<std::pair<std::string, bool>> variants = { { "open", true } };
+    std::string index_path = k4arecord::get_block_index_path(g_test_file_name.c_str());
+    if (g_synthetic_recording && std::ifstream(index_path).good())
+    {
+        variants.push_back({ "open_without_index", false });
+    }
+
+    for (auto &variant : variants)
+    {
+        std::string moved_index_path = index_path + ".moved";
+        if (!variant.second)
+        {
+            ASSERT_EQ(std::rename(index_path.c_str(), moved_index_path.c_str()), 0);
+        }
+
+        std::vector<int64_t> deltas;
+        for (size_t i = 0; i < open_count; i++)
+        {
+            k4a_playback_t handle = NULL;
+            auto start = std::chrono::high_resolution_clock::now();
+            k4a_result_t result = k4a_playback_open(g_test_file_name.c_str(), &handle);
+            auto delta = std::chrono::high_resolution_clock::now() - start;
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+            k4a_playback_close(handle);
+            deltas.push_back(delta.count());
+        }
+
+        if (!variant.second)
+        {
+            // Opening a recording without Cues writes a new index, the original one replaces it.
+            (void)std::remove(index_path.c_str());
+            ASSERT_EQ(std::rename(moved_index_path.c_str(), index_path.c_str()), 0);
+        }
+        report_latency(variant.first, deltas);
+    }
+}
+
 TEST_F(playback_perf, test_1000_reads_forward)
 {
     k4a_playback_t handle = NULL;
@@ -245,6 +444,110 @@ TEST_F(playback_perf, test_1000_reads_backward)
     k4a_playback_close(handle);
 }
 
+TEST_F(playback_perf, test_throughput_forward)
+{
+    k4a_playback_t handle = NULL;
+    ASSERT_EQ(k4a_playback_open(g_test_file_name.c_str(), &handle), K4A_RESULT_SUCCEEDED);
+
+    read_result_t result;
+    ASSERT_TRUE(read_all_captures(handle, true, &result));
+    report_throughput("forward", result);
+    report_cache_stats(handle);
+
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_perf, test_throughput_backward)
+{
+    k4a_playback_t handle = NULL;
+    ASSERT_EQ(k4a_playback_open(g_test_file_name.c_str(), &handle), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_seek_timestamp(handle, 0, K4A_PLAYBACK_SEEK_END), K4A_RESULT_SUCCEEDED);
+
+    read_result_t result;
+    ASSERT_TRUE(read_all_captures(handle, false, &result));
+    report_throughput("backward", result);
+    report_cache_stats(handle);
+
+    k4a_playback_close(handle);
+}
+
+// Scrubbing: seeks to random timestamps and reads the capture at each one. The seed is fixed so runs are comparable.
+TEST_F(playback_perf, test_random_seek_latency)
+{
+    k4a_playback_t handle = NULL;
+    ASSERT_EQ(k4a_playback_open(g_test_file_name.c_str(), &handle), K4A_RESULT_SUCCEEDED);
+
+    uint64_t length_usec = k4a_playback_get_recording_length_usec(handle);
+    std::mt19937_64 generator(1234);
+    std::uniform_int_distribution<uint64_t> distribution(0, length_usec);
+
+    std::vector<int64_t> deltas;
+    for (size_t i = 0; i < random_seek_count; i++)
+    {
+        int64_t timestamp_usec = (int64_t)distribution(generator);
+        k4a_capture_t capture = NULL;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        ASSERT_EQ(k4a_playback_seek_timestamp(handle, timestamp_usec, K4A_PLAYBACK_SEEK_BEGIN),
+                  K4A_RESULT_SUCCEEDED);
+        k4a_stream_result_t playback_result = k4a_playback_get_next_capture(handle, &capture);
+        auto delta = std::chrono::high_resolution_clock::now() - start;
+
+        // Seeking past the last capture returns EOF, which is still a valid measurement.
+        ASSERT_NE(playback_result, K4A_STREAM_RESULT_FAILED);
+        if (capture != NULL)
+        {
+            k4a_capture_release(capture);
+        }
+        deltas.push_back(delta.count());
+    }
+    report_latency("seek", deltas);
+    report_cache_stats(handle);
+
+    k4a_playback_close(handle);
+}
+
+// Compares reading every capture with and without converting the color images to BGRA32.
+TEST_F(playback_perf, test_color_conversion_cost)
+{
+    k4a_playback_t handle = NULL;
+    ASSERT_EQ(k4a_playback_open(g_test_file_name.c_str(), &handle), K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    ASSERT_EQ(k4a_playback_get_record_configuration(handle, &config), K4A_RESULT_SUCCEEDED);
+    if (!config.color_track_enabled || config.color_format == K4A_IMAGE_FORMAT_COLOR_BGRA32)
+    {
+        std::cout << "    Recording has no color track to convert." << std::endl;
+        k4a_playback_close(handle);
+        return;
+    }
+
+    read_result_t raw;
+    ASSERT_TRUE(read_all_captures(handle, true, &raw));
+    k4a_playback_close(handle);
+
+    ASSERT_EQ(k4a_playback_open(g_test_file_name.c_str(), &handle), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_set_color_conversion(handle, K4A_IMAGE_FORMAT_COLOR_BGRA32), K4A_RESULT_SUCCEEDED);
+    read_result_t converted;
+    ASSERT_TRUE(read_all_captures(handle, true, &converted));
+    k4a_playback_close(handle);
+
+    ASSERT_GT(raw.captures, 0u);
+    ASSERT_EQ(raw.captures, converted.captures);
+
+    // MJPEG frames are decoded on background threads, so the CPU time shows the cost that the wall time may hide.
+    double captures = (double)raw.captures;
+    double wall_usec = (converted.wall_sec - raw.wall_sec) * 1000000 / captures;
+    double cpu_usec = (converted.cpu_sec - raw.cpu_sec) * 1000000 / captures;
+    std::cout << "    Color conversion from " << format_names[config.color_format] << ": " << wall_usec
+              << " usec/capture wall time, " << cpu_usec << " usec/capture CPU time" << std::endl;
+
+    RecordProperty("color_conversion_wall_usec_per_capture", std::to_string(wall_usec));
+    RecordProperty("color_conversion_cpu_usec_per_capture", std::to_string(cpu_usec));
+    report_throughput("raw", raw);
+    report_throughput("converted", converted);
+}
+
 TEST_F(playback_perf, test_read_latency_30fps)
 {
     k4a_playback_t handle = NULL;
@@ -282,17 +585,7 @@ TEST_F(playback_perf, test_read_latency_30fps)
         }
     }
 
-    std::sort(deltas.begin(), deltas.end(), std::less<int64_t>());
-    int64_t total_ns = 0;
-    for (auto d : deltas)
-    {
-        total_ns += d;
-    }
-    std::cout << "    Avg latency: " << (total_ns / (int64_t)deltas.size() / 1000) << " usec" << std::endl;
-    std::cout << "    P95 latency: " << (deltas[(size_t)((double)deltas.size() * 0.95) - 1] / 1000) << " usec"
-              << std::endl;
-    std::cout << "    P99 latency: " << (deltas[(size_t)((double)deltas.size() * 0.99) - 1] / 1000) << " usec"
-              << std::endl;
+    report_latency("read_30fps", deltas);
 
     k4a_playback_close(handle);
 }
@@ -336,19 +629,270 @@ TEST_F(playback_perf, test_read_latency_30fps_bgra_conversion)
         }
     }
 
-    std::sort(deltas.begin(), deltas.end(), std::less<int64_t>());
-    int64_t total_ns = 0;
-    for (auto d : deltas)
+    report_latency("read_30fps_bgra", deltas);
+
+    k4a_playback_close(handle);
+}
+
+// Fills a buffer that is shared by every frame of the synthetic recording. Color is a gradient so that it compresses
+// like a camera image, the other formats get a pattern that doesn't compress.
+static void
+fill_synthetic_buffer(k4a_image_format_t format, uint32_t width, uint32_t height, std::vector<uint8_t> *buffer)
+{
+    if (format == K4A_IMAGE_FORMAT_COLOR_BGRA32)
     {
-        total_ns += d;
+        buffer->resize((size_t)width * height * 4);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                uint8_t *pixel = buffer->data() + ((size_t)y * width + x) * 4;
+                pixel[0] = (uint8_t)(x * 255 / width);
+                pixel[1] = (uint8_t)(y * 255 / height);
+                pixel[2] = (uint8_t)((x + y) * 255 / (width + height));
+                pixel[3] = 0xFF;
+            }
+        }
+        return;
     }
-    std::cout << "    Avg latency: " << (total_ns / (int64_t)deltas.size() / 1000) << " usec" << std::endl;
-    std::cout << "    P95 latency: " << (deltas[(size_t)((double)deltas.size() * 0.95) - 1] / 1000) << " usec"
-              << std::endl;
-    std::cout << "    P99 latency: " << (deltas[(size_t)((double)deltas.size() * 0.99) - 1] / 1000) << " usec"
-              << std::endl;
 
-    k4a_playback_close(handle);
+    size_t buffer_size = format == K4A_IMAGE_FORMAT_COLOR_NV12 ? (size_t)width * height * 3 / 2 :
+                                                                 (size_t)width * height * 2;
+    buffer->resize(buffer_size);
+    for (size_t i = 0; i < buffer_size; i++)
+    {
+        (*buffer)[i] = (uint8_t)(i * 31 + i / 4096);
+    }
+}
+
+static k4a_image_t create_synthetic_image(k4a_image_format_t format,
+                                          uint32_t width,
+                                          uint32_t height,
+                                          std::vector<uint8_t> &buffer,
+                                          uint64_t timestamp_usec)
+{
+    int stride = 0;
+    switch (format)
+    {
+    case K4A_IMAGE_FORMAT_COLOR_NV12:
+        stride = (int)width;
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_BGRA32:
+        stride = (int)width * 4;
+        break;
+    default:
+        stride = (int)width * 2;
+        break;
+    }
+
+    k4a_image_t image = NULL;
+    k4a_result_t result = k4a_image_create_from_buffer(format,
+                                                       (int)width,
+                                                       (int)height,
+                                                       stride,
+                                                       buffer.data(),
+                                                       buffer.size(),
+                                                       [](void *buffer_ptr, void *context) {
+                                                           (void)buffer_ptr;
+                                                           (void)context;
+                                                       },
+                                                       NULL,
+                                                       &image);
+    if (K4A_FAILED(result))
+    {
+        return NULL;
+    }
+    k4a_image_set_device_timestamp_usec(image, timestamp_usec);
+    return image;
+}
+
+// Writes a recording with the settings from the command line. MJPG color is compressed from BGRA32 frames by the
+// recorder, so the color track can be decoded by k4a_playback_set_color_conversion().
+static bool create_synthetic_recording(const char *path)
+{
+    k4a_device_configuration_t device_config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+    device_config.color_format = g_color_format == K4A_IMAGE_FORMAT_COLOR_MJPG ? K4A_IMAGE_FORMAT_COLOR_BGRA32 :
+                                                                                 g_color_format;
+    device_config.color_resolution = g_color_resolution;
+    device_config.depth_mode = g_depth_mode;
+    device_config.camera_fps = K4A_FRAMES_PER_SECOND_30;
+
+    k4a_record_t handle = NULL;
+    if (K4A_FAILED(k4a_record_create(path, NULL, device_config, &handle)))
+    {
+        return false;
+    }
+
+    bool result = true;
+    if (g_color_resolution != K4A_COLOR_RESOLUTION_OFF && g_color_format == K4A_IMAGE_FORMAT_COLOR_MJPG)
+    {
+        result = K4A_SUCCEEDED(k4a_record_set_color_codec(handle, K4A_RECORD_COLOR_CODEC_MJPG, 90));
+    }
+    if (result && g_imu_track)
+    {
+        result = K4A_SUCCEEDED(k4a_record_add_imu_track(handle));
+    }
+    if (result && g_custom_track)
+    {
+        k4a_record_subtitle_settings_t settings = {};
+        settings.high_freq_data = false;
+        result = K4A_SUCCEEDED(
+            k4a_record_add_custom_subtitle_track(handle, "CUSTOM_DATA", "S_K4A/PERF", NULL, 0, &settings));
+    }
+    if (result)
+    {
+        result = K4A_SUCCEEDED(k4a_record_write_header(handle));
+    }
+
+    std::vector<uint8_t> buffers[3];
+    uint32_t color_width = 0, color_height = 0, depth_width = 0, depth_height = 0;
+    if (g_color_resolution != K4A_COLOR_RESOLUTION_OFF)
+    {
+        result = result && k4a_convert_resolution_to_width_height(g_color_resolution, &color_width, &color_height);
+        fill_synthetic_buffer(device_config.color_format, color_width, color_height, &buffers[0]);
+    }
+    if (g_depth_mode != K4A_DEPTH_MODE_OFF)
+    {
+        result = result && k4a_convert_depth_mode_to_width_height(g_depth_mode, &depth_width, &depth_height);
+        fill_synthetic_buffer(K4A_IMAGE_FORMAT_DEPTH16, depth_width, depth_height, &buffers[1]);
+        fill_synthetic_buffer(K4A_IMAGE_FORMAT_IR16, depth_width, depth_height, &buffers[2]);
+    }
+    std::vector<uint8_t> custom_block(synthetic_custom_block_size);
+
+    uint64_t frame_count = (uint64_t)g_length_sec * test_camera_fps;
+    uint64_t imu_timestamp_usec = 0;
+    uint64_t custom_timestamp_usec = 0;
+    for (uint64_t frame = 0; frame < frame_count && result; frame++)
+    {
+        uint64_t timestamp_usec = frame * test_timestamp_delta_usec;
+        k4a_capture_t capture = NULL;
+        result = K4A_SUCCEEDED(k4a_capture_create(&capture));
+        if (!result)
+        {
+            break;
+        }
+
+        k4a_image_t images[3] = { NULL, NULL, NULL };
+        if (g_color_resolution != K4A_COLOR_RESOLUTION_OFF)
+        {
+            images[0] = create_synthetic_image(device_config.color_format,
+                                               color_width,
+                                               color_height,
+                                               buffers[0],
+                                               timestamp_usec);
+            k4a_capture_set_color_image(capture, images[0]);
+        }
+        if (g_depth_mode != K4A_DEPTH_MODE_OFF)
+        {
+            if (g_depth_mode != K4A_DEPTH_MODE_PASSIVE_IR)
+            {
+                images[1] = create_synthetic_image(K4A_IMAGE_FORMAT_DEPTH16,
+                                                   depth_width,
+                                                   depth_height,
+                                                   buffers[1],
+                                                   timestamp_usec);
+                k4a_capture_set_depth_image(capture, images[1]);
+            }
+            images[2] =
+                create_synthetic_image(K4A_IMAGE_FORMAT_IR16, depth_width, depth_height, buffers[2], timestamp_usec);
+            k4a_capture_set_ir_image(capture, images[2]);
+        }
+        for (size_t i = 0; i < arraysize(images); i++)
+        {
+            if (images[i] != NULL)
+            {
+                k4a_image_release(images[i]);
+            }
+        }
+
+        result = K4A_SUCCEEDED(k4a_record_write_capture(handle, capture));
+        k4a_capture_release(capture);
+
+        uint64_t next_timestamp_usec = timestamp_usec + test_timestamp_delta_usec;
+        for (; g_imu_track && result && imu_timestamp_usec < next_timestamp_usec;
+             imu_timestamp_usec += synthetic_imu_period_usec)
+        {
+            result = K4A_SUCCEEDED(k4a_record_write_imu_sample(handle, create_test_imu_sample(imu_timestamp_usec)));
+        }
+        for (; g_custom_track && result && custom_timestamp_usec < next_timestamp_usec;
+             custom_timestamp_usec += synthetic_custom_period_usec)
+        {
+            memcpy(custom_block.data(), &custom_timestamp_usec, sizeof(custom_timestamp_usec));
+            result = K4A_SUCCEEDED(k4a_record_write_custom_track_data(handle,
+                                                                      "CUSTOM_DATA",
+                                                                      custom_timestamp_usec,
+                                                                      custom_block.data(),
+                                                                      custom_block.size()));
+        }
+    }
+
+    if (result)
+    {
+        result = K4A_SUCCEEDED(k4a_record_flush(handle));
+    }
+    k4a_record_close(handle);
+    return result;
+}
+
+static bool parse_uint_option(int argc, char **argv, int *i, const char *name, uint32_t *value)
+{
+    if (strcmp(argv[*i], name) != 0)
+    {
+        return false;
+    }
+    if (*i + 1 >= argc)
+    {
+        std::cout << "Missing value for " << name << std::endl;
+        exit(1);
+    }
+    unsigned long parsed = strtoul(argv[++*i], NULL, 10);
+    if (parsed == 0 || parsed > UINT32_MAX)
+    {
+        std::cout << "Invalid value for " << name << ": " << argv[*i] << std::endl;
+        exit(1);
+    }
+    *value = (uint32_t)parsed;
+    return true;
+}
+
+template<typename T, size_t N>
+static bool parse_enum_option(int argc,
+                              char **argv,
+                              int *i,
+                              const char *name,
+                              const std::pair<const char *, T> (&values)[N],
+                              T *value)
+{
+    if (strcmp(argv[*i], name) != 0)
+    {
+        return false;
+    }
+    if (*i + 1 >= argc)
+    {
+        std::cout << "Missing value for " << name << std::endl;
+        exit(1);
+    }
+    ++*i;
+    for (size_t j = 0; j < N; j++)
+    {
+        if (strcmp(argv[*i], values[j].first) == 0)
+        {
+            *value = values[j].second;
+            return true;
+        }
+    }
+    std::cout << "Invalid value for " << name << ": " << argv[*i] << std::endl;
+    exit(1);
+}
+
+static bool parse_flag_option(char **argv, int i, const char *name, bool *value)
+{
+    if (strcmp(argv[i], name) != 0)
+    {
+        return false;
+    }
+    *value = false;
+    return true;
 }
 
 int main(int argc, char **argv)
@@ -357,14 +901,81 @@ int main(int argc, char **argv)
 
     ::testing::InitGoogleTest(&argc, argv);
 
-    if (argc < 2)
+    // K4A_IMAGE_FORMAT_CUSTOM stands for a recording without a color track.
+    static const std::pair<const char *, k4a_image_format_t> color_formats[] = {
+        { "mjpg", K4A_IMAGE_FORMAT_COLOR_MJPG },     { "nv12", K4A_IMAGE_FORMAT_COLOR_NV12 },
+        { "yuy2", K4A_IMAGE_FORMAT_COLOR_YUY2 },     { "bgra32", K4A_IMAGE_FORMAT_COLOR_BGRA32 },
+        { "off", K4A_IMAGE_FORMAT_CUSTOM },
+    };
+    static const std::pair<const char *, k4a_color_resolution_t> color_resolutions[] = {
+        { "720p", K4A_COLOR_RESOLUTION_720P },   { "1080p", K4A_COLOR_RESOLUTION_1080P },
+        { "1440p", K4A_COLOR_RESOLUTION_1440P }, { "1536p", K4A_COLOR_RESOLUTION_1536P },
+        { "2160p", K4A_COLOR_RESOLUTION_2160P }, { "3072p", K4A_COLOR_RESOLUTION_3072P },
+    };
+    static const std::pair<const char *, k4a_depth_mode_t> depth_modes[] = {
+        { "nfov_2x2binned", K4A_DEPTH_MODE_NFOV_2X2BINNED }, { "nfov_unbinned", K4A_DEPTH_MODE_NFOV_UNBINNED },
+        { "wfov_2x2binned", K4A_DEPTH_MODE_WFOV_2X2BINNED }, { "wfov_unbinned", K4A_DEPTH_MODE_WFOV_UNBINNED },
+        { "passive_ir", K4A_DEPTH_MODE_PASSIVE_IR },         { "off", K4A_DEPTH_MODE_OFF },
+    };
+
+    for (int i = 1; i < argc; i++)
     {
-        std::cout << "Usage: playback_perf <options> <testfile.mkv>" << std::endl;
-        return 1;
+        if (parse_uint_option(argc, argv, &i, "--length", &g_length_sec) ||
+            parse_enum_option(argc, argv, &i, "--color", color_formats, &g_color_format) ||
+            parse_enum_option(argc, argv, &i, "--resolution", color_resolutions, &g_color_resolution) ||
+            parse_enum_option(argc, argv, &i, "--depth", depth_modes, &g_depth_mode) ||
+            parse_flag_option(argv, i, "--no-imu", &g_imu_track) ||
+            parse_flag_option(argv, i, "--no-custom-track", &g_custom_track))
+        {
+            continue;
+        }
+        else if (argv[i][0] != '-' && g_test_file_name.empty())
+        {
+            g_test_file_name = std::string(argv[i]);
+        }
+        else
+        {
+            std::cout << "Usage: playback_perf <gtest options> [testfile.mkv]" << std::endl;
+            std::cout << "Without a test file, a synthetic recording is generated with these options:" << std::endl;
+            std::cout << "    --length <seconds>  (default 40)" << std::endl;
+            std::cout << "    --color <mjpg|nv12|yuy2|bgra32|off>  (default mjpg)" << std::endl;
+            std::cout << "    --resolution <720p|1080p|1440p|1536p|2160p|3072p>  (default 1080p)" << std::endl;
+            std::cout << "    --depth <nfov_2x2binned|nfov_unbinned|wfov_2x2binned|wfov_unbinned|passive_ir|off>  "
+                         "(default nfov_unbinned)"
+                      << std::endl;
+            std::cout << "    --no-imu  Leave out the 1kHz IMU track" << std::endl;
+            std::cout << "    --no-custom-track  Leave out the 100Hz custom data track" << std::endl;
+            std::cout << "Use --gtest_output=xml:<file> or --gtest_output=json:<file> to save the measurements."
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    if (g_test_file_name.empty())
+    {
+        if (g_color_format == K4A_IMAGE_FORMAT_CUSTOM)
+        {
+            g_color_resolution = K4A_COLOR_RESOLUTION_OFF;
+        }
+
+        g_test_file_name = synthetic_file_name;
+        g_synthetic_recording = true;
+        Timer t("Create synthetic recording: " + g_test_file_name);
+        if (!create_synthetic_recording(synthetic_file_name))
+        {
+            std::cout << "Failed to create synthetic recording." << std::endl;
+            return 1;
+        }
     }
-    g_test_file_name = std::string(argv[1]);
 
     int results = RUN_ALL_TESTS();
+
+    if (g_synthetic_recording)
+    {
+        (void)std::remove(k4arecord::get_block_index_path(synthetic_file_name).c_str());
+        (void)std::remove(synthetic_file_name);
+    }
+
     k4a_unittest_deinit();
     return results;
 }
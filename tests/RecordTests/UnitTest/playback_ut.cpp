@@ -7,15 +7,27 @@
 #include <k4ainternal/matroska_common.h>
 
 #include "test_helpers.h"
+#include <algorithm>
 #include <fstream>
+#include <iterator>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <chrono>
+#include <turbojpeg.h>
 
 // Module being tested
 #include <k4arecord/playback.h>
+#include <k4arecord/record.h>
 
 using namespace testing;
 
+#ifdef _WIN32
+#define SETENV(env, value) _putenv_s(env, value)
+#else
+#define SETENV(env, value) setenv(env, value, 1)
+#endif
+
 class playback_ut : public ::testing::Test
 {
 protected:
@@ -789,6 +801,110 @@ TEST_F(playback_ut, open_imu_playback_file)
     k4a_playback_close(handle);
 }
 
+TEST_F(playback_ut, playback_imu_range_test)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    // Query the size of the whole IMU stream, then read it in one call.
+    size_t sample_count = 0;
+    ASSERT_EQ(k4a_playback_get_imu_samples(handle, 0, UINT64_MAX, NULL, &sample_count), K4A_BUFFER_RESULT_TOO_SMALL);
+    ASSERT_EQ(sample_count, (size_t)3333);
+
+    std::vector<k4a_imu_sample_t> samples(sample_count);
+    ASSERT_EQ(k4a_playback_get_imu_samples(handle, 0, UINT64_MAX, samples.data(), &sample_count),
+              K4A_BUFFER_RESULT_SUCCEEDED);
+    ASSERT_EQ(sample_count, samples.size());
+    uint64_t imu_timestamp = 1150;
+    for (k4a_imu_sample_t &sample : samples)
+    {
+        ASSERT_TRUE(validate_imu_sample(sample, imu_timestamp));
+        imu_timestamp += 1000;
+    }
+
+    // The start of the range is inclusive and the end is exclusive, including across block boundaries.
+    for (uint64_t start_timestamp = 10150; start_timestamp < 200150; start_timestamp += 33000)
+    {
+        sample_count = samples.size();
+        ASSERT_EQ(k4a_playback_get_imu_samples(handle,
+                                               start_timestamp,
+                                               start_timestamp + 10000,
+                                               samples.data(),
+                                               &sample_count),
+                  K4A_BUFFER_RESULT_SUCCEEDED);
+        ASSERT_EQ(sample_count, (size_t)10);
+        for (size_t i = 0; i < sample_count; i++)
+        {
+            ASSERT_TRUE(validate_imu_sample(samples[i], start_timestamp + i * 1000));
+        }
+    }
+
+    sample_count = 5;
+    ASSERT_EQ(k4a_playback_get_imu_samples(handle, 10150, 20150, samples.data(), &sample_count),
+              K4A_BUFFER_RESULT_TOO_SMALL);
+    ASSERT_EQ(sample_count, (size_t)10);
+
+    sample_count = samples.size();
+    ASSERT_EQ(k4a_playback_get_imu_samples(handle, 20150, 10150, samples.data(), &sample_count),
+              K4A_BUFFER_RESULT_SUCCEEDED);
+    ASSERT_EQ(sample_count, (size_t)0);
+
+    // The playback position is not changed.
+    k4a_imu_sample_t imu_sample = { 0 };
+    ASSERT_EQ(k4a_playback_get_next_imu_sample(handle, &imu_sample), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_TRUE(validate_imu_sample(imu_sample, 1150));
+
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, playback_imu_batch_test)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    // Read the whole IMU stream in batches of about one camera frame, across block boundaries.
+    std::vector<k4a_imu_sample_t> samples(33);
+    size_t total_count = 0;
+    size_t sample_count = 0;
+    uint64_t imu_timestamp = 1150;
+    k4a_stream_result_t stream_result;
+    while ((stream_result = k4a_playback_get_next_imu_samples(handle, samples.data(), samples.size(), &sample_count)) ==
+           K4A_STREAM_RESULT_SUCCEEDED)
+    {
+        ASSERT_GT(sample_count, (size_t)0);
+        ASSERT_LE(sample_count, samples.size());
+        for (size_t i = 0; i < sample_count; i++)
+        {
+            ASSERT_TRUE(validate_imu_sample(samples[i], imu_timestamp));
+            imu_timestamp += 1000;
+        }
+        total_count += sample_count;
+    }
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_EOF);
+    ASSERT_EQ(sample_count, (size_t)0);
+    ASSERT_EQ(total_count, (size_t)3333);
+
+    // The batch moves the playback position like reading the samples one at a time.
+    k4a_imu_sample_t imu_sample = { 0 };
+    ASSERT_EQ(k4a_playback_get_previous_imu_sample(handle, &imu_sample), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_TRUE(validate_imu_sample(imu_sample, imu_timestamp - 1000));
+
+    result = k4a_playback_seek_timestamp(handle, 10150, K4A_PLAYBACK_SEEK_BEGIN);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_next_imu_samples(handle, samples.data(), 5, &sample_count), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_EQ(sample_count, (size_t)5);
+    for (size_t i = 0; i < sample_count; i++)
+    {
+        ASSERT_TRUE(validate_imu_sample(samples[i], 10150 + i * 1000));
+    }
+    ASSERT_EQ(k4a_playback_get_next_imu_sample(handle, &imu_sample), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_TRUE(validate_imu_sample(imu_sample, 15150));
+
+    k4a_playback_close(handle);
+}
+
 TEST_F(playback_ut, open_start_offset_file)
 {
     k4a_playback_t handle = NULL;
@@ -987,6 +1103,40 @@ TEST_F(playback_ut, open_depth_only_file)
     k4a_playback_close(handle);
 }
 
+TEST_F(playback_ut, open_depth_rvl_file)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_depth_rvl.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(config.depth_mode, K4A_DEPTH_MODE_NFOV_UNBINNED);
+    ASSERT_TRUE(config.depth_track_enabled);
+    ASSERT_TRUE(config.ir_track_enabled);
+
+    uint64_t timestamps[3] = { 0, 0, 0 };
+    uint64_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+
+    // RVL compressed images must decode to exactly the images that were recorded.
+    k4a_capture_t capture = NULL;
+    for (size_t i = 0; i < test_frame_count; i++)
+    {
+        k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(
+            capture, timestamps, config.color_format, config.color_resolution, config.depth_mode));
+        k4a_capture_release(capture);
+
+        timestamps[1] += timestamp_delta;
+        timestamps[2] += timestamp_delta;
+    }
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_EOF);
+
+    k4a_playback_close(handle);
+}
+
 TEST_F(playback_ut, open_bgra_color_file)
 {
     k4a_playback_t handle = NULL;
@@ -1022,6 +1172,985 @@ TEST_F(playback_ut, open_bgra_color_file)
     k4a_playback_close(handle);
 }
 
+TEST_F(playback_ut, open_bgra_mjpg_file)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_bgra_mjpg.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    // Color encoded while recording is indistinguishable from a recording of an MJPG color camera.
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(config.color_format, K4A_IMAGE_FORMAT_COLOR_MJPG);
+    ASSERT_EQ(config.color_resolution, K4A_COLOR_RESOLUTION_1080P);
+    ASSERT_TRUE(config.color_track_enabled);
+    ASSERT_FALSE(config.depth_track_enabled);
+
+    char color_mode[32];
+    size_t color_mode_size = sizeof(color_mode);
+    k4a_buffer_result_t buffer_result = k4a_playback_get_tag(handle, "K4A_COLOR_MODE", color_mode, &color_mode_size);
+    ASSERT_EQ(buffer_result, K4A_BUFFER_RESULT_SUCCEEDED);
+    ASSERT_STREQ(color_mode, "MJPG_1080P");
+
+    result = k4a_playback_set_color_conversion(handle, K4A_IMAGE_FORMAT_COLOR_BGRA32);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    uint64_t timestamp_usec = 0;
+    uint64_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+
+    // JPEG is lossy, so only the image layout and timestamps are checked.
+    k4a_capture_t capture = NULL;
+    for (size_t i = 0; i < test_frame_count; i++)
+    {
+        k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+
+        k4a_image_t color_image = k4a_capture_get_color_image(capture);
+        ASSERT_NE(color_image, nullptr);
+        ASSERT_EQ(k4a_image_get_format(color_image), K4A_IMAGE_FORMAT_COLOR_BGRA32);
+        ASSERT_EQ(k4a_image_get_width_pixels(color_image), 1920);
+        ASSERT_EQ(k4a_image_get_height_pixels(color_image), 1080);
+        ASSERT_EQ(k4a_image_get_device_timestamp_usec(color_image), timestamp_usec);
+        k4a_image_release(color_image);
+        k4a_capture_release(capture);
+
+        timestamp_usec += timestamp_delta;
+    }
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_EOF);
+
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, mjpg_decode_ahead_test)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_bgra_mjpg.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    // Decode the first frames on this thread to compare against the frames decoded in the background.
+    const size_t frame_count = 10;
+    const int width = 1920;
+    const int height = 1080;
+    std::vector<std::vector<uint8_t>> expected_frames;
+    tjhandle decoder = tjInitDecompress();
+    ASSERT_NE(decoder, nullptr);
+    k4a_capture_t capture = NULL;
+    for (size_t i = 0; i < frame_count; i++)
+    {
+        k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        k4a_image_t color_image = k4a_capture_get_color_image(capture);
+        ASSERT_NE(color_image, nullptr);
+        ASSERT_EQ(k4a_image_get_format(color_image), K4A_IMAGE_FORMAT_COLOR_MJPG);
+
+        std::vector<uint8_t> frame((size_t)(width * height * 4));
+        ASSERT_EQ(tjDecompress2(decoder,
+                                k4a_image_get_buffer(color_image),
+                                (unsigned long)k4a_image_get_size(color_image),
+                                frame.data(),
+                                width,
+                                0, // pitch
+                                height,
+                                TJPF_BGRA,
+                                TJFLAG_FASTDCT | TJFLAG_FASTUPSAMPLE),
+                  0);
+        expected_frames.push_back(std::move(frame));
+        k4a_image_release(color_image);
+        k4a_capture_release(capture);
+    }
+    (void)tjDestroy(decoder);
+
+    result = k4a_playback_set_color_conversion(handle, K4A_IMAGE_FORMAT_COLOR_BGRA32);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    result = k4a_playback_seek_timestamp(handle, 0, K4A_PLAYBACK_SEEK_BEGIN);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    // Read forward, then back to the start, so frames are decoded ahead in both directions.
+    std::vector<size_t> frame_order;
+    for (size_t i = 0; i < frame_count; i++)
+    {
+        frame_order.push_back(i);
+    }
+    for (size_t i = frame_count - 1; i > 0; i--)
+    {
+        frame_order.push_back(i - 1);
+    }
+    for (size_t n = 0; n < frame_order.size(); n++)
+    {
+        size_t i = frame_order[n];
+        k4a_stream_result_t stream_result = n < frame_count ? k4a_playback_get_next_capture(handle, &capture) :
+                                                              k4a_playback_get_previous_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+
+        k4a_image_t color_image = k4a_capture_get_color_image(capture);
+        ASSERT_NE(color_image, nullptr);
+        ASSERT_EQ(k4a_image_get_format(color_image), K4A_IMAGE_FORMAT_COLOR_BGRA32);
+        ASSERT_EQ(k4a_image_get_size(color_image), expected_frames[i].size());
+        ASSERT_EQ(memcmp(k4a_image_get_buffer(color_image), expected_frames[i].data(), expected_frames[i].size()), 0)
+            << "Frame " << i << " does not match";
+        k4a_image_release(color_image);
+        k4a_capture_release(capture);
+    }
+
+    // Switching back to MJPG stops decoding.
+    result = k4a_playback_set_color_conversion(handle, K4A_IMAGE_FORMAT_COLOR_MJPG);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+    k4a_image_t color_image = k4a_capture_get_color_image(capture);
+    ASSERT_NE(color_image, nullptr);
+    ASSERT_EQ(k4a_image_get_format(color_image), K4A_IMAGE_FORMAT_COLOR_MJPG);
+    k4a_image_release(color_image);
+    k4a_capture_release(capture);
+
+    // Closing with frames still being decoded should not block or leak.
+    result = k4a_playback_set_color_conversion(handle, K4A_IMAGE_FORMAT_COLOR_BGRA32);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+    k4a_capture_release(capture);
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, playback_read_ahead_test)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    ASSERT_EQ(k4a_playback_set_read_ahead(NULL, 2, K4A_PLAYBACK_READ_AHEAD_FOLLOW), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_playback_set_read_ahead(handle, 65, K4A_PLAYBACK_READ_AHEAD_FOLLOW), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_playback_set_read_ahead(handle, 2, (k4a_playback_read_ahead_direction_t)-1), K4A_RESULT_FAILED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    uint64_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+
+    // The same captures should be read regardless of the read-ahead settings.
+    struct
+    {
+        size_t cluster_count;
+        k4a_playback_read_ahead_direction_t direction;
+    } settings[] = { { 0, K4A_PLAYBACK_READ_AHEAD_FOLLOW },
+                     { 1, K4A_PLAYBACK_READ_AHEAD_FOLLOW },
+                     { 64, K4A_PLAYBACK_READ_AHEAD_FOLLOW },
+                     { 8, K4A_PLAYBACK_READ_AHEAD_FORWARD },
+                     { 8, K4A_PLAYBACK_READ_AHEAD_BACKWARD } };
+    k4a_capture_t capture = NULL;
+    for (size_t s = 0; s < arraysize(settings); s++)
+    {
+        result = k4a_playback_set_read_ahead(handle, settings[s].cluster_count, settings[s].direction);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+        result = k4a_playback_seek_timestamp(handle, 0, K4A_PLAYBACK_SEEK_BEGIN);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        uint64_t timestamps[3] = { 0, 1000, 1000 };
+        for (size_t i = 0; i < test_frame_count; i++)
+        {
+            k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+            ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+            ASSERT_TRUE(validate_test_capture(capture,
+                                              timestamps,
+                                              config.color_format,
+                                              config.color_resolution,
+                                              config.depth_mode));
+            k4a_capture_release(capture);
+            timestamps[0] += timestamp_delta;
+            timestamps[1] += timestamp_delta;
+            timestamps[2] += timestamp_delta;
+        }
+        ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_EOF);
+
+        // Read back to the start of the recording.
+        for (size_t i = 0; i < test_frame_count; i++)
+        {
+            timestamps[0] -= timestamp_delta;
+            timestamps[1] -= timestamp_delta;
+            timestamps[2] -= timestamp_delta;
+            k4a_stream_result_t stream_result = k4a_playback_get_previous_capture(handle, &capture);
+            ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+            ASSERT_TRUE(validate_test_capture(capture,
+                                              timestamps,
+                                              config.color_format,
+                                              config.color_resolution,
+                                              config.depth_mode));
+            k4a_capture_release(capture);
+        }
+        ASSERT_EQ(k4a_playback_get_previous_capture(handle, &capture), K4A_STREAM_RESULT_EOF);
+    }
+
+    // Closing while the prefetch thread is still reading should not block or crash.
+    result = k4a_playback_set_read_ahead(handle, 64, K4A_PLAYBACK_READ_AHEAD_FORWARD);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, playback_cache_test)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_playback_cache_stats_t stats = { 0 };
+    ASSERT_EQ(k4a_playback_get_cache_stats(NULL, &stats), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_playback_get_cache_stats(handle, NULL), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_playback_set_cache_size(NULL, 0), K4A_RESULT_FAILED);
+
+    ASSERT_EQ(k4a_playback_get_cache_stats(handle, &stats), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(stats.capacity_bytes, (uint64_t)64 * 1024 * 1024);
+    ASSERT_EQ(stats.evictions, 0u);
+
+    // Disable read-ahead so only the clusters read below are loaded.
+    ASSERT_EQ(k4a_playback_set_read_ahead(handle, 0, K4A_PLAYBACK_READ_AHEAD_FOLLOW), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_set_cache_size(handle, (uint64_t)1024 * 1024 * 1024), K4A_RESULT_SUCCEEDED);
+
+    k4a_capture_t capture = NULL;
+    for (size_t i = 0; i < 10; i++)
+    {
+        ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+        k4a_capture_release(capture);
+    }
+    k4a_playback_cache_stats_t first_read = { 0 };
+    ASSERT_EQ(k4a_playback_get_cache_stats(handle, &first_read), K4A_RESULT_SUCCEEDED);
+    ASSERT_GT(first_read.misses, 0u);
+    ASSERT_GT(first_read.size_bytes, 0u);
+
+    // Reading the same captures again should be served from the cache.
+    ASSERT_EQ(k4a_playback_seek_timestamp(handle, 0, K4A_PLAYBACK_SEEK_BEGIN), K4A_RESULT_SUCCEEDED);
+    for (size_t i = 0; i < 10; i++)
+    {
+        ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+        k4a_capture_release(capture);
+    }
+    k4a_playback_cache_stats_t second_read = { 0 };
+    ASSERT_EQ(k4a_playback_get_cache_stats(handle, &second_read), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(second_read.misses, first_read.misses);
+    ASSERT_GT(second_read.hits, first_read.hits);
+    ASSERT_EQ(second_read.evictions, 0u);
+
+    // Shrinking the cache evicts the least recently used clusters.
+    uint64_t capacity = second_read.size_bytes / 2;
+    ASSERT_EQ(k4a_playback_set_cache_size(handle, capacity), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_cache_stats(handle, &stats), K4A_RESULT_SUCCEEDED);
+    ASSERT_GT(stats.evictions, 0u);
+    ASSERT_LE(stats.size_bytes, capacity);
+    ASSERT_EQ(stats.capacity_bytes, capacity);
+
+    // With the cache disabled, the earlier clusters have to be read from disk again.
+    ASSERT_EQ(k4a_playback_set_cache_size(handle, 0), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_cache_stats(handle, &stats), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(stats.size_bytes, 0u);
+    ASSERT_EQ(k4a_playback_seek_timestamp(handle, 0, K4A_PLAYBACK_SEEK_BEGIN), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+    k4a_capture_release(capture);
+    k4a_playback_cache_stats_t third_read = { 0 };
+    ASSERT_EQ(k4a_playback_get_cache_stats(handle, &third_read), K4A_RESULT_SUCCEEDED);
+    ASSERT_GT(third_read.misses, stats.misses);
+    ASSERT_EQ(third_read.size_bytes, 0u);
+
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, capture_outlives_playback_handle)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_capture_t capture = NULL;
+    k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+    k4a_playback_close(handle);
+
+    // Images may reference the recording file in place, they need to stay valid after the file is closed.
+    uint64_t timestamps[3] = { 0, 1000, 1000 };
+    ASSERT_TRUE(
+        validate_test_capture(capture, timestamps, config.color_format, config.color_resolution, config.depth_mode));
+
+    // Image buffers are writable without modifying the recording.
+    k4a_image_t color_image = k4a_capture_get_color_image(capture);
+    ASSERT_NE(color_image, nullptr);
+    uint8_t *color_buffer = k4a_image_get_buffer(color_image);
+    ASSERT_NE(color_buffer, nullptr);
+    memset(color_buffer, 0, k4a_image_get_size(color_image));
+    k4a_image_release(color_image);
+    k4a_capture_release(capture);
+
+    result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    stream_result = k4a_playback_get_next_capture(handle, &capture);
+    ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_TRUE(
+        validate_test_capture(capture, timestamps, config.color_format, config.color_resolution, config.depth_mode));
+    k4a_capture_release(capture);
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, image_buffer_reuse_test)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    uint64_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+
+    // Hold more captures than there are pooled buffers, then read them again once their buffers have been released.
+    const size_t capture_count = 20;
+    for (size_t pass = 0; pass < 2; pass++)
+    {
+        result = k4a_playback_seek_timestamp(handle, 0, K4A_PLAYBACK_SEEK_BEGIN);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        std::vector<k4a_capture_t> captures;
+        for (size_t i = 0; i < capture_count; i++)
+        {
+            k4a_capture_t capture = NULL;
+            ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+            captures.push_back(capture);
+        }
+
+        uint64_t timestamps[3] = { 0, 1000, 1000 };
+        for (k4a_capture_t capture : captures)
+        {
+            ASSERT_TRUE(validate_test_capture(capture,
+                                              timestamps,
+                                              config.color_format,
+                                              config.color_resolution,
+                                              config.depth_mode));
+            k4a_capture_release(capture);
+            timestamps[0] += timestamp_delta;
+            timestamps[1] += timestamp_delta;
+            timestamps[2] += timestamp_delta;
+        }
+    }
+
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, playback_track_enabled_test)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    uint64_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+
+    ASSERT_EQ(k4a_playback_set_track_enabled(handle, "NOT_A_TRACK", false), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_playback_set_track_enabled(handle, NULL, false), K4A_RESULT_FAILED);
+
+    // Disabled tracks are left out of the captures, the remaining tracks should be unaffected.
+    ASSERT_EQ(k4a_playback_set_track_enabled(handle, "COLOR", false), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_set_track_enabled(handle, "IMU", false), K4A_RESULT_SUCCEEDED);
+
+    uint64_t timestamps[3] = { 0, 1000, 1000 };
+    k4a_capture_t capture = NULL;
+    for (size_t i = 0; i < 10; i++)
+    {
+        ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          K4A_COLOR_RESOLUTION_OFF,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+        timestamps[0] += timestamp_delta;
+        timestamps[1] += timestamp_delta;
+        timestamps[2] += timestamp_delta;
+    }
+
+    k4a_imu_sample_t imu_sample = { 0 };
+    ASSERT_EQ(k4a_playback_get_next_imu_sample(handle, &imu_sample), K4A_STREAM_RESULT_EOF);
+
+    // Enabling a track again keeps the playback position, color images are included starting with the next capture.
+    ASSERT_EQ(k4a_playback_set_track_enabled(handle, "COLOR", true), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_set_track_enabled(handle, "IMU", true), K4A_RESULT_SUCCEEDED);
+
+    for (size_t i = 0; i < 10; i++)
+    {
+        ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+        timestamps[0] += timestamp_delta;
+        timestamps[1] += timestamp_delta;
+        timestamps[2] += timestamp_delta;
+    }
+
+    // Reading backwards returns the color images of the captures that were read while the track was disabled.
+    timestamps[0] -= timestamp_delta;
+    timestamps[1] -= timestamp_delta;
+    timestamps[2] -= timestamp_delta;
+    for (size_t i = 0; i < 19; i++)
+    {
+        timestamps[0] -= timestamp_delta;
+        timestamps[1] -= timestamp_delta;
+        timestamps[2] -= timestamp_delta;
+        ASSERT_EQ(k4a_playback_get_previous_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+    }
+    ASSERT_EQ(k4a_playback_get_previous_capture(handle, &capture), K4A_STREAM_RESULT_EOF);
+
+    // The IMU track was never read, so it starts at the last seek position.
+    ASSERT_EQ(k4a_playback_get_next_imu_sample(handle, &imu_sample), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_TRUE(validate_imu_sample(imu_sample, 1150));
+
+    k4a_playback_close(handle);
+}
+
+TEST_F(playback_ut, playback_range_test)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    // Read the whole recording sequentially as a reference.
+    std::vector<uint64_t> depth_timestamps;
+    std::vector<uint64_t> imu_timestamps;
+    k4a_capture_t capture = NULL;
+    while (k4a_playback_get_next_capture(handle, &capture) == K4A_STREAM_RESULT_SUCCEEDED)
+    {
+        k4a_image_t depth_image = k4a_capture_get_depth_image(capture);
+        if (depth_image != NULL)
+        {
+            depth_timestamps.push_back(k4a_image_get_device_timestamp_usec(depth_image));
+            k4a_image_release(depth_image);
+        }
+        k4a_capture_release(capture);
+    }
+    k4a_imu_sample_t imu_sample = { 0 };
+    while (k4a_playback_get_next_imu_sample(handle, &imu_sample) == K4A_STREAM_RESULT_SUCCEEDED)
+    {
+        imu_timestamps.push_back(imu_sample.acc_timestamp_usec);
+    }
+    ASSERT_EQ(depth_timestamps.size(), (size_t)test_frame_count);
+
+    k4a_playback_t range_handle = NULL;
+    ASSERT_EQ(k4a_playback_open_range(handle, 0, 0, &range_handle), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_playback_open_range(handle, 4, 4, &range_handle), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_playback_open_range(handle, 0, 100000, &range_handle), K4A_RESULT_FAILED);
+
+    // Each range is read on its own thread, together they should return every block exactly once.
+    const size_t range_count = 4;
+    k4a_playback_t ranges[range_count] = {};
+    for (size_t i = 0; i < range_count; i++)
+    {
+        ASSERT_EQ(k4a_playback_open_range(handle, i, range_count, &ranges[i]), K4A_RESULT_SUCCEEDED);
+    }
+    k4a_playback_close(handle);
+
+    std::vector<uint64_t> range_depth_timestamps[range_count];
+    std::vector<uint64_t> range_imu_timestamps[range_count];
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < range_count; i++)
+    {
+        threads.emplace_back([&, i]() {
+            k4a_capture_t range_capture = NULL;
+            while (k4a_playback_get_next_capture(ranges[i], &range_capture) == K4A_STREAM_RESULT_SUCCEEDED)
+            {
+                k4a_image_t depth_image = k4a_capture_get_depth_image(range_capture);
+                if (depth_image != NULL)
+                {
+                    range_depth_timestamps[i].push_back(k4a_image_get_device_timestamp_usec(depth_image));
+                    k4a_image_release(depth_image);
+                }
+                k4a_capture_release(range_capture);
+            }
+            k4a_imu_sample_t range_imu_sample = { 0 };
+            while (k4a_playback_get_next_imu_sample(ranges[i], &range_imu_sample) == K4A_STREAM_RESULT_SUCCEEDED)
+            {
+                range_imu_timestamps[i].push_back(range_imu_sample.acc_timestamp_usec);
+            }
+        });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    std::vector<uint64_t> all_depth_timestamps;
+    std::vector<uint64_t> all_imu_timestamps;
+    for (size_t i = 0; i < range_count; i++)
+    {
+        ASSERT_FALSE(range_depth_timestamps[i].empty());
+        all_depth_timestamps.insert(all_depth_timestamps.end(),
+                                    range_depth_timestamps[i].begin(),
+                                    range_depth_timestamps[i].end());
+        all_imu_timestamps.insert(all_imu_timestamps.end(),
+                                  range_imu_timestamps[i].begin(),
+                                  range_imu_timestamps[i].end());
+    }
+    ASSERT_EQ(all_depth_timestamps, depth_timestamps);
+    ASSERT_EQ(all_imu_timestamps, imu_timestamps);
+
+    // Seeking before the start of a range moves to its first cluster, and the previous range ends before it.
+    ASSERT_EQ(k4a_playback_seek_timestamp(ranges[1], 0, K4A_PLAYBACK_SEEK_BEGIN), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_get_previous_capture(ranges[1], &capture), K4A_STREAM_RESULT_EOF);
+    ASSERT_EQ(k4a_playback_get_next_capture(ranges[1], &capture), K4A_STREAM_RESULT_SUCCEEDED);
+    k4a_image_t depth_image = k4a_capture_get_depth_image(capture);
+    ASSERT_NE(depth_image, nullptr);
+    ASSERT_EQ(k4a_image_get_device_timestamp_usec(depth_image), range_depth_timestamps[1].front());
+    k4a_image_release(depth_image);
+    k4a_capture_release(capture);
+
+    for (size_t i = 0; i < range_count; i++)
+    {
+        k4a_playback_close(ranges[i]);
+    }
+}
+
+TEST_F(playback_ut, playback_group_test)
+{
+    k4a_playback_group_t group = NULL;
+    const char *missing_paths[] = { "record_test_full.mkv", "not_a_recording.mkv" };
+    ASSERT_EQ(k4a_playback_group_open(missing_paths, arraysize(missing_paths), &group), K4A_RESULT_FAILED);
+    ASSERT_EQ(group, nullptr);
+
+    // The subordinate recording starts 10ms after the master, which is its subordinate delay. Both first captures
+    // should have the same sync timestamp, and ties are returned in the order the recordings were opened.
+    const char *paths[] = { "record_test_sub.mkv", "record_test_full.mkv" };
+    ASSERT_EQ(k4a_playback_group_open(paths, arraysize(paths), &group), K4A_RESULT_SUCCEEDED);
+    ASSERT_NE(k4a_playback_group_get_playback(group, 1), nullptr);
+    ASSERT_EQ(k4a_playback_group_get_playback(group, 2), nullptr);
+
+    k4a_record_configuration_t config;
+    ASSERT_EQ(k4a_playback_get_record_configuration(k4a_playback_group_get_playback(group, 1), &config),
+              K4A_RESULT_SUCCEEDED);
+    uint64_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+
+    k4a_capture_t capture = NULL;
+    size_t index = SIZE_MAX;
+    ASSERT_EQ(k4a_playback_group_get_next_capture(group, &capture, &index), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_EQ(index, (size_t)0);
+    uint64_t sub_timestamps[3] = { 10000, 10000, 10000 };
+    ASSERT_TRUE(validate_test_capture(capture,
+                                      sub_timestamps,
+                                      config.color_format,
+                                      config.color_resolution,
+                                      config.depth_mode));
+    k4a_capture_release(capture);
+
+    uint64_t timestamps[3] = { 0, 1000, 1000 };
+    for (size_t i = 0; i < test_frame_count; i++)
+    {
+        ASSERT_EQ(k4a_playback_group_get_next_capture(group, &capture, &index), K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_EQ(index, (size_t)1);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+        timestamps[0] += timestamp_delta;
+        timestamps[1] += timestamp_delta;
+        timestamps[2] += timestamp_delta;
+    }
+    ASSERT_EQ(k4a_playback_group_get_next_capture(group, &capture, NULL), K4A_STREAM_RESULT_EOF);
+    ASSERT_EQ(capture, nullptr);
+
+    k4a_playback_group_close(group);
+}
+
+TEST_F(playback_ut, passthrough_image_lifetime_test)
+{
+    k4a_playback_t handle = NULL;
+    k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    k4a_record_configuration_t config;
+    result = k4a_playback_get_record_configuration(handle, &config);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+    // Unconverted color images reference the cluster they were read from, which must stay valid after the cache is
+    // emptied and the playback is closed.
+    k4a_capture_t capture = NULL;
+    ASSERT_EQ(k4a_playback_get_next_capture(handle, &capture), K4A_STREAM_RESULT_SUCCEEDED);
+    result = k4a_playback_set_cache_size(handle, 0);
+    ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+    k4a_playback_close(handle);
+
+    uint64_t timestamps[3] = { 0, 1000, 1000 };
+    ASSERT_TRUE(validate_test_capture(capture,
+                                      timestamps,
+                                      config.color_format,
+                                      config.color_resolution,
+                                      config.depth_mode));
+    k4a_capture_release(capture);
+}
+
+TEST_F(playback_ut, playback_block_index_test)
+{
+    const char *index_path = "record_test_full.mkv.k4aidx";
+    std::vector<char> index_data;
+    { // The index should be written next to the recording when it is closed.
+        std::ifstream index_file(index_path, std::ios::binary);
+        ASSERT_TRUE(index_file.good());
+        index_data.assign(std::istreambuf_iterator<char>(index_file), std::istreambuf_iterator<char>());
+        ASSERT_GT(index_data.size(), (size_t)32);
+    }
+
+    // Seeking should give the same results with a valid, corrupt, or missing index.
+    for (int pass = 0; pass < 3; pass++)
+    {
+        if (pass == 1)
+        {
+            std::vector<char> corrupt_data = index_data;
+            corrupt_data.back() ^= 0x5A;
+            std::ofstream index_file(index_path, std::ios::binary | std::ios::trunc);
+            index_file.write(corrupt_data.data(), (std::streamsize)corrupt_data.size());
+        }
+        else if (pass == 2)
+        {
+            ASSERT_EQ(std::remove(index_path), 0);
+        }
+
+        k4a_playback_t handle = NULL;
+        k4a_result_t result = k4a_playback_open("record_test_full.mkv", &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        k4a_record_configuration_t config;
+        result = k4a_playback_get_record_configuration(handle, &config);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+        uint64_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(config.camera_fps));
+
+        result = k4a_playback_seek_timestamp(handle, (int64_t)(timestamp_delta * 50 - 250), K4A_PLAYBACK_SEEK_BEGIN);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        k4a_capture_t capture = NULL;
+        uint64_t timestamps[3] = { timestamp_delta * 50, timestamp_delta * 50 + 1000, timestamp_delta * 50 + 1000 };
+        k4a_stream_result_t stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+
+        k4a_imu_sample_t imu_sample = { 0 };
+        stream_result = k4a_playback_get_next_imu_sample(handle, &imu_sample);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_imu_sample(imu_sample, 1667150));
+
+        timestamps[0] -= timestamp_delta;
+        timestamps[1] -= timestamp_delta;
+        timestamps[2] -= timestamp_delta;
+        stream_result = k4a_playback_get_previous_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_test_capture(capture,
+                                          timestamps,
+                                          config.color_format,
+                                          config.color_resolution,
+                                          config.depth_mode));
+        k4a_capture_release(capture);
+
+        result = k4a_playback_seek_timestamp(handle, 0, K4A_PLAYBACK_SEEK_END);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+        stream_result = k4a_playback_get_next_capture(handle, &capture);
+        ASSERT_EQ(stream_result, K4A_STREAM_RESULT_EOF);
+
+        k4a_playback_close(handle);
+    }
+
+    { // The recording has Cue entries, so a missing index is not regenerated when opening it.
+        std::ifstream index_file(index_path, std::ios::binary);
+        ASSERT_FALSE(index_file.good());
+    }
+
+    // Restore the index for the remaining tests.
+    std::ofstream index_file(index_path, std::ios::binary | std::ios::trunc);
+    index_file.write(index_data.data(), (std::streamsize)index_data.size());
+}
+
+TEST_F(playback_ut, playback_block_index_rewritten_test)
+{
+    const char *recording_path = "record_test_index_rewritten.mkv";
+    std::string index_path = std::string(recording_path) + ".k4aidx";
+    uint8_t block[] = "block index test";
+
+    {
+        k4a_record_t handle = NULL;
+        ASSERT_EQ(k4a_record_create(recording_path, NULL, K4A_DEVICE_CONFIG_INIT_DISABLE_ALL, &handle),
+                  K4A_RESULT_SUCCEEDED);
+        k4a_record_subtitle_settings_t subtitle_settings = {};
+        ASSERT_EQ(k4a_record_add_custom_subtitle_track(handle,
+                                                       "CUSTOM_TRACK",
+                                                       "S_K4A/CUSTOM_TRACK",
+                                                       nullptr,
+                                                       0,
+                                                       &subtitle_settings),
+                  K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(k4a_record_write_header(handle), K4A_RESULT_SUCCEEDED);
+        for (size_t i = 0; i < test_frame_count; i++)
+        {
+            ASSERT_EQ(k4a_record_write_custom_track_data(handle,
+                                                         "CUSTOM_TRACK",
+                                                         1000000 + i * test_timestamp_delta_usec,
+                                                         block,
+                                                         sizeof(block)),
+                      K4A_RESULT_SUCCEEDED);
+        }
+        k4a_record_close(handle);
+    }
+
+    std::vector<char> index_data;
+    {
+        std::ifstream index_file(index_path, std::ios::binary);
+        ASSERT_TRUE(index_file.good());
+        index_data.assign(std::istreambuf_iterator<char>(index_file), std::istreambuf_iterator<char>());
+    }
+
+    { // Rewrite the last block in place, the recording keeps its size and its block offsets.
+        std::vector<char> recording_data;
+        {
+            std::ifstream recording_file(recording_path, std::ios::binary);
+            recording_data.assign(std::istreambuf_iterator<char>(recording_file), std::istreambuf_iterator<char>());
+        }
+        auto last_block = std::find_end(recording_data.begin(), recording_data.end(), block, block + sizeof(block));
+        ASSERT_NE(last_block, recording_data.end());
+        *last_block = 'B';
+
+        std::ofstream recording_file(recording_path, std::ios::binary | std::ios::trunc);
+        recording_file.write(recording_data.data(), (std::streamsize)recording_data.size());
+    }
+
+    // The old index matches the size of the recording, but must not be used for it.
+    k4a_playback_t handle = NULL;
+    ASSERT_EQ(k4a_playback_open(recording_path, &handle), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_seek_timestamp(handle, 0, K4A_PLAYBACK_SEEK_END), K4A_RESULT_SUCCEEDED);
+    k4a_playback_data_block_t data_block = NULL;
+    ASSERT_EQ(k4a_playback_get_previous_data_block(handle, "CUSTOM_TRACK", &data_block), K4A_STREAM_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_playback_data_block_get_buffer_size(data_block), sizeof(block));
+    ASSERT_EQ(k4a_playback_data_block_get_buffer(data_block)[0], 'B');
+    k4a_playback_data_block_release(data_block);
+    k4a_playback_close(handle);
+
+    { // The index was rebuilt for the rewritten recording.
+        std::ifstream index_file(index_path, std::ios::binary);
+        ASSERT_TRUE(index_file.good());
+        std::vector<char> rebuilt_data((std::istreambuf_iterator<char>(index_file)), std::istreambuf_iterator<char>());
+        ASSERT_NE(rebuilt_data, index_data);
+    }
+
+    (void)std::remove(index_path.c_str());
+    (void)std::remove(recording_path);
+}
+
+// Virtual devices replay the recording named by K4A_VIRTUAL_DEVICE. It is cleared after each test, even one that
+// fails, so later tests don't open a virtual device by accident.
+class virtual_device_ut : public ::testing::Test
+{
+protected:
+    void SetUp() override {}
+    void TearDown() override
+    {
+        SETENV("K4A_VIRTUAL_DEVICE", "");
+    }
+};
+
+TEST_F(virtual_device_ut, virtual_device_test)
+{
+    // The recording replaces any real device while K4A_VIRTUAL_DEVICE is set
+    SETENV("K4A_VIRTUAL_DEVICE", "record_test_full.mkv");
+    ASSERT_EQ(k4a_device_get_installed_count(), 1u);
+
+    k4a_device_t device = NULL;
+    ASSERT_EQ(k4a_device_open(1, &device), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_device_open(0, &device), K4A_RESULT_SUCCEEDED);
+
+    k4a_device_configuration_t config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+    config.color_format = K4A_IMAGE_FORMAT_COLOR_MJPG;
+    config.color_resolution = K4A_COLOR_RESOLUTION_1080P;
+    config.depth_mode = K4A_DEPTH_MODE_NFOV_UNBINNED;
+    config.camera_fps = K4A_FRAMES_PER_SECOND_30;
+    ASSERT_EQ(k4a_device_start_cameras(device, &config), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_device_start_imu(device), K4A_RESULT_SUCCEEDED);
+
+    // Captures arrive through k4a_device_get_capture() at the recorded frame rate
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint32_t timestamp_delta = HZ_TO_PERIOD_US(test_camera_fps);
+    for (uint64_t i = 0; i < 5; i++)
+    {
+        k4a_capture_t capture = NULL;
+        ASSERT_EQ(k4a_device_get_capture(device, &capture, 1000), K4A_WAIT_RESULT_SUCCEEDED);
+        k4a_image_t color = k4a_capture_get_color_image(capture);
+        k4a_image_t depth = k4a_capture_get_depth_image(capture);
+        ASSERT_NE(color, nullptr);
+        ASSERT_NE(depth, nullptr);
+        ASSERT_EQ(k4a_image_get_device_timestamp_usec(color), i * timestamp_delta);
+        ASSERT_EQ(k4a_image_get_device_timestamp_usec(depth), i * timestamp_delta + 1000);
+        k4a_image_release(color);
+        k4a_image_release(depth);
+        k4a_capture_release(capture);
+    }
+    ASSERT_GE(std::chrono::steady_clock::now() - start, std::chrono::microseconds(4 * timestamp_delta));
+
+    // Recorded IMU samples are returned with the timestamps they were recorded with
+    for (uint64_t i = 0; i < 10; i++)
+    {
+        k4a_imu_sample_t imu_sample = { 0 };
+        ASSERT_EQ(k4a_device_get_imu_sample(device, &imu_sample, 1000), K4A_WAIT_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_imu_sample(imu_sample, 1150 + i * 1000));
+    }
+
+    k4a_device_stop_imu(device);
+    k4a_device_stop_cameras(device);
+    k4a_device_close(device);
+
+    // A recording with a single capture is replayed in a loop, with timestamps that keep increasing
+    SETENV("K4A_VIRTUAL_DEVICE", "record_test_sub.mkv");
+    ASSERT_EQ(k4a_device_open(0, &device), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_device_start_cameras(device, &config), K4A_RESULT_SUCCEEDED);
+
+    uint64_t timestamps[3] = { 0 };
+    for (size_t i = 0; i < COUNTOF(timestamps); i++)
+    {
+        k4a_capture_t capture = NULL;
+        ASSERT_EQ(k4a_device_get_capture(device, &capture, 1000), K4A_WAIT_RESULT_SUCCEEDED);
+        k4a_image_t color = k4a_capture_get_color_image(capture);
+        ASSERT_NE(color, nullptr);
+        timestamps[i] = k4a_image_get_device_timestamp_usec(color);
+        k4a_image_release(color);
+        k4a_capture_release(capture);
+    }
+    ASSERT_EQ(timestamps[0], 10000u);
+    ASSERT_GT(timestamps[1], timestamps[0]);
+    ASSERT_EQ(timestamps[2] - timestamps[1], timestamps[1] - timestamps[0]);
+
+    k4a_device_stop_cameras(device);
+    k4a_device_close(device);
+}
+
+TEST_F(virtual_device_ut, virtual_device_imu_offset_test)
+{
+    // Recorded samples are already paired, so a gyroscope timestamp that differs from the accelerometer timestamp
+    // must not make the sample look unmatched
+    SETENV("K4A_VIRTUAL_DEVICE", "record_test_imu_offset.mkv");
+    k4a_device_t device = NULL;
+    ASSERT_EQ(k4a_device_open(0, &device), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_device_start_imu(device), K4A_RESULT_SUCCEEDED);
+
+    for (uint64_t i = 0; i < test_imu_offset_sample_count; i++)
+    {
+        k4a_imu_sample_t imu_sample = { 0 };
+        ASSERT_EQ(k4a_device_get_imu_sample(device, &imu_sample, 1000), K4A_WAIT_RESULT_SUCCEEDED);
+        ASSERT_TRUE(validate_imu_sample(imu_sample, 1150 + i * 1000, test_imu_gyro_delay_usec)) << "sample " << i;
+    }
+
+    k4a_device_stop_imu(device);
+    k4a_device_close(device);
+}
+
+typedef struct
+{
+    std::mutex lock;
+    std::condition_variable cv;
+    std::vector<uint64_t> timestamps;
+} capture_callback_context_t;
+
+// Returns the color timestamp of a capture and releases it
+static uint64_t release_capture_timestamp(k4a_capture_t capture_handle)
+{
+    k4a_image_t color = k4a_capture_get_color_image(capture_handle);
+    uint64_t timestamp_usec = color != NULL ? k4a_image_get_device_timestamp_usec(color) : UINT64_MAX;
+    k4a_image_release(color);
+    k4a_capture_release(capture_handle);
+    return timestamp_usec;
+}
+
+static void record_capture_timestamp(k4a_capture_t capture_handle, void *context)
+{
+    capture_callback_context_t *callback_context = (capture_callback_context_t *)context;
+    uint64_t timestamp_usec = release_capture_timestamp(capture_handle);
+    {
+        std::lock_guard<std::mutex> lock(callback_context->lock);
+        callback_context->timestamps.push_back(timestamp_usec);
+    }
+    callback_context->cv.notify_all();
+}
+
+static bool wait_for_callback_captures(capture_callback_context_t *callback_context, size_t count)
+{
+    std::unique_lock<std::mutex> lock(callback_context->lock);
+    return callback_context->cv.wait_for(lock, std::chrono::seconds(5), [&]() {
+        return callback_context->timestamps.size() >= count;
+    });
+}
+
+TEST_F(virtual_device_ut, virtual_device_capture_callback_test)
+{
+    SETENV("K4A_VIRTUAL_DEVICE", "record_test_full.mkv");
+    k4a_device_t device = NULL;
+    ASSERT_EQ(k4a_device_open(0, &device), K4A_RESULT_SUCCEEDED);
+
+    k4a_device_configuration_t config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+    config.color_format = K4A_IMAGE_FORMAT_COLOR_MJPG;
+    config.color_resolution = K4A_COLOR_RESOLUTION_1080P;
+    config.depth_mode = K4A_DEPTH_MODE_NFOV_UNBINNED;
+    config.camera_fps = K4A_FRAMES_PER_SECOND_30;
+    capture_callback_context_t callback_context;
+    std::vector<uint64_t> queued_timestamps;
+    k4a_capture_t capture = NULL;
+
+    // Switch between the callback and the queue while the device is streaming
+    ASSERT_EQ(k4a_device_set_capture_callback(device, record_capture_timestamp, &callback_context),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_device_start_cameras(device, &config), K4A_RESULT_SUCCEEDED);
+    ASSERT_TRUE(wait_for_callback_captures(&callback_context, 10));
+
+    ASSERT_EQ(k4a_device_set_capture_callback(device, NULL, NULL), K4A_RESULT_SUCCEEDED);
+    for (size_t i = 0; i < 10; i++)
+    {
+        ASSERT_EQ(k4a_device_get_capture(device, &capture, 1000), K4A_WAIT_RESULT_SUCCEEDED);
+        queued_timestamps.push_back(release_capture_timestamp(capture));
+    }
+
+    // Captures queued before the callback is set again stay in the queue
+    ASSERT_EQ(k4a_device_set_capture_callback(device, record_capture_timestamp, &callback_context),
+              K4A_RESULT_SUCCEEDED);
+    while (k4a_device_get_capture(device, &capture, 0) == K4A_WAIT_RESULT_SUCCEEDED)
+    {
+        queued_timestamps.push_back(release_capture_timestamp(capture));
+    }
+    size_t callback_count = 0;
+    {
+        std::lock_guard<std::mutex> lock(callback_context.lock);
+        callback_count = callback_context.timestamps.size();
+    }
+    ASSERT_TRUE(wait_for_callback_captures(&callback_context, callback_count + 10));
+
+    ASSERT_EQ(k4a_device_set_capture_callback(device, NULL, NULL), K4A_RESULT_SUCCEEDED);
+    k4a_device_stop_cameras(device);
+    k4a_device_close(device);
+
+    // Each capture from the start of the recording reached either the callback or the queue, and only one of them
+    std::vector<uint64_t> timestamps = callback_context.timestamps;
+    timestamps.insert(timestamps.end(), queued_timestamps.begin(), queued_timestamps.end());
+    std::sort(timestamps.begin(), timestamps.end());
+    uint32_t timestamp_delta = HZ_TO_PERIOD_US(test_camera_fps);
+    for (size_t i = 0; i < timestamps.size(); i++)
+    {
+        ASSERT_EQ(timestamps[i], i * timestamp_delta) << "capture " << i;
+    }
+}
+
 int main(int argc, char **argv)
 {
     k4a_unittest_init();
@@ -0,0 +1,448 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+#include <k4a/k4a.h>
+#include <k4ainternal/common.h>
+#include <k4ainternal/matroska_common.h>
+
+#include "test_helpers.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// Module being tested
+#include <k4arecord/record.h>
+
+using namespace testing;
+
+static uint32_t g_capture_rate = 30;
+static uint32_t g_device_count = 1;
+static uint32_t g_duration_sec = 5;
+
+// Interval used to sample the amount of data that has been submitted but not yet written to disk.
+static const std::chrono::milliseconds queue_sample_period(100);
+
+struct record_perf_config_t
+{
+    k4a_image_format_t color_format;
+    k4a_color_resolution_t color_resolution;
+    k4a_depth_mode_t depth_mode;
+};
+
+static void PrintTo(const record_perf_config_t &config, std::ostream *os)
+{
+    *os << (config.color_resolution == K4A_COLOR_RESOLUTION_OFF ? "" : format_names[config.color_format]) << " "
+        << resolution_names[config.color_resolution] << " " << depth_names[config.depth_mode];
+}
+
+// Recordings are written through k4a_record_create_with_io() so the benchmark can see how much of the submitted data
+// has reached the file. Only the writer thread calls these, but file_size is read by the sampling thread.
+struct perf_sink_t
+{
+    FILE *file = NULL;
+    uint64_t position = 0;
+    std::atomic<uint64_t> file_size{ 0 };
+};
+
+static size_t perf_sink_write(void *context, const void *buffer, size_t buffer_size)
+{
+    perf_sink_t *sink = static_cast<perf_sink_t *>(context);
+    size_t written = fwrite(buffer, 1, buffer_size, sink->file);
+    sink->position += written;
+    if (sink->position > sink->file_size)
+    {
+        sink->file_size = sink->position;
+    }
+    return written;
+}
+
+static bool perf_sink_seek(void *context, uint64_t offset)
+{
+    perf_sink_t *sink = static_cast<perf_sink_t *>(context);
+#ifdef _WIN32
+    bool result = _fseeki64(sink->file, (int64_t)offset, SEEK_SET) == 0;
+#else
+    bool result = fseeko(sink->file, (off_t)offset, SEEK_SET) == 0;
+#endif
+    if (result)
+    {
+        sink->position = offset;
+    }
+    return result;
+}
+
+static void perf_sink_close(void *context)
+{
+    perf_sink_t *sink = static_cast<perf_sink_t *>(context);
+    fclose(sink->file);
+    sink->file = NULL;
+}
+
+// A full size image buffer that is shared by every synthetic capture. Creating the captures costs next to nothing, so
+// the measured CPU time is spent in the recorder.
+struct synthetic_image_t
+{
+    k4a_image_format_t format;
+    int width;
+    int height;
+    int stride;
+    std::vector<uint8_t> buffer;
+};
+
+static bool create_synthetic_image(k4a_image_format_t format, uint32_t width, uint32_t height, synthetic_image_t *image)
+{
+    image->format = format;
+    image->width = (int)width;
+    image->height = (int)height;
+
+    size_t buffer_size = 0;
+    switch (format)
+    {
+    case K4A_IMAGE_FORMAT_COLOR_MJPG:
+        // Compressed frames from the color camera are typically around 2 bits per pixel.
+        image->stride = 0;
+        buffer_size = width * height / 4;
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_NV12:
+        image->stride = (int)width;
+        buffer_size = width * height * 3 / 2;
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_YUY2:
+    case K4A_IMAGE_FORMAT_DEPTH16:
+    case K4A_IMAGE_FORMAT_IR16:
+        image->stride = (int)width * 2;
+        buffer_size = width * height * 2;
+        break;
+    case K4A_IMAGE_FORMAT_COLOR_BGRA32:
+        image->stride = (int)width * 4;
+        buffer_size = width * height * 4;
+        break;
+    default:
+        return false;
+    }
+
+    image->buffer.resize(buffer_size);
+    for (size_t i = 0; i < buffer_size; i++)
+    {
+        image->buffer[i] = (uint8_t)(i * 31 + i / 4096);
+    }
+    return true;
+}
+
+static k4a_image_t create_image(synthetic_image_t &image, uint64_t timestamp_usec)
+{
+    k4a_image_t handle = NULL;
+    k4a_result_t result = k4a_image_create_from_buffer(image.format,
+                                                       image.width,
+                                                       image.height,
+                                                       image.stride,
+                                                       image.buffer.data(),
+                                                       image.buffer.size(),
+                                                       [](void *buffer, void *context) {
+                                                           (void)buffer;
+                                                           (void)context;
+                                                       },
+                                                       NULL,
+                                                       &handle);
+    if (K4A_FAILED(result))
+    {
+        return NULL;
+    }
+    k4a_image_set_device_timestamp_usec(handle, timestamp_usec);
+    return handle;
+}
+
+struct device_result_t
+{
+    uint64_t frames_written = 0;
+    uint64_t frames_failed = 0;
+    uint64_t frames_late = 0; // Captures that could not be submitted within one frame period of their due time.
+    std::atomic<uint64_t> bytes_submitted{ 0 }; // Read by the sampling thread while recording.
+    bool recording_failed = false;
+};
+
+static void record_device(size_t device_index,
+                          const record_perf_config_t &test_config,
+                          perf_sink_t *sink,
+                          device_result_t *result)
+{
+    k4a_device_configuration_t device_config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
+    device_config.color_format = test_config.color_format;
+    device_config.color_resolution = test_config.color_resolution;
+    device_config.depth_mode = test_config.depth_mode;
+    device_config.camera_fps = g_capture_rate <= 5 ? K4A_FRAMES_PER_SECOND_5 :
+                                                     (g_capture_rate <= 15 ? K4A_FRAMES_PER_SECOND_15 :
+                                                                             K4A_FRAMES_PER_SECOND_30);
+
+    synthetic_image_t images[3] = {};
+    bool enabled[3] = { false, false, false };
+    uint32_t width = 0, height = 0;
+    if (test_config.color_resolution != K4A_COLOR_RESOLUTION_OFF &&
+        k4a_convert_resolution_to_width_height(test_config.color_resolution, &width, &height))
+    {
+        enabled[0] = create_synthetic_image(test_config.color_format, width, height, &images[0]);
+    }
+    if (test_config.depth_mode != K4A_DEPTH_MODE_OFF &&
+        k4a_convert_depth_mode_to_width_height(test_config.depth_mode, &width, &height))
+    {
+        enabled[1] = test_config.depth_mode != K4A_DEPTH_MODE_PASSIVE_IR &&
+                     create_synthetic_image(K4A_IMAGE_FORMAT_DEPTH16, width, height, &images[1]);
+        enabled[2] = create_synthetic_image(K4A_IMAGE_FORMAT_IR16, width, height, &images[2]);
+    }
+
+    std::ostringstream path;
+    path << "record_perf_" << device_index << ".mkv";
+    sink->file = fopen(path.str().c_str(), "wb");
+    if (sink->file == NULL)
+    {
+        result->recording_failed = true;
+        return;
+    }
+
+    k4a_record_io_callbacks_t io = {};
+    io.write = perf_sink_write;
+    io.seek = perf_sink_seek;
+    io.close = perf_sink_close;
+    io.context = sink;
+
+    // The sink is closed through io.close, including when the recording can't be created.
+    k4a_record_t handle = NULL;
+    if (K4A_FAILED(k4a_record_create_with_io(&io, NULL, device_config, &handle)))
+    {
+        result->recording_failed = true;
+        return;
+    }
+    if (K4A_FAILED(k4a_record_write_header(handle)))
+    {
+        result->recording_failed = true;
+        k4a_record_close(handle);
+        return;
+    }
+
+    auto period = std::chrono::microseconds(1000000 / g_capture_rate);
+    uint64_t frame_count = (uint64_t)g_duration_sec * g_capture_rate;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t frame = 0; frame < frame_count; frame++)
+    {
+        auto due = start + period * frame;
+        std::this_thread::sleep_until(due);
+        if (std::chrono::steady_clock::now() > due + period)
+        {
+            // A real device would have dropped this capture while the recorder was blocked.
+            result->frames_late++;
+        }
+
+        k4a_capture_t capture = NULL;
+        if (K4A_FAILED(k4a_capture_create(&capture)))
+        {
+            result->frames_failed++;
+            continue;
+        }
+
+        uint64_t timestamp_usec = (uint64_t)(period.count() * (int64_t)frame);
+        size_t capture_size = 0;
+        for (size_t i = 0; i < arraysize(images); i++)
+        {
+            if (!enabled[i])
+            {
+                continue;
+            }
+            k4a_image_t image = create_image(images[i], timestamp_usec);
+            if (image == NULL)
+            {
+                continue;
+            }
+            capture_size += images[i].buffer.size();
+            if (i == 0)
+            {
+                k4a_capture_set_color_image(capture, image);
+            }
+            else if (i == 1)
+            {
+                k4a_capture_set_depth_image(capture, image);
+            }
+            else
+            {
+                k4a_capture_set_ir_image(capture, image);
+            }
+            k4a_image_release(image);
+        }
+
+        if (K4A_SUCCEEDED(k4a_record_write_capture(handle, capture)))
+        {
+            result->frames_written++;
+            result->bytes_submitted += capture_size;
+        }
+        else
+        {
+            result->frames_failed++;
+        }
+        k4a_capture_release(capture);
+    }
+
+    if (K4A_FAILED(k4a_record_flush(handle)))
+    {
+        result->recording_failed = true;
+    }
+    k4a_record_close(handle);
+}
+
+class record_perf : public ::testing::TestWithParam<record_perf_config_t>
+{
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+TEST_P(record_perf, write_throughput)
+{
+    record_perf_config_t config = GetParam();
+
+    std::vector<perf_sink_t> sinks(g_device_count);
+    std::vector<device_result_t> results(g_device_count);
+    std::vector<std::thread> threads;
+
+    // Largest amount of submitted data not yet in the file, in bytes, for each sample period.
+    std::vector<uint64_t> queue_depth;
+    std::atomic<bool> recording(true);
+
+    std::clock_t cpu_start = std::clock();
+    auto wall_start = std::chrono::steady_clock::now();
+
+    std::thread sampler([&]() {
+        while (recording)
+        {
+            uint64_t depth = 0;
+            for (size_t i = 0; i < g_device_count; i++)
+            {
+                uint64_t submitted = results[i].bytes_submitted;
+                uint64_t written = sinks[i].file_size;
+                depth += submitted > written ? submitted - written : 0;
+            }
+            queue_depth.push_back(depth);
+            std::this_thread::sleep_for(queue_sample_period);
+        }
+    });
+
+    for (size_t i = 0; i < g_device_count; i++)
+    {
+        threads.emplace_back(record_device, i, std::cref(config), &sinks[i], &results[i]);
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    auto wall_time = std::chrono::steady_clock::now() - wall_start;
+    std::clock_t cpu_time = std::clock() - cpu_start;
+    recording = false;
+    sampler.join();
+
+    uint64_t frames_written = 0, frames_failed = 0, frames_late = 0, bytes_written = 0;
+    for (size_t i = 0; i < g_device_count; i++)
+    {
+        ASSERT_FALSE(results[i].recording_failed) << "Recording " << i << " failed";
+        frames_written += results[i].frames_written;
+        frames_failed += results[i].frames_failed;
+        frames_late += results[i].frames_late;
+        bytes_written += sinks[i].file_size;
+
+        std::ostringstream path;
+        path << "record_perf_" << i << ".mkv";
+        ASSERT_EQ(std::remove(path.str().c_str()), 0);
+    }
+
+    double wall_sec = std::chrono::duration<double>(wall_time).count();
+    double cpu_ms = 1000.0 * (double)cpu_time / CLOCKS_PER_SEC;
+    std::cout << "    Devices: " << g_device_count << ", rate: " << g_capture_rate
+              << " fps, duration: " << g_duration_sec << " s" << std::endl;
+    std::cout << "    Sustained write: " << ((double)bytes_written / (1024 * 1024) / wall_sec) << " MB/s ("
+              << bytes_written << " bytes in " << wall_sec << " s)" << std::endl;
+    std::cout << "    CPU per frame: " << (frames_written > 0 ? cpu_ms / (double)frames_written : 0.0) << " ms"
+              << std::endl;
+    std::cout << "    Frames written: " << frames_written << ", failed: " << frames_failed << ", late: " << frames_late
+              << std::endl;
+
+    std::cout << "    Queue depth (MB, every " << queue_sample_period.count() << " ms):";
+    uint64_t max_depth = 0;
+    for (size_t i = 0; i < queue_depth.size(); i++)
+    {
+        max_depth = std::max(max_depth, queue_depth[i]);
+        std::cout << (i % 20 == 0 ? "\n       " : "") << " " << (queue_depth[i] / (1024 * 1024));
+    }
+    std::cout << std::endl << "    Max queue depth: " << (max_depth / (1024 * 1024)) << " MB" << std::endl;
+
+    ASSERT_EQ(frames_failed, 0u);
+}
+
+INSTANTIATE_TEST_CASE_P(
+    record_perf,
+    record_perf,
+    ValuesIn(std::vector<record_perf_config_t>{
+        { K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_COLOR_RESOLUTION_2160P, K4A_DEPTH_MODE_OFF },
+        { K4A_IMAGE_FORMAT_COLOR_NV12, K4A_COLOR_RESOLUTION_720P, K4A_DEPTH_MODE_OFF },
+        { K4A_IMAGE_FORMAT_COLOR_YUY2, K4A_COLOR_RESOLUTION_720P, K4A_DEPTH_MODE_OFF },
+        { K4A_IMAGE_FORMAT_COLOR_BGRA32, K4A_COLOR_RESOLUTION_1080P, K4A_DEPTH_MODE_OFF },
+        { K4A_IMAGE_FORMAT_COLOR_BGRA32, K4A_COLOR_RESOLUTION_2160P, K4A_DEPTH_MODE_OFF },
+        { K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_COLOR_RESOLUTION_OFF, K4A_DEPTH_MODE_NFOV_2X2BINNED },
+        { K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_COLOR_RESOLUTION_OFF, K4A_DEPTH_MODE_NFOV_UNBINNED },
+        { K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_COLOR_RESOLUTION_OFF, K4A_DEPTH_MODE_WFOV_2X2BINNED },
+        { K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_COLOR_RESOLUTION_OFF, K4A_DEPTH_MODE_WFOV_UNBINNED },
+        { K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_COLOR_RESOLUTION_OFF, K4A_DEPTH_MODE_PASSIVE_IR },
+        { K4A_IMAGE_FORMAT_COLOR_MJPG, K4A_COLOR_RESOLUTION_2160P, K4A_DEPTH_MODE_NFOV_UNBINNED },
+        { K4A_IMAGE_FORMAT_COLOR_NV12, K4A_COLOR_RESOLUTION_720P, K4A_DEPTH_MODE_WFOV_2X2BINNED },
+        { K4A_IMAGE_FORMAT_COLOR_YUY2, K4A_COLOR_RESOLUTION_720P, K4A_DEPTH_MODE_NFOV_UNBINNED },
+        { K4A_IMAGE_FORMAT_COLOR_BGRA32, K4A_COLOR_RESOLUTION_1080P, K4A_DEPTH_MODE_WFOV_UNBINNED },
+        { K4A_IMAGE_FORMAT_COLOR_BGRA32, K4A_COLOR_RESOLUTION_2160P, K4A_DEPTH_MODE_NFOV_UNBINNED },
+    }));
+
+static bool parse_uint_option(int argc, char **argv, int *i, const char *name, uint32_t *value)
+{
+    if (strcmp(argv[*i], name) != 0)
+    {
+        return false;
+    }
+    if (*i + 1 >= argc)
+    {
+        std::cout << "Missing value for " << name << std::endl;
+        exit(1);
+    }
+    unsigned long parsed = strtoul(argv[++*i], NULL, 10);
+    if (parsed == 0 || parsed > UINT32_MAX)
+    {
+        std::cout << "Invalid value for " << name << ": " << argv[*i] << std::endl;
+        exit(1);
+    }
+    *value = (uint32_t)parsed;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    k4a_unittest_init();
+
+    ::testing::InitGoogleTest(&argc, argv);
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!parse_uint_option(argc, argv, &i, "--rate", &g_capture_rate) &&
+            !parse_uint_option(argc, argv, &i, "--devices", &g_device_count) &&
+            !parse_uint_option(argc, argv, &i, "--duration", &g_duration_sec))
+        {
+            std::cout << "Usage: record_perf <gtest options> [--rate <captures per second>] [--devices <count>] "
+                         "[--duration <seconds>]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    int results = RUN_ALL_TESTS();
+    k4a_unittest_deinit();
+    return results;
+}
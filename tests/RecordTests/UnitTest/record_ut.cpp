@@ -6,9 +6,15 @@
 
 // Module being tested
 #include <k4ainternal/matroska_write.h>
+#include <k4ainternal/rvl_codec.h>
 #include <k4arecord/record.h>
+#include <k4arecord/playback.h>
 #include <k4a/k4a.h>
 
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
 #include <ebml/MemIOCallback.h>
 #include <matroska/KaxSegment.h>
 
@@ -132,6 +138,294 @@ TEST_F(record_ut, new_cluster_out_of_order)
     ASSERT_EQ(context->pending_clusters.size(), 3u);
 }
 
+struct memory_sink_t
+{
+    std::vector<uint8_t> data;
+    size_t position = 0;
+    int close_count = 0;
+};
+
+static size_t memory_sink_write(void *context, const void *buffer, size_t buffer_size)
+{
+    memory_sink_t *sink = static_cast<memory_sink_t *>(context);
+    if (sink->position + buffer_size > sink->data.size())
+    {
+        sink->data.resize(sink->position + buffer_size);
+    }
+    memcpy(sink->data.data() + sink->position, buffer, buffer_size);
+    sink->position += buffer_size;
+    return buffer_size;
+}
+
+static bool memory_sink_seek(void *context, uint64_t offset)
+{
+    memory_sink_t *sink = static_cast<memory_sink_t *>(context);
+    if (offset > sink->data.size())
+    {
+        return false;
+    }
+    sink->position = (size_t)offset;
+    return true;
+}
+
+static void memory_sink_close(void *context)
+{
+    static_cast<memory_sink_t *>(context)->close_count++;
+}
+
+static void write_custom_io_recording(memory_sink_t *sink, bool seekable, size_t imu_sample_count)
+{
+    k4a_record_io_callbacks_t io = {};
+    io.write = memory_sink_write;
+    io.seek = seekable ? memory_sink_seek : NULL;
+    io.close = memory_sink_close;
+    io.context = sink;
+
+    k4a_record_t handle = NULL;
+    ASSERT_EQ(k4a_record_create_with_io(&io, NULL, K4A_DEVICE_CONFIG_INIT_DISABLE_ALL, &handle),
+              K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_record_add_imu_track(handle), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_record_write_header(handle), K4A_RESULT_SUCCEEDED);
+
+    for (size_t i = 0; i < imu_sample_count; i++)
+    {
+        k4a_imu_sample_t sample = {};
+        sample.acc_timestamp_usec = 1000 + i * 1000;
+        sample.gyro_timestamp_usec = 1000 + i * 1000;
+        sample.acc_sample.v[0] = (float)i;
+        sample.gyro_sample.v[0] = (float)i;
+        ASSERT_EQ(k4a_record_write_imu_sample(handle, sample), K4A_RESULT_SUCCEEDED);
+    }
+
+    ASSERT_EQ(k4a_record_flush(handle), K4A_RESULT_SUCCEEDED);
+    k4a_record_close(handle);
+}
+
+static void verify_custom_io_recording(const memory_sink_t &sink, size_t imu_sample_count)
+{
+    ASSERT_EQ(sink.close_count, 1);
+    ASSERT_GT(sink.data.size(), 4u);
+    // EBML magic number
+    ASSERT_EQ(sink.data[0], 0x1A);
+    ASSERT_EQ(sink.data[1], 0x45);
+    ASSERT_EQ(sink.data[2], 0xDF);
+    ASSERT_EQ(sink.data[3], 0xA3);
+
+    const char *path = "record_test_custom_io.mkv";
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(sink.data.data()), (std::streamsize)sink.data.size());
+    }
+
+    k4a_playback_t playback = NULL;
+    ASSERT_EQ(k4a_playback_open(path, &playback), K4A_RESULT_SUCCEEDED);
+
+    size_t count = 0;
+    k4a_imu_sample_t sample = {};
+    while (k4a_playback_get_next_imu_sample(playback, &sample) == K4A_STREAM_RESULT_SUCCEEDED)
+    {
+        ASSERT_EQ(sample.acc_sample.v[0], (float)count);
+        count++;
+    }
+    ASSERT_EQ(count, imu_sample_count);
+
+    k4a_playback_close(playback);
+    ASSERT_EQ(std::remove(path), 0);
+    (void)std::remove((std::string(path) + BLOCK_INDEX_FILE_SUFFIX).c_str());
+}
+
+TEST_F(record_ut, custom_io_seekable)
+{
+    memory_sink_t sink;
+    write_custom_io_recording(&sink, true, 100);
+    verify_custom_io_recording(sink, 100);
+}
+
+TEST_F(record_ut, custom_io_append_only)
+{
+    memory_sink_t sink;
+    write_custom_io_recording(&sink, false, 100);
+
+    // Append-only outputs must only ever grow at the end.
+    ASSERT_EQ(sink.position, sink.data.size());
+
+    // The segment size can't be updated at the end, so it is written as unknown
+    const uint8_t segment_head[] = { 0x18, 0x53, 0x80, 0x67, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+    auto segment = std::search(sink.data.begin(), sink.data.end(), segment_head, segment_head + sizeof(segment_head));
+    ASSERT_NE(segment, sink.data.end());
+
+    verify_custom_io_recording(sink, 100);
+}
+
+TEST_F(record_ut, custom_io_invalid_args)
+{
+    k4a_record_io_callbacks_t io = {};
+    k4a_record_t handle = NULL;
+    ASSERT_EQ(k4a_record_create_with_io(NULL, NULL, K4A_DEVICE_CONFIG_INIT_DISABLE_ALL, &handle), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_record_create_with_io(&io, NULL, K4A_DEVICE_CONFIG_INIT_DISABLE_ALL, &handle), K4A_RESULT_FAILED);
+    ASSERT_EQ(handle, nullptr);
+}
+
+TEST_F(record_ut, write_batched_track_data)
+{
+    const char *path = "record_test_batched.mkv";
+    const size_t sample_count = 1000;
+    const size_t batch_size = 64;
+
+    k4a_record_t handle = NULL;
+    ASSERT_EQ(k4a_record_create(path, NULL, K4A_DEVICE_CONFIG_INIT_DISABLE_ALL, &handle), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_record_add_imu_track(handle), K4A_RESULT_SUCCEEDED);
+    k4a_record_subtitle_settings_t settings = { true };
+    ASSERT_EQ(k4a_record_add_custom_subtitle_track(handle, "CUSTOM", "S_K4A/TEST", NULL, 0, &settings),
+              K4A_RESULT_SUCCEEDED);
+
+    // Batched writes are only allowed after the header.
+    k4a_imu_sample_t samples[batch_size] = {};
+    ASSERT_EQ(k4a_record_write_imu_samples(handle, samples, batch_size), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_record_write_header(handle), K4A_RESULT_SUCCEEDED);
+
+    ASSERT_EQ(k4a_record_write_imu_samples(handle, NULL, 1), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_record_write_imu_samples(handle, NULL, 0), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_record_write_custom_track_data_blocks(handle, "IMU", NULL, 0), K4A_RESULT_FAILED);
+
+    uint32_t values[batch_size] = {};
+    k4a_record_custom_data_block_t blocks[batch_size] = {};
+    for (size_t start = 0; start < sample_count; start += batch_size)
+    {
+        size_t count = std::min(batch_size, sample_count - start);
+        for (size_t i = 0; i < count; i++)
+        {
+            uint64_t timestamp_usec = 1000 + (start + i) * 625; // 1.6 kHz
+            samples[i].acc_timestamp_usec = timestamp_usec;
+            samples[i].gyro_timestamp_usec = timestamp_usec;
+            samples[i].acc_sample.v[0] = (float)(start + i);
+
+            values[i] = (uint32_t)(start + i);
+            blocks[i].device_timestamp_usec = timestamp_usec;
+            blocks[i].buffer = reinterpret_cast<const uint8_t *>(&values[i]);
+            blocks[i].buffer_size = sizeof(values[i]);
+        }
+        ASSERT_EQ(k4a_record_write_imu_samples(handle, samples, count), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(k4a_record_write_custom_track_data_blocks(handle, "CUSTOM", blocks, count), K4A_RESULT_SUCCEEDED);
+    }
+
+    ASSERT_EQ(k4a_record_flush(handle), K4A_RESULT_SUCCEEDED);
+    k4a_record_close(handle);
+
+    k4a_playback_t playback = NULL;
+    ASSERT_EQ(k4a_playback_open(path, &playback), K4A_RESULT_SUCCEEDED);
+
+    size_t count = 0;
+    k4a_imu_sample_t sample = {};
+    while (k4a_playback_get_next_imu_sample(playback, &sample) == K4A_STREAM_RESULT_SUCCEEDED)
+    {
+        ASSERT_EQ(sample.acc_sample.v[0], (float)count);
+        count++;
+    }
+    ASSERT_EQ(count, sample_count);
+
+    count = 0;
+    k4a_playback_data_block_t block = NULL;
+    while (k4a_playback_get_next_data_block(playback, "CUSTOM", &block) == K4A_STREAM_RESULT_SUCCEEDED)
+    {
+        ASSERT_EQ(k4a_playback_data_block_get_buffer_size(block), sizeof(uint32_t));
+        uint32_t value = 0;
+        memcpy(&value, k4a_playback_data_block_get_buffer(block), sizeof(value));
+        ASSERT_EQ(value, (uint32_t)count);
+        k4a_playback_data_block_release(block);
+        count++;
+    }
+    ASSERT_EQ(count, sample_count);
+
+    k4a_playback_close(playback);
+    ASSERT_EQ(std::remove(path), 0);
+    (void)std::remove((std::string(path) + BLOCK_INDEX_FILE_SUFFIX).c_str());
+}
+
+TEST_F(record_ut, rvl_codec_round_trip)
+{
+    // Simulate a depth image: invalid (zero) pixels at the edges and smooth values in the middle.
+    const size_t width = 640, height = 576;
+    std::vector<uint16_t> pixels(width * height);
+    for (size_t y = 0; y < height; y++)
+    {
+        for (size_t x = 0; x < width; x++)
+        {
+            bool invalid = x < 40 || x >= width - 40 || (x * 7 + y * 13) % 101 == 0;
+            pixels[y * width + x] = invalid ? 0 : (uint16_t)(1000 + x / 4 + y / 8);
+        }
+    }
+    pixels[1] = UINT16_MAX;
+    pixels[2] = 1;
+
+    std::vector<uint8_t> compressed;
+    ASSERT_TRUE(rvl_encode_image(pixels.data(), pixels.size(), compressed));
+    ASSERT_LT(compressed.size(), pixels.size() * sizeof(uint16_t) / 3);
+
+    std::vector<uint16_t> decoded(pixels.size(), 0xBEEF);
+    ASSERT_TRUE(rvl_decode_image(compressed.data(), compressed.size(), decoded.data(), decoded.size()));
+    ASSERT_EQ(decoded, pixels);
+
+    // Images smaller than the band count and empty images are valid.
+    for (size_t count = 0; count <= RVL_BAND_COUNT + 1; count++)
+    {
+        ASSERT_TRUE(rvl_encode_image(pixels.data(), count, compressed));
+        ASSERT_TRUE(rvl_decode_image(compressed.data(), compressed.size(), decoded.data(), count));
+        ASSERT_TRUE(std::equal(pixels.begin(), pixels.begin() + (ptrdiff_t)count, decoded.begin()));
+    }
+}
+
+TEST_F(record_ut, rvl_codec_invalid_data)
+{
+    std::vector<uint16_t> pixels(1000);
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        pixels[i] = (uint16_t)(i % 3 == 0 ? 0 : i * 31);
+    }
+
+    std::vector<uint8_t> compressed;
+    ASSERT_TRUE(rvl_encode_image(pixels.data(), pixels.size(), compressed));
+
+    std::vector<uint16_t> decoded(pixels.size());
+    ASSERT_FALSE(rvl_decode_image(compressed.data(), 0, decoded.data(), decoded.size()));
+    ASSERT_FALSE(rvl_decode_image(compressed.data(), compressed.size() / 2, decoded.data(), decoded.size()));
+    ASSERT_FALSE(rvl_decode_image(compressed.data(), compressed.size(), decoded.data(), decoded.size() + 1));
+
+    std::vector<uint8_t> bad_band_count = compressed;
+    bad_band_count[0] = RVL_BAND_COUNT + 1;
+    ASSERT_FALSE(rvl_decode_image(bad_band_count.data(), bad_band_count.size(), decoded.data(), decoded.size()));
+}
+
+TEST_F(record_ut, color_codec_invalid_args)
+{
+    k4a_device_configuration_t record_config = {};
+    record_config.color_format = K4A_IMAGE_FORMAT_COLOR_MJPG;
+    record_config.color_resolution = K4A_COLOR_RESOLUTION_1080P;
+    record_config.depth_mode = K4A_DEPTH_MODE_OFF;
+    record_config.camera_fps = K4A_FRAMES_PER_SECOND_30;
+
+    k4a_record_t handle = NULL;
+    ASSERT_EQ(k4a_record_create("record_test_color_codec.mkv", NULL, record_config, &handle), K4A_RESULT_SUCCEEDED);
+
+    // Only BGRA color can be encoded.
+    ASSERT_EQ(k4a_record_set_color_codec(handle, K4A_RECORD_COLOR_CODEC_MJPG, 90), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_record_set_color_codec(handle, K4A_RECORD_COLOR_CODEC_RAW, 0), K4A_RESULT_SUCCEEDED);
+    k4a_record_close(handle);
+
+    record_config.color_format = K4A_IMAGE_FORMAT_COLOR_BGRA32;
+    ASSERT_EQ(k4a_record_create("record_test_color_codec.mkv", NULL, record_config, &handle), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_record_set_color_codec(handle, K4A_RECORD_COLOR_CODEC_MJPG, 0), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_record_set_color_codec(handle, K4A_RECORD_COLOR_CODEC_MJPG, 101), K4A_RESULT_FAILED);
+    ASSERT_EQ(k4a_record_set_color_codec(handle, K4A_RECORD_COLOR_CODEC_MJPG, 90), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(k4a_record_write_header(handle), K4A_RESULT_SUCCEEDED);
+
+    // The codec can't be changed once the header is written.
+    ASSERT_EQ(k4a_record_set_color_codec(handle, K4A_RECORD_COLOR_CODEC_RAW, 0), K4A_RESULT_FAILED);
+    k4a_record_close(handle);
+
+    ASSERT_EQ(std::remove("record_test_color_codec.mkv"), 0);
+}
+
 // This test's goal is to fill up the write queue by saturating disk write.
 // It should trigger the write speed warning message in the logs.
 // Since this test is unlikely to complete, and needs to be manually run, it is disabled.
@@ -205,6 +499,7 @@ TEST_F(record_ut, DISABLED_bgra_color_max_disk_write)
     k4a_record_close(handle);
 
     ASSERT_EQ(std::remove("record_test_bgra_color.mkv"), 0);
+    (void)std::remove("record_test_bgra_color.mkv" BLOCK_INDEX_FILE_SUFFIX);
 }
 
 int main(int argc, char **argv)
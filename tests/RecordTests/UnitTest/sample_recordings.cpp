@@ -10,6 +10,49 @@
 
 using namespace testing;
 
+// create_test_capture() only allocates 8KB per image, but the color encoder needs a complete BGRA frame.
+static k4a_capture_t create_bgra_test_capture(uint64_t timestamp_us, k4a_color_resolution_t resolution)
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    if (!k4a_convert_resolution_to_width_height(resolution, &width, &height))
+    {
+        return NULL;
+    }
+
+    k4a_capture_t capture = NULL;
+    if (K4A_FAILED(k4a_capture_create(&capture)))
+    {
+        return NULL;
+    }
+
+    k4a_image_t image = NULL;
+    if (K4A_FAILED(k4a_image_create(K4A_IMAGE_FORMAT_COLOR_BGRA32, (int)width, (int)height, (int)width * 4, &image)))
+    {
+        k4a_capture_release(capture);
+        return NULL;
+    }
+
+    // A smooth gradient, so the frame compresses like a camera image.
+    uint8_t *buffer = k4a_image_get_buffer(image);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            uint8_t *pixel = buffer + (y * width + x) * 4;
+            pixel[0] = (uint8_t)(x * 255 / width);
+            pixel[1] = (uint8_t)(y * 255 / height);
+            pixel[2] = (uint8_t)(timestamp_us / 1000);
+            pixel[3] = 0xFF;
+        }
+    }
+    k4a_image_set_device_timestamp_usec(image, timestamp_us);
+
+    k4a_capture_set_color_image(capture, image);
+    k4a_image_release(image);
+    return capture;
+}
+
 void SampleRecordings::SetUp()
 {
     k4a_device_configuration_t record_config_empty = {};
@@ -311,6 +354,38 @@ void SampleRecordings::SetUp()
 
         k4a_record_close(handle);
     }
+    { // Create a recording file with RVL compressed depth and IR
+        k4a_record_t handle = NULL;
+        k4a_result_t result = k4a_record_create("record_test_depth_rvl.mkv", NULL, record_config_depth_only, &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_set_depth_codec(handle, K4A_RECORD_DEPTH_CODEC_RVL);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_write_header(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        uint64_t timestamps[3] = { 0, 0, 0 };
+        uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(record_config_depth_only.camera_fps));
+        for (size_t i = 0; i < test_frame_count; i++)
+        {
+            k4a_capture_t capture = create_test_capture(timestamps,
+                                                        record_config_depth_only.color_format,
+                                                        record_config_depth_only.color_resolution,
+                                                        record_config_depth_only.depth_mode);
+            result = k4a_record_write_capture(handle, capture);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+            k4a_capture_release(capture);
+
+            timestamps[1] += timestamp_delta;
+            timestamps[2] += timestamp_delta;
+        }
+
+        result = k4a_record_flush(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        k4a_record_close(handle);
+    }
     { // Create a recording file with BGRA color
         k4a_record_t handle = NULL;
         k4a_result_t result = k4a_record_create("record_test_bgra_color.mkv", NULL, record_config_bgra_color, &handle);
@@ -331,6 +406,58 @@ void SampleRecordings::SetUp()
         result = k4a_record_flush(handle);
         ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
 
+        k4a_record_close(handle);
+    }
+    { // Create a recording file with BGRA color encoded to MJPEG while recording
+        k4a_record_t handle = NULL;
+        k4a_result_t result = k4a_record_create("record_test_bgra_mjpg.mkv", NULL, record_config_bgra_color, &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_set_color_codec(handle, K4A_RECORD_COLOR_CODEC_MJPG, 90);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_write_header(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        uint64_t timestamp_usec = 0;
+        uint32_t timestamp_delta = HZ_TO_PERIOD_US(k4a_convert_fps_to_uint(record_config_bgra_color.camera_fps));
+        for (size_t i = 0; i < test_frame_count; i++)
+        {
+            k4a_capture_t capture = create_bgra_test_capture(timestamp_usec, record_config_bgra_color.color_resolution);
+            ASSERT_NE(capture, nullptr);
+            result = k4a_record_write_capture(handle, capture);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+            k4a_capture_release(capture);
+
+            timestamp_usec += timestamp_delta;
+        }
+
+        result = k4a_record_flush(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        k4a_record_close(handle);
+    }
+    { // Create an IMU only recording, with the gyroscope samples taken later than the accelerometer samples
+        k4a_record_t handle = NULL;
+        k4a_result_t result = k4a_record_create("record_test_imu_offset.mkv", NULL, record_config_empty, &handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_add_imu_track(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        result = k4a_record_write_header(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
+        for (uint64_t i = 0; i < test_imu_offset_sample_count; i++)
+        {
+            k4a_imu_sample_t imu_sample = create_test_imu_sample(1150 + i * 1000, test_imu_gyro_delay_usec);
+            result = k4a_record_write_imu_sample(handle, imu_sample);
+            ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+        }
+
+        result = k4a_record_flush(handle);
+        ASSERT_EQ(result, K4A_RESULT_SUCCEEDED);
+
         k4a_record_close(handle);
     }
 }
@@ -345,7 +472,24 @@ void SampleRecordings::TearDown()
     ASSERT_EQ(std::remove("record_test_offset.mkv"), 0);
     ASSERT_EQ(std::remove("record_test_color_only.mkv"), 0);
     ASSERT_EQ(std::remove("record_test_depth_only.mkv"), 0);
+    ASSERT_EQ(std::remove("record_test_depth_rvl.mkv"), 0);
     ASSERT_EQ(std::remove("record_test_bgra_color.mkv"), 0);
+    ASSERT_EQ(std::remove("record_test_bgra_mjpg.mkv"), 0);
+    ASSERT_EQ(std::remove("record_test_imu_offset.mkv"), 0);
+
+    // Recordings containing blocks also have an index file, see block_index.h
+    (void)std::remove("record_test_empty.mkv" BLOCK_INDEX_FILE_SUFFIX);
+    (void)std::remove("record_test_full.mkv" BLOCK_INDEX_FILE_SUFFIX);
+    (void)std::remove("record_test_delay.mkv" BLOCK_INDEX_FILE_SUFFIX);
+    (void)std::remove("record_test_skips.mkv" BLOCK_INDEX_FILE_SUFFIX);
+    (void)std::remove("record_test_sub.mkv" BLOCK_INDEX_FILE_SUFFIX);
+    (void)std::remove("record_test_offset.mkv" BLOCK_INDEX_FILE_SUFFIX);
+    (void)std::remove("record_test_color_only.mkv" BLOCK_INDEX_FILE_SUFFIX);
+    (void)std::remove("record_test_depth_only.mkv" BLOCK_INDEX_FILE_SUFFIX);
+    (void)std::remove("record_test_depth_rvl.mkv" BLOCK_INDEX_FILE_SUFFIX);
+    (void)std::remove("record_test_bgra_color.mkv" BLOCK_INDEX_FILE_SUFFIX);
+    (void)std::remove("record_test_bgra_mjpg.mkv" BLOCK_INDEX_FILE_SUFFIX);
+    (void)std::remove("record_test_imu_offset.mkv" BLOCK_INDEX_FILE_SUFFIX);
 }
 
 void CustomTrackRecordings::SetUp()
@@ -485,4 +629,5 @@ void CustomTrackRecordings::SetUp()
 void CustomTrackRecordings::TearDown()
 {
     ASSERT_EQ(std::remove("record_test_custom_track.mkv"), 0);
+    (void)std::remove("record_test_custom_track.mkv" BLOCK_INDEX_FILE_SUFFIX);
 }
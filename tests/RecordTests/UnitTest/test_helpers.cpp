@@ -252,12 +252,12 @@ bool validate_test_image(k4a_image_t image,
     return false;
 }
 
-k4a_imu_sample_t create_test_imu_sample(uint64_t timestamp_us)
+k4a_imu_sample_t create_test_imu_sample(uint64_t timestamp_us, uint64_t gyro_delay_us)
 {
     k4a_imu_sample_t sample = {};
     sample.acc_timestamp_usec = timestamp_us;
     sample.acc_sample = { { 1.0f, 2.0f, 3.0f } };
-    sample.gyro_timestamp_usec = timestamp_us;
+    sample.gyro_timestamp_usec = timestamp_us + gyro_delay_us;
     sample.gyro_sample = { { -1.0f, -2.0f, -3.0f } };
     return sample;
 }
@@ -267,10 +267,10 @@ k4a_imu_sample_t create_test_imu_sample(uint64_t timestamp_us)
 // 1.0, 2.0, and 3.0 are all exact float values, and no math is done. Equals is fine in this case.
 #pragma clang diagnostic ignored "-Wfloat-equal"
 #endif
-bool validate_imu_sample(k4a_imu_sample_t &imu_sample, uint64_t timestamp_us)
+bool validate_imu_sample(k4a_imu_sample_t &imu_sample, uint64_t timestamp_us, uint64_t gyro_delay_us)
 {
     VALIDATE_PARAMETER(imu_sample.acc_timestamp_usec, timestamp_us);
-    VALIDATE_PARAMETER(imu_sample.gyro_timestamp_usec, timestamp_us);
+    VALIDATE_PARAMETER(imu_sample.gyro_timestamp_usec, timestamp_us + gyro_delay_us);
     EXIT_IF_FALSE(imu_sample.acc_sample.v[0] == 1.0f);
     EXIT_IF_FALSE(imu_sample.acc_sample.v[1] == 2.0f);
     EXIT_IF_FALSE(imu_sample.acc_sample.v[2] == 3.0f);
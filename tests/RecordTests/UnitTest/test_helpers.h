@@ -30,6 +30,8 @@ static const uint32_t test_depth_height = 576;
 static const uint32_t test_camera_fps = 30;
 static const uint32_t test_timestamp_delta_usec = 33333;
 static const size_t test_frame_count = 100;
+static const uint64_t test_imu_offset_sample_count = 100; // IMU samples in record_test_imu_offset.mkv, 1ms apart
+static const uint64_t test_imu_gyro_delay_usec = 300;     // Gyroscope delay in record_test_imu_offset.mkv
 
 k4a_capture_t create_test_capture(uint64_t timestamp_us[3],
                                   k4a_image_format_t color_format,
@@ -50,8 +52,9 @@ bool validate_test_image(k4a_image_t image,
                          uint32_t height,
                          uint32_t stride);
 
-k4a_imu_sample_t create_test_imu_sample(uint64_t timestamp_us);
-bool validate_imu_sample(k4a_imu_sample_t &imu_sample, uint64_t timestamp_us);
+// The gyroscope sample is taken gyro_delay_us after the accelerometer sample
+k4a_imu_sample_t create_test_imu_sample(uint64_t timestamp_us, uint64_t gyro_delay_us = 0);
+bool validate_imu_sample(k4a_imu_sample_t &imu_sample, uint64_t timestamp_us, uint64_t gyro_delay_us = 0);
 bool validate_null_imu_sample(k4a_imu_sample_t &imu_sample);
 
 struct custom_track_test_data
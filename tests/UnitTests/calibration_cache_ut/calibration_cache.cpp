@@ -0,0 +1,141 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+
+#include <calibration_cache.h>
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define SETENV(env, value) _putenv_s(env, value)
+#else
+#define SETENV(env, value) setenv(env, value, 1)
+#endif
+
+int main(int argc, char **argv)
+{
+    return k4a_test_common_main(argc, argv);
+}
+
+// Entries are written to the working directory of the test
+#define CACHE_DIRECTORY "."
+#define SERIAL_NUMBER "CL8T1230001"
+#define FIRMWARE_VERSION "1.0.9"
+#define ENTRY_PATH "./" SERIAL_NUMBER "_" FIRMWARE_VERSION ".k4acal"
+
+class calibration_cache_ut : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        (void)remove(ENTRY_PATH);
+        m_calibration = "{\"CalibrationInformation\": {\"Cameras\": []}}";
+    }
+
+    void TearDown() override
+    {
+        (void)remove(ENTRY_PATH);
+    }
+
+    k4a_result_t write_entry()
+    {
+        return calibration_cache_write(CACHE_DIRECTORY,
+                                       SERIAL_NUMBER,
+                                       FIRMWARE_VERSION,
+                                       (const uint8_t *)m_calibration.data(),
+                                       m_calibration.size());
+    }
+
+    std::string m_calibration;
+};
+
+TEST_F(calibration_cache_ut, round_trip)
+{
+    std::vector<uint8_t> data(1024);
+    size_t data_size = data.size();
+    ASSERT_EQ(K4A_RESULT_FAILED,
+              calibration_cache_read(CACHE_DIRECTORY, SERIAL_NUMBER, FIRMWARE_VERSION, data.data(), &data_size));
+
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, write_entry());
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              calibration_cache_read(CACHE_DIRECTORY, SERIAL_NUMBER, FIRMWARE_VERSION, data.data(), &data_size));
+    ASSERT_EQ(m_calibration, std::string((const char *)data.data(), data_size));
+
+    // Writing again replaces the entry
+    m_calibration = "{}";
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, write_entry());
+    data_size = data.size();
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              calibration_cache_read(CACHE_DIRECTORY, SERIAL_NUMBER, FIRMWARE_VERSION, data.data(), &data_size));
+    ASSERT_EQ(m_calibration, std::string((const char *)data.data(), data_size));
+}
+
+TEST_F(calibration_cache_ut, other_firmware_version)
+{
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, write_entry());
+
+    std::vector<uint8_t> data(1024);
+    size_t data_size = data.size();
+    ASSERT_EQ(K4A_RESULT_FAILED,
+              calibration_cache_read(CACHE_DIRECTORY, SERIAL_NUMBER, "1.1.0", data.data(), &data_size));
+    ASSERT_EQ(K4A_RESULT_FAILED,
+              calibration_cache_read(CACHE_DIRECTORY, "CL8T1230002", FIRMWARE_VERSION, data.data(), &data_size));
+}
+
+TEST_F(calibration_cache_ut, buffer_too_small)
+{
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, write_entry());
+
+    std::vector<uint8_t> data(m_calibration.size() - 1);
+    size_t data_size = data.size();
+    ASSERT_EQ(K4A_RESULT_FAILED,
+              calibration_cache_read(CACHE_DIRECTORY, SERIAL_NUMBER, FIRMWARE_VERSION, data.data(), &data_size));
+    ASSERT_EQ(data.size(), data_size);
+}
+
+TEST_F(calibration_cache_ut, corrupted_entry)
+{
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED, write_entry());
+
+    // Flip one byte of the calibration, which is stored at the end of the entry
+    {
+        std::fstream file(ENTRY_PATH, std::ios::in | std::ios::out | std::ios::binary);
+        ASSERT_TRUE(file.is_open());
+        file.seekg(-1, std::ios::end);
+        char last = 0;
+        file.read(&last, 1);
+        file.seekp(-1, std::ios::end);
+        last = (char)(last ^ 0x01);
+        file.write(&last, 1);
+    }
+
+    std::vector<uint8_t> data(1024);
+    size_t data_size = data.size();
+    ASSERT_EQ(K4A_RESULT_FAILED,
+              calibration_cache_read(CACHE_DIRECTORY, SERIAL_NUMBER, FIRMWARE_VERSION, data.data(), &data_size));
+
+    // Truncated entries are rejected as well
+    {
+        std::ofstream file(ENTRY_PATH, std::ios::binary | std::ios::trunc);
+        file.write("K4ACAL1", 8);
+    }
+    ASSERT_EQ(K4A_RESULT_FAILED,
+              calibration_cache_read(CACHE_DIRECTORY, SERIAL_NUMBER, FIRMWARE_VERSION, data.data(), &data_size));
+}
+
+TEST_F(calibration_cache_ut, directory_from_environment)
+{
+    SETENV(CALIBRATION_CACHE_ENV_VAR, "");
+    ASSERT_EQ(NULL, calibration_cache_get_directory());
+
+    SETENV(CALIBRATION_CACHE_ENV_VAR, CACHE_DIRECTORY);
+    ASSERT_STREQ(CACHE_DIRECTORY, calibration_cache_get_directory());
+
+    SETENV(CALIBRATION_CACHE_ENV_VAR, "");
+}
@@ -0,0 +1,326 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+
+#include <frame_queue.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+    return k4a_test_common_main(argc, argv);
+}
+
+#define TEST_QUEUE_DEPTH 4
+
+// The queue never looks inside a capture, so the tests push numbered tokens instead of real captures
+#define TOKEN(n) ((k4a_capture_t)(uintptr_t)(n))
+#define TOKEN_VALUE(capture) ((uintptr_t)(capture))
+
+static std::atomic<uint32_t> g_released_count;
+static std::atomic<uintptr_t> g_last_released;
+
+static void token_release(k4a_capture_t capture)
+{
+    g_last_released = TOKEN_VALUE(capture);
+    g_released_count++;
+}
+
+struct frame_queue_parameters
+{
+    const char *name;
+    bool single_producer;
+};
+
+static void PrintTo(const frame_queue_parameters &parameters, std::ostream *os)
+{
+    *os << parameters.name;
+}
+
+class frame_queue_ut : public ::testing::TestWithParam<frame_queue_parameters>
+{
+protected:
+    void SetUp() override
+    {
+        g_released_count = 0;
+        g_last_released = 0;
+    }
+
+    frame_queue_t create_queue(uint32_t depth)
+    {
+        frame_queue_t queue = NULL;
+        k4a_result_t result = GetParam().single_producer ?
+                                  frame_queue_create_single_producer(depth, "test", &queue, token_release) :
+                                  frame_queue_create(depth, "test", &queue, token_release);
+        EXPECT_EQ(K4A_RESULT_SUCCEEDED, result);
+        return queue;
+    }
+};
+
+TEST_P(frame_queue_ut, push_pop_in_order)
+{
+    frame_queue_t queue = create_queue(TEST_QUEUE_DEPTH);
+    ASSERT_NE(queue, nullptr);
+    frame_queue_enable(queue);
+
+    for (uintptr_t i = 1; i <= 3; i++)
+    {
+        frame_queue_push(queue, TOKEN(i));
+    }
+    ASSERT_EQ(TOKEN(1), get_frame_queue_front(queue));
+
+    k4a_capture_t capture = NULL;
+    for (uintptr_t i = 1; i <= 3; i++)
+    {
+        ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, frame_queue_pop(queue, 0, &capture));
+        ASSERT_EQ(TOKEN(i), capture);
+    }
+    ASSERT_EQ(K4A_WAIT_RESULT_TIMEOUT, frame_queue_pop(queue, 0, &capture));
+    ASSERT_EQ(nullptr, get_frame_queue_front(queue));
+    ASSERT_EQ(0u, g_released_count);
+
+    frame_queue_destroy(queue);
+}
+
+TEST_P(frame_queue_ut, full_queue_drops_oldest)
+{
+    frame_queue_t queue = create_queue(TEST_QUEUE_DEPTH);
+    ASSERT_NE(queue, nullptr);
+    frame_queue_enable(queue);
+
+    for (uintptr_t i = 1; i <= TEST_QUEUE_DEPTH + 2; i++)
+    {
+        frame_queue_push(queue, TOKEN(i));
+    }
+    ASSERT_EQ(2u, g_released_count);
+    ASSERT_EQ(2u, g_last_released);
+
+    k4a_capture_t capture = NULL;
+    for (uintptr_t i = 3; i <= TEST_QUEUE_DEPTH + 2; i++)
+    {
+        ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, frame_queue_pop(queue, 0, &capture));
+        ASSERT_EQ(TOKEN(i), capture);
+    }
+    ASSERT_EQ(K4A_WAIT_RESULT_TIMEOUT, frame_queue_pop(queue, 0, &capture));
+
+    frame_queue_destroy(queue);
+}
+
+TEST_P(frame_queue_ut, pop_many)
+{
+    frame_queue_t queue = create_queue(TEST_QUEUE_DEPTH);
+    ASSERT_NE(queue, nullptr);
+    frame_queue_enable(queue);
+
+    k4a_capture_t captures[TEST_QUEUE_DEPTH] = { 0 };
+    uint32_t count = 0;
+    ASSERT_EQ(K4A_WAIT_RESULT_TIMEOUT, frame_queue_pop_many(queue, 0, captures, TEST_QUEUE_DEPTH, &count));
+    ASSERT_EQ(0u, count);
+
+    for (uintptr_t i = 1; i <= 3; i++)
+    {
+        frame_queue_push(queue, TOKEN(i));
+    }
+
+    // Stops at max_count, the rest stays queued
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, frame_queue_pop_many(queue, 0, captures, 2, &count));
+    ASSERT_EQ(2u, count);
+    ASSERT_EQ(TOKEN(1), captures[0]);
+    ASSERT_EQ(TOKEN(2), captures[1]);
+
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, frame_queue_pop_many(queue, 0, captures, TEST_QUEUE_DEPTH, &count));
+    ASSERT_EQ(1u, count);
+    ASSERT_EQ(TOKEN(3), captures[0]);
+
+    // A blocked call returns what is queued once the first capture arrives
+    std::thread producer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        frame_queue_push(queue, TOKEN(4));
+    });
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, frame_queue_pop_many(queue, 1000, captures, TEST_QUEUE_DEPTH, &count));
+    producer.join();
+    ASSERT_EQ(1u, count);
+    ASSERT_EQ(TOKEN(4), captures[0]);
+    ASSERT_EQ(0u, g_released_count);
+
+    frame_queue_destroy(queue);
+}
+
+TEST_P(frame_queue_ut, stats_and_dropped_handle)
+{
+    frame_queue_t queue = create_queue(TEST_QUEUE_DEPTH);
+    ASSERT_NE(queue, nullptr);
+    frame_queue_enable(queue);
+
+    k4a_capture_t dropped = NULL;
+    for (uintptr_t i = 1; i <= TEST_QUEUE_DEPTH; i++)
+    {
+        frame_queue_push_w_dropped(queue, TOKEN(i), &dropped);
+        ASSERT_EQ(nullptr, dropped);
+    }
+
+    // The dropped capture is handed back instead of being released
+    frame_queue_push_w_dropped(queue, TOKEN(TEST_QUEUE_DEPTH + 1), &dropped);
+    ASSERT_EQ(TOKEN(1), dropped);
+    ASSERT_EQ(0u, g_released_count);
+
+    k4a_capture_t capture = NULL;
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, frame_queue_pop(queue, 0, &capture));
+
+    frame_queue_stats_t stats;
+    frame_queue_get_stats(queue, &stats);
+    ASSERT_EQ((uint64_t)TEST_QUEUE_DEPTH + 1, stats.pushed_count);
+    ASSERT_EQ(1u, stats.dropped_count);
+    ASSERT_EQ((uint32_t)TEST_QUEUE_DEPTH, stats.high_water);
+
+    // Enabling the queue again starts the statistics over
+    frame_queue_disable(queue);
+    frame_queue_enable(queue);
+    frame_queue_get_stats(queue, &stats);
+    ASSERT_EQ(0u, stats.pushed_count);
+    ASSERT_EQ(0u, stats.dropped_count);
+    ASSERT_EQ(0u, stats.high_water);
+
+    frame_queue_destroy(queue);
+}
+
+TEST_P(frame_queue_ut, pop_timeout)
+{
+    frame_queue_t queue = create_queue(TEST_QUEUE_DEPTH);
+    ASSERT_NE(queue, nullptr);
+    frame_queue_enable(queue);
+
+    k4a_capture_t capture = NULL;
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(K4A_WAIT_RESULT_TIMEOUT, frame_queue_pop(queue, 50, &capture));
+    auto waited = std::chrono::steady_clock::now() - start;
+    ASSERT_GE(std::chrono::duration_cast<std::chrono::milliseconds>(waited).count(), 40);
+
+    frame_queue_destroy(queue);
+}
+
+TEST_P(frame_queue_ut, disable_releases_and_unblocks)
+{
+    frame_queue_t queue = create_queue(TEST_QUEUE_DEPTH);
+    ASSERT_NE(queue, nullptr);
+
+    // Pushing to a disabled queue releases the capture
+    frame_queue_push(queue, TOKEN(1));
+    ASSERT_EQ(1u, g_released_count);
+
+    frame_queue_enable(queue);
+    frame_queue_push(queue, TOKEN(2));
+    frame_queue_disable(queue);
+    ASSERT_EQ(2u, g_released_count);
+
+    k4a_capture_t capture = NULL;
+    ASSERT_EQ(K4A_WAIT_RESULT_FAILED, frame_queue_pop(queue, 0, &capture));
+
+    // A pop waiting forever fails once the queue is disabled
+    frame_queue_enable(queue);
+    std::atomic<k4a_wait_result_t> wresult(K4A_WAIT_RESULT_SUCCEEDED);
+    std::thread consumer([&]() {
+        k4a_capture_t popped = NULL;
+        wresult = frame_queue_pop(queue, K4A_WAIT_INFINITE, &popped);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    frame_queue_disable(queue);
+    consumer.join();
+    ASSERT_EQ(K4A_WAIT_RESULT_FAILED, wresult);
+
+    frame_queue_destroy(queue);
+}
+
+TEST_P(frame_queue_ut, threaded_push_pop)
+{
+    const uintptr_t count = 200000;
+    frame_queue_t queue = create_queue(TEST_QUEUE_DEPTH);
+    ASSERT_NE(queue, nullptr);
+    frame_queue_enable(queue);
+
+    std::thread producer([&]() {
+        for (uintptr_t i = 1; i <= count; i++)
+        {
+            frame_queue_push(queue, TOKEN(i));
+        }
+    });
+
+    // Every capture is either popped or dropped exactly once, and the popped ones come out in order
+    uint32_t popped_count = 0;
+    uintptr_t last = 0;
+    k4a_capture_t capture = NULL;
+    while (last != count && frame_queue_pop(queue, 1000, &capture) == K4A_WAIT_RESULT_SUCCEEDED)
+    {
+        ASSERT_GT(TOKEN_VALUE(capture), last);
+        last = TOKEN_VALUE(capture);
+        popped_count++;
+    }
+    producer.join();
+
+    ASSERT_EQ(count, last);
+    ASSERT_EQ(count, popped_count + g_released_count);
+
+    frame_queue_destroy(queue);
+}
+
+// Measures the time from frame_queue_push on the producer thread until a consumer blocked in frame_queue_pop has the
+// capture, which is the latency the frame set callback adds before k4a_device_get_capture returns.
+TEST_P(frame_queue_ut, push_to_pop_latency)
+{
+    const uintptr_t count = 1000;
+    frame_queue_t queue = create_queue(TEST_QUEUE_DEPTH);
+    ASSERT_NE(queue, nullptr);
+    frame_queue_enable(queue);
+
+    std::vector<std::chrono::steady_clock::time_point> push_times(count + 1);
+    std::vector<double> latency_us;
+    latency_us.reserve(count);
+
+    std::thread consumer([&]() {
+        k4a_capture_t capture = NULL;
+        while (frame_queue_pop(queue, 1000, &capture) == K4A_WAIT_RESULT_SUCCEEDED)
+        {
+            auto delta = std::chrono::steady_clock::now() - push_times[TOKEN_VALUE(capture)];
+            latency_us.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(delta).count() / 1000);
+            if (TOKEN_VALUE(capture) == count)
+            {
+                break;
+            }
+        }
+    });
+
+    for (uintptr_t i = 1; i <= count; i++)
+    {
+        // Give the consumer time to block again, like it does between frames
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+        push_times[i] = std::chrono::steady_clock::now();
+        frame_queue_push(queue, TOKEN(i));
+    }
+    consumer.join();
+    frame_queue_destroy(queue);
+
+    ASSERT_EQ(count, latency_us.size() + g_released_count);
+    ASSERT_FALSE(latency_us.empty());
+
+    std::sort(latency_us.begin(), latency_us.end());
+    double median = latency_us[latency_us.size() / 2];
+    double p99 = latency_us[latency_us.size() * 99 / 100];
+    double max = latency_us.back();
+    std::cout << "    " << GetParam().name << ": push to pop latency median " << median << " us, p99 " << p99
+              << " us, max " << max << " us" << std::endl;
+    RecordProperty("latency_median_us", std::to_string(median));
+    RecordProperty("latency_p99_us", std::to_string(p99));
+    RecordProperty("latency_max_us", std::to_string(max));
+}
+
+INSTANTIATE_TEST_CASE_P(frame_queue_ut,
+                        frame_queue_ut,
+                        ::testing::ValuesIn(std::vector<frame_queue_parameters>{ { "locked", false },
+                                                                                 { "single_producer", true } }));
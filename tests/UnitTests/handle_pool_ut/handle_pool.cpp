@@ -0,0 +1,122 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+
+#include <k4a/k4a.h>
+#include <handle_pool.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+int main(int argc, char **argv)
+{
+    return k4a_test_common_main(argc, argv);
+}
+
+typedef struct _test_handle_t
+{
+    int recycled;
+    int reused;
+    int destroyed;
+} test_handle_t;
+
+static void test_handle_recycle(test_handle_t *handle)
+{
+    handle->recycled++;
+}
+
+static test_handle_t *test_handle_reuse(test_handle_t *handle)
+{
+    handle->reused++;
+    return handle;
+}
+
+static void test_handle_destroy(test_handle_t *handle)
+{
+    handle->destroyed++;
+}
+
+TEST(handle_pool_ut, handle_pool_overflow_test)
+{
+    std::vector<test_handle_t> handles(HANDLE_POOL_SIZE + 1);
+    {
+        handle_pool<test_handle_t *, test_handle_t> pool(test_handle_recycle, test_handle_reuse, test_handle_destroy);
+
+        // Handles are kept until the pool is full, the next one is destroyed right away
+        for (size_t i = 0; i < handles.size(); i++)
+        {
+            pool.release(&handles[i]);
+        }
+        for (size_t i = 0; i < HANDLE_POOL_SIZE; i++)
+        {
+            ASSERT_EQ(handles[i].recycled, 1);
+            ASSERT_EQ(handles[i].destroyed, 0);
+        }
+        ASSERT_EQ(handles[HANDLE_POOL_SIZE].destroyed, 1);
+
+        test_handle_t *handle = NULL;
+        ASSERT_EQ(pool.acquire(&handle), handle);
+        ASSERT_NE(handle, nullptr);
+        ASSERT_EQ(handle->reused, 1);
+        pool.release(handle);
+    }
+
+    // The pool destroys the handles it still holds
+    for (size_t i = 0; i < HANDLE_POOL_SIZE; i++)
+    {
+        ASSERT_EQ(handles[i].destroyed, 1);
+    }
+}
+
+TEST(handle_pool_ut, handle_pool_reuse_test)
+{
+    // Hold more handles than the wrapper pools, so the pool is empty before the handles under test are released
+    std::vector<k4a_image_t> held_images(HANDLE_POOL_SIZE);
+    std::vector<k4a_capture_t> held_captures(HANDLE_POOL_SIZE);
+    for (size_t i = 0; i < held_images.size(); i++)
+    {
+        ASSERT_EQ(k4a_image_create(K4A_IMAGE_FORMAT_DEPTH16, 4, 4, 8, &held_images[i]), K4A_RESULT_SUCCEEDED);
+        ASSERT_EQ(k4a_capture_create(&held_captures[i]), K4A_RESULT_SUCCEEDED);
+    }
+
+    k4a_image_t image = NULL;
+    ASSERT_EQ(k4a_image_create(K4A_IMAGE_FORMAT_DEPTH16, 4, 4, 8, &image), K4A_RESULT_SUCCEEDED);
+    k4a_capture_t capture = NULL;
+    ASSERT_EQ(k4a_capture_create(&capture), K4A_RESULT_SUCCEEDED);
+    k4a_capture_set_depth_image(capture, image);
+
+    // Released handles are invalid while they are in the pool
+    k4a_image_release(image);
+    ASSERT_NE(k4a_image_get_buffer(image), nullptr);
+    k4a_capture_release(capture);
+    ASSERT_EQ(k4a_image_get_buffer(image), nullptr);
+    ASSERT_EQ(k4a_image_get_width_pixels(image), 0);
+    ASSERT_EQ(k4a_capture_get_depth_image(capture), nullptr);
+
+    // The next create hands out the pooled handle again, as a valid handle without the previous contents
+    k4a_capture_t reused_capture = NULL;
+    ASSERT_EQ(k4a_capture_create(&reused_capture), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(reused_capture, capture);
+    ASSERT_EQ(k4a_capture_get_depth_image(reused_capture), nullptr);
+
+    k4a_image_t reused_image = NULL;
+    ASSERT_EQ(k4a_image_create(K4A_IMAGE_FORMAT_IR16, 8, 2, 16, &reused_image), K4A_RESULT_SUCCEEDED);
+    ASSERT_EQ(reused_image, image);
+    ASSERT_NE(k4a_image_get_buffer(reused_image), nullptr);
+    ASSERT_EQ(k4a_image_get_format(reused_image), K4A_IMAGE_FORMAT_IR16);
+    ASSERT_EQ(k4a_image_get_width_pixels(reused_image), 8);
+
+    k4a_capture_set_ir_image(reused_capture, reused_image);
+    k4a_image_t ir = k4a_capture_get_ir_image(reused_capture);
+    ASSERT_EQ(ir, reused_image);
+    k4a_image_release(ir);
+    k4a_image_release(reused_image);
+    k4a_capture_release(reused_capture);
+
+    for (size_t i = 0; i < held_images.size(); i++)
+    {
+        k4a_image_release(held_images[i]);
+        k4a_capture_release(held_captures[i]);
+    }
+}
@@ -43,6 +43,10 @@ K4A_DECLARE_CONTEXT(foo_t, context_t);
 K4A_DECLARE_HANDLE(bar_t);
 K4A_DECLARE_CONTEXT(bar_t, context2_t);
 
+// Declare a handle type that can be kept in a pool
+K4A_DECLARE_HANDLE(baz_t);
+K4A_DECLARE_POOLED_CONTEXT(baz_t, context_t);
+
 TEST(handle_ut, create_free)
 {
     foo_t foo = NULL;
@@ -116,6 +120,29 @@ TEST(handle_ut_deathtest, use_after_free)
     EXPECT_EQ(NULL, foo_t_get_context(foo));
 }
 
+TEST(handle_ut_deathtest, use_after_recycle)
+{
+    baz_t baz = NULL;
+    context_t *pContext = baz_t_create(&baz);
+    EXPECT_NE((context_t *)NULL, pContext);
+    pContext->my = 1;
+
+    // A recycled handle is invalid until it is reused
+    baz_t_recycle(baz);
+    EXPECT_EQ(NULL, baz_t_get_context(baz));
+
+    // Reuse hands out the same context again
+    EXPECT_EQ(pContext, baz_t_reuse(baz));
+    EXPECT_EQ(pContext, baz_t_get_context(baz));
+    EXPECT_EQ(1, pContext->my);
+
+    // A handle that is in use can't be reused
+    EXPECT_EQ(NULL, baz_t_reuse(baz));
+    EXPECT_EQ(pContext, baz_t_get_context(baz));
+
+    baz_t_destroy(baz);
+}
+
 TEST(handle_ut, K4A_DECLARE_CONTEXT_in_shared_header)
 {
     dual_defined_t dual = NULL;
@@ -0,0 +1,387 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <utcommon.h>
+
+#include <imusync.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+    return k4a_test_common_main(argc, argv);
+}
+
+// 500 Hz, like the Orbbec IMU
+#define SAMPLE_PERIOD_USEC 2000
+
+// The synthetic signals are linear in time, so interpolating between two samples gives the exact value
+static float accel_signal(uint64_t timestamp_usec, int axis)
+{
+    return (float)((double)timestamp_usec / 100000.0) + (float)axis;
+}
+
+static float gyro_signal(uint64_t timestamp_usec, int axis)
+{
+    return (float)((double)timestamp_usec / 50000.0) - (float)axis;
+}
+
+static imu_frame_data make_sample(uint64_t timestamp_usec, imu_data_type type)
+{
+    imu_frame_data sample;
+    sample.timestamp = timestamp_usec;
+    sample.temp = 30.0f;
+    for (int i = 0; i < 3; i++)
+    {
+        sample.data[i] = type == ACCEL_FRAME_TYPE ? accel_signal(timestamp_usec, i) : gyro_signal(timestamp_usec, i);
+    }
+    return sample;
+}
+
+class imusync_ut : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, imusync_create(&m_imusync));
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED, imusync_start(m_imusync));
+    }
+
+    void TearDown() override
+    {
+        imusync_destroy(m_imusync);
+    }
+
+    // Feeds both streams in the order the device callbacks deliver them, with the gyroscope samples delivered
+    // gyro_delay_usec later than the accelerometer samples. The synchronized samples are read as they come, like an
+    // application does, and checked against the synthetic signals.
+    size_t push_streams(const std::vector<uint64_t> &accel_timestamps,
+                        const std::vector<uint64_t> &gyro_timestamps,
+                        uint64_t gyro_delay_usec,
+                        uint64_t *last_timestamp)
+    {
+        size_t total = 0;
+        size_t accel_index = 0;
+        size_t gyro_index = 0;
+        while (accel_index < accel_timestamps.size() || gyro_index < gyro_timestamps.size())
+        {
+            if (gyro_index == gyro_timestamps.size() ||
+                (accel_index < accel_timestamps.size() &&
+                 accel_timestamps[accel_index] <= gyro_timestamps[gyro_index] + gyro_delay_usec))
+            {
+                imusync_push_frame(m_imusync,
+                                   make_sample(accel_timestamps[accel_index++], ACCEL_FRAME_TYPE),
+                                   ACCEL_FRAME_TYPE);
+            }
+            else
+            {
+                imusync_push_frame(m_imusync,
+                                   make_sample(gyro_timestamps[gyro_index++], GYRO_FRAME_TYPE),
+                                   GYRO_FRAME_TYPE);
+            }
+            total += read_and_validate(last_timestamp);
+        }
+        return total;
+    }
+
+    // Reads every queued sample and checks it against the synthetic signals
+    size_t read_and_validate(uint64_t *last_timestamp)
+    {
+        size_t total = 0;
+        k4a_imu_sample_t samples[64];
+        size_t count = 0;
+        while (imusync_get_frames(m_imusync, samples, 64, 0, &count) == K4A_WAIT_RESULT_SUCCEEDED)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                EXPECT_GT(samples[i].acc_timestamp_usec, *last_timestamp);
+                EXPECT_EQ(samples[i].acc_timestamp_usec, samples[i].gyro_timestamp_usec);
+                *last_timestamp = samples[i].acc_timestamp_usec;
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    EXPECT_FLOAT_EQ(accel_signal(*last_timestamp, axis), samples[i].acc_sample.v[axis]);
+                    EXPECT_NEAR(gyro_signal(*last_timestamp, axis), samples[i].gyro_sample.v[axis], 1e-3);
+                }
+            }
+            total += count;
+        }
+        return total;
+    }
+
+    static void print_stats(const char *name, const imusync_pairing_stats_t &stats)
+    {
+        double mean_gap = stats.paired_count == 0 ? 0 : (double)stats.total_gap_usec / (double)stats.paired_count;
+        std::cout << "    " << name << ": paired " << stats.paired_count << ", interpolated "
+                  << stats.interpolated_count << ", unmatched accel " << stats.unmatched_accel_count
+                  << ", unmatched gyro " << stats.unmatched_gyro_count << ", gap mean " << mean_gap << " us, max "
+                  << stats.max_gap_usec << " us" << std::endl;
+    }
+
+    imusync_t m_imusync = NULL;
+};
+
+TEST_F(imusync_ut, equal_timestamps_pair_exactly)
+{
+    const size_t count = 100;
+    std::vector<uint64_t> timestamps;
+    for (size_t i = 0; i < count; i++)
+    {
+        timestamps.push_back(1000 + i * SAMPLE_PERIOD_USEC);
+    }
+
+    uint64_t last_timestamp = 0;
+    ASSERT_EQ(count, push_streams(timestamps, timestamps, 3 * SAMPLE_PERIOD_USEC, &last_timestamp));
+    ASSERT_EQ(timestamps.back(), last_timestamp);
+
+    imusync_pairing_stats_t stats;
+    imusync_get_pairing_stats(m_imusync, &stats);
+    print_stats("equal", stats);
+    ASSERT_EQ(count, stats.paired_count);
+    ASSERT_EQ(0u, stats.interpolated_count);
+    ASSERT_EQ(0u, stats.unmatched_accel_count);
+    ASSERT_EQ(0u, stats.unmatched_gyro_count);
+    ASSERT_EQ(0u, stats.max_gap_usec);
+}
+
+TEST_F(imusync_ut, lost_samples_are_dropped)
+{
+    // Every tenth gyroscope sample and every seventh accelerometer sample is lost
+    const size_t count = 700;
+    std::vector<uint64_t> accel_timestamps;
+    std::vector<uint64_t> gyro_timestamps;
+    size_t both = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t timestamp = 1000 + i * SAMPLE_PERIOD_USEC;
+        if (i % 7 != 3)
+        {
+            accel_timestamps.push_back(timestamp);
+        }
+        if (i % 10 != 5)
+        {
+            gyro_timestamps.push_back(timestamp);
+        }
+        both += (i % 7 != 3 && i % 10 != 5) ? 1 : 0;
+    }
+
+    uint64_t last_timestamp = 0;
+    ASSERT_EQ(both, push_streams(accel_timestamps, gyro_timestamps, 2 * SAMPLE_PERIOD_USEC, &last_timestamp));
+
+    imusync_pairing_stats_t stats;
+    imusync_get_pairing_stats(m_imusync, &stats);
+    print_stats("lost", stats);
+    ASSERT_EQ(both, stats.paired_count);
+    ASSERT_EQ(accel_timestamps.size() - both, stats.unmatched_accel_count);
+    ASSERT_EQ(gyro_timestamps.size() - both, stats.unmatched_gyro_count);
+}
+
+TEST_F(imusync_ut, synchronized_samples_keep_their_timestamps)
+{
+    // Samples read from a recording are already paired, even if the gyroscope timestamp differs
+    const size_t count = 100;
+    const uint64_t offset_usec = 300;
+    for (size_t i = 0; i < count; i++)
+    {
+        k4a_imu_sample_t sample = {};
+        sample.acc_timestamp_usec = 1000 + i * SAMPLE_PERIOD_USEC;
+        sample.gyro_timestamp_usec = sample.acc_timestamp_usec - offset_usec;
+        sample.temperature = 30.0f;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            sample.acc_sample.v[axis] = accel_signal(sample.acc_timestamp_usec, axis);
+            sample.gyro_sample.v[axis] = gyro_signal(sample.gyro_timestamp_usec, axis);
+        }
+        imusync_push_sample(m_imusync, &sample);
+    }
+
+    k4a_imu_sample_t samples[count];
+    size_t read_count = 0;
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, imusync_get_frames(m_imusync, samples, count, 0, &read_count));
+    ASSERT_EQ(count, read_count);
+    for (size_t i = 0; i < count; i++)
+    {
+        ASSERT_EQ(1000 + i * SAMPLE_PERIOD_USEC, samples[i].acc_timestamp_usec);
+        ASSERT_EQ(samples[i].acc_timestamp_usec - offset_usec, samples[i].gyro_timestamp_usec);
+        for (int axis = 0; axis < 3; axis++)
+        {
+            ASSERT_FLOAT_EQ(accel_signal(samples[i].acc_timestamp_usec, axis), samples[i].acc_sample.v[axis]);
+            ASSERT_FLOAT_EQ(gyro_signal(samples[i].gyro_timestamp_usec, axis), samples[i].gyro_sample.v[axis]);
+        }
+    }
+
+    imusync_pairing_stats_t stats;
+    imusync_get_pairing_stats(m_imusync, &stats);
+    ASSERT_EQ(count, stats.paired_count);
+    ASSERT_EQ(0u, stats.unmatched_accel_count);
+    ASSERT_EQ(0u, stats.unmatched_gyro_count);
+    ASSERT_EQ(offset_usec, stats.max_gap_usec);
+}
+
+TEST_F(imusync_ut, offset_streams_are_interpolated)
+{
+    imusync_set_interpolation(m_imusync, true);
+
+    // Without interpolation, streams with a phase offset never pair
+    const size_t count = 500;
+    const uint64_t offset_usec = 700;
+    std::vector<uint64_t> accel_timestamps;
+    std::vector<uint64_t> gyro_timestamps;
+    for (size_t i = 0; i < count; i++)
+    {
+        accel_timestamps.push_back(10000 + i * SAMPLE_PERIOD_USEC);
+        gyro_timestamps.push_back(10000 - offset_usec + i * SAMPLE_PERIOD_USEC);
+    }
+
+    // The last accelerometer sample waits for a gyroscope sample after it
+    uint64_t last_timestamp = 0;
+    ASSERT_EQ(count - 1, push_streams(accel_timestamps, gyro_timestamps, 4 * SAMPLE_PERIOD_USEC, &last_timestamp));
+
+    imusync_pairing_stats_t stats;
+    imusync_get_pairing_stats(m_imusync, &stats);
+    print_stats("offset", stats);
+    ASSERT_EQ(count - 1, stats.paired_count);
+    ASSERT_EQ(count - 1, stats.interpolated_count);
+    ASSERT_EQ(0u, stats.unmatched_accel_count);
+    ASSERT_EQ(SAMPLE_PERIOD_USEC - offset_usec, stats.max_gap_usec);
+}
+
+TEST_F(imusync_ut, jittered_rates_are_interpolated)
+{
+    imusync_set_interpolation(m_imusync, true);
+
+    // Accelerometer at 500 Hz and gyroscope at 400 Hz, both with up to +-100 us of deterministic jitter
+    const size_t count = 1000;
+    const uint64_t gyro_period_usec = 2500;
+    std::vector<uint64_t> accel_timestamps;
+    std::vector<uint64_t> gyro_timestamps;
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < count; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        accel_timestamps.push_back(10000 + i * SAMPLE_PERIOD_USEC + (seed >> 16) % 201 - 100);
+        seed = seed * 1103515245 + 12345;
+        gyro_timestamps.push_back(10000 + i * gyro_period_usec + (seed >> 16) % 201 - 100);
+    }
+
+    uint64_t last_timestamp = 0;
+    size_t read_count = push_streams(accel_timestamps, gyro_timestamps, 1000, &last_timestamp);
+
+    imusync_pairing_stats_t stats;
+    imusync_get_pairing_stats(m_imusync, &stats);
+    print_stats("jitter", stats);
+    ASSERT_EQ(read_count, stats.paired_count);
+    ASSERT_EQ(count, stats.paired_count + stats.unmatched_accel_count);
+    ASSERT_LE(stats.max_gap_usec, gyro_period_usec + 200);
+    RecordProperty("max_gap_usec", std::to_string(stats.max_gap_usec));
+}
+
+TEST_F(imusync_ut, batch_read_and_stop)
+{
+    std::vector<uint64_t> timestamps;
+    for (size_t i = 0; i < 10; i++)
+    {
+        timestamps.push_back(1000 + i * SAMPLE_PERIOD_USEC);
+    }
+    for (uint64_t timestamp : timestamps)
+    {
+        imusync_push_frame(m_imusync, make_sample(timestamp, ACCEL_FRAME_TYPE), ACCEL_FRAME_TYPE);
+        imusync_push_frame(m_imusync, make_sample(timestamp, GYRO_FRAME_TYPE), GYRO_FRAME_TYPE);
+    }
+
+    k4a_imu_sample_t samples[10];
+    size_t count = 0;
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, imusync_get_frames(m_imusync, samples, 4, 0, &count));
+    ASSERT_EQ(4u, count);
+    ASSERT_EQ(timestamps[0], samples[0].acc_timestamp_usec);
+    ASSERT_EQ(K4A_WAIT_RESULT_SUCCEEDED, imusync_get_frames(m_imusync, samples, 10, 0, &count));
+    ASSERT_EQ(6u, count);
+    ASSERT_EQ(timestamps[4], samples[0].acc_timestamp_usec);
+    ASSERT_EQ(K4A_WAIT_RESULT_TIMEOUT, imusync_get_frame(m_imusync, samples, 10));
+
+    frame_queue_stats_t queue_stats;
+    imusync_get_stats(m_imusync, &queue_stats);
+    ASSERT_EQ(10u, queue_stats.pushed_count);
+    ASSERT_EQ(0u, queue_stats.dropped_count);
+    ASSERT_EQ(10u, queue_stats.high_water);
+
+    // A read waiting forever fails once the IMU is stopped
+    std::atomic<k4a_wait_result_t> wresult(K4A_WAIT_RESULT_SUCCEEDED);
+    std::thread consumer([&]() {
+        k4a_imu_sample_t sample;
+        wresult = imusync_get_frame(m_imusync, &sample, K4A_WAIT_INFINITE);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    imusync_stop(m_imusync);
+    consumer.join();
+    ASSERT_EQ(K4A_WAIT_RESULT_FAILED, wresult);
+    ASSERT_EQ(K4A_WAIT_RESULT_FAILED, imusync_get_frame(m_imusync, samples, 0));
+}
+
+TEST_F(imusync_ut, waiting_reads_use_the_whole_timeout)
+{
+    // Without samples a read returns once its timeout has elapsed
+    k4a_imu_sample_t sample;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ASSERT_EQ(K4A_WAIT_RESULT_TIMEOUT, imusync_get_frame(m_imusync, &sample, 100));
+    ASSERT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(100));
+
+    // Two readers wait for one sample at a time. The reader that doesn't get the first sample keeps waiting for the
+    // next one instead of returning early.
+    std::atomic<int> succeeded_count(0);
+    std::vector<std::thread> consumers;
+    for (int i = 0; i < 2; i++)
+    {
+        consumers.emplace_back([&]() {
+            k4a_imu_sample_t consumer_sample;
+            if (imusync_get_frame(m_imusync, &consumer_sample, 2000) == K4A_WAIT_RESULT_SUCCEEDED)
+            {
+                succeeded_count++;
+            }
+        });
+    }
+
+    for (uint64_t timestamp = 1000; timestamp < 1000 + 2 * SAMPLE_PERIOD_USEC; timestamp += SAMPLE_PERIOD_USEC)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        imusync_push_frame(m_imusync, make_sample(timestamp, ACCEL_FRAME_TYPE), ACCEL_FRAME_TYPE);
+        imusync_push_frame(m_imusync, make_sample(timestamp, GYRO_FRAME_TYPE), GYRO_FRAME_TYPE);
+    }
+
+    for (std::thread &consumer : consumers)
+    {
+        consumer.join();
+    }
+    ASSERT_EQ(2, succeeded_count);
+}
+
+// Measures the cost of synchronizing a sample, which runs on the IMU callback threads of libobsensor
+TEST_F(imusync_ut, push_cost)
+{
+    const size_t count = 200000;
+    k4a_imu_sample_t samples[64];
+    size_t read_count = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t timestamp = 1000 + i * SAMPLE_PERIOD_USEC;
+        imusync_push_frame(m_imusync, make_sample(timestamp, ACCEL_FRAME_TYPE), ACCEL_FRAME_TYPE);
+        imusync_push_frame(m_imusync, make_sample(timestamp, GYRO_FRAME_TYPE), GYRO_FRAME_TYPE);
+        if (i % 64 == 63)
+        {
+            imusync_get_frames(m_imusync, samples, 64, 0, &read_count);
+            ASSERT_EQ(64u, read_count);
+        }
+    }
+    auto delta = std::chrono::steady_clock::now() - start;
+
+    double push_ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(delta).count() / (count * 2);
+    std::cout << "    " << push_ns << " ns per pushed sample" << std::endl;
+    RecordProperty("push_ns", std::to_string(push_ns));
+}
@@ -0,0 +1,130 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <k4a/k4a.h>
+#include <gtest/gtest.h>
+#include <utcommon.h>
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+// Number of times each image is queried. Every query reads all of the image properties, like the transformation
+// functions do for each of their input and output images.
+static const int query_count = 1000000;
+
+struct image_perf_parameters
+{
+    const char *name;
+    k4a_image_format_t format;
+    int width_pixels;
+    int height_pixels;
+    int stride_bytes;
+};
+
+static void PrintTo(const image_perf_parameters &parameters, std::ostream *os)
+{
+    *os << parameters.name;
+}
+
+class image_perf : public ::testing::TestWithParam<image_perf_parameters>
+{
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+TEST_P(image_perf, image_properties)
+{
+    image_perf_parameters parameters = GetParam();
+
+    k4a_image_t image = NULL;
+    ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+              k4a_image_create(parameters.format,
+                               parameters.width_pixels,
+                               parameters.height_pixels,
+                               parameters.stride_bytes,
+                               &image));
+
+    uint8_t *buffer = k4a_image_get_buffer(image);
+    size_t size = k4a_image_get_size(image);
+    ASSERT_NE(buffer, nullptr);
+    ASSERT_EQ(size, (size_t)parameters.height_pixels * (size_t)parameters.stride_bytes);
+    ASSERT_EQ(k4a_image_get_format(image), parameters.format);
+    ASSERT_EQ(k4a_image_get_width_pixels(image), parameters.width_pixels);
+    ASSERT_EQ(k4a_image_get_height_pixels(image), parameters.height_pixels);
+    ASSERT_EQ(k4a_image_get_stride_bytes(image), parameters.stride_bytes);
+
+    // Sum the results so the queries can't be optimized away.
+    uint64_t checksum = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < query_count; i++)
+    {
+        checksum += (uint64_t)(size_t)k4a_image_get_buffer(image);
+        checksum += k4a_image_get_size(image);
+        checksum += (uint64_t)k4a_image_get_format(image);
+        checksum += (uint64_t)k4a_image_get_width_pixels(image);
+        checksum += (uint64_t)k4a_image_get_height_pixels(image);
+        checksum += (uint64_t)k4a_image_get_stride_bytes(image);
+    }
+    auto delta = std::chrono::high_resolution_clock::now() - start;
+
+    uint64_t expected = (uint64_t)(size_t)buffer + size + (uint64_t)parameters.format +
+                        (uint64_t)parameters.width_pixels + (uint64_t)parameters.height_pixels +
+                        (uint64_t)parameters.stride_bytes;
+    ASSERT_EQ(checksum, expected * query_count);
+
+    double query_ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(delta).count() / query_count;
+    std::cout << "    " << parameters.name << ": " << query_ns << " ns to read all properties, "
+              << (query_ns / 6) << " ns per call" << std::endl;
+    RecordProperty("query_ns", std::to_string(query_ns));
+
+    k4a_image_release(image);
+}
+
+// Number of images created and released, like a streaming application does for every frame.
+static const int create_count = 10000;
+
+TEST_P(image_perf, image_create_release)
+{
+    image_perf_parameters parameters = GetParam();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < create_count; i++)
+    {
+        k4a_image_t image = NULL;
+        ASSERT_EQ(K4A_RESULT_SUCCEEDED,
+                  k4a_image_create(parameters.format,
+                                   parameters.width_pixels,
+                                   parameters.height_pixels,
+                                   parameters.stride_bytes,
+                                   &image));
+        k4a_image_release(image);
+    }
+    auto delta = std::chrono::high_resolution_clock::now() - start;
+
+    double create_us = (double)std::chrono::duration_cast<std::chrono::microseconds>(delta).count() / create_count;
+    std::cout << "    " << parameters.name << ": " << create_us << " us to create and release an image" << std::endl;
+    RecordProperty("create_us", std::to_string(create_us));
+}
+
+INSTANTIATE_TEST_CASE_P(image_perf,
+                        image_perf,
+                        ::testing::ValuesIn(std::vector<image_perf_parameters>{
+                            { "DEPTH16_640x576", K4A_IMAGE_FORMAT_DEPTH16, 640, 576, 640 * 2 },
+                            { "IR16_1024x1024", K4A_IMAGE_FORMAT_IR16, 1024, 1024, 1024 * 2 },
+                            { "BGRA32_1920x1080", K4A_IMAGE_FORMAT_COLOR_BGRA32, 1920, 1080, 1920 * 4 },
+                            { "YUY2_1280x720", K4A_IMAGE_FORMAT_COLOR_YUY2, 1280, 720, 1280 * 2 },
+                            { "CUSTOM16_640x576", K4A_IMAGE_FORMAT_CUSTOM16, 640, 576, 640 * 2 },
+                        }));
+
+int main(int argc, char **argv)
+{
+    k4a_unittest_init();
+
+    ::testing::InitGoogleTest(&argc, argv);
+
+    int results = RUN_ALL_TESTS();
+    k4a_unittest_deinit();
+    return results;
+}